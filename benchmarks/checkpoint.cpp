@@ -0,0 +1,68 @@
+#include "checkpoint.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+// Writes `count` [n, n] weights, as a checkpoint and as raw floats
+auto write_files(size_t count, size_t side) -> std::filesystem::path {
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  std::map<std::string, synapse::Tensor> tensors;
+  std::ofstream raw(dir / "synapse_bench.raw", std::ios::binary);
+  const std::vector<float> values(side * side, 0.5F);
+  for (size_t i = 0; i < count; ++i) {
+    tensors.emplace(std::to_string(i), synapse::Tensor{values, {side, side}});
+    raw.write(reinterpret_cast<const char *>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(float)));
+  }
+  synapse::save_checkpoint(dir / "synapse_bench.ckpt", tensors);
+  return dir;
+}
+
+auto set_file_bytes(benchmark::State &state, size_t count, size_t side)
+    -> void {
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(count * side * side *
+                                               sizeof(float)));
+}
+
+// Opens the checkpoint, the weights are only paged in when used
+auto BM_LoadCheckpoint(benchmark::State &state) -> void {
+  const auto count = static_cast<size_t>(state.range(0));
+  const size_t side = 1024;
+  const std::filesystem::path dir = write_files(count, side);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        synapse::load_checkpoint(dir / "synapse_bench.ckpt"));
+  }
+  set_file_bytes(state, count, side);
+}
+
+// Reference: reads every weight into a buffer and copies it into a tensor
+auto BM_ReadAndCopy(benchmark::State &state) -> void {
+  const auto count = static_cast<size_t>(state.range(0));
+  const size_t side = 1024;
+  const std::filesystem::path dir = write_files(count, side);
+  for (auto _ : state) {
+    std::ifstream raw(dir / "synapse_bench.raw", std::ios::binary);
+    std::vector<synapse::Tensor> tensors;
+    std::vector<float> buffer(side * side);
+    for (size_t i = 0; i < count; ++i) {
+      raw.read(reinterpret_cast<char *>(buffer.data()),
+               static_cast<std::streamsize>(buffer.size() * sizeof(float)));
+      tensors.emplace_back(buffer, synapse::Shape{side, side});
+    }
+    benchmark::DoNotOptimize(tensors);
+  }
+  set_file_bytes(state, count, side);
+}
+} // namespace
+
+BENCHMARK(BM_LoadCheckpoint)->Arg(16)->Arg(64);
+BENCHMARK(BM_ReadAndCopy)->Arg(16)->Arg(64);
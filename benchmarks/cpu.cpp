@@ -0,0 +1,42 @@
+#include "cpu.h"
+#include "func.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+auto make_tensor(size_t numel) -> synapse::Tensor {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(static_cast<float>(i));
+  }
+  return synapse::Tensor{std::move(out), synapse::Shape{numel}};
+}
+
+// Kernels of one level, the argument being a `CpuLevel`. Levels the host
+// does not support are skipped
+auto BM_AddAtLevel(benchmark::State &state) -> void {
+  const auto level = static_cast<synapse::CpuLevel>(state.range(0));
+  if (level > synapse::detected_cpu_level()) {
+    state.SkipWithError("Level not supported by this host");
+    return;
+  }
+  const synapse::CpuLevel initial = synapse::cpu_level();
+  synapse::set_cpu_level(level);
+  // Fits in L2, so the loads do not hide the arithmetic
+  const synapse::Tensor lhs = make_tensor(size_t{1} << 14);
+  const synapse::Tensor rhs = make_tensor(size_t{1} << 14);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::add(lhs, rhs));
+  }
+  state.SetLabel(std::string(synapse::cpu_level_name(level)));
+  synapse::set_cpu_level(initial);
+}
+} // namespace
+
+BENCHMARK(BM_AddAtLevel)->DenseRange(0, 3);
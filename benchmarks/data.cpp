@@ -0,0 +1,79 @@
+#include "data.h"
+#include "dtype.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace {
+constexpr size_t SAMPLES = 4096;
+constexpr size_t FEATURES = 3 * 32 * 32;
+constexpr size_t BATCH = 64;
+
+auto make_dataset() -> std::shared_ptr<synapse::data::TensorDataset> {
+  std::vector<float> features(SAMPLES * FEATURES);
+  for (size_t i = 0; i < features.size(); ++i) {
+    features[i] = std::sin(static_cast<float>(i));
+  }
+  return std::make_shared<synapse::data::TensorDataset>(
+      std::vector<synapse::Tensor>{
+          synapse::Tensor{features, {SAMPLES, FEATURES}},
+          synapse::Tensor::zeros({SAMPLES}, synapse::DType::Int32)});
+}
+
+// Stands in for a training step on the batch
+auto consume(const synapse::Tensor &features) -> float {
+  const float *data = features.data();
+  float sum = 0.0F;
+  for (size_t repeat = 0; repeat < 4; ++repeat) {
+    for (size_t i = 0; i < features.size(); ++i) {
+      sum += std::sqrt(std::abs(data[i]));
+    }
+  }
+  return sum;
+}
+
+// A shuffled epoch, with `state.range(0)` workers loading ahead
+auto BM_LoaderEpoch(benchmark::State &state) -> void {
+  const auto dataset = make_dataset();
+  synapse::data::DataLoader loader(
+      dataset, {.batch_size = BATCH,
+                .shuffle = true,
+                .num_workers = static_cast<size_t>(state.range(0))});
+  for (auto _ : state) {
+    while (const std::optional<synapse::data::Batch> batch = loader.next()) {
+      benchmark::DoNotOptimize(consume((*batch)[0]));
+    }
+    loader.reset();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(SAMPLES));
+}
+
+// Reference: gathers every batch into freshly allocated tensors
+auto BM_GatherEpoch(benchmark::State &state) -> void {
+  std::vector<float> source(SAMPLES * FEATURES);
+  for (size_t i = 0; i < source.size(); ++i) {
+    source[i] = std::sin(static_cast<float>(i));
+  }
+  for (auto _ : state) {
+    for (size_t begin = 0; begin < SAMPLES; begin += BATCH) {
+      std::vector<float> rows(source.begin() +
+                                  static_cast<long>(begin * FEATURES),
+                              source.begin() + static_cast<long>(
+                                                   (begin + BATCH) * FEATURES));
+      const synapse::Tensor batch{rows, {BATCH, FEATURES}};
+      benchmark::DoNotOptimize(consume(batch));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(SAMPLES));
+}
+} // namespace
+
+BENCHMARK(BM_LoaderEpoch)->Arg(0)->Arg(1)->Arg(2);
+BENCHMARK(BM_GatherEpoch);
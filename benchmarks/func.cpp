@@ -0,0 +1,177 @@
+#include "func.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+auto values(size_t numel) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(static_cast<float>(i));
+  }
+  return out;
+}
+
+// Splits `numel` elements over `rank` dimensions of roughly equal size, the
+// last one absorbing the remainder
+auto shape_of_rank(size_t numel, size_t rank) -> synapse::Shape {
+  synapse::Shape shape(rank, 1);
+  const auto side = static_cast<size_t>(
+      std::pow(static_cast<double>(numel), 1.0 / static_cast<double>(rank)));
+  size_t rest = numel;
+  for (size_t d = 0; d + 1 < rank; ++d) {
+    shape[d] = side;
+    rest /= side;
+  }
+  shape[rank - 1] = rest;
+  return shape;
+}
+
+// Reports the bytes read and written by an element-wise op over `numel`
+// outputs with `inputs` operands
+auto set_elementwise_bytes(benchmark::State &state, size_t numel,
+                           size_t inputs) -> void {
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(numel * (inputs + 1) *
+                                               sizeof(float)));
+}
+
+template <auto Op> auto BM_Binary(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const synapse::Tensor lhs{values(numel), {numel}};
+  const synapse::Tensor rhs{values(numel), {numel}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Op(lhs, rhs));
+  }
+  set_elementwise_bytes(state, numel, 2);
+}
+
+// Same number of elements laid out over more and more dimensions. Operands
+// are transposed so their dimensions cannot be coalesced with the dense
+// output's.
+template <auto Op> auto BM_BinaryRank(benchmark::State &state) -> void {
+  const auto rank = static_cast<size_t>(state.range(0));
+  const synapse::Shape shape = shape_of_rank(size_t{1} << 20, rank);
+  const size_t numel = synapse::shape_numel(shape);
+  const synapse::Tensor lhs =
+      synapse::Tensor{values(numel), shape}.transpose(0, rank - 1);
+  const synapse::Tensor rhs =
+      synapse::Tensor{values(numel), shape}.transpose(0, rank - 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Op(lhs, rhs));
+  }
+  set_elementwise_bytes(state, numel, 2);
+}
+
+// A [n, n] matrix combined with a broadcasted [n] row
+template <auto Op> auto BM_BinaryBroadcast(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::Tensor lhs{values(side * side), {side, side}};
+  const synapse::Tensor rhs{values(side), {side}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Op(lhs, rhs));
+  }
+  set_elementwise_bytes(state, side * side, 1);
+}
+
+auto BM_Matmul(benchmark::State &state) -> void {
+  const auto batch = static_cast<size_t>(state.range(0));
+  const auto side = static_cast<size_t>(state.range(1));
+  const synapse::Shape shape = batch == 1
+                                   ? synapse::Shape{side, side}
+                                   : synapse::Shape{batch, side, side};
+  const size_t numel = synapse::shape_numel(shape);
+  const synapse::Tensor lhs{values(numel), shape};
+  const synapse::Tensor rhs{values(numel), shape};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::matmul(lhs, rhs));
+  }
+  state.counters["FLOPS"] = benchmark::Counter(
+      2.0 * static_cast<double>(batch * side * side * side),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Product with a transposed rhs, read through its strides
+auto BM_MatmulTransposed(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::Tensor lhs{values(side * side), {side, side}};
+  const synapse::Tensor rhs =
+      synapse::Tensor{values(side * side), {side, side}}.transpose(0, 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::matmul(lhs, rhs));
+  }
+  state.counters["FLOPS"] =
+      benchmark::Counter(2.0 * static_cast<double>(side * side * side),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Accumulating into an existing tensor, as gradient accumulation does,
+// allocating a new sum every step against writing in place
+auto BM_Accumulate(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const synapse::Tensor grad{values(numel), {numel}};
+  synapse::Tensor acc = synapse::Tensor::zeros({numel});
+  for (auto _ : state) {
+    acc = synapse::add(acc, grad);
+    benchmark::DoNotOptimize(acc.raw_data());
+  }
+  set_elementwise_bytes(state, numel, 2);
+}
+
+auto BM_AccumulateInPlace(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const synapse::Tensor grad{values(numel), {numel}};
+  synapse::Tensor acc = synapse::Tensor::zeros({numel});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::add_(acc, grad).raw_data());
+  }
+  set_elementwise_bytes(state, numel, 2);
+}
+
+auto BM_MatmulOut(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::Tensor lhs{values(side * side), {side, side}};
+  const synapse::Tensor rhs{values(side * side), {side, side}};
+  synapse::Tensor out = synapse::Tensor::empty({side, side});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::matmul(lhs, rhs, out).raw_data());
+  }
+  state.counters["FLOPS"] =
+      benchmark::Counter(2.0 * static_cast<double>(side * side * side),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+
+auto add(const synapse::Tensor &lhs, const synapse::Tensor &rhs)
+    -> synapse::Tensor {
+  return synapse::add(lhs, rhs);
+}
+
+auto mul(const synapse::Tensor &lhs, const synapse::Tensor &rhs)
+    -> synapse::Tensor {
+  return synapse::mul(lhs, rhs);
+}
+} // namespace
+
+BENCHMARK(BM_Binary<add>)->Name("BM_Add")->RangeMultiplier(8)->Range(
+    1 << 10, 1 << 24);
+BENCHMARK(BM_Binary<mul>)->Name("BM_Mul")->RangeMultiplier(8)->Range(
+    1 << 10, 1 << 24);
+BENCHMARK(BM_BinaryRank<add>)->Name("BM_AddRank")->DenseRange(2, 6);
+BENCHMARK(BM_BinaryRank<mul>)->Name("BM_MulRank")->DenseRange(2, 6);
+BENCHMARK(BM_BinaryBroadcast<add>)
+    ->Name("BM_AddBroadcast")
+    ->RangeMultiplier(4)
+    ->Range(64, 4096);
+BENCHMARK(BM_Matmul)
+    ->ArgNames({"batch", "n"})
+    ->ArgsProduct({{1}, {16, 64, 256, 1024}})
+    ->ArgsProduct({{32}, {16, 64}})
+    ->UseRealTime();
+BENCHMARK(BM_MatmulTransposed)->RangeMultiplier(4)->Range(64, 1024);
+BENCHMARK(BM_Accumulate)->RangeMultiplier(8)->Range(1 << 10, 1 << 24);
+BENCHMARK(BM_AccumulateInPlace)->RangeMultiplier(8)->Range(1 << 10, 1 << 24);
+BENCHMARK(BM_MatmulOut)->RangeMultiplier(4)->Range(16, 256);
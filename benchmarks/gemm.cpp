@@ -0,0 +1,44 @@
+#include "gemm.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace {
+auto values(size_t numel) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(static_cast<float>(i));
+  }
+  return out;
+}
+
+// Skinny products (m, n, k), with B read transposed when `range(3)` is set,
+// as a linear layer reads its weight
+auto BM_SgemmSkinny(benchmark::State &state) -> void {
+  const auto m = static_cast<size_t>(state.range(0));
+  const auto n = static_cast<size_t>(state.range(1));
+  const auto k = static_cast<size_t>(state.range(2));
+  const bool transposed = state.range(3) != 0;
+  const std::vector<float> a = values(m * k);
+  const std::vector<float> b = values(k * n);
+  std::vector<float> c(m * n);
+  const size_t rs_b = transposed ? 1 : n;
+  const size_t cs_b = transposed ? k : 1;
+  for (auto _ : state) {
+    synapse::sgemm(m, n, k, a.data(), k, 1, b.data(), rs_b, cs_b, c.data(),
+                   n);
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.counters["FLOPS"] =
+      benchmark::Counter(2.0 * static_cast<double>(m * n * k),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+} // namespace
+
+BENCHMARK(BM_SgemmSkinny)
+    ->ArgNames({"m", "n", "k", "bt"})
+    ->ArgsProduct({{256}, {1}, {1024}, {0, 1}})
+    ->ArgsProduct({{1}, {256}, {1024}, {0, 1}})
+    ->ArgsProduct({{1024}, {2, 4, 8}, {256}, {0, 1}})
+    ->ArgsProduct({{4096}, {1}, {4096}, {0}});
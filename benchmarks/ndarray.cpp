@@ -0,0 +1,174 @@
+#include "ndarray.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace {
+auto BM_NdIndexToPos(benchmark::State &state) -> void {
+  const auto rank = static_cast<size_t>(state.range(0));
+  const synapse::Shape shape(rank, 7);
+  const synapse::Strides strides = synapse::contiguous_strides(shape);
+  synapse::Shape index(rank, 3);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::nd_index_to_pos(index, strides));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+auto BM_PosToNdIndex(benchmark::State &state) -> void {
+  const auto rank = static_cast<size_t>(state.range(0));
+  const synapse::Shape shape(rank, 7);
+  const size_t pos = synapse::shape_numel(shape) / 2;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::pos_to_nd_index(pos, shape));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Broadcasts a rank `n` shape against a rank `n - 1` shape of ones
+auto BM_ShapeBroadcast(benchmark::State &state) -> void {
+  const auto rank = static_cast<size_t>(state.range(0));
+  const synapse::Shape lhs(rank, 5);
+  const synapse::Shape rhs(rank - 1, 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::shape_broadcast(lhs, rhs));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Includes copying the source vector, which the constructor takes by value
+auto BM_TensorFromVector(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const std::vector<float> data(numel, 1.0F);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::Tensor{data, {numel}});
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(numel * sizeof(float)));
+}
+
+auto BM_TensorZeros(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::Tensor::zeros({numel}));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(numel * sizeof(float)));
+}
+
+// Shares the buffer, whatever the size
+auto BM_TensorCopy(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const synapse::Tensor source = synapse::Tensor::zeros({numel});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::Tensor{source});
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(2 * numel * sizeof(float)));
+}
+
+// Copy-on-write: the first write to the copy pays for the elements
+auto BM_TensorCopyThenWrite(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const synapse::Tensor source = synapse::Tensor::zeros({numel});
+  for (auto _ : state) {
+    synapse::Tensor copy{source};
+    copy.data()[0] = 1.0F;
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(2 * numel * sizeof(float)));
+}
+
+// Sums a square matrix element by element, the way custom kernels index
+template <typename Get>
+auto sum_elements(size_t side, Get &&get) -> float {
+  float sum = 0.0F;
+  for (size_t i = 0; i < side; ++i) {
+    for (size_t j = 0; j < side; ++j) {
+      sum += get(i, j);
+    }
+  }
+  return sum;
+}
+
+auto BM_IndexOperator(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::NDArray array = synapse::NDArray::zeros({side, side});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sum_elements(
+        side, [&array](size_t i, size_t j) { return array(i, j); }));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(side * side));
+}
+
+auto BM_IndexAccessor(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::NDArray array = synapse::NDArray::zeros({side, side});
+  for (auto _ : state) {
+    const auto acc = array.accessor<2>();
+    benchmark::DoNotOptimize(
+        sum_elements(side, [&acc](size_t i, size_t j) { return acc(i, j); }));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(side * side));
+}
+
+auto BM_IndexRawPointer(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::NDArray array = synapse::NDArray::zeros({side, side});
+  for (auto _ : state) {
+    const float *data = array.data();
+    benchmark::DoNotOptimize(sum_elements(
+        side, [data, side](size_t i, size_t j) { return data[i * side + j]; }));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(side * side));
+}
+
+// Square matrix with `n` elements per side
+auto BM_ToString(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::Tensor tensor = synapse::Tensor::zeros({side, side});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tensor.to_string());
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(side * side));
+}
+
+// Streams a square matrix with every element shown, without building the
+// whole text in memory
+auto BM_StreamFull(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const synapse::Tensor tensor = synapse::Tensor::zeros({side, side});
+  const synapse::PrintOptions options{.threshold = side * side};
+  size_t bytes = 0;
+  for (auto _ : state) {
+    synapse::write_array(tensor, options, [&bytes](std::string_view chunk) {
+      bytes += chunk.size();
+      benchmark::DoNotOptimize(chunk.data());
+    });
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+} // namespace
+
+BENCHMARK(BM_NdIndexToPos)->DenseRange(1, 8);
+BENCHMARK(BM_PosToNdIndex)->DenseRange(1, 8);
+BENCHMARK(BM_ShapeBroadcast)->DenseRange(1, 8);
+BENCHMARK(BM_TensorFromVector)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+BENCHMARK(BM_TensorZeros)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+BENCHMARK(BM_TensorCopy)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+BENCHMARK(BM_TensorCopyThenWrite)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 24);
+BENCHMARK(BM_IndexOperator)->Arg(256);
+BENCHMARK(BM_IndexAccessor)->Arg(256);
+BENCHMARK(BM_IndexRawPointer)->Arg(256);
+BENCHMARK(BM_ToString)->RangeMultiplier(4)->Range(4, 4096);
+BENCHMARK(BM_StreamFull)->RangeMultiplier(4)->Range(64, 1024);
@@ -0,0 +1,114 @@
+#include "func.h"
+#include "gemm.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+auto values(size_t numel) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(static_cast<float>(i));
+  }
+  return out;
+}
+
+auto make_tensor(const synapse::Shape &shape) -> synapse::Tensor {
+  return synapse::Tensor{values(synapse::shape_numel(shape)), shape};
+}
+
+// MLP block of a batch of tokens, with the epilogue fused into the GEMM
+auto BM_LinearGeluFused(benchmark::State &state) -> void {
+  const auto features = static_cast<size_t>(state.range(0));
+  const synapse::Tensor input = make_tensor({256, features});
+  const synapse::Tensor weight = make_tensor({4 * features, features});
+  const synapse::Tensor bias = make_tensor({4 * features});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::nn::linear(input, weight, &bias,
+                                                 synapse::Activation::Gelu));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(256 * 4 * features * features));
+}
+
+// Same block as separate ops, each a round trip through memory
+auto BM_LinearGeluUnfused(benchmark::State &state) -> void {
+  const auto features = static_cast<size_t>(state.range(0));
+  const synapse::Tensor input = make_tensor({256, features});
+  const synapse::Tensor weight = make_tensor({4 * features, features});
+  const synapse::Tensor bias = make_tensor({4 * features});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::gelu(
+        synapse::add(synapse::matmul(input, weight.transpose(0, 1)), bias)));
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(256 * 4 * features * features));
+}
+
+auto BM_Conv2d(benchmark::State &state) -> void {
+  const auto channels = static_cast<size_t>(state.range(0));
+  const auto kernel = static_cast<size_t>(state.range(1));
+  const synapse::Tensor input = make_tensor({8, channels, 32, 32});
+  const synapse::Tensor weight =
+      make_tensor({channels, channels, kernel, kernel});
+  const synapse::Tensor bias = make_tensor({channels});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::nn::conv2d(
+        input, weight, &bias, 1, kernel / 2, synapse::Activation::Relu));
+  }
+}
+
+auto BM_LayerNorm(benchmark::State &state) -> void {
+  const auto features = static_cast<size_t>(state.range(0));
+  const synapse::Tensor input = make_tensor({1024, features});
+  const synapse::Tensor weight = make_tensor({features});
+  const synapse::Tensor bias = make_tensor({features});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::nn::layer_norm(input, weight, bias));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(2 * 1024 * features *
+                                               sizeof(float)));
+}
+
+// Online softmax over the rows, against max, exp, sum and div as separate
+// passes
+auto BM_SoftmaxFused(benchmark::State &state) -> void {
+  const auto length = static_cast<size_t>(state.range(0));
+  const synapse::Tensor input = make_tensor({1024, length});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::nn::softmax(input, 1));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(2 * 1024 * length *
+                                               sizeof(float)));
+}
+
+auto BM_SoftmaxUnfused(benchmark::State &state) -> void {
+  const auto length = static_cast<size_t>(state.range(0));
+  const synapse::Tensor input = make_tensor({1024, length});
+  for (auto _ : state) {
+    const synapse::Tensor shifted =
+        synapse::exp(synapse::sub(input, synapse::max(input, {1}, true)));
+    benchmark::DoNotOptimize(
+        synapse::div(shifted, synapse::sum(shifted, {1}, true)));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(2 * 1024 * length *
+                                               sizeof(float)));
+}
+} // namespace
+
+BENCHMARK(BM_LinearGeluFused)->RangeMultiplier(2)->Range(128, 512);
+BENCHMARK(BM_LinearGeluUnfused)->RangeMultiplier(2)->Range(128, 512);
+BENCHMARK(BM_Conv2d)
+    ->ArgNames({"channels", "kernel"})
+    ->ArgsProduct({{16, 64}, {1, 3}});
+BENCHMARK(BM_LayerNorm)->RangeMultiplier(4)->Range(256, 4096);
+BENCHMARK(BM_SoftmaxFused)->RangeMultiplier(4)->Range(256, 4096);
+BENCHMARK(BM_SoftmaxUnfused)->RangeMultiplier(4)->Range(256, 4096);
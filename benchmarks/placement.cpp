@@ -0,0 +1,44 @@
+#include "allocator.h"
+#include "func.h"
+#include "parallel.h"
+#include "placement.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace {
+// Bandwidth-bound addition of operands placed by `policy`, -1 standing for
+// the default caching allocator, with the workers pinned by `affinity`
+auto BM_AddPlaced(benchmark::State &state) -> void {
+  const int64_t policy = state.range(0);
+  const auto affinity = static_cast<synapse::ThreadAffinity>(state.range(1));
+  const size_t numel = size_t{1} << 24;
+  const synapse::ThreadAffinity previous = synapse::get_thread_affinity();
+  synapse::set_thread_affinity(affinity);
+  std::optional<synapse::AllocatorGuard> guard;
+  if (policy >= 0) {
+    guard.emplace(std::make_shared<synapse::NumaAllocator>(
+        static_cast<synapse::NumaPolicy>(policy)));
+  }
+  // Zero-filled by the pool, so first-touch pages follow the workers
+  const synapse::Tensor lhs = synapse::Tensor::zeros({numel});
+  const synapse::Tensor rhs = synapse::Tensor::zeros({numel});
+  synapse::Tensor out = synapse::Tensor::zeros({numel});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::add(lhs, rhs, out).raw_data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(numel * 3 * sizeof(float)));
+  synapse::set_thread_affinity(previous);
+}
+} // namespace
+
+// Policies: -1 default, 0 first touch, 1 interleave. Affinity: 0 none,
+// 1 node, 2 core
+BENCHMARK(BM_AddPlaced)
+    ->ArgNames({"policy", "affinity"})
+    ->ArgsProduct({{-1, 0, 1}, {0, 1, 2}})
+    ->UseRealTime();
@@ -0,0 +1,52 @@
+#include "func.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "planner.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <vector>
+
+namespace {
+// Two layer perceptron whose activations are chained element-wise ops
+struct Mlp {
+  synapse::nn::Linear hidden;
+  synapse::nn::Linear output;
+
+  [[nodiscard]] auto forward(const synapse::Tensor &input) const
+      -> synapse::Tensor {
+    synapse::Tensor out = this->hidden(input);
+    out = synapse::relu(out);
+    out = synapse::mul(out, out);
+    return this->output(out);
+  }
+};
+
+auto BM_MlpEager(benchmark::State &state) -> void {
+  const auto batch = static_cast<size_t>(state.range(0));
+  const Mlp mlp{synapse::nn::Linear(256, 1024), synapse::nn::Linear(1024, 256)};
+  const synapse::Tensor input = synapse::Tensor::zeros({batch, 256});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(mlp.forward(input));
+  }
+}
+
+// Same model with every activation served from a planned workspace
+auto BM_MlpPlanned(benchmark::State &state) -> void {
+  const auto batch = static_cast<size_t>(state.range(0));
+  const Mlp mlp{synapse::nn::Linear(256, 1024), synapse::nn::Linear(1024, 256)};
+  const synapse::Tensor input = synapse::Tensor::zeros({batch, 256});
+  const auto forward = [&] { return mlp.forward(input); };
+  synapse::MemoryPlan plan(forward);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(plan.run(forward));
+  }
+  state.counters["workspace_bytes"] =
+      static_cast<double>(plan.workspace_bytes());
+  state.counters["unplanned_bytes"] =
+      static_cast<double>(plan.unplanned_bytes());
+}
+} // namespace
+
+BENCHMARK(BM_MlpEager)->RangeMultiplier(4)->Range(16, 256);
+BENCHMARK(BM_MlpPlanned)->RangeMultiplier(4)->Range(16, 256);
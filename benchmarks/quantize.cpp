@@ -0,0 +1,66 @@
+#include "gemm.h"
+#include "nn.h"
+#include "quantize.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+auto BM_Sgemm(benchmark::State &state) -> void {
+  const auto n = static_cast<size_t>(state.range(0));
+  const std::vector<float> a(n * n, 0.5F);
+  const std::vector<float> b(n * n, 0.25F);
+  std::vector<float> c(n * n);
+  for (auto _ : state) {
+    synapse::sgemm(n, n, n, a.data(), n, 1, b.data(), n, 1, c.data(), n);
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.counters["GOPS"] = benchmark::Counter(
+      2.0 * static_cast<double>(n * n * n),
+      benchmark::Counter::kIsIterationInvariantRate,
+      benchmark::Counter::kIs1000);
+}
+
+auto BM_Igemm(benchmark::State &state) -> void {
+  const auto n = static_cast<size_t>(state.range(0));
+  const std::vector<int8_t> a(n * n, 3);
+  const std::vector<int8_t> b(n * n, -5);
+  std::vector<int32_t> c(n * n);
+  for (auto _ : state) {
+    synapse::igemm(n, n, n, a.data(), n, 1, b.data(), n, 1, c.data(), n);
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.counters["GOPS"] = benchmark::Counter(
+      2.0 * static_cast<double>(n * n * n),
+      benchmark::Counter::kIsIterationInvariantRate,
+      benchmark::Counter::kIs1000);
+}
+
+auto BM_LinearFloat(benchmark::State &state) -> void {
+  const auto batch = static_cast<size_t>(state.range(0));
+  const synapse::nn::Linear layer(1024, 1024);
+  const synapse::Tensor input = synapse::Tensor::zeros({batch, 1024});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(layer(input));
+  }
+}
+
+// Calibrated input range, so no pass computes it at run time
+auto BM_LinearInt8(benchmark::State &state) -> void {
+  const auto batch = static_cast<size_t>(state.range(0));
+  synapse::nn::Linear layer(1024, 1024);
+  const synapse::nn::QuantizedLinear quantized(
+      layer, synapse::QuantParams::from_range(-1.0F, 1.0F));
+  const synapse::Tensor input = synapse::Tensor::zeros({batch, 1024});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(quantized(input));
+  }
+}
+} // namespace
+
+BENCHMARK(BM_Sgemm)->RangeMultiplier(4)->Range(64, 1024);
+BENCHMARK(BM_Igemm)->RangeMultiplier(4)->Range(64, 1024);
+BENCHMARK(BM_LinearFloat)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK(BM_LinearInt8)->RangeMultiplier(4)->Range(1, 256);
@@ -0,0 +1,100 @@
+#include "func.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+auto values(size_t numel) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(static_cast<float>(i));
+  }
+  return out;
+}
+
+auto set_read_bytes(benchmark::State &state, size_t numel) -> void {
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(numel * sizeof(float)));
+}
+
+// Reference: a single accumulator, which the compiler cannot vectorize
+// without reassociating the additions
+auto BM_SumLoop(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const std::vector<float> data = values(numel);
+  for (auto _ : state) {
+    float sum = 0.0F;
+    for (const float value : data) {
+      sum += value;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  set_read_bytes(state, numel);
+}
+
+// Full reductions of a dense vector
+template <auto Op> auto BM_ReduceAll(benchmark::State &state) -> void {
+  const auto numel = static_cast<size_t>(state.range(0));
+  const synapse::Tensor tensor{values(numel), {numel}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Op(tensor, {}, false));
+  }
+  set_read_bytes(state, numel);
+}
+
+// Reduces one dimension of a [n, n] matrix, transposed when `transposed`
+// is set so the reduced elements of an output are not contiguous anymore
+template <auto Op> auto BM_ReduceDim(benchmark::State &state) -> void {
+  const auto side = static_cast<size_t>(state.range(0));
+  const auto dim = static_cast<size_t>(state.range(1));
+  const synapse::Tensor tensor =
+      state.range(2) != 0
+          ? synapse::Tensor{values(side * side), {side, side}}.transpose(0, 1)
+          : synapse::Tensor{values(side * side), {side, side}};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Op(tensor, {dim}, false));
+  }
+  set_read_bytes(state, side * side);
+}
+
+auto sum(const synapse::Tensor &tensor, const std::vector<size_t> &dims,
+         bool keepdim) -> synapse::Tensor {
+  return synapse::sum(tensor, dims, keepdim);
+}
+
+auto max(const synapse::Tensor &tensor, const std::vector<size_t> &dims,
+         bool keepdim) -> synapse::Tensor {
+  return synapse::max(tensor, dims, keepdim);
+}
+
+auto var(const synapse::Tensor &tensor, const std::vector<size_t> &dims,
+         bool keepdim) -> synapse::Tensor {
+  return synapse::var(tensor, dims, keepdim);
+}
+} // namespace
+
+BENCHMARK(BM_SumLoop)->RangeMultiplier(16)->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_ReduceAll<sum>)
+    ->Name("BM_SumAll")
+    ->RangeMultiplier(16)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_ReduceAll<max>)
+    ->Name("BM_MaxAll")
+    ->RangeMultiplier(16)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(BM_ReduceDim<sum>)
+    ->Name("BM_SumDim")
+    ->ArgNames({"n", "dim", "transposed"})
+    ->ArgsProduct({{256, 2048}, {0, 1}, {0, 1}});
+BENCHMARK(BM_ReduceDim<max>)
+    ->Name("BM_MaxDim")
+    ->ArgNames({"n", "dim", "transposed"})
+    ->ArgsProduct({{2048}, {0, 1}, {0}});
+BENCHMARK(BM_ReduceDim<var>)
+    ->Name("BM_VarDim")
+    ->ArgNames({"n", "dim", "transposed"})
+    ->ArgsProduct({{2048}, {0, 1}, {0}});
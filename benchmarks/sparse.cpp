@@ -0,0 +1,50 @@
+#include "func.h"
+#include "ndarray.h"
+#include "sparse.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace {
+// One element in 20 is nonzero, like a pruned weight
+auto make_pruned(size_t rows, size_t cols) -> synapse::Tensor {
+  std::vector<float> out(rows * cols, 0.0F);
+  for (size_t i = 0; i < out.size(); i += 20) {
+    out[i] = std::sin(static_cast<float>(i));
+  }
+  return synapse::Tensor{std::move(out), synapse::Shape{rows, cols}};
+}
+
+auto make_tensor(const synapse::Shape &shape) -> synapse::Tensor {
+  std::vector<float> out(synapse::shape_numel(shape));
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = std::cos(static_cast<float>(i));
+  }
+  return synapse::Tensor{std::move(out), shape};
+}
+
+auto BM_DenseMatmul95(benchmark::State &state) -> void {
+  const auto n = static_cast<size_t>(state.range(0));
+  const synapse::Tensor lhs = make_pruned(n, n);
+  const synapse::Tensor rhs = make_tensor({n, 64});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::matmul(lhs, rhs));
+  }
+}
+
+auto BM_Spmm95(benchmark::State &state) -> void {
+  const auto n = static_cast<size_t>(state.range(0));
+  const synapse::SparseTensor lhs =
+      synapse::SparseTensor::from_dense(make_pruned(n, n));
+  const synapse::Tensor rhs = make_tensor({n, 64});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(synapse::spmm(lhs, rhs));
+  }
+}
+} // namespace
+
+BENCHMARK(BM_DenseMatmul95)->RangeMultiplier(4)->Range(256, 4096);
+BENCHMARK(BM_Spmm95)->RangeMultiplier(4)->Range(256, 4096);
@@ -0,0 +1,47 @@
+#include "func.h"
+#include "static_tensor.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+using Mat3 = synapse::StaticTensor<float, 3, 3>;
+using Vec3 = synapse::StaticTensor<float, 3>;
+
+// Rotates and translates a point, as geometry code does millions of times
+auto BM_TransformStatic(benchmark::State &state) -> void {
+  const Mat3 rotation({0, -1, 0, 1, 0, 0, 0, 0, 1});
+  const Vec3 offset({1, 2, 3});
+  Vec3 point({1, 1, 1});
+  for (auto _ : state) {
+    point = synapse::matmul(rotation, point) + offset;
+    benchmark::DoNotOptimize(point);
+  }
+}
+
+auto BM_TransformTensor(benchmark::State &state) -> void {
+  const synapse::Tensor rotation{
+      std::vector<float>{0, -1, 0, 1, 0, 0, 0, 0, 1}, synapse::Shape{3, 3}};
+  const synapse::Tensor offset{std::vector<float>{1, 2, 3},
+                               synapse::Shape{3}};
+  synapse::Tensor point{std::vector<float>{1, 1, 1}, synapse::Shape{3}};
+  for (auto _ : state) {
+    point = synapse::add(synapse::matmul(rotation, point), offset);
+    benchmark::DoNotOptimize(point);
+  }
+}
+
+auto BM_Matmul4x4Static(benchmark::State &state) -> void {
+  using Mat4 = synapse::StaticTensor<float, 4, 4>;
+  const Mat4 lhs = Mat4::full(0.5F);
+  Mat4 acc = Mat4::full(1.0F);
+  for (auto _ : state) {
+    acc = synapse::matmul(lhs, acc);
+    benchmark::DoNotOptimize(acc);
+  }
+}
+} // namespace
+
+BENCHMARK(BM_TransformStatic);
+BENCHMARK(BM_TransformTensor);
+BENCHMARK(BM_Matmul4x4Static);
@@ -0,0 +1,57 @@
+#include "func.h"
+#include "ndarray.h"
+#include "stream.h"
+#include "tensor.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t BATCHES = 8;
+
+// Stands in for reading and decoding a batch, which mostly waits on I/O
+auto load_batch() -> synapse::Tensor {
+  std::this_thread::sleep_for(std::chrono::microseconds(500));
+  return synapse::Tensor::zeros({128, 256});
+}
+
+auto compute(const synapse::Tensor &batch, const synapse::Tensor &weight)
+    -> synapse::Tensor {
+  return synapse::relu(synapse::matmul(batch, weight));
+}
+
+auto BM_LoadThenCompute(benchmark::State &state) -> void {
+  const synapse::Tensor weight = synapse::Tensor::zeros({256, 256});
+  for (auto _ : state) {
+    for (size_t i = 0; i < BATCHES; ++i) {
+      benchmark::DoNotOptimize(compute(load_batch(), weight));
+    }
+  }
+}
+
+// Batches are loaded on one stream while the previous ones are computed
+auto BM_LoadWhileComputing(benchmark::State &state) -> void {
+  const synapse::Tensor weight = synapse::Tensor::zeros({256, 256});
+  synapse::Stream loader;
+  synapse::Stream worker;
+  for (auto _ : state) {
+    std::vector<synapse::Future<synapse::Tensor>> outputs;
+    outputs.reserve(BATCHES);
+    for (size_t i = 0; i < BATCHES; ++i) {
+      outputs.push_back(worker.submit(
+          [&weight](const synapse::Tensor &batch) {
+            return compute(batch, weight);
+          },
+          loader.submit(load_batch)));
+    }
+    for (const synapse::Future<synapse::Tensor> &out : outputs) {
+      benchmark::DoNotOptimize(out.get());
+    }
+  }
+}
+} // namespace
+
+BENCHMARK(BM_LoadThenCompute)->UseRealTime();
+BENCHMARK(BM_LoadWhileComputing)->UseRealTime();
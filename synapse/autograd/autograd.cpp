@@ -0,0 +1,281 @@
+#include "autograd.h"
+#include "func.h"
+#include "iterator.h"
+#include "ndarray.h"
+#include "reduce.h"
+#include "storage.h"
+#include "tensor.h"
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+thread_local bool grad_mode_enabled = true;
+
+// Adds `grad` into `acc` element by element, in place
+auto accumulate_into(synapse::Tensor &acc, const synapse::Tensor &grad)
+    -> void {
+  synapse::add_(acc, grad);
+}
+
+// Node that must receive the gradient of `tensor`, null if it needs none
+auto gradient_edge(const synapse::Tensor &tensor)
+    -> std::shared_ptr<synapse::Node> {
+  const auto &meta = tensor.autograd_meta();
+  if (!meta) {
+    return nullptr;
+  }
+  if (meta->grad_fn) {
+    return meta->grad_fn;
+  }
+  if (!meta->requires_grad) {
+    return nullptr;
+  }
+  std::shared_ptr<synapse::Node> accumulator = meta->grad_accumulator.lock();
+  if (!accumulator) {
+    accumulator = std::make_shared<synapse::AccumulateGrad>(meta);
+    meta->grad_accumulator = accumulator;
+  }
+  return accumulator;
+}
+
+// Pending gradient of a node. The first gradient to arrive is stored as is,
+// and may alias a buffer owned by someone else, so it is only accumulated in
+// place once the buffer has been replaced by one we own.
+struct InputBuffer {
+  synapse::Tensor grad;
+  bool owned;
+};
+} // namespace
+
+synapse::AutogradMeta::AutogradMeta()
+    : requires_grad(false), grad(nullptr), grad_fn(nullptr),
+      grad_accumulator() {}
+
+synapse::AutogradMeta::~AutogradMeta() = default;
+
+synapse::Node::Node(std::string name,
+                    std::vector<std::shared_ptr<synapse::Node>> next_edges)
+    : _name(std::move(name)), _next_edges(std::move(next_edges)) {}
+
+synapse::Node::~Node() = default;
+
+auto synapse::Node::name() const -> const std::string & { return this->_name; }
+
+auto synapse::Node::next_edges() const
+    -> const std::vector<std::shared_ptr<synapse::Node>> & {
+  return this->_next_edges;
+}
+
+auto synapse::Node::release() -> void {}
+
+synapse::FunctionNode::FunctionNode(
+    std::string name, std::vector<std::shared_ptr<synapse::Node>> next_edges,
+    std::vector<synapse::Tensor> saved, Backward backward)
+    : synapse::Node(std::move(name), std::move(next_edges)),
+      _saved(std::move(saved)), _backward(std::move(backward)),
+      _released(false) {}
+
+auto synapse::FunctionNode::apply(const synapse::Tensor &grad)
+    -> synapse::Node::Gradients {
+  if (this->_released) {
+    throw std::runtime_error(std::format(
+        "Trying to backward through {} a second time, but its saved tensors "
+        "were already freed. Pass retain_graph=true on the first call.",
+        this->name()));
+  }
+  return this->_backward(grad, this->_saved);
+}
+
+auto synapse::FunctionNode::release() -> void {
+  this->_saved.clear();
+  this->_saved.shrink_to_fit();
+  this->_released = true;
+}
+
+synapse::AccumulateGrad::AccumulateGrad(
+    std::shared_ptr<synapse::AutogradMeta> meta)
+    : synapse::Node("AccumulateGrad", {}), _meta(std::move(meta)) {}
+
+auto synapse::AccumulateGrad::apply(const synapse::Tensor &grad)
+    -> synapse::Node::Gradients {
+  if (this->_meta->grad) {
+    accumulate_into(*this->_meta->grad, grad);
+  } else {
+    // The copy shares the graph buffer copy-on-write, so accumulating into
+    // the stored gradient later detaches it instead of writing the graph's
+    this->_meta->grad = std::make_unique<synapse::Tensor>(grad);
+  }
+  return {};
+}
+
+auto synapse::GradMode::is_enabled() -> bool { return grad_mode_enabled; }
+
+auto synapse::GradMode::set_enabled(bool enabled) -> void {
+  grad_mode_enabled = enabled;
+}
+
+synapse::NoGradGuard::NoGradGuard()
+    : _previous(synapse::GradMode::is_enabled()) {
+  synapse::GradMode::set_enabled(false);
+}
+
+synapse::NoGradGuard::~NoGradGuard() {
+  synapse::GradMode::set_enabled(this->_previous);
+}
+
+auto synapse::save_tensor(const synapse::Tensor &tensor) -> synapse::Tensor {
+  const std::shared_ptr<synapse::Storage> &storage = tensor.storage();
+  // Sharing would evaluate a pending storage ahead of its consumers
+  if (storage->pending()) {
+    return tensor.detach();
+  }
+  if (!storage->shareable()) {
+    return synapse::Tensor{static_cast<const synapse::NDArray &>(tensor)};
+  }
+  return synapse::Tensor{synapse::NDArray{storage->share(), tensor.offset(),
+                                          tensor.shape(), tensor.strides()}};
+}
+
+auto synapse::needs_grad(const std::vector<const synapse::Tensor *> &inputs)
+    -> bool {
+  if (!synapse::GradMode::is_enabled()) {
+    return false;
+  }
+  for (const synapse::Tensor *input : inputs) {
+    if (input->requires_grad()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto synapse::record(synapse::Tensor &output, std::string name,
+                     const std::vector<const synapse::Tensor *> &inputs,
+                     std::vector<synapse::Tensor> saved,
+                     synapse::FunctionNode::Backward backward) -> void {
+  if (!synapse::needs_grad(inputs)) {
+    return;
+  }
+  std::vector<std::shared_ptr<synapse::Node>> next_edges;
+  next_edges.reserve(inputs.size());
+  for (const synapse::Tensor *input : inputs) {
+    next_edges.push_back(gradient_edge(*input));
+  }
+  output.set_grad_fn(std::make_shared<synapse::FunctionNode>(
+      std::move(name), std::move(next_edges), std::move(saved),
+      std::move(backward)));
+}
+
+auto synapse::backward(const synapse::Tensor &root,
+                       const synapse::Tensor &grad, bool retain_graph)
+    -> void {
+  if (!root.requires_grad()) {
+    throw std::runtime_error(
+        "Tensor does not require grad and does not have a grad_fn.");
+  }
+  if (root.shape() != grad.shape()) {
+    throw std::runtime_error(
+        std::format("Gradient shape {} does not match tensor shape {}.",
+                    grad.shape(), root.shape()));
+  }
+
+  const std::shared_ptr<synapse::Node> root_node = gradient_edge(root);
+  synapse::NoGradGuard no_grad;
+
+  // Counts, for every reachable node, how many gradients it will receive
+  std::unordered_map<synapse::Node *, size_t> dependencies;
+  std::vector<synapse::Node *> stack{root_node.get()};
+  dependencies[root_node.get()] = 0;
+  while (!stack.empty()) {
+    synapse::Node *node = stack.back();
+    stack.pop_back();
+    for (const auto &next : node->next_edges()) {
+      if (!next) {
+        continue;
+      }
+      const auto [it, inserted] = dependencies.try_emplace(next.get(), 0);
+      ++it->second;
+      if (inserted) {
+        stack.push_back(next.get());
+      }
+    }
+  }
+
+  std::unordered_map<synapse::Node *, InputBuffer> buffers;
+  buffers.emplace(root_node.get(), InputBuffer{grad.detach(), false});
+  std::vector<synapse::Node *> ready{root_node.get()};
+  while (!ready.empty()) {
+    synapse::Node *node = ready.back();
+    ready.pop_back();
+
+    // The incoming gradient is dropped as soon as the node consumed it. A
+    // node may receive none when no consumer produced one, in which case it
+    // is skipped but still unblocks the nodes after it.
+    synapse::Node::Gradients input_grads;
+    const auto buffer = buffers.find(node);
+    if (buffer != buffers.end()) {
+      input_grads = node->apply(buffer->second.grad);
+      buffers.erase(buffer);
+    }
+    if (!retain_graph) {
+      node->release();
+    }
+
+    const auto &next_edges = node->next_edges();
+    for (size_t i = 0; i < next_edges.size(); ++i) {
+      synapse::Node *next = next_edges[i].get();
+      if (next == nullptr) {
+        continue;
+      }
+      if (i < input_grads.size() && input_grads[i]) {
+        auto &input_grad = *input_grads[i];
+        const auto pending = buffers.find(next);
+        if (pending == buffers.end()) {
+          buffers.emplace(next, InputBuffer{std::move(input_grad), false});
+        } else {
+          if (!pending->second.owned) {
+            // A copy through NDArray has a storage of its own, sharing the
+            // buffer copy-on-write, so accumulating detaches the buffer
+            // rather than writing into the tensor the gradient came from
+            pending->second.grad =
+                synapse::Tensor{synapse::NDArray{pending->second.grad}};
+            pending->second.owned = true;
+          }
+          accumulate_into(pending->second.grad, input_grad);
+        }
+      }
+      // Every consumer has run, so the gradient is final
+      if (--dependencies[next] == 0) {
+        ready.push_back(next);
+      }
+    }
+  }
+}
+
+auto synapse::sum_to(const synapse::Tensor &tensor, const synapse::Shape &shape)
+    -> synapse::Tensor {
+  if (tensor.shape() == shape) {
+    return tensor.detach();
+  }
+  // Leading dimensions and dimensions broadcasted from size 1 are summed
+  const size_t lead = tensor.ndim() - shape.size();
+  std::vector<size_t> dims;
+  for (size_t d = 0; d < tensor.ndim(); ++d) {
+    if (d < lead || (shape[d - lead] == 1 && tensor.shape()[d] != 1)) {
+      dims.push_back(d);
+    }
+  }
+  if (dims.empty()) {
+    return synapse::Tensor{tensor.NDArray::reshape(shape)};
+  }
+  return synapse::Tensor{
+      synapse::reduce(tensor, synapse::ReduceOp::Sum, dims, true)
+          .reshape(shape)};
+}
@@ -0,0 +1,408 @@
+#include "data.h"
+#include "dtype.h"
+#include "mapped_file.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+auto synapse::data::Field::bytes() const -> size_t {
+  return synapse::shape_numel(this->shape) * synapse::dtype_size(this->dtype);
+}
+
+synapse::data::TensorDataset::TensorDataset(std::vector<Tensor> tensors)
+    : _tensors(), _fields() {
+  if (tensors.empty()) {
+    throw std::invalid_argument("A tensor dataset needs at least one tensor.");
+  }
+  for (const Tensor &tensor : tensors) {
+    if (tensor.ndim() == 0) {
+      throw std::invalid_argument(
+          "The first dimension of the tensors must index the samples.");
+    }
+    if (tensor.shape()[0] != tensors[0].shape()[0]) {
+      throw std::invalid_argument(std::format(
+          "Tensors of shapes {} and {} hold a different number of samples.",
+          tensors[0].shape(), tensor.shape()));
+    }
+    const Shape &shape = tensor.shape();
+    this->_fields.push_back({Shape(shape.begin() + 1, shape.end()),
+                             tensor.dtype()});
+    this->_tensors.push_back(tensor.eval().contiguous());
+  }
+}
+
+auto synapse::data::TensorDataset::size() const -> size_t {
+  return this->_tensors[0].shape()[0];
+}
+
+auto synapse::data::TensorDataset::fields() const
+    -> const std::vector<Field> & {
+  return this->_fields;
+}
+
+auto synapse::data::TensorDataset::read(size_t index,
+                                        std::span<void *const> out) const
+    -> void {
+  for (size_t i = 0; i < this->_tensors.size(); ++i) {
+    const size_t bytes = this->_fields[i].bytes();
+    std::memcpy(out[i],
+                static_cast<const std::byte *>(this->_tensors[i].raw_data()) +
+                    index * bytes,
+                bytes);
+  }
+}
+
+synapse::data::MappedDataset::MappedDataset(const std::filesystem::path &path,
+                                            std::vector<Field> fields,
+                                            size_t offset)
+    : _file(std::make_shared<MappedFile>(path)), _fields(std::move(fields)),
+      _offset(offset), _record_bytes(0), _size(0) {
+  if (this->_fields.empty()) {
+    throw std::invalid_argument("A mapped dataset needs at least one field.");
+  }
+  for (const Field &field : this->_fields) {
+    this->_record_bytes += field.bytes();
+  }
+  const size_t file_bytes = this->_file->size();
+  if (this->_record_bytes == 0 || offset > file_bytes ||
+      (file_bytes - offset) % this->_record_bytes != 0) {
+    throw std::invalid_argument(std::format(
+        "{} does not hold whole records of {} bytes after byte {}.",
+        path.string(), this->_record_bytes, offset));
+  }
+  this->_size = (file_bytes - offset) / this->_record_bytes;
+}
+
+auto synapse::data::MappedDataset::size() const -> size_t {
+  return this->_size;
+}
+
+auto synapse::data::MappedDataset::fields() const
+    -> const std::vector<Field> & {
+  return this->_fields;
+}
+
+auto synapse::data::MappedDataset::read(size_t index,
+                                        std::span<void *const> out) const
+    -> void {
+  const std::byte *record =
+      this->_file->data() + this->_offset + index * this->_record_bytes;
+  for (size_t i = 0; i < this->_fields.size(); ++i) {
+    const size_t bytes = this->_fields[i].bytes();
+    std::memcpy(out[i], record, bytes);
+    record += bytes;
+  }
+}
+
+/**
+ * @brief State shared by a loader, its workers and its live batches.
+ *
+ * @details Batches of the current epoch are claimed in order, each into a
+ * free slot, that is a set of batch buffers. `epoch` tells results of an
+ * epoch dropped by `reset` apart, their slot is freed instead of being
+ * handed out.
+ */
+class synapse::data::LoaderState {
+public:
+  struct Loaded {
+    size_t slot;
+    size_t samples;
+    std::exception_ptr error;
+  };
+
+  // Batch claimed by a worker, or by `next` without workers
+  struct Claim {
+    size_t batch;
+    size_t slot;
+    size_t epoch;
+    std::vector<size_t> indices;
+  };
+
+  const std::shared_ptr<const Dataset> dataset;
+  const LoaderOptions options;
+  const size_t num_batches;
+  // Per slot, one buffer per field
+  std::vector<std::vector<Tensor>> buffers;
+
+  std::mutex mutex;
+  std::condition_variable work_cv;
+  std::condition_variable ready_cv;
+  std::vector<size_t> order;
+  size_t epoch;
+  // Next batch to be claimed, and to be returned by `next`
+  size_t claimed;
+  size_t consumed;
+  // Batches being read, of any epoch
+  size_t in_flight;
+  std::vector<size_t> free_slots;
+  std::map<size_t, Loaded> ready;
+  bool stop;
+
+  LoaderState(std::shared_ptr<const Dataset> source, LoaderOptions config)
+      : dataset(std::move(source)), options(config),
+        num_batches(LoaderState::_num_batches(*this->dataset, config)),
+        buffers(), mutex(), work_cv(), ready_cv(),
+        order(this->dataset->size()), epoch(0), claimed(0), consumed(0),
+        in_flight(0), free_slots(), ready(), stop(false) {
+    for (size_t slot = 0; slot < config.prefetch; ++slot) {
+      std::vector<Tensor> &slot_buffers = this->buffers.emplace_back();
+      for (const Field &field : this->dataset->fields()) {
+        Shape shape{config.batch_size};
+        shape.insert(shape.end(), field.shape.begin(), field.shape.end());
+        slot_buffers.push_back(Tensor::empty(shape, field.dtype));
+      }
+      this->free_slots.push_back(config.prefetch - 1 - slot);
+    }
+    std::iota(this->order.begin(), this->order.end(), 0);
+    this->_shuffle();
+  }
+
+  // Starts a new epoch, the caller holding the lock
+  auto restart() -> void {
+    ++this->epoch;
+    this->claimed = 0;
+    this->consumed = 0;
+    for (const auto &[batch, loaded] : this->ready) {
+      this->free_slots.push_back(loaded.slot);
+    }
+    this->ready.clear();
+    this->_shuffle();
+    this->work_cv.notify_all();
+  }
+
+  // Takes the next batch and a free slot, the caller holding the lock
+  auto claim() -> Claim {
+    const size_t batch = this->claimed++;
+    const size_t slot = this->free_slots.back();
+    this->free_slots.pop_back();
+    ++this->in_flight;
+    const size_t begin = batch * this->options.batch_size;
+    const size_t end =
+        std::min(begin + this->options.batch_size, this->order.size());
+    return {batch, slot, this->epoch,
+            std::vector<size_t>(this->order.begin() + static_cast<long>(begin),
+                                this->order.begin() + static_cast<long>(end))};
+  }
+
+  // Collates the samples of `claim` into its slot, without the lock
+  auto fill(const Claim &claim) -> void {
+    std::vector<std::byte *> rows;
+    std::vector<size_t> row_bytes;
+    for (size_t i = 0; i < this->buffers[claim.slot].size(); ++i) {
+      rows.push_back(
+          static_cast<std::byte *>(this->buffers[claim.slot][i].raw_data()));
+      row_bytes.push_back(this->dataset->fields()[i].bytes());
+    }
+    std::vector<void *> out(rows.size());
+    for (const size_t index : claim.indices) {
+      std::copy(rows.begin(), rows.end(), out.begin());
+      this->dataset->read(index, out);
+      for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] += row_bytes[i];
+      }
+    }
+  }
+
+  // Publishes a filled claim, the caller holding the lock
+  auto finish(const Claim &claim, std::exception_ptr error) -> void {
+    --this->in_flight;
+    if (claim.epoch != this->epoch) {
+      this->free_slots.push_back(claim.slot);
+      this->work_cv.notify_one();
+    } else {
+      this->ready.emplace(claim.batch, Loaded{claim.slot, claim.indices.size(),
+                                              std::move(error)});
+    }
+    this->ready_cv.notify_all();
+  }
+
+  auto release(size_t slot) -> void {
+    {
+      const std::lock_guard<std::mutex> lock(this->mutex);
+      this->free_slots.push_back(slot);
+    }
+    this->work_cv.notify_one();
+    this->ready_cv.notify_all();
+  }
+
+  auto work() -> void {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+      this->work_cv.wait(lock, [this] {
+        return this->stop || (this->claimed < this->num_batches &&
+                              !this->free_slots.empty());
+      });
+      if (this->stop) {
+        return;
+      }
+      const Claim claim = this->claim();
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        this->fill(claim);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      this->finish(claim, std::move(error));
+    }
+  }
+
+private:
+  static auto _num_batches(const Dataset &dataset, const LoaderOptions &config)
+      -> size_t {
+    if (config.batch_size == 0 || config.prefetch == 0) {
+      throw std::invalid_argument(
+          "The batch size and the number of prefetched batches must be "
+          "positive.");
+    }
+    return config.drop_last
+               ? dataset.size() / config.batch_size
+               : (dataset.size() + config.batch_size - 1) / config.batch_size;
+  }
+
+  auto _shuffle() -> void {
+    if (this->options.shuffle) {
+      std::mt19937_64 engine(this->options.seed + this->epoch);
+      std::ranges::shuffle(this->order, engine);
+    }
+  }
+};
+
+synapse::data::Batch::Batch(std::shared_ptr<LoaderState> state, size_t slot,
+                            std::vector<Tensor> tensors)
+    : _state(std::move(state)), _slot(slot), _tensors(std::move(tensors)) {}
+
+synapse::data::Batch::Batch(Batch &&other) noexcept
+    : _state(std::move(other._state)), _slot(other._slot),
+      _tensors(std::move(other._tensors)) {}
+
+auto synapse::data::Batch::operator=(Batch &&other) noexcept -> Batch & {
+  if (this != &other) {
+    this->_release();
+    this->_state = std::move(other._state);
+    this->_slot = other._slot;
+    this->_tensors = std::move(other._tensors);
+  }
+  return *this;
+}
+
+synapse::data::Batch::~Batch() { this->_release(); }
+
+auto synapse::data::Batch::_release() -> void {
+  if (this->_state != nullptr) {
+    this->_tensors.clear();
+    this->_state->release(this->_slot);
+    this->_state.reset();
+  }
+}
+
+auto synapse::data::Batch::size() const -> size_t {
+  return this->_tensors[0].shape()[0];
+}
+
+auto synapse::data::Batch::operator[](size_t field) const -> const Tensor & {
+  return this->_tensors.at(field);
+}
+
+auto synapse::data::Batch::tensors() const -> const std::vector<Tensor> & {
+  return this->_tensors;
+}
+
+synapse::data::DataLoader::DataLoader(std::shared_ptr<const Dataset> dataset,
+                                      LoaderOptions options)
+    : _state(std::make_shared<LoaderState>(std::move(dataset), options)),
+      _workers() {
+  for (size_t i = 0; i < options.num_workers; ++i) {
+    this->_workers.emplace_back([state = this->_state] { state->work(); });
+  }
+}
+
+synapse::data::DataLoader::~DataLoader() {
+  {
+    const std::lock_guard<std::mutex> lock(this->_state->mutex);
+    this->_state->stop = true;
+  }
+  this->_state->work_cv.notify_all();
+  for (std::thread &worker : this->_workers) {
+    worker.join();
+  }
+}
+
+auto synapse::data::DataLoader::next() -> std::optional<Batch> {
+  LoaderState &state = *this->_state;
+  std::unique_lock<std::mutex> lock(state.mutex);
+  if (state.consumed == state.num_batches) {
+    return std::nullopt;
+  }
+  const size_t batch = state.consumed;
+  if (this->_workers.empty() && state.free_slots.empty()) {
+    throw std::logic_error(
+        "Every set of batch buffers is held by a live batch.");
+  }
+  if (this->_workers.empty()) {
+    const LoaderState::Claim claim = state.claim();
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      state.fill(claim);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    state.finish(claim, std::move(error));
+  }
+  // Stuck when the batch waits for a slot only a live batch can free
+  state.ready_cv.wait(lock, [&state, batch] {
+    return state.ready.contains(batch) ||
+           (state.claimed == batch && state.free_slots.empty() &&
+            state.in_flight == 0);
+  });
+  const auto it = state.ready.find(batch);
+  if (it == state.ready.end()) {
+    throw std::logic_error(
+        "Every set of batch buffers is held by a live batch.");
+  }
+  const LoaderState::Loaded loaded = it->second;
+  state.ready.erase(it);
+  ++state.consumed;
+  if (loaded.error != nullptr) {
+    state.free_slots.push_back(loaded.slot);
+    state.work_cv.notify_one();
+    std::rethrow_exception(loaded.error);
+  }
+  lock.unlock();
+
+  std::vector<Tensor> tensors;
+  for (const Tensor &buffer : state.buffers[loaded.slot]) {
+    tensors.push_back(buffer.slice(0, 0, loaded.samples));
+  }
+  return Batch(this->_state, loaded.slot, std::move(tensors));
+}
+
+auto synapse::data::DataLoader::reset() -> void {
+  const std::lock_guard<std::mutex> lock(this->_state->mutex);
+  this->_state->restart();
+}
+
+auto synapse::data::DataLoader::num_batches() const -> size_t {
+  return this->_state->num_batches;
+}
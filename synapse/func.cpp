@@ -1,63 +1,1170 @@
 #include "func.h"
+#include "autograd.h"
+#include "dtype.h"
+#include "elementwise.h"
+#include "gemm.h"
+#include "iterator.h"
+#include "lazy.h"
 #include "ndarray.h"
+#include "parallel.h"
+#include "planner.h"
+#include "profiler.h"
+#include "reduce.h"
 #include "tensor.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <format>
+#include <initializer_list>
+#include <numbers>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
+namespace {
+using Saved = std::vector<synapse::Tensor>;
+using Gradients = synapse::Node::Gradients;
+
+// Inner loop of the Float32 binary ops of the backward formulas. Dense runs
+// and runs where one side is a broadcasted scalar get their own branch so the
+// compiler can vectorize them.
+template <typename T, typename Op>
+auto binary_loop(Op op) {
+  return [op](T *out, const T *const *in, const size_t *strides, size_t n) {
+    const T *lhs = in[0];
+    const T *rhs = in[1];
+    if (strides[0] == 1 && strides[1] == 1 && strides[2] == 1) {
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = op(lhs[i], rhs[i]);
+      }
+    } else if (strides[0] == 1 && strides[1] == 1 && strides[2] == 0) {
+      const T scalar = *rhs;
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = op(lhs[i], scalar);
+      }
+    } else if (strides[0] == 1 && strides[1] == 0 && strides[2] == 1) {
+      const T scalar = *lhs;
+      for (size_t i = 0; i < n; ++i) {
+        out[i] = op(scalar, rhs[i]);
+      }
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        out[i * strides[0]] = op(lhs[i * strides[1]], rhs[i * strides[2]]);
+      }
+    }
+  };
+}
+
+// Float32 kernel over arbitrary operands, used by the backward formulas
+template <typename Op>
+auto binary_op(const synapse::Tensor &tensor_1,
+               const synapse::Tensor &tensor_2, Op op) -> synapse::Tensor {
+  const synapse::Shape shape =
+      synapse::shape_broadcast(tensor_1.shape(), tensor_2.shape());
+  const synapse::NDArray lhs = tensor_1.NDArray::to(synapse::DType::Float32);
+  const synapse::NDArray rhs = tensor_2.NDArray::to(synapse::DType::Float32);
+  synapse::Tensor tensor_3 = synapse::Tensor::empty(shape);
+  const synapse::TensorIterator iter(tensor_3, {&lhs, &rhs});
+  iter.parallel_for_each(binary_loop<float>(op));
+  return tensor_3;
+}
+
+// Dtype an element-wise op computes and returns its result in
+auto result_dtype(synapse::ElementwiseOp op, synapse::DType dtype)
+    -> synapse::DType {
+  if (synapse::is_floating_point_op(op) && !synapse::is_floating_point(dtype)) {
+    return synapse::DType::Float32;
+  }
+  return dtype;
+}
+
+// Output of an element-wise forward op, which a memory plan may place over
+// an operand read for the last time
+auto elementwise_output(
+    const synapse::Shape &shape, synapse::DType dtype,
+    std::initializer_list<const synapse::NDArray *> operands)
+    -> synapse::Tensor {
+  const synapse::InplaceHint hint(operands, shape, dtype);
+  return synapse::Tensor::empty(shape, dtype);
+}
+
+// Kernel of `op` over `dtype` for the current CPU level
+auto elementwise_kernel(synapse::ElementwiseOp op, synapse::DType dtype)
+    -> synapse::ElementwiseKernel {
+  const synapse::ElementwiseKernel kernel =
+      synapse::elementwise_kernels().find(op, dtype);
+  if (kernel == nullptr) {
+    throw std::logic_error(
+        std::format("No element-wise kernel registered for {}.",
+                    synapse::dtype_name(dtype)));
+  }
+  return kernel;
+}
+
+// Runs the kernel of `Op` over operands already converted to the dtype of
+// `out`, which may alias them at the same index only
+template <synapse::ElementwiseOp Op>
+auto run_binary(const synapse::NDArray &lhs, const synapse::NDArray &rhs,
+                synapse::NDArray &out) -> void {
+  const synapse::TensorIterator iter(out, {&lhs, &rhs});
+  synapse::dispatch(out.dtype(), [&iter, kernel = elementwise_kernel(
+                                             Op, out.dtype())](auto tag) {
+    using T = typename decltype(tag)::type;
+    iter.parallel_for_each<T>([kernel](T *dst, const T *const *in,
+                                       const size_t *strides, size_t n) {
+      const std::array<const void *, 2> operands{in[0], in[1]};
+      kernel(dst, operands.data(), strides, n);
+    });
+  });
+}
+
+template <synapse::ElementwiseOp Op>
+auto run_unary(const synapse::NDArray &src, synapse::NDArray &out) -> void {
+  const synapse::TensorIterator iter(out, {&src});
+  synapse::dispatch(out.dtype(), [&iter, kernel = elementwise_kernel(
+                                             Op, out.dtype())](auto tag) {
+    using T = typename decltype(tag)::type;
+    iter.parallel_for_each<T>([kernel](T *dst, const T *const *in,
+                                       const size_t *strides, size_t n) {
+      const std::array<const void *, 1> operands{in[0]};
+      kernel(dst, operands.data(), strides, n);
+    });
+  });
+}
+
+// Forward pass of the element-wise ops of func.h, deferred in lazy mode.
+// Operands are converted to the promoted dtype and run through the kernel
+// registry, which computes every dtype in its `compute_type_t`.
+template <synapse::ElementwiseOp Op>
+auto binary_op(const synapse::Tensor &tensor_1,
+               const synapse::Tensor &tensor_2) -> synapse::Tensor {
+  const synapse::DType dtype = result_dtype(
+      Op, synapse::promote_types(tensor_1.dtype(), tensor_2.dtype()));
+  if (synapse::LazyMode::is_enabled() &&
+      tensor_1.dtype() == synapse::DType::Float32 &&
+      tensor_2.dtype() == synapse::DType::Float32) {
+    return synapse::Tensor{
+        synapse::lazy_elementwise(Op, {&tensor_1, &tensor_2})};
+  }
+  const synapse::Shape shape =
+      synapse::shape_broadcast(tensor_1.shape(), tensor_2.shape());
+  const synapse::NDArray lhs = tensor_1.NDArray::to(dtype);
+  const synapse::NDArray rhs = tensor_2.NDArray::to(dtype);
+  synapse::Tensor tensor_3 = elementwise_output(shape, dtype, {&lhs, &rhs});
+  run_binary<Op>(lhs, rhs, tensor_3);
+  return tensor_3;
+}
+
+template <synapse::ElementwiseOp Op>
+auto unary_op(const synapse::Tensor &tensor) -> synapse::Tensor {
+  const synapse::DType dtype = result_dtype(Op, tensor.dtype());
+  if (synapse::LazyMode::is_enabled() &&
+      tensor.dtype() == synapse::DType::Float32) {
+    return synapse::Tensor{synapse::lazy_elementwise(Op, {&tensor})};
+  }
+  const synapse::NDArray src = tensor.NDArray::to(dtype);
+  synapse::Tensor out = elementwise_output(tensor.shape(), dtype, {&src});
+  run_unary<Op>(src, out);
+  return out;
+}
+
+// Whether writing `out` may change elements of `input` before they are read,
+// that is when they overlap in the same storage without being the same view.
+// An element-wise kernel reads each element before writing the same index,
+// so an operand that is exactly `out` is safe.
+auto overlaps(const synapse::NDArray &out, const synapse::NDArray &input)
+    -> bool {
+  if (out.storage() != input.storage() || out.size() == 0 ||
+      input.size() == 0) {
+    return false;
+  }
+  if (out.offset() == input.offset() && out.shape() == input.shape() &&
+      out.strides() == input.strides()) {
+    return false;
+  }
+  // Ranges of elements the views span
+  const auto last = [](const synapse::NDArray &array) {
+    size_t pos = array.offset();
+    for (size_t i = 0; i < array.ndim(); ++i) {
+      pos += (array.shape()[i] - 1) * array.strides()[i];
+    }
+    return pos;
+  };
+  return out.offset() <= last(input) && input.offset() <= last(out);
+}
+
+// Out and in-place variants are never recorded, see func.h
+auto check_not_recorded(const char *name, const synapse::Tensor &out,
+                        std::initializer_list<const synapse::Tensor *> inputs)
+    -> void {
+  std::vector<const synapse::Tensor *> tensors(inputs);
+  tensors.push_back(&out);
+  if (synapse::needs_grad(tensors)) {
+    throw std::logic_error(std::format(
+        "The out and in-place variants of {} are not differentiable.", name));
+  }
+}
+
+auto check_out(const char *name, const synapse::Tensor &out,
+               const synapse::Shape &shape, synapse::DType dtype) -> void {
+  if (out.shape() != shape || out.dtype() != dtype) {
+    throw std::invalid_argument(std::format(
+        "{} writes a {} tensor of shape {}, found a {} output of shape {}.",
+        name, synapse::dtype_name(dtype), shape,
+        synapse::dtype_name(out.dtype()), out.shape()));
+  }
+  for (size_t i = 0; i < out.ndim(); ++i) {
+    if (out.strides()[i] == 0 && out.shape()[i] > 1) {
+      throw std::invalid_argument(
+          std::format("{} cannot write into a broadcasted view.", name));
+    }
+  }
+}
+
+// Out variant of the element-wise ops, evaluated eagerly in any mode. An
+// output overlapping an operand is computed into a temporary first.
+template <synapse::ElementwiseOp Op>
+auto binary_op(const char *name, const synapse::Tensor &tensor_1,
+               const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  synapse::ProfileScope profile(name, {&tensor_1, &tensor_2});
+  const synapse::DType dtype = result_dtype(
+      Op, synapse::promote_types(tensor_1.dtype(), tensor_2.dtype()));
+  check_not_recorded(name, out, {&tensor_1, &tensor_2});
+  check_out(name, out,
+            synapse::shape_broadcast(tensor_1.shape(), tensor_2.shape()),
+            dtype);
+  const synapse::NDArray lhs = tensor_1.NDArray::to(dtype);
+  const synapse::NDArray rhs = tensor_2.NDArray::to(dtype);
+  if (overlaps(out, lhs) || overlaps(out, rhs)) {
+    synapse::NDArray staged = synapse::NDArray::empty(out.shape(), dtype);
+    run_binary<Op>(lhs, rhs, staged);
+    out.copy_(staged);
+  } else {
+    run_binary<Op>(lhs, rhs, out);
+  }
+  profile.set_output(out);
+  return out;
+}
+
+template <synapse::ElementwiseOp Op>
+auto unary_op(const char *name, const synapse::Tensor &tensor,
+              synapse::Tensor &out) -> synapse::Tensor & {
+  synapse::ProfileScope profile(name, {&tensor});
+  const synapse::DType dtype = result_dtype(Op, tensor.dtype());
+  check_not_recorded(name, out, {&tensor});
+  check_out(name, out, tensor.shape(), dtype);
+  const synapse::NDArray src = tensor.NDArray::to(dtype);
+  if (overlaps(out, src)) {
+    synapse::NDArray staged = synapse::NDArray::empty(out.shape(), dtype);
+    run_unary<Op>(src, staged);
+    out.copy_(staged);
+  } else {
+    run_unary<Op>(src, out);
+  }
+  profile.set_output(out);
+  return out;
+}
+
+// Reference product for the dtypes sgemm does not cover, accumulating in
+// the compute type of `T`
+template <typename T>
+auto typed_gemm(size_t m, size_t n, size_t k, const T *a, size_t rs_a,
+                size_t cs_a, const T *b, size_t rs_b, size_t cs_b, T *c,
+                size_t ldc) -> void {
+  using C = synapse::compute_type_t<T>;
+  std::vector<C> row(n);
+  for (size_t i = 0; i < m; ++i) {
+    std::fill(row.begin(), row.end(), C{0});
+    for (size_t p = 0; p < k; ++p) {
+      const C scale = synapse::scalar_cast<C>(a[(i * rs_a) + (p * cs_a)]);
+      const T *b_row = b + (p * rs_b);
+      for (size_t j = 0; j < n; ++j) {
+        row[j] += scale * synapse::scalar_cast<C>(b_row[j * cs_b]);
+      }
+    }
+    for (size_t j = 0; j < n; ++j) {
+      c[(i * ldc) + j] = synapse::scalar_cast<T>(row[j]);
+    }
+  }
+}
+
+template <typename T>
+auto all_close(const T *lhs, const T *rhs, size_t numel, T tol) -> bool {
+  return synapse::parallel_reduce(
+      0, numel, synapse::GRAIN_SIZE, true,
+      [lhs, rhs, tol](size_t begin, size_t end, bool close) {
+        for (size_t i = begin; close && i < end; ++i) {
+          close = !(std::fabs(lhs[i] - rhs[i]) > tol);
+        }
+        return close;
+      },
+      [](bool lhs_close, bool rhs_close) { return lhs_close && rhs_close; });
+}
+
+// Gradient of a reduction over `dims` broadcasted back to the input `shape`
+auto expand_grad(const synapse::Tensor &grad, const synapse::Shape &shape,
+                 const std::vector<size_t> &dims) -> synapse::Tensor {
+  return synapse::Tensor{
+      grad.NDArray::reshape(synapse::reduced_shape(shape, dims, true))
+          .expand(shape)
+          .contiguous()};
+}
+
+// Backward of max and min: the gradient goes to the elements equal to the
+// extremum, split evenly between ties
+auto extremum_backward(const synapse::Tensor &grad, const Saved &saved,
+                       const synapse::Shape &shape,
+                       const std::vector<size_t> &dims) -> Gradients {
+  const synapse::Shape kept = synapse::reduced_shape(shape, dims, true);
+  const synapse::Tensor mask =
+      binary_op(saved[0], saved[1].reshape(kept),
+                [](float x, float best) { return x == best ? 1.0F : 0.0F; });
+  const synapse::Tensor ties{
+      synapse::reduce(mask, synapse::ReduceOp::Sum, dims, true)};
+  return synapse::make_gradients(
+      synapse::mul(mask, synapse::div(grad.reshape(kept), ties)));
+}
+} // namespace
+
 auto synapse::add(const synapse::Tensor &tensor_1,
                   const synapse::Tensor &tensor_2) -> synapse::Tensor {
-  if (tensor_1.size() != tensor_2.size()) {
-    throw std::invalid_argument("Tensor sizes do not match");
+  synapse::ProfileScope profile("add", {&tensor_1, &tensor_2});
+  synapse::Tensor tensor_3 =
+      binary_op<synapse::ElementwiseOp::Add>(tensor_1, tensor_2);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "AddBackward", {&tensor_1, &tensor_2}, {},
+        [shape_1 = tensor_1.shape(), shape_2 = tensor_2.shape()](
+            const synapse::Tensor &grad, const Saved &) -> Gradients {
+          return synapse::make_gradients(synapse::sum_to(grad, shape_1),
+                                         synapse::sum_to(grad, shape_2));
+        });
   }
+  profile.set_output(tensor_3);
+  return tensor_3;
+}
 
-  Tensor tensor_3{std::vector<float>(tensor_1.size()), tensor_1.shape()};
-  for (size_t i = 0; i < tensor_1.size(); i++) {
-    tensor_3.data()[i] = tensor_1.data()[i] + tensor_2.data()[i];
+auto synapse::sub(const synapse::Tensor &tensor_1,
+                  const synapse::Tensor &tensor_2) -> synapse::Tensor {
+  synapse::ProfileScope profile("sub", {&tensor_1, &tensor_2});
+  synapse::Tensor tensor_3 =
+      binary_op<synapse::ElementwiseOp::Sub>(tensor_1, tensor_2);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "SubBackward", {&tensor_1, &tensor_2}, {},
+        [shape_1 = tensor_1.shape(), shape_2 = tensor_2.shape()](
+            const synapse::Tensor &grad, const Saved &) -> Gradients {
+          return synapse::make_gradients(
+              synapse::sum_to(grad, shape_1),
+              synapse::sum_to(synapse::neg(grad), shape_2));
+        });
   }
+  profile.set_output(tensor_3);
   return tensor_3;
 }
 
 auto synapse::mul(const synapse::Tensor &tensor_1,
                   const synapse::Tensor &tensor_2) -> synapse::Tensor {
-  if (tensor_1.size() != tensor_2.size()) {
-    throw std::invalid_argument("Tensor sizes do not match");
+  synapse::ProfileScope profile("mul", {&tensor_1, &tensor_2});
+  synapse::Tensor tensor_3 =
+      binary_op<synapse::ElementwiseOp::Mul>(tensor_1, tensor_2);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "MulBackward", {&tensor_1, &tensor_2},
+        synapse::save_for_backward(tensor_1, tensor_2),
+        [shape_1 = tensor_1.shape(), shape_2 = tensor_2.shape()](
+            const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(
+              synapse::sum_to(synapse::mul(grad, saved[1]), shape_1),
+              synapse::sum_to(synapse::mul(grad, saved[0]), shape_2));
+        });
   }
+  profile.set_output(tensor_3);
+  return tensor_3;
+}
 
-  Tensor tensor_3{std::vector<float>(tensor_1.size()), tensor_1.shape()};
-  for (size_t i = 0; i < tensor_1.size(); i++) {
-    tensor_3.data()[i] = tensor_1.data()[i] * tensor_2.data()[i];
+auto synapse::div(const synapse::Tensor &tensor_1,
+                  const synapse::Tensor &tensor_2) -> synapse::Tensor {
+  synapse::ProfileScope profile("div", {&tensor_1, &tensor_2});
+  synapse::Tensor tensor_3 =
+      binary_op<synapse::ElementwiseOp::Div>(tensor_1, tensor_2);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "DivBackward", {&tensor_1, &tensor_2},
+        synapse::save_for_backward(tensor_1, tensor_2),
+        [shape_1 = tensor_1.shape(), shape_2 = tensor_2.shape()](
+            const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          // d(a / b)/db = -a / b^2
+          const synapse::Tensor scaled = synapse::div(grad, saved[1]);
+          return synapse::make_gradients(
+              synapse::sum_to(scaled, shape_1),
+              synapse::sum_to(synapse::neg(synapse::div(
+                                  synapse::mul(scaled, saved[0]), saved[1])),
+                              shape_2));
+        });
   }
+  profile.set_output(tensor_3);
   return tensor_3;
 }
 
-auto synapse::matmul(const synapse::Tensor &tensor_1,
-                     const synapse::Tensor &tensor_2) -> synapse::Tensor {
-  if (tensor_1.shape()[tensor_1.shape().size() - 1] != tensor_2.shape()[0]) {
+auto synapse::maximum(const synapse::Tensor &tensor_1,
+                      const synapse::Tensor &tensor_2) -> synapse::Tensor {
+  synapse::ProfileScope profile("maximum", {&tensor_1, &tensor_2});
+  synapse::Tensor tensor_3 =
+      binary_op<synapse::ElementwiseOp::Maximum>(tensor_1, tensor_2);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "MaximumBackward", {&tensor_1, &tensor_2},
+        synapse::save_for_backward(tensor_1, tensor_2),
+        [shape_1 = tensor_1.shape(), shape_2 = tensor_2.shape()](
+            const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          // Ties send the whole gradient to the first operand
+          const synapse::Tensor first = binary_op(
+              saved[0], saved[1],
+              [](float lhs, float rhs) { return lhs >= rhs ? 1.0F : 0.0F; });
+          const synapse::Tensor second = binary_op(
+              saved[0], saved[1],
+              [](float lhs, float rhs) { return lhs >= rhs ? 0.0F : 1.0F; });
+          return synapse::make_gradients(
+              synapse::sum_to(synapse::mul(grad, first), shape_1),
+              synapse::sum_to(synapse::mul(grad, second), shape_2));
+        });
+  }
+  profile.set_output(tensor_3);
+  return tensor_3;
+}
+
+auto synapse::minimum(const synapse::Tensor &tensor_1,
+                      const synapse::Tensor &tensor_2) -> synapse::Tensor {
+  synapse::ProfileScope profile("minimum", {&tensor_1, &tensor_2});
+  synapse::Tensor tensor_3 =
+      binary_op<synapse::ElementwiseOp::Minimum>(tensor_1, tensor_2);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "MinimumBackward", {&tensor_1, &tensor_2},
+        synapse::save_for_backward(tensor_1, tensor_2),
+        [shape_1 = tensor_1.shape(), shape_2 = tensor_2.shape()](
+            const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          // Ties send the whole gradient to the first operand
+          const synapse::Tensor first = binary_op(
+              saved[0], saved[1],
+              [](float lhs, float rhs) { return lhs <= rhs ? 1.0F : 0.0F; });
+          const synapse::Tensor second = binary_op(
+              saved[0], saved[1],
+              [](float lhs, float rhs) { return lhs <= rhs ? 0.0F : 1.0F; });
+          return synapse::make_gradients(
+              synapse::sum_to(synapse::mul(grad, first), shape_1),
+              synapse::sum_to(synapse::mul(grad, second), shape_2));
+        });
+  }
+  profile.set_output(tensor_3);
+  return tensor_3;
+}
+
+auto synapse::neg(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("neg", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Neg>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(out, "NegBackward", {&tensor}, {},
+                    [](const synapse::Tensor &grad, const Saved &)
+                        -> Gradients {
+                      return synapse::make_gradients(synapse::neg(grad));
+                    });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::abs(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("abs", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Abs>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "AbsBackward", {&tensor}, synapse::save_for_backward(tensor),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(
+              binary_op(grad, saved[0], [](float g, float x) {
+                return x > 0.0F ? g : (x < 0.0F ? -g : 0.0F);
+              }));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::exp(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("exp", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Exp>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "ExpBackward", {&tensor}, synapse::save_for_backward(out),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(synapse::mul(grad, saved[0]));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::log(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("log", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Log>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "LogBackward", {&tensor}, synapse::save_for_backward(tensor),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(synapse::div(grad, saved[0]));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::sqrt(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("sqrt", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Sqrt>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "SqrtBackward", {&tensor}, synapse::save_for_backward(out),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(
+              binary_op(grad, saved[0], [](float g, float root) {
+                return g / (2.0F * root);
+              }));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::relu(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("relu", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Relu>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "ReluBackward", {&tensor}, synapse::save_for_backward(out),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(
+              binary_op(grad, saved[0], [](float g, float y) {
+                return y > 0.0F ? g : 0.0F;
+              }));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::sigmoid(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("sigmoid", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Sigmoid>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "SigmoidBackward", {&tensor}, synapse::save_for_backward(out),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(
+              binary_op(grad, saved[0], [](float g, float y) {
+                return g * y * (1.0F - y);
+              }));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::tanh(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("tanh", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Tanh>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "TanhBackward", {&tensor}, synapse::save_for_backward(out),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          return synapse::make_gradients(
+              binary_op(grad, saved[0], [](float g, float y) {
+                return g * (1.0F - (y * y));
+              }));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::gelu(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("gelu", {&tensor});
+  synapse::Tensor out = unary_op<synapse::ElementwiseOp::Gelu>(tensor);
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "GeluBackward", {&tensor}, synapse::save_for_backward(tensor),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          // d(gelu)/dx = Phi(x) + x * phi(x)
+          return synapse::make_gradients(
+              binary_op(grad, saved[0], [](float g, float x) {
+                const float cdf =
+                    0.5F * (1.0F + std::erf(x / std::numbers::sqrt2_v<float>));
+                const float pdf = std::exp(-0.5F * x * x) *
+                                  std::numbers::inv_sqrtpi_v<float> /
+                                  std::numbers::sqrt2_v<float>;
+                return g * (cdf + (x * pdf));
+              }));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::sum(const synapse::Tensor &tensor,
+                  const std::vector<size_t> &dims, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("sum", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::Sum, dims, keepdim)};
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "SumBackward", {&tensor}, {},
+        [shape = tensor.shape(), dims](const synapse::Tensor &grad,
+                                       const Saved &) -> Gradients {
+          return synapse::make_gradients(expand_grad(grad, shape, dims));
+        });
+  }
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::mean(const synapse::Tensor &tensor,
+                   const std::vector<size_t> &dims, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("mean", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::Mean, dims, keepdim)};
+  if (synapse::needs_grad({&tensor})) {
+    const auto count = static_cast<float>(tensor.size() / out.size());
+    synapse::record(
+        out, "MeanBackward", {&tensor}, {},
+        [shape = tensor.shape(), dims, count](const synapse::Tensor &grad,
+                                              const Saved &) -> Gradients {
+          return synapse::make_gradients(
+              synapse::div(expand_grad(grad, shape, dims),
+                           synapse::Tensor({count}, {})));
+        });
+  }
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::max(const synapse::Tensor &tensor,
+                  const std::vector<size_t> &dims, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("max", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::Max, dims, keepdim)};
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(out, "MaxBackward", {&tensor},
+                    synapse::save_for_backward(tensor, out),
+                    [shape = tensor.shape(), dims](const synapse::Tensor &grad,
+                                                   const Saved &saved) {
+                      return extremum_backward(grad, saved, shape, dims);
+                    });
+  }
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::min(const synapse::Tensor &tensor,
+                  const std::vector<size_t> &dims, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("min", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::Min, dims, keepdim)};
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(out, "MinBackward", {&tensor},
+                    synapse::save_for_backward(tensor, out),
+                    [shape = tensor.shape(), dims](const synapse::Tensor &grad,
+                                                   const Saved &saved) {
+                      return extremum_backward(grad, saved, shape, dims);
+                    });
+  }
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::var(const synapse::Tensor &tensor,
+                  const std::vector<size_t> &dims, bool keepdim,
+                  size_t correction) -> synapse::Tensor {
+  synapse::ProfileScope profile("var", {&tensor});
+  synapse::Tensor out{synapse::reduce(tensor, synapse::ReduceOp::Var, dims,
+                                      keepdim, correction)};
+  if (synapse::needs_grad({&tensor})) {
+    // d(var)/dx = 2 (x - mean) / (count - correction)
+    const float scale =
+        2.0F / (static_cast<float>(tensor.size() / std::max<size_t>(
+                                                       out.size(), 1)) -
+                static_cast<float>(correction));
+    synapse::record(
+        out, "VarBackward", {&tensor}, synapse::save_for_backward(tensor),
+        [shape = tensor.shape(), dims, scale](const synapse::Tensor &grad,
+                                              const Saved &saved)
+            -> Gradients {
+          const synapse::Tensor mean{
+              synapse::reduce(saved[0], synapse::ReduceOp::Mean, dims, true)};
+          const synapse::Tensor deviation = binary_op(
+              saved[0], mean, [](float x, float m) { return x - m; });
+          return synapse::make_gradients(binary_op(
+              deviation,
+              grad.reshape(synapse::reduced_shape(shape, dims, true)),
+              [scale](float d, float g) { return scale * d * g; }));
+        });
+  }
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::norm(const synapse::Tensor &tensor,
+                   const std::vector<size_t> &dims, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("norm", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::Norm, dims, keepdim)};
+  if (synapse::needs_grad({&tensor})) {
+    synapse::record(
+        out, "NormBackward", {&tensor}, synapse::save_for_backward(tensor, out),
+        [shape = tensor.shape(), dims](const synapse::Tensor &grad,
+                                       const Saved &saved) -> Gradients {
+          // d(norm)/dx = x / norm, taken as 0 at the origin
+          const synapse::Shape kept = synapse::reduced_shape(shape, dims, true);
+          const synapse::Tensor direction =
+              binary_op(saved[0], saved[1].reshape(kept), [](float x, float n) {
+                return n == 0.0F ? 0.0F : x / n;
+              });
+          return synapse::make_gradients(
+              synapse::mul(direction, grad.reshape(kept)));
+        });
+  }
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::argmax(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("argmax", {&tensor});
+  synapse::Tensor out{synapse::reduce(
+      tensor.NDArray::reshape({tensor.size()}), synapse::ReduceOp::ArgMax,
+      {0})};
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::argmax(const synapse::Tensor &tensor, size_t dim, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("argmax", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::ArgMax, {dim}, keepdim)};
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::argmin(const synapse::Tensor &tensor) -> synapse::Tensor {
+  synapse::ProfileScope profile("argmin", {&tensor});
+  synapse::Tensor out{synapse::reduce(
+      tensor.NDArray::reshape({tensor.size()}), synapse::ReduceOp::ArgMin,
+      {0})};
+  profile.set_reduced_output(out);
+  return out;
+}
+
+auto synapse::argmin(const synapse::Tensor &tensor, size_t dim, bool keepdim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("argmin", {&tensor});
+  synapse::Tensor out{
+      synapse::reduce(tensor, synapse::ReduceOp::ArgMin, {dim}, keepdim)};
+  profile.set_reduced_output(out);
+  return out;
+}
+
+namespace {
+// Forward of `matmul`, written into `out` when it is set and can take the
+// product directly: a dense tensor of the result shape and dtype, not
+// overlapping the operands. Returns the product, a view of `out` in that
+// case, and its number of flops.
+auto matmul_forward(const synapse::Tensor &tensor_1,
+                    const synapse::Tensor &tensor_2, const synapse::Tensor *out)
+    -> std::pair<synapse::Tensor, size_t> {
+  if (tensor_1.ndim() == 0 || tensor_2.ndim() == 0) {
+    throw std::invalid_argument(
+        "Matrix multiplication does not support 0-dimensional tensors.");
+  }
+
+  // Follows NumPy semantics: a 1D lhs is treated as a row vector and a 1D rhs
+  // as a column vector, and the added dimension is removed from the output.
+  // Operands are read through their strides, so transposed or sliced views
+  // are multiplied without being copied first.
+  // Half precision operands are multiplied by sgemm in float32 and rounded
+  // once at the end, Int8 ones by igemm, and the other dtypes sgemm does not
+  // cover use typed_gemm.
+  const synapse::DType dtype =
+      synapse::promote_types(tensor_1.dtype(), tensor_2.dtype());
+  const synapse::DType compute =
+      dtype == synapse::DType::Float16 || dtype == synapse::DType::BFloat16
+          ? synapse::DType::Float32
+          : dtype;
+  const synapse::NDArray array_1 = tensor_1.NDArray::to(compute);
+  const synapse::NDArray array_2 = tensor_2.NDArray::to(compute);
+  synapse::Shape shape_1 = array_1.shape();
+  synapse::Shape shape_2 = array_2.shape();
+  synapse::Strides view_strides_1 = array_1.strides();
+  synapse::Strides view_strides_2 = array_2.strides();
+  if (tensor_1.ndim() == 1) {
+    shape_1 = {1, shape_1[0]};
+    view_strides_1 = {0, view_strides_1[0]};
+  }
+  if (tensor_2.ndim() == 1) {
+    shape_2 = {shape_2[0], 1};
+    view_strides_2 = {view_strides_2[0], 0};
+  }
+
+  const size_t rank_1 = shape_1.size();
+  const size_t rank_2 = shape_2.size();
+  const size_t m = shape_1[rank_1 - 2];
+  const size_t k = shape_1[rank_1 - 1];
+  const size_t n = shape_2[rank_2 - 1];
+  if (k != shape_2[rank_2 - 2]) {
     throw std::invalid_argument(std::format(
         "Matrix multiplication is invalid. Found tensor shapes {} and {}.",
         tensor_1.shape(), tensor_2.shape()));
   }
 
-  synapse::Shape out_shape =
-      synapse::shape_broadcast(tensor_1.shape(), tensor_2.shape());
+  // Every dimension but the last two is a batch dimension and is broadcasted
+  const synapse::Shape batch_1(shape_1.begin(), shape_1.end() - 2);
+  const synapse::Shape batch_2(shape_2.begin(), shape_2.end() - 2);
+  const synapse::Shape batch = synapse::shape_broadcast(batch_1, batch_2);
 
-  // TODO(diogo): I need to implement shape broadcast
+  synapse::Shape out_shape = batch;
+  if (tensor_1.ndim() > 1) {
+    out_shape.push_back(m);
+  }
+  if (tensor_2.ndim() > 1) {
+    out_shape.push_back(n);
+  }
 
-  return tensor_1;
+  // Strides used to walk each operand's batch, 0 along broadcasted dimensions
+  const auto batch_strides = [&batch](const synapse::Shape &operand,
+                                      const synapse::Strides &operand_strides) {
+    synapse::Strides strides(batch.size(), 0);
+    const size_t lead = batch.size() - operand.size();
+    for (size_t i = 0; i < operand.size(); ++i) {
+      strides[lead + i] = operand[i] == 1 ? 0 : operand_strides[i];
+    }
+    return strides;
+  };
+  const synapse::Strides strides_1 = batch_strides(batch_1, view_strides_1);
+  const synapse::Strides strides_2 = batch_strides(batch_2, view_strides_2);
+  const size_t batch_size = synapse::shape_numel(batch);
+
+  // Written in place when the kernels produce the dtype of `out` directly.
+  // Unlike element-wise ops, every output element reads whole rows and
+  // columns of the operands, so even an identical view cannot be written.
+  const bool direct = out != nullptr && out->shape() == out_shape &&
+                      out->dtype() == compute && compute == dtype &&
+                      out->is_contigous() &&
+                      out->storage() != array_1.storage() &&
+                      out->storage() != array_2.storage();
+  synapse::Tensor tensor_3 =
+      direct ? synapse::Tensor{synapse::NDArray{out->storage(), out->offset(),
+                                                out_shape, out->strides()}}
+             : synapse::Tensor::empty(out_shape, compute);
+  // Detaches a shared buffer once, before the products write it in parallel
+  static_cast<void>(tensor_3.raw_data());
+  const auto product = [&](size_t offset_1, size_t offset_2, size_t b) {
+    if (compute == synapse::DType::Float32) {
+      synapse::sgemm(m, n, k, array_1.data() + offset_1,
+                     view_strides_1[rank_1 - 2], view_strides_1[rank_1 - 1],
+                     array_2.data() + offset_2, view_strides_2[rank_2 - 2],
+                     view_strides_2[rank_2 - 1],
+                     tensor_3.data() + (b * m * n), n);
+      return;
+    }
+    if (compute == synapse::DType::Int8 && k <= synapse::IGEMM_MAX_DEPTH) {
+      // Exact int32 products saturated to int8, like typed_gemm does
+      std::vector<int32_t> acc(m * n);
+      synapse::igemm(m, n, k, array_1.data_ptr<int8_t>() + offset_1,
+                     view_strides_1[rank_1 - 2], view_strides_1[rank_1 - 1],
+                     array_2.data_ptr<int8_t>() + offset_2,
+                     view_strides_2[rank_2 - 2], view_strides_2[rank_2 - 1],
+                     acc.data(), n);
+      int8_t *dst = tensor_3.data_ptr<int8_t>() + (b * m * n);
+      for (size_t i = 0; i < m * n; ++i) {
+        dst[i] = synapse::scalar_cast<int8_t>(acc[i]);
+      }
+      return;
+    }
+    synapse::dispatch(compute, [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      typed_gemm(m, n, k, array_1.data_ptr<T>() + offset_1,
+                 view_strides_1[rank_1 - 2], view_strides_1[rank_1 - 1],
+                 array_2.data_ptr<T>() + offset_2, view_strides_2[rank_2 - 2],
+                 view_strides_2[rank_2 - 1],
+                 tensor_3.data_ptr<T>() + (b * m * n), n);
+    });
+  };
+  const auto multiply = [&](size_t begin, size_t end) {
+    synapse::Shape index = synapse::pos_to_nd_index(begin, batch);
+    size_t offset_1 = synapse::nd_index_to_pos(index, strides_1);
+    size_t offset_2 = synapse::nd_index_to_pos(index, strides_2);
+    for (size_t b = begin; b < end; ++b) {
+      product(offset_1, offset_2, b);
+
+      // Advances the batch index like an odometer, updating both offsets
+      for (size_t d = batch.size(); d-- > 0;) {
+        offset_1 += strides_1[d];
+        offset_2 += strides_2[d];
+        if (++index[d] < batch[d]) {
+          break;
+        }
+        offset_1 -= strides_1[d] * batch[d];
+        offset_2 -= strides_2[d] * batch[d];
+        index[d] = 0;
+      }
+    }
+  };
+  // Enough matrices to keep every thread busy are spread across the pool,
+  // otherwise sgemm parallelizes each product on its own
+  if (batch_size >= synapse::get_num_threads()) {
+    const size_t work = std::max<size_t>(m * n * k, 1);
+    synapse::parallel_for(0, batch_size,
+                          std::max<size_t>(synapse::GRAIN_SIZE / work, 1),
+                          multiply);
+  } else {
+    multiply(0, batch_size);
+  }
+  if (compute != dtype) {
+    tensor_3 = synapse::Tensor{tensor_3.NDArray::to(dtype)};
+  }
+  return {std::move(tensor_3), 2 * batch_size * m * n * k};
+}
+} // namespace
+
+auto synapse::matmul(const synapse::Tensor &tensor_1,
+                     const synapse::Tensor &tensor_2) -> synapse::Tensor {
+  synapse::ProfileScope profile("matmul", {&tensor_1, &tensor_2});
+  auto [tensor_3, flops] = matmul_forward(tensor_1, tensor_2, nullptr);
+  if (synapse::needs_grad({&tensor_1, &tensor_2})) {
+    synapse::record(
+        tensor_3, "MatmulBackward", {&tensor_1, &tensor_2},
+        synapse::save_for_backward(tensor_1, tensor_2),
+        [](const synapse::Tensor &grad, const Saved &saved) -> Gradients {
+          const synapse::Tensor &lhs = saved[0];
+          const synapse::Tensor &rhs = saved[1];
+          // Restores the dimensions removed for 1D operands so the gradients
+          // are plain batched matrix products
+          const synapse::Tensor mat_1 =
+              lhs.ndim() == 1 ? lhs.reshape({1, lhs.shape()[0]}) : lhs.detach();
+          const synapse::Tensor mat_2 =
+              rhs.ndim() == 1 ? rhs.reshape({rhs.shape()[0], 1}) : rhs.detach();
+          const size_t mat_rank_1 = mat_1.ndim();
+          const size_t mat_rank_2 = mat_2.ndim();
+          const size_t batch_rank = grad.ndim() - (lhs.ndim() == 1 ? 0 : 1) -
+                                    (rhs.ndim() == 1 ? 0 : 1);
+          synapse::Shape grad_shape(grad.shape().begin(),
+                                    grad.shape().begin() + batch_rank);
+          grad_shape.push_back(mat_1.shape()[mat_rank_1 - 2]);
+          grad_shape.push_back(mat_2.shape()[mat_rank_2 - 1]);
+          const synapse::Tensor grad_mat = grad.reshape(grad_shape);
+
+          const synapse::Tensor grad_1 = synapse::matmul(
+              grad_mat, mat_2.transpose(mat_rank_2 - 2, mat_rank_2 - 1));
+          const synapse::Tensor grad_2 = synapse::matmul(
+              mat_1.transpose(mat_rank_1 - 2, mat_rank_1 - 1), grad_mat);
+          return synapse::make_gradients(
+              synapse::sum_to(grad_1, mat_1.shape()).reshape(lhs.shape()),
+              synapse::sum_to(grad_2, mat_2.shape()).reshape(rhs.shape()));
+        });
+  }
+  profile.set_output(tensor_3, flops);
+  return std::move(tensor_3);
+}
+
+auto synapse::matmul(const synapse::Tensor &tensor_1,
+                     const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  synapse::ProfileScope profile("matmul", {&tensor_1, &tensor_2});
+  check_not_recorded("matmul", out, {&tensor_1, &tensor_2});
+  const auto [product, flops] = matmul_forward(tensor_1, tensor_2, &out);
+  if (product.storage() != out.storage()) {
+    check_out("matmul", out, product.shape(), product.dtype());
+    out.copy_(product);
+  }
+  profile.set_output(out, flops);
+  return out;
 }
 
 auto synapse::is_close(const synapse::Tensor &tensor_1,
                        const synapse::Tensor &tensor_2, float tol) -> bool {
+  synapse::ProfileScope profile("is_close", {&tensor_1, &tensor_2});
   if (tensor_1.shape() != tensor_2.shape()) {
     return false;
   }
-  for (size_t i = 0; i < tensor_1.size(); ++i) {
-    if (std::fabs(tensor_1.data()[i] - tensor_2.data()[i]) > tol) {
-      return false;
-    }
+  if (tensor_1.dtype() == synapse::DType::Float32 &&
+      tensor_2.dtype() == synapse::DType::Float32) {
+    const Tensor lhs = tensor_1.contiguous();
+    const Tensor rhs = tensor_2.contiguous();
+    return all_close(lhs.data(), rhs.data(), lhs.size(), tol);
   }
-  return true;
+  // Any other pair is compared in double precision
+  const synapse::NDArray lhs =
+      tensor_1.NDArray::to(synapse::DType::Float64).contiguous();
+  const synapse::NDArray rhs =
+      tensor_2.NDArray::to(synapse::DType::Float64).contiguous();
+  return all_close(lhs.data_ptr<double>(), rhs.data_ptr<double>(), lhs.size(),
+                   static_cast<double>(tol));
+}
+
+// Out and in-place variants, see func.h
+
+auto synapse::add(const synapse::Tensor &tensor_1,
+                  const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return binary_op<synapse::ElementwiseOp::Add>("add", tensor_1, tensor_2, out);
+}
+
+auto synapse::add_(synapse::Tensor &tensor_1, const synapse::Tensor &tensor_2)
+    -> synapse::Tensor & {
+  return synapse::add(tensor_1, tensor_2, tensor_1);
+}
+
+auto synapse::sub(const synapse::Tensor &tensor_1,
+                  const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return binary_op<synapse::ElementwiseOp::Sub>("sub", tensor_1, tensor_2, out);
+}
+
+auto synapse::sub_(synapse::Tensor &tensor_1, const synapse::Tensor &tensor_2)
+    -> synapse::Tensor & {
+  return synapse::sub(tensor_1, tensor_2, tensor_1);
+}
+
+auto synapse::mul(const synapse::Tensor &tensor_1,
+                  const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return binary_op<synapse::ElementwiseOp::Mul>("mul", tensor_1, tensor_2, out);
+}
+
+auto synapse::mul_(synapse::Tensor &tensor_1, const synapse::Tensor &tensor_2)
+    -> synapse::Tensor & {
+  return synapse::mul(tensor_1, tensor_2, tensor_1);
+}
+
+auto synapse::div(const synapse::Tensor &tensor_1,
+                  const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return binary_op<synapse::ElementwiseOp::Div>("div", tensor_1, tensor_2, out);
+}
+
+auto synapse::div_(synapse::Tensor &tensor_1, const synapse::Tensor &tensor_2)
+    -> synapse::Tensor & {
+  return synapse::div(tensor_1, tensor_2, tensor_1);
+}
+
+auto synapse::maximum(const synapse::Tensor &tensor_1,
+                      const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return binary_op<synapse::ElementwiseOp::Maximum>("maximum", tensor_1,
+                                                    tensor_2, out);
+}
+
+auto synapse::maximum_(synapse::Tensor &tensor_1,
+                       const synapse::Tensor &tensor_2) -> synapse::Tensor & {
+  return synapse::maximum(tensor_1, tensor_2, tensor_1);
+}
+
+auto synapse::minimum(const synapse::Tensor &tensor_1,
+                      const synapse::Tensor &tensor_2, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return binary_op<synapse::ElementwiseOp::Minimum>("minimum", tensor_1,
+                                                    tensor_2, out);
+}
+
+auto synapse::minimum_(synapse::Tensor &tensor_1,
+                       const synapse::Tensor &tensor_2) -> synapse::Tensor & {
+  return synapse::minimum(tensor_1, tensor_2, tensor_1);
+}
+
+auto synapse::neg(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Neg>("neg", tensor, out);
+}
+
+auto synapse::neg_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::neg(tensor, tensor);
+}
+
+auto synapse::abs(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Abs>("abs", tensor, out);
+}
+
+auto synapse::abs_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::abs(tensor, tensor);
+}
+
+auto synapse::exp(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Exp>("exp", tensor, out);
+}
+
+auto synapse::exp_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::exp(tensor, tensor);
+}
+
+auto synapse::log(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Log>("log", tensor, out);
+}
+
+auto synapse::log_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::log(tensor, tensor);
+}
+
+auto synapse::sqrt(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Sqrt>("sqrt", tensor, out);
+}
+
+auto synapse::sqrt_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::sqrt(tensor, tensor);
+}
+
+auto synapse::relu(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Relu>("relu", tensor, out);
+}
+
+auto synapse::relu_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::relu(tensor, tensor);
+}
+
+auto synapse::sigmoid(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Sigmoid>("sigmoid", tensor, out);
+}
+
+auto synapse::sigmoid_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::sigmoid(tensor, tensor);
+}
+
+auto synapse::tanh(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Tanh>("tanh", tensor, out);
+}
+
+auto synapse::tanh_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::tanh(tensor, tensor);
+}
+
+auto synapse::gelu(const synapse::Tensor &tensor, synapse::Tensor &out)
+    -> synapse::Tensor & {
+  return unary_op<synapse::ElementwiseOp::Gelu>("gelu", tensor, out);
+}
+
+auto synapse::gelu_(synapse::Tensor &tensor) -> synapse::Tensor & {
+  return synapse::gelu(tensor, tensor);
 }
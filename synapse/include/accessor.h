@@ -0,0 +1,151 @@
+#ifndef SYNAPSE_ACCESSOR_H
+#define SYNAPSE_ACCESSOR_H
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+
+// Set to 1 by the SYNAPSE_BOUNDS_CHECK CMake option
+#ifndef SYNAPSE_BOUNDS_CHECK
+#define SYNAPSE_BOUNDS_CHECK 0
+#endif
+
+namespace synapse {
+
+/**
+ * @brief Whether `Accessor::operator()` checks its indices.
+ */
+inline constexpr bool BOUNDS_CHECK = SYNAPSE_BOUNDS_CHECK != 0;
+
+/**
+ * @brief Element access into a strided array of a rank known at compile
+ * time.
+ *
+ * @details Shape and strides are held in `std::array`s, so indexing is a
+ * handful of multiply-adds on registers: nothing is allocated and the rank
+ * is checked by the compiler. `operator()` only checks the indices when
+ * synapse is built with `SYNAPSE_BOUNDS_CHECK`, `at()` always does.
+ *
+ * An accessor does not own anything; it is valid as long as the storage of
+ * the array it was created from is alive and not reallocated. Like a raw
+ * `data()` pointer, it keeps pointing to the buffer it was created on: once
+ * the array has been copied, that buffer is shared copy-on-write with the
+ * copy, and writing through the accessor changes both (see storage.h).
+ * Create accessors after taking copies, not before.
+ *
+ * ### Example
+ * ```
+ * auto acc = array.accessor<2>(); // float elements
+ * for (size_t i = 0; i < acc.size(0); ++i) {
+ *   for (size_t j = 0; j < acc.size(1); ++j) {
+ *     acc(i, j) *= 2.0F;
+ *   }
+ * }
+ * ```
+ */
+template <typename T, size_t Rank> class Accessor {
+public:
+  Accessor(T *data, const std::array<size_t, Rank> &shape,
+           const std::array<size_t, Rank> &strides)
+      : _data(data), _shape(shape), _strides(strides) {}
+
+  // Accessors
+  [[nodiscard]] auto data() const -> T * { return this->_data; }
+  [[nodiscard]] auto size(size_t dim) const -> size_t {
+    return this->_shape[dim];
+  }
+  [[nodiscard]] auto stride(size_t dim) const -> size_t {
+    return this->_strides[dim];
+  }
+  [[nodiscard]] auto shape() const -> const std::array<size_t, Rank> & {
+    return this->_shape;
+  }
+  [[nodiscard]] auto strides() const -> const std::array<size_t, Rank> & {
+    return this->_strides;
+  }
+
+  /**
+   * @brief Element at the given indices, checked only with
+   * `SYNAPSE_BOUNDS_CHECK`.
+   */
+  template <std::integral... Indices>
+    requires(sizeof...(Indices) == Rank)
+  auto operator()(Indices... indices) const -> T & {
+    const std::array<size_t, Rank> index{static_cast<size_t>(indices)...};
+    if constexpr (BOUNDS_CHECK) {
+      this->_check(index);
+    }
+    return this->_data[this->_position(index)];
+  }
+
+  /**
+   * @brief Element at the given indices.
+   * @throws std::out_of_range if an index is out of bounds.
+   */
+  template <std::integral... Indices>
+    requires(sizeof...(Indices) == Rank)
+  auto at(Indices... indices) const -> T & {
+    const std::array<size_t, Rank> index{static_cast<size_t>(indices)...};
+    this->_check(index);
+    return this->_data[this->_position(index)];
+  }
+
+  /**
+   * @brief Fixes the first index, returning the sub-array of rank - 1.
+   */
+  auto operator[](size_t index) const -> Accessor<T, Rank - 1>
+    requires(Rank > 1)
+  {
+    if constexpr (BOUNDS_CHECK) {
+      this->_check_dim(0, index);
+    }
+    std::array<size_t, Rank - 1> shape{};
+    std::array<size_t, Rank - 1> strides{};
+    for (size_t d = 1; d < Rank; ++d) {
+      shape[d - 1] = this->_shape[d];
+      strides[d - 1] = this->_strides[d];
+    }
+    return {this->_data + (index * this->_strides[0]), shape, strides};
+  }
+
+  auto operator[](size_t index) const -> T &
+    requires(Rank == 1)
+  {
+    if constexpr (BOUNDS_CHECK) {
+      this->_check_dim(0, index);
+    }
+    return this->_data[index * this->_strides[0]];
+  }
+
+private:
+  T *_data;
+  std::array<size_t, Rank> _shape;
+  std::array<size_t, Rank> _strides;
+
+  auto _position(const std::array<size_t, Rank> &index) const -> size_t {
+    size_t pos = 0;
+    for (size_t d = 0; d < Rank; ++d) {
+      pos += index[d] * this->_strides[d];
+    }
+    return pos;
+  }
+
+  auto _check(const std::array<size_t, Rank> &index) const -> void {
+    for (size_t d = 0; d < Rank; ++d) {
+      this->_check_dim(d, index[d]);
+    }
+  }
+
+  auto _check_dim(size_t dim, size_t index) const -> void {
+    if (index >= this->_shape[dim]) {
+      throw std::out_of_range(
+          std::format("Index {} is out of bounds for dimension {} of size {}.",
+                      index, dim, this->_shape[dim]));
+    }
+  }
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_ACCESSOR_H
@@ -0,0 +1,203 @@
+#ifndef SYNAPSE_ALLOCATOR_H
+#define SYNAPSE_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Counters describing how an allocator has been used.
+ *
+ * @details Byte counters are expressed in block sizes, that is after rounding
+ * the request up to the size class (or alignment) actually reserved.
+ */
+struct AllocatorStats {
+  // Number of blocks handed out
+  size_t allocations;
+  // Blocks served from memory the allocator already owned
+  size_t hits;
+  // Blocks that required memory from the system
+  size_t misses;
+  // Bytes currently handed out
+  size_t live_bytes;
+  // High-water mark of `live_bytes`
+  size_t peak_bytes;
+  // Bytes owned by the allocator but not handed out
+  size_t cached_bytes;
+};
+
+/**
+ * @brief Source of the memory backing tensor storages.
+ *
+ * @details Every block is aligned to `alignment` bytes so kernels can use
+ * aligned vector loads on the start of a storage and never split a cache
+ * line across two tensors. Implementations must be thread safe, since a
+ * storage may be released by a different thread than the one that created
+ * it.
+ */
+class Allocator {
+public:
+  static constexpr size_t alignment = 64;
+
+  Allocator(const Allocator &) = delete;
+  Allocator(Allocator &&) = delete;
+  auto operator=(const Allocator &) -> Allocator & = delete;
+  auto operator=(Allocator &&) -> Allocator & = delete;
+  Allocator() = default;
+  virtual ~Allocator();
+
+  /**
+   * @brief Returns an uninitialised block of at least `bytes` bytes.
+   *
+   * @details A request of 0 bytes returns a null pointer.
+   */
+  virtual auto allocate(size_t bytes) -> void * = 0;
+
+  /**
+   * @brief Gives back a block, `bytes` must match the allocation request.
+   */
+  virtual auto deallocate(void *ptr, size_t bytes) -> void = 0;
+
+  [[nodiscard]] virtual auto stats() const -> AllocatorStats = 0;
+
+  /**
+   * @brief Restarts the peak tracking from the current live bytes.
+   */
+  virtual auto reset_peak() -> void = 0;
+
+  /**
+   * @brief Whether blocks keep their contents until they are given back.
+   *
+   * @details Copies of arrays share their blocks copy-on-write only when
+   * they do (see `Storage::share`), which an allocator handing out the same
+   * memory again while a block is still live cannot guarantee.
+   */
+  [[nodiscard]] virtual auto stable_blocks() const -> bool { return true; }
+};
+
+/**
+ * @brief Pool of aligned blocks grouped in size classes.
+ *
+ * @details Requests are rounded up to a size class (four classes per power of
+ * two, so at most 25% is wasted) and freed blocks are kept in a per class free
+ * list instead of going back to the system. Steady-state loops that keep
+ * allocating the same shapes are therefore served without ever calling
+ * `operator new`, and blocks are never zero-filled.
+ *
+ * Idle blocks are capped at `max_cached_bytes`, beyond which freed blocks are
+ * returned to the system.
+ */
+class CachingAllocator : public Allocator {
+public:
+  explicit CachingAllocator(size_t max_cached_bytes = size_t{1} << 30);
+  ~CachingAllocator() override;
+
+  auto allocate(size_t bytes) -> void * override;
+  auto deallocate(void *ptr, size_t bytes) -> void override;
+  [[nodiscard]] auto stats() const -> AllocatorStats override;
+  auto reset_peak() -> void override;
+
+  /**
+   * @brief Returns every idle block to the system.
+   */
+  auto empty_cache() -> void;
+
+  /**
+   * @brief Size of the block reserved for a request of `bytes` bytes.
+   */
+  static auto size_class(size_t bytes) -> size_t;
+
+private:
+  mutable std::mutex _mutex;
+  size_t _max_cached_bytes;
+  std::unordered_map<size_t, std::vector<void *>> _free_blocks;
+  AllocatorStats _stats;
+};
+
+/**
+ * @brief Bump allocator for short-lived temporaries.
+ *
+ * @details Blocks are carved out of large chunks by advancing an offset, and
+ * freeing a single block only updates the counters. Once every block has
+ * been freed the arena rewinds to the start, merging its chunks into a single
+ * one large enough for the whole previous round. A loop whose iterations
+ * allocate the same temporaries thus settles on one chunk, reused every
+ * iteration.
+ *
+ * ### Example
+ * ```
+ * auto arena = std::make_shared<synapse::Arena>();
+ * for (const auto &batch : batches) {
+ *   synapse::AllocatorGuard guard(arena);
+ *   synapse::Tensor out = model(batch); // Temporaries come from the arena
+ * }
+ * ```
+ */
+class Arena : public Allocator {
+public:
+  explicit Arena(size_t chunk_bytes = size_t{1} << 20);
+  ~Arena() override;
+
+  auto allocate(size_t bytes) -> void * override;
+  auto deallocate(void *ptr, size_t bytes) -> void override;
+  [[nodiscard]] auto stats() const -> AllocatorStats override;
+  auto reset_peak() -> void override;
+
+  /**
+   * @brief Total size of the chunks currently owned.
+   */
+  [[nodiscard]] auto capacity() const -> size_t;
+
+private:
+  struct Chunk {
+    void *data;
+    size_t bytes;
+  };
+
+  mutable std::mutex _mutex;
+  size_t _chunk_bytes;
+  std::vector<Chunk> _chunks;
+  // Bump offset into the last chunk
+  size_t _offset;
+  size_t _capacity;
+  AllocatorStats _stats;
+
+  auto _rewind() -> void;
+};
+
+/**
+ * @brief Process-wide caching allocator, used unless a guard is active.
+ */
+auto default_allocator() -> const std::shared_ptr<CachingAllocator> &;
+
+/**
+ * @brief Allocator used by new storages on the calling thread.
+ */
+auto current_allocator() -> std::shared_ptr<Allocator>;
+
+/**
+ * @brief Makes new storages on the calling thread use `allocator` for the
+ * lifetime of the guard.
+ *
+ * @details Storages keep their allocator alive, so tensors may safely outlive
+ * the guard and the allocator they came from.
+ */
+class AllocatorGuard {
+public:
+  AllocatorGuard(const AllocatorGuard &) = delete;
+  AllocatorGuard(AllocatorGuard &&) = delete;
+  auto operator=(const AllocatorGuard &) -> AllocatorGuard & = delete;
+  auto operator=(AllocatorGuard &&) -> AllocatorGuard & = delete;
+  explicit AllocatorGuard(std::shared_ptr<Allocator> allocator);
+  ~AllocatorGuard();
+
+private:
+  std::shared_ptr<Allocator> _previous;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_ALLOCATOR_H
@@ -0,0 +1,217 @@
+#ifndef SYNAPSE_AUTOGRAD_H
+#define SYNAPSE_AUTOGRAD_H
+
+#include "ndarray.h"
+#include "tensor.h"
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace synapse {
+
+class Node;
+
+/**
+ * @brief Gradient state attached to a Tensor.
+ *
+ * @details Only tensors taking part in differentiation carry one. Leaves are
+ * tensors created by the user with `requires_grad` set; every other tensor in
+ * the graph is the output of an op and points to the node that produced it.
+ */
+struct AutogradMeta {
+  AutogradMeta(const AutogradMeta &) = delete;
+  AutogradMeta(AutogradMeta &&) = delete;
+  auto operator=(const AutogradMeta &) -> AutogradMeta & = delete;
+  auto operator=(AutogradMeta &&) -> AutogradMeta & = delete;
+  AutogradMeta();
+  ~AutogradMeta();
+
+  bool requires_grad;
+  // Accumulated gradient, only populated on leaves
+  std::unique_ptr<Tensor> grad;
+  // Node that produced this tensor, null on leaves
+  std::shared_ptr<Node> grad_fn;
+  // Node accumulating into `grad`, shared by every op using this leaf
+  std::weak_ptr<Node> grad_accumulator;
+};
+
+/**
+ * @brief A step of the backward graph.
+ *
+ * @details A node receives the gradient of the op output and produces one
+ * gradient per op input. `next_edges()[i]` is the node that must receive the
+ * gradient of input `i`, or null when that input does not require grad.
+ */
+class Node {
+public:
+  using Gradients = std::vector<std::optional<Tensor>>;
+
+  Node(const Node &) = delete;
+  Node(Node &&) = delete;
+  auto operator=(const Node &) -> Node & = delete;
+  auto operator=(Node &&) -> Node & = delete;
+  Node(std::string name, std::vector<std::shared_ptr<Node>> next_edges);
+  virtual ~Node();
+
+  // Accessors
+  [[nodiscard]] auto name() const -> const std::string &;
+  [[nodiscard]] auto next_edges() const
+      -> const std::vector<std::shared_ptr<Node>> &;
+
+  // Computes the gradients of the inputs from the gradient of the output
+  virtual auto apply(const Tensor &grad) -> Gradients = 0;
+
+  // Frees everything saved for backward, called once the node has run
+  virtual auto release() -> void;
+
+private:
+  std::string _name;
+  std::vector<std::shared_ptr<Node>> _next_edges;
+};
+
+/**
+ * @brief Node whose backward formula is given as a function.
+ *
+ * @details Tensors needed by the formula are kept in `saved` rather than
+ * captured by the function, so `release()` can free them as soon as the node
+ * has run, long before the rest of the graph is destroyed.
+ */
+class FunctionNode : public Node {
+public:
+  using Backward = std::function<Gradients(
+      const Tensor &grad, const std::vector<Tensor> &saved)>;
+
+  FunctionNode(std::string name, std::vector<std::shared_ptr<Node>> next_edges,
+               std::vector<Tensor> saved, Backward backward);
+
+  auto apply(const Tensor &grad) -> Gradients override;
+  auto release() -> void override;
+
+private:
+  std::vector<Tensor> _saved;
+  Backward _backward;
+  bool _released;
+};
+
+/**
+ * @brief Sink node adding the incoming gradient into a leaf's `grad`.
+ */
+class AccumulateGrad : public Node {
+public:
+  explicit AccumulateGrad(std::shared_ptr<AutogradMeta> meta);
+
+  auto apply(const Tensor &grad) -> Gradients override;
+
+private:
+  std::shared_ptr<AutogradMeta> _meta;
+};
+
+/**
+ * @brief Thread local switch controlling whether ops record a graph.
+ */
+class GradMode {
+public:
+  static auto is_enabled() -> bool;
+  static auto set_enabled(bool enabled) -> void;
+};
+
+/**
+ * @brief Disables graph recording for the lifetime of the guard.
+ */
+class NoGradGuard {
+public:
+  NoGradGuard(const NoGradGuard &) = delete;
+  NoGradGuard(NoGradGuard &&) = delete;
+  auto operator=(const NoGradGuard &) -> NoGradGuard & = delete;
+  auto operator=(NoGradGuard &&) -> NoGradGuard & = delete;
+  NoGradGuard();
+  ~NoGradGuard();
+
+private:
+  bool _previous;
+};
+
+/**
+ * @brief Detached copy of `tensor` to save for backward.
+ *
+ * @details The copy has a storage of its own sharing the buffer
+ * copy-on-write (see storage.h), with the offset and strides of `tensor`,
+ * so saving copies no elements, yet an out or in-place op writing to the
+ * operand afterwards detaches the operand's buffer rather than changing what
+ * backward reads. Storages whose allocator cannot share its blocks are
+ * copied instead, and pending storages (see lazy.h) are aliased so saving
+ * does not evaluate them. The copy never extends the lifetime of the
+ * tensor's graph.
+ */
+auto save_tensor(const Tensor &tensor) -> Tensor;
+
+// Collects the copies of `tensors` to save for backward, see `save_tensor`
+template <typename... Tensors>
+auto save_for_backward(const Tensors &...tensors) -> std::vector<Tensor> {
+  std::vector<Tensor> saved;
+  saved.reserve(sizeof...(tensors));
+  (saved.push_back(synapse::save_tensor(tensors)), ...);
+  return saved;
+}
+
+/**
+ * @brief Packs the gradients returned by a backward formula.
+ *
+ * @details Moves the tensors in, where a braced list would copy them.
+ */
+template <typename... Grads>
+auto make_gradients(Grads &&...grads) -> Node::Gradients {
+  Node::Gradients out;
+  out.reserve(sizeof...(grads));
+  (out.emplace_back(std::forward<Grads>(grads)), ...);
+  return out;
+}
+
+/**
+ * @brief Checks whether an op over `inputs` has to be recorded.
+ */
+auto needs_grad(const std::vector<const Tensor *> &inputs) -> bool;
+
+/**
+ * @brief Attaches a backward node to `output` if any input requires grad.
+ *
+ * @param output Result of the op.
+ * @param name Name of the node, for debugging.
+ * @param inputs Op inputs, in the order the backward returns gradients.
+ * @param saved Tensors the backward formula needs, see `save_for_backward`.
+ * @param backward Backward formula.
+ */
+auto record(Tensor &output, std::string name,
+            const std::vector<const Tensor *> &inputs,
+            std::vector<Tensor> saved, FunctionNode::Backward backward)
+    -> void;
+
+/**
+ * @brief Runs the backward pass from `root` seeded with `grad`.
+ *
+ * @details Nodes are executed in topological order: a node only runs once the
+ * gradients from all of its consumers have been accumulated. Right after a
+ * node runs its incoming gradient buffer is dropped and, unless
+ * `retain_graph` is set, its saved tensors are released, so peak memory is
+ * bounded by the live frontier of the graph rather than by the whole graph.
+ *
+ * @throws std::runtime_error if `root` does not require grad, if the shapes
+ * of `root` and `grad` differ, or if the graph was already released.
+ */
+auto backward(const Tensor &root, const Tensor &grad, bool retain_graph = false)
+    -> void;
+
+/**
+ * @brief Sums `tensor` over its broadcasted dimensions down to `shape`.
+ *
+ * @details The inverse of broadcasting, used to reduce the gradient of a
+ * broadcasted operand back to its own shape.
+ */
+auto sum_to(const Tensor &tensor, const Shape &shape) -> Tensor;
+
+} // namespace synapse
+
+#endif // !SYNAPSE_AUTOGRAD_H
@@ -0,0 +1,72 @@
+#ifndef SYNAPSE_CHECKPOINT_H
+#define SYNAPSE_CHECKPOINT_H
+
+#include "tensor.h"
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace synapse {
+
+/**
+ * @brief Writes named tensors to a checkpoint file, replacing any existing
+ * file at `path`.
+ *
+ * @details A checkpoint is a header describing every tensor followed by the
+ * elements, so that it can be memory-mapped by `load_checkpoint`. All
+ * integers are little endian.
+ *
+ * | Offset | Size | Field                                          |
+ * |--------|------|------------------------------------------------|
+ * | 0      | 8    | Magic `"SYNAPSE\0"`                            |
+ * | 8      | 4    | Format version, currently 1                    |
+ * | 12     | 4    | Number of tensors                              |
+ * | 16     | 8    | Size of the header, the offset of the elements |
+ *
+ * followed by one record per tensor, in name order:
+ *
+ * | Size      | Field                                               |
+ * |-----------|-----------------------------------------------------|
+ * | 4         | Length of the name in bytes                         |
+ * | length    | Name, UTF-8 without terminator                      |
+ * | 1         | DType: Float64, Float32, Float16, BFloat16, Int32,   |
+ * |           | Int8 as 0 to 5                                      |
+ * | 1         | Number of dimensions                                |
+ * | 8 x ndim  | Shape                                               |
+ * | 8         | Offset of the elements from the start of the file   |
+ * | 8         | Size of the elements in bytes                       |
+ *
+ * Elements are stored dense and row-major, and every tensor starts on a
+ * 64-byte boundary (the `Allocator::alignment`), the gaps being zeros.
+ *
+ * The file is written under a temporary name next to `path` and then
+ * renamed, so a failed save leaves any previous file untouched, and saving
+ * tensors loaded from `path` back to it is safe.
+ *
+ * @throws std::runtime_error if the file cannot be written.
+ */
+auto save_checkpoint(const std::filesystem::path &path,
+                     const std::map<std::string, Tensor> &tensors) -> void;
+
+/**
+ * @brief Opens a checkpoint written by `save_checkpoint`.
+ *
+ * @details The file is memory-mapped and only its header is read: every
+ * tensor is a view into the mapping, so nothing is copied and pages are read
+ * from disk the first time they are touched. Processes opening the same file
+ * share its pages through the page cache.
+ *
+ * The mapping is private: tensors can be written to, which copies the
+ * touched pages, but the file itself never changes. It stays mapped until
+ * the last tensor (or view of one) is destroyed. Copies of a tensor share
+ * the mapping copy-on-write and keep it mapped as well, until they are
+ * written to.
+ *
+ * @throws std::runtime_error if the file cannot be mapped or is not a valid
+ * checkpoint.
+ */
+auto load_checkpoint(const std::filesystem::path &path)
+    -> std::map<std::string, Tensor>;
+} // namespace synapse
+
+#endif // !SYNAPSE_CHECKPOINT_H
@@ -0,0 +1,120 @@
+#ifndef SYNAPSE_CPU_H
+#define SYNAPSE_CPU_H
+
+#include "dtype.h"
+#include <array>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Instruction set levels kernels are compiled for, in increasing
+ * order.
+ *
+ * @details `Baseline` is whatever the library is built with and runs
+ * anywhere. `Sse42` adds SSE4.2, `Avx2` AVX2 and FMA, and `Avx512` the
+ * AVX-512 foundation. Every level implies the ones below it.
+ */
+enum class CpuLevel { Baseline, Sse42, Avx2, Avx512 };
+
+constexpr size_t CPU_LEVELS = 4;
+
+/**
+ * @brief Highest level the host supports, read once from CPUID.
+ */
+auto detected_cpu_level() -> CpuLevel;
+
+/**
+ * @brief Level the kernels are currently chosen for.
+ *
+ * @details Starts at the detected level, or at the one named by the
+ * `SYNAPSE_CPU_LEVEL` environment variable (`baseline`, `sse4.2`, `avx2` or
+ * `avx512`) when it is set, capped at the detected level. The variable lets
+ * a single build be tested on the code paths of older hosts. The GEMM
+ * backend is picked from the starting level as well.
+ */
+auto cpu_level() -> CpuLevel;
+
+/**
+ * @brief Chooses the kernels of the next ops for `level`.
+ * @throws std::invalid_argument if the host does not support `level`.
+ */
+auto set_cpu_level(CpuLevel level) -> void;
+
+auto cpu_level_name(CpuLevel level) -> std::string_view;
+
+/**
+ * @brief Table of the kernels of `Op` over every dtype, one per CPU level.
+ *
+ * @details Kernels are registered for the levels they were compiled for, and
+ * `find` returns the one of the highest level not above the current one.
+ * An op only needs a `Baseline` kernel, the other levels being
+ * optimizations of it.
+ *
+ * ### Example
+ * ```
+ * registry.add(Op::Add, synapse::DType::Float32, synapse::CpuLevel::Avx2,
+ *              add_avx2<float>);
+ * const Kernel kernel = registry.find(Op::Add, synapse::DType::Float32);
+ * ```
+ */
+template <typename Op, typename Kernel> class KernelRegistry {
+public:
+  KernelRegistry(const KernelRegistry &) = delete;
+  KernelRegistry(KernelRegistry &&) = delete;
+  auto operator=(const KernelRegistry &) -> KernelRegistry & = delete;
+  auto operator=(KernelRegistry &&) -> KernelRegistry & = delete;
+  KernelRegistry() : _mutex(), _kernels() {}
+  ~KernelRegistry() = default;
+
+  auto add(Op op, DType dtype, CpuLevel level, Kernel kernel) -> void {
+    const std::unique_lock<std::shared_mutex> lock(this->_mutex);
+    this->_kernels[{op, dtype}][static_cast<size_t>(level)] = kernel;
+  }
+
+  /**
+   * @brief Kernel of the highest level not above `level`, null if there is
+   * none.
+   */
+  [[nodiscard]] auto find(Op op, DType dtype,
+                          CpuLevel level = cpu_level()) const -> Kernel {
+    const std::shared_lock<std::shared_mutex> lock(this->_mutex);
+    const auto it = this->_kernels.find({op, dtype});
+    if (it == this->_kernels.end()) {
+      return nullptr;
+    }
+    for (size_t i = static_cast<size_t>(level) + 1; i-- > 0;) {
+      if (it->second[i] != nullptr) {
+        return it->second[i];
+      }
+    }
+    return nullptr;
+  }
+
+  // Levels with a kernel of their own
+  [[nodiscard]] auto levels(Op op, DType dtype) const
+      -> std::vector<CpuLevel> {
+    const std::shared_lock<std::shared_mutex> lock(this->_mutex);
+    std::vector<CpuLevel> out;
+    const auto it = this->_kernels.find({op, dtype});
+    for (size_t i = 0; it != this->_kernels.end() && i < CPU_LEVELS; ++i) {
+      if (it->second[i] != nullptr) {
+        out.push_back(static_cast<CpuLevel>(i));
+      }
+    }
+    return out;
+  }
+
+private:
+  mutable std::shared_mutex _mutex;
+  std::map<std::pair<Op, DType>, std::array<Kernel, CPU_LEVELS>> _kernels;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_CPU_H
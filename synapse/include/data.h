@@ -0,0 +1,232 @@
+#ifndef SYNAPSE_DATA_H
+#define SYNAPSE_DATA_H
+
+#include "dtype.h"
+#include "mapped_file.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Input pipeline, from the samples of a dataset to batched tensors.
+ */
+namespace synapse::data {
+
+// Shape and dtype of one part of a sample, such as the image or the label
+struct Field {
+  Shape shape;
+  DType dtype = DType::Float32;
+
+  // Size of one sample of the field
+  [[nodiscard]] auto bytes() const -> size_t;
+};
+
+/**
+ * @brief Indexed collection of samples made of fixed-shape fields.
+ *
+ * @details Samples are written straight into the buffers of a batch, so a
+ * dataset never allocates a tensor per sample.
+ */
+class Dataset {
+public:
+  Dataset() = default;
+  Dataset(const Dataset &) = default;
+  Dataset(Dataset &&) = default;
+  auto operator=(const Dataset &) -> Dataset & = default;
+  auto operator=(Dataset &&) -> Dataset & = default;
+  virtual ~Dataset() = default;
+
+  [[nodiscard]] virtual auto size() const -> size_t = 0;
+  [[nodiscard]] virtual auto fields() const -> const std::vector<Field> & = 0;
+
+  /**
+   * @brief Writes sample `index` to `out`, one dense buffer per field.
+   *
+   * @details The buffers hold `fields()[i].bytes()` bytes each. Called by
+   * the workers of a `DataLoader` at the same time, so implementations must
+   * be thread-safe.
+   */
+  virtual auto read(size_t index, std::span<void *const> out) const
+      -> void = 0;
+};
+
+/**
+ * @brief Dataset over tensors already in memory, the first dimension
+ * indexing the samples.
+ */
+class TensorDataset : public Dataset {
+public:
+  /**
+   * @throws std::invalid_argument if there are no tensors, one is a scalar
+   * or their first dimensions differ.
+   */
+  explicit TensorDataset(std::vector<Tensor> tensors);
+
+  [[nodiscard]] auto size() const -> size_t override;
+  [[nodiscard]] auto fields() const -> const std::vector<Field> & override;
+  auto read(size_t index, std::span<void *const> out) const -> void override;
+
+private:
+  // Contiguous, evaluated copies
+  std::vector<NDArray> _tensors;
+  std::vector<Field> _fields;
+};
+
+/**
+ * @brief Dataset streamed from a file of fixed-size records.
+ *
+ * @details Records start at byte `offset` and hold the fields one after the
+ * other, densely in native byte order. The file is memory-mapped, so
+ * samples are paged in from disk as they are read and datasets larger than
+ * memory only keep the pages in use resident.
+ *
+ * ### Example
+ * ```
+ * // 28x28 bytes of pixels, then the label
+ * const auto dataset = std::make_shared<synapse::data::MappedDataset>(
+ *     "train.bin", std::vector<synapse::data::Field>{
+ *                      {{28, 28}, synapse::DType::Int8},
+ *                      {{}, synapse::DType::Int32}});
+ * ```
+ */
+class MappedDataset : public Dataset {
+public:
+  /**
+   * @throws std::system_error if the file cannot be mapped.
+   * @throws std::invalid_argument if there are no fields, or the file past
+   * `offset` is not a whole number of records.
+   */
+  MappedDataset(const std::filesystem::path &path, std::vector<Field> fields,
+                size_t offset = 0);
+
+  [[nodiscard]] auto size() const -> size_t override;
+  [[nodiscard]] auto fields() const -> const std::vector<Field> & override;
+  auto read(size_t index, std::span<void *const> out) const -> void override;
+
+private:
+  std::shared_ptr<MappedFile> _file;
+  std::vector<Field> _fields;
+  size_t _offset;
+  size_t _record_bytes;
+  size_t _size;
+};
+
+struct LoaderOptions {
+  size_t batch_size = 1;
+  // Visits the samples in a new random order every epoch
+  bool shuffle = false;
+  uint64_t seed = 0;
+  // Skips the last batch when it would be smaller than `batch_size`
+  bool drop_last = false;
+  // Threads filling batches in the background, 0 fills them in `next`
+  size_t num_workers = 1;
+  // Batches buffered ahead of the consumer, each with its own buffers
+  size_t prefetch = 2;
+};
+
+class LoaderState;
+
+/**
+ * @brief Samples of a `DataLoader`, one tensor per field with the batch as
+ * the first dimension.
+ *
+ * @details The tensors view buffers the loader reuses, so the buffers go
+ * back to the loader when the batch is destroyed, and the loader stalls
+ * once the consumer holds all of them. A copy of a full batch tensor
+ * shares its buffer until the loader refills it, which then writes to a
+ * buffer of its own instead.
+ */
+class Batch {
+public:
+  Batch(const Batch &) = delete;
+  auto operator=(const Batch &) -> Batch & = delete;
+  Batch(Batch &&other) noexcept;
+  auto operator=(Batch &&other) noexcept -> Batch &;
+  ~Batch();
+
+  // Number of samples, smaller than the batch size for a last partial batch
+  [[nodiscard]] auto size() const -> size_t;
+  [[nodiscard]] auto operator[](size_t field) const -> const Tensor &;
+  [[nodiscard]] auto tensors() const -> const std::vector<Tensor> &;
+
+private:
+  friend class DataLoader;
+
+  std::shared_ptr<LoaderState> _state;
+  size_t _slot;
+  std::vector<Tensor> _tensors;
+
+  Batch(std::shared_ptr<LoaderState> state, size_t slot,
+        std::vector<Tensor> tensors);
+  auto _release() -> void;
+};
+
+/**
+ * @brief Iterates a dataset in batches, filling the next ones on background
+ * threads while the current one is used.
+ *
+ * @details `prefetch` sets of batch buffers are allocated once, and every
+ * batch is collated into a free set, so the steady state allocates nothing.
+ * Workers take the batches in order, each waiting for a free set of
+ * buffers, which bounds the batches loaded ahead. Batches come out in order
+ * whatever the worker finishing first, and a failed read is rethrown by the
+ * `next` returning its batch.
+ *
+ * ### Example
+ * ```
+ * synapse::data::DataLoader loader(dataset, {.batch_size = 64,
+ *                                            .shuffle = true,
+ *                                            .num_workers = 2});
+ * for (size_t epoch = 0; epoch < 10; ++epoch, loader.reset()) {
+ *   while (const std::optional<synapse::data::Batch> batch = loader.next()) {
+ *     train_step((*batch)[0], (*batch)[1]);
+ *   }
+ * }
+ * ```
+ */
+class DataLoader {
+public:
+  DataLoader(const DataLoader &) = delete;
+  DataLoader(DataLoader &&) = delete;
+  auto operator=(const DataLoader &) -> DataLoader & = delete;
+  auto operator=(DataLoader &&) -> DataLoader & = delete;
+
+  /**
+   * @brief Starts loading the first epoch.
+   * @throws std::invalid_argument if the batch size or `prefetch` is 0.
+   */
+  explicit DataLoader(std::shared_ptr<const Dataset> dataset,
+                      LoaderOptions options = {});
+  // Waits for the workers to finish the batch they are reading
+  ~DataLoader();
+
+  /**
+   * @brief Next batch of the epoch, none once the epoch is over.
+   * @throws std::logic_error if the batch cannot be loaded because every
+   * set of buffers is held by a live batch.
+   */
+  [[nodiscard]] auto next() -> std::optional<Batch>;
+
+  /**
+   * @brief Starts the next epoch, reshuffled, dropping the batches loaded
+   * ahead.
+   */
+  auto reset() -> void;
+
+  // Batches per epoch
+  [[nodiscard]] auto num_batches() const -> size_t;
+
+private:
+  std::shared_ptr<LoaderState> _state;
+  std::vector<std::thread> _workers;
+};
+} // namespace synapse::data
+
+#endif // !SYNAPSE_DATA_H
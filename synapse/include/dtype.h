@@ -0,0 +1,276 @@
+#ifndef SYNAPSE_DTYPE_H
+#define SYNAPSE_DTYPE_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace synapse {
+
+/**
+ * @brief Element types an NDArray can hold.
+ */
+enum class DType { Float64, Float32, Float16, BFloat16, Int32, Int8 };
+
+/**
+ * @brief IEEE 754 half precision float, stored as its raw bits.
+ *
+ * @details Only a storage format: arithmetic converts to float, computes in
+ * single precision and rounds back (round to nearest even).
+ */
+struct Half {
+  uint16_t bits;
+
+  Half() = default;
+  explicit Half(float value);
+  explicit operator float() const;
+  static constexpr auto from_bits(uint16_t bits) -> Half {
+    Half out;
+    out.bits = bits;
+    return out;
+  }
+};
+
+/**
+ * @brief Brain floating point: the upper half of an IEEE 754 float.
+ *
+ * @details Keeps the float exponent range with an 8-bit mantissa, so
+ * converting from float is a rounding of the low 16 bits.
+ */
+struct BFloat16 {
+  uint16_t bits;
+
+  BFloat16() = default;
+  explicit BFloat16(float value);
+  explicit operator float() const;
+  static constexpr auto from_bits(uint16_t bits) -> BFloat16 {
+    BFloat16 out;
+    out.bits = bits;
+    return out;
+  }
+};
+
+// Scalar conversions, round to nearest even
+inline auto float_to_half_bits(float value) -> uint16_t {
+  const uint32_t bits = std::bit_cast<uint32_t>(value);
+  const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000U);
+  const uint32_t abs = bits & 0x7FFFFFFFU;
+  if (abs >= 0x7F800000U) {
+    // Infinity stays infinity, NaN becomes a quiet NaN
+    return static_cast<uint16_t>(sign |
+                                 (abs > 0x7F800000U ? 0x7E00U : 0x7C00U));
+  }
+  const int exponent = static_cast<int>(abs >> 23) - 127 + 15;
+  if (exponent >= 31) {
+    return static_cast<uint16_t>(sign | 0x7C00U);
+  }
+  uint32_t mantissa = 0;
+  uint32_t shift = 13;
+  if (exponent <= 0) {
+    // Subnormal half, the implicit bit becomes explicit
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa = (abs & 0x7FFFFFU) | 0x800000U;
+    shift = static_cast<uint32_t>(14 - exponent);
+  } else {
+    mantissa = (static_cast<uint32_t>(exponent) << 23) | (abs & 0x7FFFFFU);
+  }
+  uint32_t half = mantissa >> shift;
+  const uint32_t rest = mantissa & ((1U << shift) - 1);
+  const uint32_t midpoint = 1U << (shift - 1);
+  // A carry out of the mantissa correctly bumps the exponent
+  if (rest > midpoint || (rest == midpoint && (half & 1U) != 0)) {
+    ++half;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+inline auto half_bits_to_float(uint16_t bits) -> float {
+  const uint32_t sign = static_cast<uint32_t>(bits & 0x8000U) << 16;
+  const uint32_t exponent = (bits >> 10) & 0x1FU;
+  const uint32_t mantissa = bits & 0x3FFU;
+  if (exponent == 0) {
+    const float value = static_cast<float>(mantissa) * 0x1p-24F;
+    return sign != 0 ? -value : value;
+  }
+  if (exponent == 31) {
+    return std::bit_cast<float>(sign | 0x7F800000U | (mantissa << 13));
+  }
+  return std::bit_cast<float>(sign | ((exponent + 112) << 23) |
+                              (mantissa << 13));
+}
+
+inline auto float_to_bfloat16_bits(float value) -> uint16_t {
+  const uint32_t bits = std::bit_cast<uint32_t>(value);
+  if ((bits & 0x7FFFFFFFU) > 0x7F800000U) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40U);
+  }
+  const uint32_t rounding = 0x7FFFU + ((bits >> 16) & 1U);
+  return static_cast<uint16_t>((bits + rounding) >> 16);
+}
+
+inline auto bfloat16_bits_to_float(uint16_t bits) -> float {
+  return std::bit_cast<float>(static_cast<uint32_t>(bits) << 16);
+}
+
+inline Half::Half(float value) : bits(float_to_half_bits(value)) {}
+inline Half::operator float() const { return half_bits_to_float(this->bits); }
+inline BFloat16::BFloat16(float value) : bits(float_to_bfloat16_bits(value)) {}
+inline BFloat16::operator float() const {
+  return bfloat16_bits_to_float(this->bits);
+}
+
+/**
+ * @brief Maps a C++ element type to its DType.
+ */
+template <typename T> struct dtype_of;
+template <> struct dtype_of<double> {
+  static constexpr DType value = DType::Float64;
+};
+template <> struct dtype_of<float> {
+  static constexpr DType value = DType::Float32;
+};
+template <> struct dtype_of<Half> {
+  static constexpr DType value = DType::Float16;
+};
+template <> struct dtype_of<BFloat16> {
+  static constexpr DType value = DType::BFloat16;
+};
+template <> struct dtype_of<int32_t> {
+  static constexpr DType value = DType::Int32;
+};
+template <> struct dtype_of<int8_t> {
+  static constexpr DType value = DType::Int8;
+};
+
+/**
+ * @brief Type arithmetic on `T` is carried out in.
+ *
+ * @details Half precision types are computed in float and integers in
+ * int64_t, so intermediate results cannot overflow and saturate once stored
+ * back (see `scalar_cast`). Float and double are computed in themselves.
+ */
+template <typename T>
+using compute_type_t = std::conditional_t<
+    std::is_same_v<T, Half> || std::is_same_v<T, BFloat16>, float,
+    std::conditional_t<std::is_integral_v<T>, int64_t, T>>;
+
+/**
+ * @brief Converts a scalar between element types.
+ *
+ * @details Conversions to integers truncate towards zero and saturate at the
+ * bounds of the type, NaN becomes 0.
+ */
+template <typename To, typename From>
+inline auto scalar_cast(From value) -> To {
+  if constexpr (std::is_same_v<To, From>) {
+    return value;
+  } else if constexpr (std::is_same_v<From, Half> ||
+                       std::is_same_v<From, BFloat16>) {
+    return scalar_cast<To>(static_cast<float>(value));
+  } else if constexpr (std::is_same_v<To, Half> ||
+                       std::is_same_v<To, BFloat16>) {
+    return To(static_cast<float>(value));
+  } else if constexpr (std::is_integral_v<To> &&
+                       std::is_floating_point_v<From>) {
+    // The bounds are powers of two (minus one for the upper one), so the
+    // lower bound is exact and the upper one rounds up to the next power
+    constexpr auto lower = static_cast<From>(std::numeric_limits<To>::min());
+    constexpr auto upper = static_cast<From>(std::numeric_limits<To>::max());
+    if (std::isnan(value)) {
+      return To{0};
+    }
+    if (value <= lower) {
+      return std::numeric_limits<To>::min();
+    }
+    if (value >= upper) {
+      return std::numeric_limits<To>::max();
+    }
+    return static_cast<To>(value);
+  } else if constexpr (std::is_integral_v<To> && std::is_integral_v<From>) {
+    return static_cast<To>(std::clamp<int64_t>(
+        value, std::numeric_limits<To>::min(), std::numeric_limits<To>::max()));
+  } else {
+    return static_cast<To>(value);
+  }
+}
+
+/**
+ * @brief Wraps a type so a generic lambda can receive it as an argument.
+ */
+template <typename T> struct TypeTag {
+  using type = T;
+};
+
+/**
+ * @brief Calls `fn(TypeTag<T>{})` with the C++ type matching `dtype`.
+ *
+ * ### Example
+ * ```
+ * synapse::dispatch(array.dtype(), [&](auto tag) {
+ *   using T = typename decltype(tag)::type;
+ *   const T *data = array.data_ptr<T>();
+ * });
+ * ```
+ */
+template <typename Fn> auto dispatch(DType dtype, Fn &&fn) {
+  switch (dtype) {
+  case DType::Float64:
+    return fn(TypeTag<double>{});
+  case DType::Float32:
+    return fn(TypeTag<float>{});
+  case DType::Float16:
+    return fn(TypeTag<Half>{});
+  case DType::BFloat16:
+    return fn(TypeTag<BFloat16>{});
+  case DType::Int32:
+    return fn(TypeTag<int32_t>{});
+  case DType::Int8:
+    return fn(TypeTag<int8_t>{});
+  default:
+    throw std::invalid_argument("Unknown dtype.");
+  }
+}
+
+/**
+ * @brief Size in bytes of one element.
+ */
+auto dtype_size(DType dtype) -> size_t;
+
+/**
+ * @brief Name of the dtype, as used in error messages.
+ */
+auto dtype_name(DType dtype) -> std::string_view;
+
+auto is_floating_point(DType dtype) -> bool;
+
+/**
+ * @brief Dtype of the result of a binary op over `lhs` and `rhs`.
+ *
+ * @details Mirrors the usual promotion lattice:
+ * - floating point types win over integer types;
+ * - within a category, the wider type wins;
+ * - Float16 and BFloat16 promote to Float32, as neither can represent the
+ *   other.
+ */
+auto promote_types(DType lhs, DType rhs) -> DType;
+
+/**
+ * @brief Converts `numel` dense elements from `src_dtype` to `dst_dtype`.
+ *
+ * @details Float32 to and from Float16 use F16C and Float32 to and from
+ * BFloat16 use AVX2 when the host supports them, every other pair goes
+ * through `scalar_cast`. Large buffers are converted in parallel.
+ */
+auto convert(const void *src, DType src_dtype, void *dst, DType dst_dtype,
+             size_t numel) -> void;
+} // namespace synapse
+
+#endif // !SYNAPSE_DTYPE_H
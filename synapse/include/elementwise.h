@@ -0,0 +1,138 @@
+#ifndef SYNAPSE_ELEMENTWISE_H
+#define SYNAPSE_ELEMENTWISE_H
+
+#include "cpu.h"
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <type_traits>
+
+namespace synapse {
+
+/**
+ * @brief Element-wise ops of func.h.
+ *
+ * @details Naming the ops lets the eager kernels and the lazy fused
+ * evaluator share a single scalar definition of every op, so both paths
+ * produce the same values.
+ */
+enum class ElementwiseOp {
+  // Binary
+  Add,
+  Sub,
+  Mul,
+  Div,
+  Maximum,
+  Minimum,
+  // Unary
+  Neg,
+  Abs,
+  Exp,
+  Log,
+  Sqrt,
+  Relu,
+  Sigmoid,
+  Tanh,
+  Gelu,
+};
+
+constexpr size_t ELEMENTWISE_OPS = static_cast<size_t>(ElementwiseOp::Gelu) + 1;
+
+/**
+ * @brief Whether the op takes two operands.
+ */
+constexpr auto is_binary(ElementwiseOp op) -> bool {
+  return op == ElementwiseOp::Add || op == ElementwiseOp::Sub ||
+         op == ElementwiseOp::Mul || op == ElementwiseOp::Div ||
+         op == ElementwiseOp::Maximum || op == ElementwiseOp::Minimum;
+}
+
+/**
+ * @brief Whether the op is only defined on real numbers, integer operands are
+ * then promoted to Float32.
+ */
+constexpr auto is_floating_point_op(ElementwiseOp op) -> bool {
+  return op == ElementwiseOp::Div || op == ElementwiseOp::Exp ||
+         op == ElementwiseOp::Log || op == ElementwiseOp::Sqrt ||
+         op == ElementwiseOp::Sigmoid || op == ElementwiseOp::Tanh ||
+         op == ElementwiseOp::Gelu;
+}
+
+/**
+ * @brief Scalar definition of a binary op, computed in `T`.
+ */
+template <ElementwiseOp Op, typename T = float>
+inline auto binary_scalar(T lhs, T rhs) -> T {
+  static_assert(is_binary(Op), "Op is not a binary op.");
+  if constexpr (Op == ElementwiseOp::Add) {
+    return lhs + rhs;
+  } else if constexpr (Op == ElementwiseOp::Sub) {
+    return lhs - rhs;
+  } else if constexpr (Op == ElementwiseOp::Mul) {
+    return lhs * rhs;
+  } else if constexpr (Op == ElementwiseOp::Div) {
+    return lhs / rhs;
+  } else if constexpr (Op == ElementwiseOp::Maximum) {
+    return lhs >= rhs ? lhs : rhs;
+  } else {
+    return lhs <= rhs ? lhs : rhs;
+  }
+}
+
+/**
+ * @brief Scalar definition of a unary op, computed in `T`.
+ */
+template <ElementwiseOp Op, typename T = float>
+inline auto unary_scalar(T value) -> T {
+  static_assert(!is_binary(Op), "Op is not a unary op.");
+  if constexpr (Op == ElementwiseOp::Neg) {
+    return -value;
+  } else if constexpr (Op == ElementwiseOp::Abs) {
+    if constexpr (std::is_integral_v<T>) {
+      return value < 0 ? -value : value;
+    } else {
+      return std::fabs(value);
+    }
+  } else if constexpr (Op == ElementwiseOp::Exp) {
+    return static_cast<T>(std::exp(value));
+  } else if constexpr (Op == ElementwiseOp::Log) {
+    return static_cast<T>(std::log(value));
+  } else if constexpr (Op == ElementwiseOp::Sqrt) {
+    return static_cast<T>(std::sqrt(value));
+  } else if constexpr (Op == ElementwiseOp::Relu) {
+    return value > T{0} ? value : T{0};
+  } else if constexpr (Op == ElementwiseOp::Sigmoid) {
+    return static_cast<T>(T{1} / (T{1} + std::exp(-value)));
+  } else if constexpr (Op == ElementwiseOp::Tanh) {
+    return static_cast<T>(std::tanh(value));
+  } else {
+    // Exact GELU, x * Phi(x) with Phi the standard normal CDF
+    using R = std::conditional_t<std::is_floating_point_v<T>, T, float>;
+    const auto x = static_cast<R>(value);
+    return static_cast<T>(x * (R{1} + std::erf(x / std::numbers::sqrt2_v<R>)) /
+                          R{2});
+  }
+}
+
+/**
+ * @brief Inner loop of an element-wise op over `n` elements of one dtype.
+ *
+ * @details Same contract as the loops of `TensorIterator`: `in` holds one
+ * pointer per operand, `strides` the element strides of the output then of
+ * every operand.
+ */
+using ElementwiseKernel = void (*)(void *out, const void *const *in,
+                                   const size_t *strides, size_t n);
+
+/**
+ * @brief Kernels of the eager element-wise ops of func.h.
+ *
+ * @details Every op has a `Baseline` kernel for every dtype. Float32,
+ * Float64 and Int32 also get SSE4.2, AVX2 and AVX-512 builds of the same
+ * loops, vectorized by the compiler for each instruction set.
+ */
+auto elementwise_kernels()
+    -> KernelRegistry<ElementwiseOp, ElementwiseKernel> &;
+} // namespace synapse
+
+#endif // !SYNAPSE_ELEMENTWISE_H
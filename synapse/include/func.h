@@ -2,12 +2,121 @@
 #define FUNC_H
 
 #include "tensor.h"
+#include <cstddef>
+#include <vector>
 
 namespace synapse {
+// Element-wise ops compute in the promoted dtype of their operands (see
+// promote_types), integers are promoted to float32 by div and the
+// transcendental ops
+
+// Binary element-wise ops, operands are broadcasted against each other
 auto add(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
+auto sub(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
 auto mul(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
+auto div(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
+auto maximum(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
+auto minimum(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
+
+// Unary element-wise ops
+auto neg(const Tensor &tensor) -> Tensor;
+auto abs(const Tensor &tensor) -> Tensor;
+auto exp(const Tensor &tensor) -> Tensor;
+auto log(const Tensor &tensor) -> Tensor;
+auto sqrt(const Tensor &tensor) -> Tensor;
+auto relu(const Tensor &tensor) -> Tensor;
+auto sigmoid(const Tensor &tensor) -> Tensor;
+auto tanh(const Tensor &tensor) -> Tensor;
+// Exact GELU, x * Phi(x) with Phi the standard normal CDF
+auto gelu(const Tensor &tensor) -> Tensor;
+
+// Reductions over `dims`, every dimension when `dims` is empty. Reduced
+// dimensions are dropped from the result unless `keepdim` is set. See
+// `reduce` for the result dtypes, max and min split the gradient evenly
+// between tied elements
+auto sum(const Tensor &tensor, const std::vector<size_t> &dims = {},
+         bool keepdim = false) -> Tensor;
+auto mean(const Tensor &tensor, const std::vector<size_t> &dims = {},
+          bool keepdim = false) -> Tensor;
+auto max(const Tensor &tensor, const std::vector<size_t> &dims = {},
+         bool keepdim = false) -> Tensor;
+auto min(const Tensor &tensor, const std::vector<size_t> &dims = {},
+         bool keepdim = false) -> Tensor;
+// Divides by `count - correction`, the unbiased estimator by default
+auto var(const Tensor &tensor, const std::vector<size_t> &dims = {},
+         bool keepdim = false, size_t correction = 1) -> Tensor;
+// L2 norm
+auto norm(const Tensor &tensor, const std::vector<size_t> &dims = {},
+          bool keepdim = false) -> Tensor;
+
+// Int32 index of the first extremum along `dim`, or into the flattened
+// tensor. Not differentiable
+auto argmax(const Tensor &tensor) -> Tensor;
+auto argmax(const Tensor &tensor, size_t dim, bool keepdim = false) -> Tensor;
+auto argmin(const Tensor &tensor) -> Tensor;
+auto argmin(const Tensor &tensor, size_t dim, bool keepdim = false) -> Tensor;
+
 auto matmul(const Tensor &tensor_1, const Tensor &tensor_2) -> Tensor;
 
+// Out variants write the result into `out` and return it, so loops reusing
+// their buffers never allocate. `out` must have the result shape and dtype,
+// and may overlap the operands: an operand that is the same view as `out` is
+// read in place, any other overlap goes through a temporary. In-place
+// variants `op_` write into their first operand. Both are evaluated eagerly,
+// even in lazy mode, and are not differentiable: they throw
+// std::logic_error when an operand or `out` requires grad while grad mode
+// is enabled, and std::invalid_argument when `out` does not fit.
+//
+// ### Example
+// ```
+// synapse::Tensor acc = synapse::Tensor::zeros({batch, dim});
+// for (const synapse::Tensor &x : residuals) {
+//   synapse::add_(acc, x);
+// }
+// ```
+auto add(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+auto sub(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+auto mul(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+auto div(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+auto maximum(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+auto minimum(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+auto add_(Tensor &tensor_1, const Tensor &tensor_2) -> Tensor &;
+auto sub_(Tensor &tensor_1, const Tensor &tensor_2) -> Tensor &;
+auto mul_(Tensor &tensor_1, const Tensor &tensor_2) -> Tensor &;
+auto div_(Tensor &tensor_1, const Tensor &tensor_2) -> Tensor &;
+auto maximum_(Tensor &tensor_1, const Tensor &tensor_2) -> Tensor &;
+auto minimum_(Tensor &tensor_1, const Tensor &tensor_2) -> Tensor &;
+
+auto neg(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto abs(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto exp(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto log(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto sqrt(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto relu(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto sigmoid(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto tanh(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto gelu(const Tensor &tensor, Tensor &out) -> Tensor &;
+auto neg_(Tensor &tensor) -> Tensor &;
+auto abs_(Tensor &tensor) -> Tensor &;
+auto exp_(Tensor &tensor) -> Tensor &;
+auto log_(Tensor &tensor) -> Tensor &;
+auto sqrt_(Tensor &tensor) -> Tensor &;
+auto relu_(Tensor &tensor) -> Tensor &;
+auto sigmoid_(Tensor &tensor) -> Tensor &;
+auto tanh_(Tensor &tensor) -> Tensor &;
+auto gelu_(Tensor &tensor) -> Tensor &;
+
+// Writes the product straight into a dense `out`, and through a temporary
+// when `out` is strided, overlaps an operand or is half precision
+auto matmul(const Tensor &tensor_1, const Tensor &tensor_2, Tensor &out)
+    -> Tensor &;
+
 auto is_close(const Tensor &tensor_1, const Tensor &tensor_2, float tol = 1e-5F)
     -> bool;
 } // namespace synapse
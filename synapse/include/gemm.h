@@ -0,0 +1,207 @@
+#ifndef SYNAPSE_GEMM_H
+#define SYNAPSE_GEMM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Micro-kernel families available to the GEMM engine.
+ *
+ * @details The best supported backend is selected at runtime from the CPU
+ * features reported by the host. `Scalar` is portable C++ and is always
+ * available; the others are only usable on x86-64 CPUs exposing the matching
+ * instruction sets.
+ */
+enum class GemmBackend { Scalar, Avx2, Avx512 };
+
+/**
+ * @brief Activations `sgemm` can apply to its output, see `GemmEpilogue`.
+ */
+enum class Activation { None, Relu, Gelu };
+
+/**
+ * @brief Element-wise work fused into the end of `sgemm`.
+ *
+ * @details Every element becomes `activation(C(i, j) + bias[i * rs_bias +
+ * j * cs_bias])`, computed on each tile of C right after its last depth
+ * block so the tile is still in cache. A bias per column of C (e.g. the
+ * output features of a linear layer) has `rs_bias = 0` and `cs_bias = 1`,
+ * a bias per row (e.g. the output channels of a convolution) the opposite.
+ * Without a bias only the activation is applied.
+ */
+struct GemmEpilogue {
+  const float *bias = nullptr;
+  size_t rs_bias = 0;
+  size_t cs_bias = 1;
+  Activation activation = Activation::None;
+};
+
+/**
+ * @brief Returns the backend currently used by `sgemm`.
+ */
+auto gemm_backend() -> GemmBackend;
+
+/**
+ * @brief Checks whether the host can run the given backend.
+ */
+auto gemm_backend_supported(GemmBackend backend) -> bool;
+
+/**
+ * @brief Forces `sgemm` to use a specific backend.
+ *
+ * @throws std::invalid_argument if the host does not support the backend.
+ *
+ * @details Mostly useful to validate every micro-kernel against each other in
+ * tests and to compare them in benchmarks.
+ */
+auto set_gemm_backend(GemmBackend backend) -> void;
+
+/**
+ * @brief Single precision general matrix multiplication, C = A * B.
+ *
+ * @param m Rows of A and C.
+ * @param n Columns of B and C.
+ * @param k Columns of A and rows of B.
+ * @param a Pointer to A(0, 0).
+ * @param rs_a Element distance between consecutive rows of A.
+ * @param cs_a Element distance between consecutive columns of A.
+ * @param b Pointer to B(0, 0).
+ * @param rs_b Element distance between consecutive rows of B.
+ * @param cs_b Element distance between consecutive columns of B.
+ * @param c Pointer to the row-major output C(0, 0).
+ * @param ldc Element distance between consecutive rows of C.
+ * @param accumulate If true computes C += A * B instead of overwriting C.
+ * @param epilogue Bias and activation applied to the result.
+ *
+ * @details Operands are described by arbitrary row/column strides, so
+ * transposed inputs do not have to be copied before the call: they are read
+ * once while packing. The engine follows the usual Goto/BLIS layering:
+ * 1. B is packed into KC x NC panels that stay resident in L2/L3.
+ * 2. A is packed into MC x KC blocks that stay resident in L2.
+ * 3. A register-blocked MR x NR micro-kernel streams both packed panels from
+ *    L1 and keeps the whole C tile in vector registers.
+ *
+ * Skinny problems (m == 1 or n == 1) skip packing, since each operand element
+ * is only used once and packing would double the memory traffic.
+ */
+auto sgemm(size_t m, size_t n, size_t k, const float *a, size_t rs_a,
+           size_t cs_a, const float *b, size_t rs_b, size_t cs_b, float *c,
+           size_t ldc, bool accumulate = false,
+           const GemmEpilogue &epilogue = {}) -> void;
+
+/**
+ * @brief Turns the int32 products of `igemm` back into real values.
+ *
+ * @details With A quantized as `a_scale * (A_q - a_zero_point)` and column j
+ * of B as `b_scale_j * (B_q - b_zero_point_j)`, the zero points are removed
+ * exactly in int32 and every element becomes `activation(scale_j * C_q +
+ * bias_j)`, with `scale_j = a_scale * b_scale_j`. Int8 outputs are then
+ * requantized to `round(x / out_scale) + out_zero_point`, saturated to
+ * [-128, 127]. Scales, biases and zero points shared by every column have a
+ * column stride of 0.
+ */
+struct Requantization {
+  int32_t a_zero_point = 0;
+  const int32_t *b_zero_points = nullptr;
+  size_t cs_b_zero_points = 0;
+  const float *scales = nullptr;
+  size_t cs_scales = 0;
+  const float *bias = nullptr;
+  size_t cs_bias = 1;
+  Activation activation = Activation::None;
+  float out_scale = 1.0F;
+  int32_t out_zero_point = 0;
+};
+
+/**
+ * @brief Largest depth `igemm` accepts, past which int32 sums could overflow.
+ */
+constexpr size_t IGEMM_MAX_DEPTH = size_t{1} << 16;
+
+/**
+ * @brief Int8 matrix multiplication with exact int32 accumulation, C = A * B.
+ *
+ * @throws std::invalid_argument if `k` exceeds `IGEMM_MAX_DEPTH`.
+ *
+ * @details Arguments are laid out like for `sgemm`. Both operands are packed
+ * in groups of 4 consecutive depth elements, which is the unit of the
+ * micro-kernels:
+ * - `Avx512` uses AVX-512 VNNI `vpdpbusd` when the host has it. The
+ *   instruction multiplies unsigned by signed bytes, so A is packed shifted
+ *   by +128 and `128 * sum(B column)` is subtracted from each result.
+ * - `Avx2` sign-extends both operands to 16 bits and uses `vpmaddwd`. Unlike
+ *   `vpmaddubsw`, whose 16-bit pair sums saturate for large operands, it
+ *   never loses precision.
+ * - `Scalar` is the portable fallback.
+ * Every backend gives the same exact result.
+ */
+auto igemm(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+           size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b, int32_t *c,
+           size_t ldc) -> void;
+
+/**
+ * @brief Same, with the results dequantized into `c` on each tile while it is
+ * still in cache.
+ * @throws std::invalid_argument if `requantization` has no scales.
+ */
+auto igemm(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+           size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b, float *c,
+           size_t ldc, const Requantization &requantization) -> void;
+
+/**
+ * @brief Same, with the results requantized to int8.
+ * @throws std::invalid_argument if `requantization` has no scales or a
+ * non-positive `out_scale`.
+ */
+auto igemm(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+           size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b, int8_t *c,
+           size_t ldc, const Requantization &requantization) -> void;
+
+/**
+ * @brief B operand of `igemm` packed ahead of time, for weights multiplied
+ * many times.
+ *
+ * @details Packing reads all of B, which costs as much as multiplying a
+ * single row by it. The layout is the one of the backend current at
+ * construction, which later products keep using.
+ */
+class PackedInt8Matrix {
+public:
+  /**
+   * @brief Packs the k x n matrix B, laid out like for `igemm`.
+   * @throws std::invalid_argument if `k` exceeds `IGEMM_MAX_DEPTH`.
+   */
+  PackedInt8Matrix(size_t k, size_t n, const int8_t *b, size_t rs_b,
+                   size_t cs_b);
+
+  [[nodiscard]] auto rows() const -> size_t;
+  [[nodiscard]] auto cols() const -> size_t;
+  [[nodiscard]] auto backend() const -> GemmBackend;
+  [[nodiscard]] auto data() const -> const int8_t *;
+  // Sum of every column, used to remove zero points
+  [[nodiscard]] auto col_sums() const -> const int32_t *;
+
+private:
+  size_t _k;
+  size_t _n;
+  GemmBackend _backend;
+  std::vector<int8_t> _data;
+  std::vector<int32_t> _col_sums;
+};
+
+// The products of `igemm` with a prepacked B
+auto igemm(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+           const PackedInt8Matrix &b, int32_t *c, size_t ldc) -> void;
+auto igemm(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+           const PackedInt8Matrix &b, float *c, size_t ldc,
+           const Requantization &requantization) -> void;
+auto igemm(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+           const PackedInt8Matrix &b, int8_t *c, size_t ldc,
+           const Requantization &requantization) -> void;
+
+} // namespace synapse
+
+#endif // !SYNAPSE_GEMM_H
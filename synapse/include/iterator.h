@@ -0,0 +1,155 @@
+#ifndef SYNAPSE_ITERATOR_H
+#define SYNAPSE_ITERATOR_H
+
+#include "ndarray.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Walks an output array and any number of broadcasted inputs in
+ * lockstep, handing out the longest possible 1D runs to an inner loop.
+ *
+ * @details On construction every input is broadcasted to the output shape
+ * (stride 0 along broadcasted axes), size 1 dimensions are dropped and
+ * adjacent dimensions that are contiguous with each other in *every* operand
+ * are merged. Element-wise kernels therefore only ever see the innermost
+ * dimension, which for dense operands covers the whole tensor in a single
+ * call, and can specialise on its strides (all 1, some 0, or arbitrary).
+ *
+ * Every operand must have the same dtype, the loops receive pointers of the
+ * matching element type `T` (float unless stated otherwise).
+ *
+ * ### Example
+ * ```
+ * synapse::TensorIterator iter(out, {&lhs, &rhs});
+ * iter.for_each([](float *dst, const float *const *src,
+ *                  const size_t *strides, size_t n) {
+ *   // strides[0] is the output stride, strides[1 + i] belongs to src[i]
+ * });
+ * ```
+ */
+class TensorIterator {
+public:
+  /**
+   * @brief Prepares an iteration over `output` and `inputs`.
+   *
+   * @throws std::invalid_argument if an input cannot be broadcasted to the
+   * output shape or the operands have different dtypes.
+   */
+  TensorIterator(NDArray &output, const std::vector<const NDArray *> &inputs);
+
+  /**
+   * @brief Same as above, with the output given as a raw strided Float32
+   * buffer.
+   */
+  TensorIterator(float *output, Shape shape, Strides output_strides,
+                 const std::vector<const NDArray *> &inputs);
+
+  // Accessors, describing the coalesced iteration space
+  [[nodiscard]] auto shape() const -> const Shape &;
+  [[nodiscard]] auto strides(size_t operand) const -> const Strides &;
+  [[nodiscard]] auto ninputs() const -> size_t;
+  [[nodiscard]] auto numel() const -> size_t;
+  [[nodiscard]] auto dtype() const -> DType;
+
+  /**
+   * @brief Runs `loop` over every element.
+   *
+   * @details `loop(T *out, const T *const *in, const size_t *strides,
+   * size_t n)` is called once per inner run of `n` elements.
+   */
+  template <typename T = float, typename Loop>
+  auto for_each(Loop &&loop) const -> void {
+    this->for_each<T>(loop, 0, this->numel());
+  }
+
+  /**
+   * @brief Runs `loop` over the elements in the linear range [begin, end).
+   *
+   * @details Ranges may start and stop anywhere, so the iteration space can
+   * be split into independent chunks.
+   */
+  template <typename T = float, typename Loop>
+  auto for_each(Loop &&loop, size_t begin, size_t end) const -> void {
+    if (begin >= end) {
+      return;
+    }
+    this->_check_dtype(dtype_of<T>::value);
+    const size_t ndim = this->_shape.size();
+    const size_t ninputs = this->_inputs.size();
+    const size_t inner = this->_shape[ndim - 1];
+
+    Shape index = synapse::pos_to_nd_index(begin, this->_shape);
+    std::vector<size_t> inner_strides(ninputs + 1);
+    for (size_t t = 0; t <= ninputs; ++t) {
+      inner_strides[t] = this->_strides[t][ndim - 1];
+    }
+    std::vector<const T *> in(ninputs);
+
+    size_t pos = begin;
+    while (pos < end) {
+      // Pointers to the first element of the current run
+      T *out = static_cast<T *>(this->_output) +
+               synapse::nd_index_to_pos(index, this->_strides[0]);
+      for (size_t t = 0; t < ninputs; ++t) {
+        in[t] = static_cast<const T *>(this->_inputs[t]) +
+                synapse::nd_index_to_pos(index, this->_strides[t + 1]);
+      }
+      const size_t n = std::min(inner - index[ndim - 1], end - pos);
+      loop(out, in.data(), inner_strides.data(), n);
+      pos += n;
+
+      // Moves to the start of the next run
+      index[ndim - 1] += n;
+      for (size_t d = ndim; d-- > 1 && index[d] == this->_shape[d];) {
+        index[d] = 0;
+        ++index[d - 1];
+      }
+    }
+  }
+
+  /**
+   * @brief Like `for_each`, splitting the elements across the thread pool.
+   *
+   * @details Runs serially when the output has a stride 0 dimension, since
+   * several positions then write to the same element and concurrent chunks
+   * would race on it.
+   */
+  template <typename T = float, typename Loop>
+  auto parallel_for_each(const Loop &loop,
+                         size_t grain_size = synapse::GRAIN_SIZE) const
+      -> void {
+    if (this->_overlapping_output()) {
+      this->for_each<T>(loop);
+      return;
+    }
+    synapse::parallel_for(0, this->numel(), grain_size,
+                          [this, &loop](size_t begin, size_t end) {
+                            this->for_each<T>(loop, begin, end);
+                          });
+  }
+
+private:
+  void *_output;
+  std::vector<const void *> _inputs;
+  DType _dtype;
+  Shape _shape;
+  // One entry per operand, the output first
+  std::vector<Strides> _strides;
+  size_t _numel;
+
+  TensorIterator(void *output, DType dtype, Shape shape,
+                 Strides output_strides,
+                 const std::vector<const NDArray *> &inputs);
+
+  auto _coalesce() -> void;
+  auto _check_dtype(DType dtype) const -> void;
+  [[nodiscard]] auto _overlapping_output() const -> bool;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_ITERATOR_H
@@ -0,0 +1,89 @@
+#ifndef SYNAPSE_LAZY_H
+#define SYNAPSE_LAZY_H
+
+#include "elementwise.h"
+#include "ndarray.h"
+#include <memory>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Thread local switch making element-wise ops deferred.
+ *
+ * @details While enabled, the ops of func.h listed in `ElementwiseOp` do not
+ * compute anything. They return a tensor whose storage holds the expression
+ * producing it, and the expression of a still deferred operand is inlined
+ * into the new one. The whole chain is then evaluated in a single fused pass
+ * over memory the first time the elements are accessed (`Tensor::eval()`,
+ * `data()`, `to_string()`, being the input of an eager op, ...), without
+ * ever writing the intermediate results.
+ *
+ * Operands are read when the expression is evaluated, not when the op is
+ * called, so they must not be modified in between.
+ */
+class LazyMode {
+public:
+  static auto is_enabled() -> bool;
+  static auto set_enabled(bool enabled) -> void;
+};
+
+/**
+ * @brief Enables lazy mode for the lifetime of the guard.
+ *
+ * ### Example
+ * ```
+ * synapse::Tensor out = [&] {
+ *   synapse::LazyGuard lazy;
+ *   return synapse::relu(synapse::add(synapse::mul(a, b), c));
+ * }();
+ * out.eval(); // One pass reading a, b and c and writing out
+ * ```
+ */
+class LazyGuard {
+public:
+  LazyGuard(const LazyGuard &) = delete;
+  LazyGuard(LazyGuard &&) = delete;
+  auto operator=(const LazyGuard &) -> LazyGuard & = delete;
+  auto operator=(LazyGuard &&) -> LazyGuard & = delete;
+  explicit LazyGuard(bool enabled = true);
+  ~LazyGuard();
+
+private:
+  bool _previous;
+};
+
+/**
+ * @brief Node of a deferred element-wise expression.
+ *
+ * @details Leaves hold a view over the array they read, every other node
+ * applies `op` to its operands, broadcasted to `shape`.
+ */
+struct LazyExpr {
+  ElementwiseOp op;
+  Shape shape;
+  std::unique_ptr<NDArray> leaf;
+  std::vector<std::shared_ptr<const LazyExpr>> operands;
+};
+
+/**
+ * @brief Creates the deferred result of applying `op` to `inputs`.
+ *
+ * @throws std::invalid_argument if the inputs cannot be broadcasted together
+ * or their number does not match the op.
+ */
+auto lazy_elementwise(ElementwiseOp op,
+                      const std::vector<const NDArray *> &inputs) -> NDArray;
+
+/**
+ * @brief Evaluates `expr` into the dense row-major buffer `out`.
+ *
+ * @details The expression is flattened into a small register program, run
+ * over blocks of a few hundred elements that stay in L1, so every leaf is
+ * read once and `out` is written once regardless of the expression depth.
+ * Sub-expressions shared inside the DAG are computed once per block.
+ */
+auto evaluate(const LazyExpr &expr, float *out) -> void;
+} // namespace synapse
+
+#endif // !SYNAPSE_LAZY_H
@@ -0,0 +1,39 @@
+#ifndef SYNAPSE_MAPPED_FILE_H
+#define SYNAPSE_MAPPED_FILE_H
+
+#include <cstddef>
+#include <filesystem>
+
+namespace synapse {
+
+/**
+ * @brief Private memory mapping of a whole file.
+ *
+ * @details Pages are read from disk the first time they are touched, and
+ * writes copy the touched page instead of reaching the file. Storages
+ * viewing the mapping hold it through a `shared_ptr`, so it stays mapped
+ * until the last of them is destroyed. An empty file maps to no data.
+ */
+class MappedFile {
+public:
+  MappedFile(const MappedFile &) = delete;
+  MappedFile(MappedFile &&) = delete;
+  auto operator=(const MappedFile &) -> MappedFile & = delete;
+  auto operator=(MappedFile &&) -> MappedFile & = delete;
+
+  /**
+   * @throws std::system_error if the file cannot be opened or mapped.
+   */
+  explicit MappedFile(const std::filesystem::path &path);
+  ~MappedFile();
+
+  [[nodiscard]] auto data() const -> std::byte *;
+  [[nodiscard]] auto size() const -> size_t;
+
+private:
+  void *_data;
+  size_t _size;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_MAPPED_FILE_H
@@ -1,9 +1,20 @@
 #ifndef NDARRAY_H
 #define NDARRAY_H
 
+#include "accessor.h"
+#include "dtype.h"
+#include "storage.h"
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace synapse {
@@ -26,6 +37,22 @@ using Shape = std::vector<size_t>;
  */
 using Strides = std::vector<size_t>;
 
+/**
+ * @brief Number of elements described by a shape.
+ *
+ * @details A 0-dimensional shape describes a single scalar element.
+ */
+auto shape_numel(const Shape &shape) -> size_t;
+
+/**
+ * @brief Computes the row-major (C order) strides of a shape.
+ *
+ * @param shape The shape of the tensor.
+ * @return Strides where `strides[i] = shape[i + 1] * strides[i + 1]` and the
+ * last stride is 1. A 0-dimensional shape has no strides.
+ */
+auto contiguous_strides(const Shape &shape) -> Strides;
+
 /**
  * @brief Maps multi-dimensional coordinates to a linear memory offset.
  *
@@ -71,37 +98,180 @@ auto shape_broadcast(const Shape &shape_1, const Shape &shape_2) -> Shape;
 /**
  * @brief An N-dimensional array (Tensor) container.
  *
- * @details NDArray manages a flat block of memory and uses a `Shape` and
- * `Strides` to provide a multi-dimensional view of that data.
+ * @details NDArray is a view over a reference-counted `Storage`: an offset
+ * into the flat buffer plus a `Shape` and `Strides` describing how to walk it.
+ * Slicing, transposing, reshaping and broadcasting only create a new view over
+ * the same storage, so they never copy elements. Use `contiguous()` when a
+ * dense row-major buffer is required.
+ *
+ * Elements have the `DType` of the storage, Float32 unless requested
+ * otherwise. `data()` and `operator()` are the Float32 accessors, the other
+ * dtypes are reached through `data_ptr<T>()` and `at<T>()`.
+ *
+ * A copy of an array covering its whole storage shares the buffer until
+ * either side is written, through the non-const accessors, so passing
+ * arrays by value or keeping them in containers does not copy elements.
+ * Reading through the const accessors never copies.
  *
  * ### Example
  * ```
  * synapse::NDArray arr({1, 2, 3, 4}, {2, 2});
  * float val = arr(0, 1); // Accesses first row, second column
+ * synapse::NDArray col = arr.transpose(0, 1).slice(0, 1, 2); // No copies
  * ```
  */
 class NDArray {
 public:
-  NDArray(const NDArray &) = default;
+  // Copies are independent dense values, only views share the storage.
+  // Copying a whole dense array is O(1), see `Storage::share`.
+  NDArray(const NDArray &other);
   NDArray(NDArray &&) = default;
-  auto operator=(const NDArray &) -> NDArray & = default;
+  auto operator=(const NDArray &other) -> NDArray &;
   auto operator=(NDArray &&) -> NDArray & = default;
   NDArray(std::vector<float> data, Shape shape);
+  // Rounds the values to `dtype`
+  NDArray(const std::vector<float> &data, Shape shape, DType dtype);
+  NDArray(std::shared_ptr<Storage> storage, size_t offset, Shape shape,
+          Strides strides);
   ~NDArray() = default;
 
+  // Factories
+
+  /**
+   * @brief Creates a dense array whose elements are left uninitialised.
+   *
+   * @details Meant for outputs that are about to be fully overwritten, so
+   * the buffer is neither zero-filled nor copied from a vector.
+   */
+  static auto empty(const Shape &shape, DType dtype = DType::Float32)
+      -> NDArray;
+  static auto zeros(const Shape &shape, DType dtype = DType::Float32)
+      -> NDArray;
+
   // Accessors
   [[nodiscard]] auto shape() const -> const Shape &;
   [[nodiscard]] auto strides() const -> const Strides &;
-  auto data() -> std::vector<float> &;
-  [[nodiscard]] auto data() const -> const std::vector<float> &;
+  [[nodiscard]] auto storage() const -> const std::shared_ptr<Storage> &;
+  [[nodiscard]] auto offset() const -> size_t;
+  [[nodiscard]] auto dtype() const -> DType;
+  [[nodiscard]] auto element_size() const -> size_t;
+  // Pointer to the first element, whatever the dtype
+  auto raw_data() -> void *;
+  [[nodiscard]] auto raw_data() const -> const void *;
+  // Float32 only, see `data_ptr`
+  auto data() -> float *;
+  [[nodiscard]] auto data() const -> const float *;
+
+  /**
+   * @brief Typed pointer to the first element.
+   * @throws std::invalid_argument if `T` does not match the dtype.
+   */
+  template <typename T> auto data_ptr() -> T * {
+    this->_check_dtype(dtype_of<T>::value);
+    return static_cast<T *>(this->raw_data());
+  }
+  template <typename T> [[nodiscard]] auto data_ptr() const -> const T * {
+    this->_check_dtype(dtype_of<T>::value);
+    return static_cast<const T *>(this->raw_data());
+  }
   [[nodiscard]] auto ndim() const -> size_t;
   [[nodiscard]] auto size() const -> size_t;
 
   // Methods
-  auto is_contigous() -> bool;
+  [[nodiscard]] auto is_contigous() const -> bool;
+  // Formatted with the current print options, see `operator<<`
   [[nodiscard]] auto to_string() const -> std::string;
+  // Elements converted to float
+  [[nodiscard]] auto to_vector() const -> std::vector<float>;
 
-  // Allows accessing elements of the ndarray directly
+  /**
+   * @brief Returns the elements converted to `dtype`.
+   *
+   * @details Shares the storage when the dtype already matches, otherwise
+   * returns a new dense array (see `synapse::convert`).
+   */
+  [[nodiscard]] auto to(DType dtype) const -> NDArray;
+
+  // Views (no data is copied)
+
+  /**
+   * @brief Selects the range [start, end) with the given step along `dim`.
+   * @throws std::out_of_range if the dimension or the range is invalid.
+   */
+  [[nodiscard]] auto slice(size_t dim, size_t start, size_t end,
+                           size_t step = 1) const -> NDArray;
+
+  /**
+   * @brief Swaps two dimensions.
+   * @throws std::out_of_range if a dimension is invalid.
+   */
+  [[nodiscard]] auto transpose(size_t dim_0, size_t dim_1) const -> NDArray;
+
+  /**
+   * @brief Reorders all dimensions, output dimension `i` is input `dims[i]`.
+   * @throws std::invalid_argument if `dims` is not a permutation.
+   */
+  [[nodiscard]] auto permute(const Shape &dims) const -> NDArray;
+
+  /**
+   * @brief Reinterprets the elements with a new shape.
+   * @throws std::invalid_argument if the number of elements differs.
+   *
+   * @details Returns a view whenever the current strides allow expressing the
+   * new shape, otherwise falls back to a contiguous copy.
+   */
+  [[nodiscard]] auto reshape(const Shape &shape) const -> NDArray;
+
+  /**
+   * @brief Broadcasts the array to `shape` using stride 0 on expanded axes.
+   * @throws std::invalid_argument if the shapes are not broadcast compatible.
+   *
+   * @details Follows the same rules as `shape_broadcast`, except that the
+   * result must be exactly `shape`. The returned view aliases elements, so it
+   * should be treated as read-only.
+   */
+  [[nodiscard]] auto broadcast_to(const Shape &shape) const -> NDArray;
+  [[nodiscard]] auto expand(const Shape &shape) const -> NDArray;
+
+  /**
+   * @brief Returns a row-major dense array with the same elements.
+   *
+   * @details This is a no-op (sharing the storage) when the array is already
+   * contiguous, otherwise the elements are copied into a new storage.
+   */
+  [[nodiscard]] auto contiguous() const -> NDArray;
+
+  /**
+   * @brief Copies the elements of `src` into this array, in place.
+   * @throws std::invalid_argument if `src` cannot be broadcasted to this shape.
+   *
+   * @details Writes go through the strides, so copying into a view updates
+   * the storage it was taken from. Elements are converted to the dtype of
+   * this array.
+   */
+  auto copy_(const NDArray &src) -> NDArray &;
+
+  /**
+   * @brief Allocation-free element access for arrays of rank `Rank`.
+   * @throws std::invalid_argument if the rank or the element type do not
+   * match.
+   *
+   * @details Checks the array once, so element accesses through the
+   * returned accessor are plain pointer arithmetic (see `Accessor`).
+   * Evaluates a deferred array.
+   */
+  template <size_t Rank, typename T = float>
+  auto accessor() -> Accessor<T, Rank> {
+    return {this->data_ptr<T>(), this->_extents<Rank>(this->_shape),
+            this->_extents<Rank>(this->_strides)};
+  }
+  template <size_t Rank, typename T = float>
+  [[nodiscard]] auto accessor() const -> Accessor<const T, Rank> {
+    return {this->data_ptr<T>(), this->_extents<Rank>(this->_shape),
+            this->_extents<Rank>(this->_strides)};
+  }
+
+  // Allows accessing elements of the ndarray directly, always bounds checked
   template <typename... Indices>
   auto operator()(Indices... indices) const -> const float & {
     return this->data()[_operator_parenthesis(indices...)];
@@ -110,34 +280,137 @@ public:
   auto operator()(Indices... indices) -> float & {
     return this->data()[_operator_parenthesis(indices...)];
   }
+  template <typename T, typename... Indices>
+  auto at(Indices... indices) const -> const T & {
+    return this->data_ptr<T>()[_operator_parenthesis(indices...)];
+  }
+  template <typename T, typename... Indices>
+  auto at(Indices... indices) -> T & {
+    return this->data_ptr<T>()[_operator_parenthesis(indices...)];
+  }
 
 private:
-  std::vector<float> _data;
+  std::shared_ptr<Storage> _storage;
+  size_t _offset;
   Shape _shape;
   Strides _strides;
   size_t _ndim;
   size_t _size;
 
+  auto _check_dtype(DType dtype) const -> void;
+  // Whether a copy can share the storage instead of copying the elements
+  [[nodiscard]] auto _shares_on_copy() const -> bool;
+
   template <typename... Indices>
   auto _operator_parenthesis(Indices... indices) const -> size_t {
     static_assert(sizeof...(indices) > 0, "At least one index is required.");
-    Shape idx_vec{static_cast<size_t>(indices)...};
+    const std::array<size_t, sizeof...(Indices)> index{
+        static_cast<size_t>(indices)...};
 
     // Bounds checking
-    if (idx_vec.size() != this->ndim()) {
+    if (index.size() != this->ndim()) {
       throw std::out_of_range(
           "Number of indices does not match the number of dimensions.");
     }
-    for (size_t i = 0; i < idx_vec.size(); i++) {
-      if (idx_vec[i] >= this->shape()[i]) {
+    size_t pos = 0;
+    for (size_t i = 0; i < index.size(); i++) {
+      if (index[i] >= this->_shape[i]) {
         throw std::out_of_range("Index out of bounds for dimension " +
                                 std::to_string(i));
       }
+      pos += index[i] * this->_strides[i];
     }
+    return pos;
+  }
 
-    return synapse::nd_index_to_pos(idx_vec, this->strides());
+  template <size_t Rank>
+  auto _extents(const std::vector<size_t> &values) const
+      -> std::array<size_t, Rank> {
+    if (this->_ndim != Rank) {
+      throw std::invalid_argument(std::format(
+          "Cannot access a {}D array through a {}D accessor.", this->_ndim,
+          Rank));
+    }
+    std::array<size_t, Rank> out{};
+    std::copy_n(values.begin(), Rank, out.begin());
+    return out;
   }
 };
+
+/**
+ * @brief How arrays are printed, see `set_print_options`.
+ */
+struct PrintOptions {
+  // Decimals of floating point elements
+  size_t precision = 3;
+  // Arrays with more elements than this are summarized
+  size_t threshold = 1000;
+  // Elements kept at each end of a summarized dimension, 0 leaves only `...`
+  size_t edge_items = 3;
+};
+
+auto print_options() -> PrintOptions;
+auto set_print_options(const PrintOptions &options) -> void;
+
+/**
+ * @brief Formats `array` and hands the text to `sink` in bounded chunks.
+ *
+ * @details Elements are read through the strides of `array` and converted
+ * with `std::to_chars`, so the output is locale independent and no buffer
+ * proportional to the array is ever built. Arrays of more than
+ * `options.threshold` elements are summarized like NumPy does: dimensions
+ * longer than twice `options.edge_items` only show their edges around a
+ * `...`.
+ */
+auto write_array(const NDArray &array, const PrintOptions &options,
+                 const std::function<void(std::string_view)> &sink) -> void;
+
+/**
+ * @brief Streams `array` with the current print options.
+ *
+ * ### Example
+ * ```
+ * synapse::NDArray big = synapse::NDArray::zeros({1000, 1000});
+ * std::cout << big; // [[0.000, 0.000, 0.000, ..., 0.000, 0.000, 0.000], ...
+ * ```
+ */
+auto operator<<(std::ostream &os, const NDArray &array) -> std::ostream &;
 } // namespace synapse
 
+/**
+ * @brief `std::format` support, the precision of floating point elements can
+ * be set in the format spec (e.g. `std::format("{:.5}", array)`).
+ */
+template <> struct std::formatter<synapse::NDArray> {
+  constexpr auto parse(std::format_parse_context &ctx)
+      -> std::format_parse_context::iterator {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it == '.') {
+      size_t precision = 0;
+      for (++it; it != ctx.end() && *it >= '0' && *it <= '9'; ++it) {
+        precision = (precision * 10) + static_cast<size_t>(*it - '0');
+      }
+      this->_precision = precision;
+    }
+    if (it != ctx.end() && *it != '}') {
+      throw std::format_error("Invalid format spec for an array.");
+    }
+    return it;
+  }
+
+  auto format(const synapse::NDArray &array, std::format_context &ctx) const
+      -> std::format_context::iterator {
+    synapse::PrintOptions options = synapse::print_options();
+    options.precision = this->_precision.value_or(options.precision);
+    auto out = ctx.out();
+    synapse::write_array(array, options, [&out](std::string_view chunk) {
+      out = std::copy(chunk.begin(), chunk.end(), out);
+    });
+    return out;
+  }
+
+private:
+  std::optional<size_t> _precision;
+};
+
 #endif // !NDARRAY_H
@@ -0,0 +1,282 @@
+#ifndef SYNAPSE_NN_H
+#define SYNAPSE_NN_H
+
+#include "gemm.h"
+#include "sparse.h"
+#include "tensor.h"
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Neural network layers.
+ *
+ * @details When every operand is Float32 and none requires grad, the
+ * functional ops run fused inference kernels. Otherwise they are built from
+ * the differentiable ops of func.h (or record their own backward), so the
+ * layers can be trained and other dtypes go through the usual promotion.
+ */
+namespace synapse::nn {
+
+/**
+ * @brief Affine map over the last dimension, `activation(x W^T + b)`.
+ *
+ * @param input Tensor of shape (..., in_features).
+ * @param weight Tensor of shape (out_features, in_features).
+ * @param bias Optional tensor of shape (out_features).
+ * @param activation Activation applied to the result.
+ * @throws std::invalid_argument if the shapes do not match.
+ *
+ * @details Inference runs a single `sgemm` reading the weight through its
+ * transposed strides, the bias and activation being its epilogue, so the
+ * output is written to memory once.
+ */
+auto linear(const Tensor &input, const Tensor &weight,
+            const Tensor *bias = nullptr,
+            Activation activation = Activation::None) -> Tensor;
+
+/**
+ * @brief 2D cross-correlation, as in most deep learning frameworks.
+ *
+ * @param input Tensor of shape (batch, in_channels, height, width).
+ * @param weight Tensor of shape (out_channels, in_channels, kernel_h,
+ * kernel_w).
+ * @param bias Optional tensor of shape (out_channels).
+ * @param stride Step between two windows, along both spatial dimensions.
+ * @param padding Zeros added on every side of both spatial dimensions.
+ * @param activation Activation applied to the result.
+ * @throws std::invalid_argument if the shapes do not match or the kernel
+ * does not fit in the padded input.
+ * @return A Float32 tensor, whatever the dtype of the operands.
+ *
+ * @details Every image is unfolded into a matrix with one column per output
+ * pixel (im2col) and multiplied by the weight viewed as a matrix with one
+ * row per output channel. The bias and activation are the epilogue of that
+ * product.
+ */
+auto conv2d(const Tensor &input, const Tensor &weight,
+            const Tensor *bias = nullptr, size_t stride = 1,
+            size_t padding = 0, Activation activation = Activation::None)
+    -> Tensor;
+
+/**
+ * @brief Normalizes over the trailing dimensions of the shape of `weight`,
+ * then scales by `weight` and shifts by `bias`.
+ *
+ * @throws std::invalid_argument if the trailing dimensions of `input` do not
+ * match `weight`, or `bias` does not match `weight`.
+ *
+ * @details Inference computes the mean and variance of each row in a single
+ * pass (Welford's algorithm) and normalizes it in a second one.
+ */
+auto layer_norm(const Tensor &input, const Tensor &weight, const Tensor &bias,
+                float eps = 1e-5F) -> Tensor;
+
+/**
+ * @brief Exponentials along `dim` normalized to sum to 1.
+ *
+ * @throws std::out_of_range if `dim` is out of range.
+ *
+ * @details Inference uses the online softmax: the maximum and the sum of
+ * the exponentials are found together in a single pass over the input,
+ * rescaling the sum whenever the maximum grows, and a second pass over the
+ * output normalizes it.
+ */
+auto softmax(const Tensor &input, size_t dim) -> Tensor;
+
+/**
+ * @brief Rows of `weight` selected by `indices`.
+ *
+ * @param indices Tensor of any shape holding integral values, read as Int32.
+ * @param weight Tensor of shape (num_embeddings, embedding_dim).
+ * @throws std::invalid_argument if `weight` is not 2-dimensional.
+ * @throws std::out_of_range if an index is not a row of `weight`.
+ * @return A Float32 tensor of shape (..., embedding_dim).
+ *
+ * @details The gradient of `weight` is dense, zero outside of the selected
+ * rows. See `Embedding` for one holding the selected rows only.
+ */
+auto embedding(const Tensor &indices, const Tensor &weight) -> Tensor;
+
+/**
+ * @brief A layer, mapping an input tensor to an output tensor.
+ */
+class Module {
+public:
+  Module() = default;
+  Module(const Module &) = default;
+  Module(Module &&) = default;
+  auto operator=(const Module &) -> Module & = default;
+  auto operator=(Module &&) -> Module & = default;
+  virtual ~Module() = default;
+
+  [[nodiscard]] virtual auto forward(const Tensor &input) const -> Tensor = 0;
+
+  /**
+   * @brief The learnable tensors of the layer, empty when there are none.
+   */
+  virtual auto parameters() -> std::vector<Tensor *>;
+
+  auto operator()(const Tensor &input) const -> Tensor;
+};
+
+/**
+ * @brief Layer computing `linear`.
+ *
+ * ### Example
+ * ```
+ * synapse::nn::Linear hidden(784, 256, true, synapse::Activation::Relu);
+ * synapse::Tensor out = hidden(batch); // One fused GEMM in inference
+ * ```
+ */
+class Linear : public Module {
+public:
+  /**
+   * @brief Initializes the parameters from U(-1/sqrt(in), 1/sqrt(in)).
+   */
+  Linear(size_t in_features, size_t out_features, bool bias = true,
+         Activation activation = Activation::None);
+  Linear(Tensor weight, std::optional<Tensor> bias,
+         Activation activation = Activation::None);
+
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+  auto parameters() -> std::vector<Tensor *> override;
+
+  auto weight() -> Tensor &;
+  // Throws std::logic_error when the layer has no bias
+  auto bias() -> Tensor &;
+  [[nodiscard]] auto activation() const -> Activation;
+
+private:
+  Tensor _weight;
+  std::optional<Tensor> _bias;
+  Activation _activation;
+};
+
+/**
+ * @brief Layer computing `conv2d`.
+ */
+class Conv2d : public Module {
+public:
+  /**
+   * @brief Initializes the parameters from U(-1/sqrt(fan_in),
+   * 1/sqrt(fan_in)), with `fan_in = in_channels * kernel_size^2`.
+   */
+  Conv2d(size_t in_channels, size_t out_channels, size_t kernel_size,
+         size_t stride = 1, size_t padding = 0, bool bias = true,
+         Activation activation = Activation::None);
+  Conv2d(Tensor weight, std::optional<Tensor> bias, size_t stride = 1,
+         size_t padding = 0, Activation activation = Activation::None);
+
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+  auto parameters() -> std::vector<Tensor *> override;
+
+  auto weight() -> Tensor &;
+  // Throws std::logic_error when the layer has no bias
+  auto bias() -> Tensor &;
+
+private:
+  Tensor _weight;
+  std::optional<Tensor> _bias;
+  size_t _stride;
+  size_t _padding;
+  Activation _activation;
+};
+
+/**
+ * @brief Layer computing `layer_norm`, the weight starts at 1 and the bias
+ * at 0.
+ */
+class LayerNorm : public Module {
+public:
+  explicit LayerNorm(const Shape &normalized_shape, float eps = 1e-5F);
+
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+  auto parameters() -> std::vector<Tensor *> override;
+
+  auto weight() -> Tensor &;
+  auto bias() -> Tensor &;
+
+private:
+  Tensor _weight;
+  Tensor _bias;
+  float _eps;
+};
+
+/**
+ * @brief Layer computing `softmax` along `dim`.
+ */
+class Softmax : public Module {
+public:
+  explicit Softmax(size_t dim);
+
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+
+private:
+  size_t _dim;
+};
+
+/**
+ * @brief Layer computing `embedding`, a lookup table of learnable vectors.
+ *
+ * @details With `sparse` set, backward does not give the weight a dense
+ * gradient. It accumulates the gradient of the rows that were looked up in
+ * a `SparseTensor` instead, so its memory and the optimizer step scale with
+ * the batch rather than with the table.
+ *
+ * ### Example
+ * ```
+ * synapse::nn::Embedding table(1'000'000, 64, true);
+ * table.weight().set_requires_grad();
+ * synapse::sum(table(ids)).backward();
+ * table.sparse_grad().add_to(table.weight(), -learning_rate);
+ * table.zero_sparse_grad();
+ * ```
+ */
+class Embedding : public Module {
+public:
+  /**
+   * @brief Initializes the weight from N(0, 1).
+   */
+  Embedding(size_t num_embeddings, size_t embedding_dim, bool sparse = false);
+  explicit Embedding(Tensor weight, bool sparse = false);
+
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+  auto parameters() -> std::vector<Tensor *> override;
+
+  auto weight() -> Tensor &;
+
+  /**
+   * @brief Gradient of the weight accumulated by backward in sparse mode.
+   * @throws std::logic_error if no gradient has been computed.
+   */
+  [[nodiscard]] auto sparse_grad() const -> const SparseTensor &;
+  [[nodiscard]] auto has_sparse_grad() const -> bool;
+  auto zero_sparse_grad() -> void;
+
+private:
+  Tensor _weight;
+  bool _sparse;
+  // Shared with the backward nodes of the forward passes
+  std::shared_ptr<std::optional<SparseTensor>> _sparse_grad;
+};
+
+/**
+ * @brief Layer computing `synapse::gelu`.
+ */
+class GELU : public Module {
+public:
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+};
+
+/**
+ * @brief Layer computing `synapse::relu`.
+ */
+class ReLU : public Module {
+public:
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+};
+} // namespace synapse::nn
+
+#endif // !SYNAPSE_NN_H
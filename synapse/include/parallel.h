@@ -0,0 +1,165 @@
+#ifndef SYNAPSE_PARALLEL_H
+#define SYNAPSE_PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Default number of elements below which a loop is not split.
+ *
+ * @details Waking workers costs a few microseconds, which is roughly the
+ * time needed to stream this many floats through a simple element-wise op.
+ */
+constexpr size_t GRAIN_SIZE = 32768;
+
+/**
+ * @brief Number of threads used by parallel regions, the caller included.
+ *
+ * @details Defaults to the `SYNAPSE_NUM_THREADS` environment variable when
+ * set, otherwise to the number of hardware threads.
+ */
+auto get_num_threads() -> size_t;
+
+/**
+ * @brief Resizes the intra-op thread pool.
+ *
+ * @details A value of 1 disables parallelism entirely. Must not be called
+ * from inside a parallel region.
+ *
+ * @throws std::invalid_argument if `num_threads` is 0.
+ */
+auto set_num_threads(size_t num_threads) -> void;
+
+/**
+ * @brief How the workers of the thread pool are pinned to CPUs.
+ *
+ * @details `Node` restricts every worker to the CPUs of one NUMA node and
+ * `Core` to a single one of them (see placement.h). Threads are spread over
+ * the nodes of `numa_cpu_nodes` in contiguous blocks, the same way
+ * `parallel_run` deals out the chunks, so a chunk keeps running on the node
+ * where its pages were first written. The calling thread, which takes part
+ * as the first thread, is never pinned.
+ */
+enum class ThreadAffinity { None, Node, Core };
+
+/**
+ * @brief Current pinning of the workers.
+ *
+ * @details Defaults to the `SYNAPSE_THREAD_AFFINITY` environment variable
+ * (`none`, `node` or `core`) when set, otherwise to `None`.
+ */
+auto get_thread_affinity() -> ThreadAffinity;
+
+/**
+ * @brief Restarts the workers with `affinity`. Must not be called from
+ * inside a parallel region.
+ */
+auto set_thread_affinity(ThreadAffinity affinity) -> void;
+
+/**
+ * @brief Whether the calling thread is running a parallel region task.
+ */
+auto in_parallel_region() -> bool;
+
+/**
+ * @brief Runs `task(chunk)` for every chunk in [0, num_chunks) on the pool.
+ *
+ * @details Chunks are dealt to the threads in contiguous blocks, and a thread
+ * that has finished its own block steals the remaining chunks of the others.
+ * The first exception thrown by a task is rethrown on the calling thread once
+ * every thread has stopped. Nested calls, and calls made while the pool is
+ * busy with another region, run inline on the calling thread.
+ */
+auto parallel_run(size_t num_chunks, const std::function<void(size_t)> &task)
+    -> void;
+
+/**
+ * @brief Calls `fn(chunk_begin, chunk_end)` over disjoint chunks covering
+ * [begin, end), possibly in parallel.
+ *
+ * @details Ranges not larger than `grain_size` run directly on the calling
+ * thread. Larger ones are split in chunks of at least `grain_size` elements,
+ * with a few chunks per thread so stealing can balance uneven work.
+ *
+ * ### Example
+ * ```
+ * synapse::parallel_for(0, n, synapse::GRAIN_SIZE,
+ *                       [&](size_t begin, size_t end) {
+ *                         for (size_t i = begin; i < end; ++i) {
+ *                           out[i] = in[i] * 2;
+ *                         }
+ *                       });
+ * ```
+ */
+template <typename Fn>
+auto parallel_for(size_t begin, size_t end, size_t grain_size, const Fn &fn)
+    -> void {
+  if (begin >= end) {
+    return;
+  }
+  const size_t numel = end - begin;
+  const size_t grain = std::max<size_t>(grain_size, 1);
+  const size_t threads = synapse::get_num_threads();
+  if (numel <= grain || threads == 1 || synapse::in_parallel_region()) {
+    fn(begin, end);
+    return;
+  }
+  const size_t num_chunks =
+      std::min((numel + grain - 1) / grain, threads * 4);
+  const size_t chunk = (numel + num_chunks - 1) / num_chunks;
+  synapse::parallel_run(num_chunks, [&](size_t i) {
+    const size_t chunk_begin = begin + (i * chunk);
+    if (chunk_begin < end) {
+      fn(chunk_begin, std::min(chunk_begin + chunk, end));
+    }
+  });
+}
+
+/**
+ * @brief Reduces [begin, end) in parallel.
+ *
+ * @details Every chunk is reduced with `fn(chunk_begin, chunk_end, identity)`
+ * and the partial results are folded with `combine`, in chunk order, so the
+ * result does not depend on which thread ran which chunk.
+ */
+template <typename T, typename Fn, typename Combine>
+auto parallel_reduce(size_t begin, size_t end, size_t grain_size,
+                     const T &identity, const Fn &fn, const Combine &combine)
+    -> T {
+  if (begin >= end) {
+    return identity;
+  }
+  const size_t numel = end - begin;
+  const size_t grain = std::max<size_t>(grain_size, 1);
+  const size_t threads = synapse::get_num_threads();
+  if (numel <= grain || threads == 1 || synapse::in_parallel_region()) {
+    return fn(begin, end, identity);
+  }
+  const size_t num_chunks =
+      std::min((numel + grain - 1) / grain, threads * 4);
+  const size_t chunk = (numel + num_chunks - 1) / num_chunks;
+  // Wrapped so that every partial is a distinct object, even for bool
+  struct Partial {
+    T value;
+  };
+  std::vector<Partial> partials(num_chunks, Partial{identity});
+  synapse::parallel_run(num_chunks, [&](size_t i) {
+    const size_t chunk_begin = begin + (i * chunk);
+    if (chunk_begin < end) {
+      partials[i].value =
+          fn(chunk_begin, std::min(chunk_begin + chunk, end), identity);
+    }
+  });
+  T out = identity;
+  for (const Partial &partial : partials) {
+    out = combine(out, partial.value);
+  }
+  return out;
+}
+} // namespace synapse
+
+#endif // !SYNAPSE_PARALLEL_H
@@ -0,0 +1,152 @@
+#ifndef SYNAPSE_PLACEMENT_H
+#define SYNAPSE_PLACEMENT_H
+
+#include "allocator.h"
+#include "tensor.h"
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace synapse {
+
+// Topology
+
+/**
+ * @brief Whether placement is backed by the kernel's NUMA policies.
+ *
+ * @details False when the library is built without libnuma or the host
+ * does not support it. Everything below still works then, on a host seen
+ * as a single node holding every CPU.
+ */
+auto numa_enabled() -> bool;
+
+// Number of memory nodes, at least 1
+auto numa_num_nodes() -> size_t;
+
+/**
+ * @brief CPUs of `node` the process may run on.
+ * @throws std::invalid_argument if there is no such node.
+ */
+auto numa_node_cpus(size_t node) -> std::vector<size_t>;
+
+/**
+ * @brief Nodes holding at least one CPU the process may run on, in
+ * increasing order.
+ *
+ * @details Memory-only nodes and nodes outside the process's CPU set are
+ * left out, so threads are only ever placed on these.
+ */
+auto numa_cpu_nodes() -> std::vector<size_t>;
+
+// Node of the CPU the calling thread is running on
+auto numa_current_node() -> size_t;
+
+/**
+ * @brief Restricts the calling thread to `cpus`.
+ * @return Whether the system accepted the mask, which it may refuse for
+ * CPUs outside the process's own set. Always false outside of Linux.
+ */
+auto pin_current_thread(std::span<const size_t> cpus) -> bool;
+
+// CPUs the calling thread may run on
+auto current_thread_cpus() -> std::vector<size_t>;
+
+// Placement
+
+/**
+ * @brief Where the pages of a block go.
+ *
+ * @details `FirstTouch` leaves each page on the node of the thread that
+ * writes it first, so a tensor filled by the pool (see `NDArray::zeros` and
+ * the element-wise kernels) lands next to the workers that read it back
+ * with the same split. `Interleave` spreads the pages round-robin over every
+ * node, which evens out the bandwidth of tensors read by all threads.
+ * `Bind` keeps the pages on one node.
+ */
+enum class NumaPolicy { FirstTouch, Interleave, Bind };
+
+/**
+ * @brief Allocator placing its blocks with a NUMA policy.
+ *
+ * @details Blocks are mapped from the system page by page, so none of their
+ * pages has been touched when they are handed out, and they go back to the
+ * system when freed. This suits long-lived tensors, such as weights, rather
+ * than temporaries, which are better left to the caching allocator.
+ *
+ * ### Example
+ * ```
+ * {
+ *   synapse::AllocatorGuard guard(std::make_shared<synapse::NumaAllocator>(
+ *       synapse::NumaPolicy::Interleave));
+ *   weights = synapse::Tensor::zeros({4096, 4096});
+ * }
+ * ```
+ */
+class NumaAllocator : public Allocator {
+public:
+  /**
+   * @brief `node` is only used by `NumaPolicy::Bind`.
+   * @throws std::invalid_argument if binding to a node that does not exist.
+   */
+  explicit NumaAllocator(NumaPolicy policy = NumaPolicy::FirstTouch,
+                         size_t node = 0);
+  ~NumaAllocator() override;
+
+  // Throws std::bad_alloc if the system has no memory left
+  auto allocate(size_t bytes) -> void * override;
+  auto deallocate(void *ptr, size_t bytes) -> void override;
+  [[nodiscard]] auto stats() const -> AllocatorStats override;
+  auto reset_peak() -> void override;
+
+  [[nodiscard]] auto policy() const -> NumaPolicy;
+  [[nodiscard]] auto node() const -> size_t;
+
+  // Size of the mapping backing a request of `bytes` bytes
+  static auto block_size(size_t bytes) -> size_t;
+
+private:
+  NumaPolicy _policy;
+  size_t _node;
+  mutable std::mutex _mutex;
+  AllocatorStats _stats;
+};
+
+/**
+ * @brief Read-only tensor with a copy on every node, so each thread reads
+ * the one in its local memory.
+ *
+ * @details Replicas are bound to their node and do not track gradients.
+ * Only the nodes of `numa_cpu_nodes` get one, since no thread reads from
+ * the others.
+ * They are taken once, so writing to the source afterwards does not update
+ * them. On a single node the only replica is a copy-on-write copy of the
+ * source, so nothing is copied until one of them is written.
+ *
+ * ### Example
+ * ```
+ * const synapse::ReplicatedTensor replicated(weight);
+ * synapse::parallel_for(0, batch, 1, [&](size_t begin, size_t end) {
+ *   const synapse::Tensor &local = replicated.local();
+ *   ...
+ * });
+ * ```
+ */
+class ReplicatedTensor {
+public:
+  explicit ReplicatedTensor(const Tensor &tensor);
+
+  // Replica of the node the calling thread runs on
+  [[nodiscard]] auto local() const -> const Tensor &;
+  // Throws std::out_of_range if `node` has no replica
+  [[nodiscard]] auto replica(size_t node) const -> const Tensor &;
+  [[nodiscard]] auto num_replicas() const -> size_t;
+
+private:
+  std::vector<Tensor> _replicas;
+  // Index into `_replicas` of every node, `_replicas.size()` if it has none
+  std::vector<size_t> _index;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_PLACEMENT_H
@@ -0,0 +1,168 @@
+#ifndef SYNAPSE_PLANNER_H
+#define SYNAPSE_PLANNER_H
+
+#include "allocator.h"
+#include "autograd.h"
+#include "dtype.h"
+#include "ndarray.h"
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Placement of one buffer of a planned forward pass.
+ *
+ * @details Steps count the allocations and releases seen while recording, a
+ * buffer still alive at the end of the recording is released on the last
+ * step.
+ */
+struct PlannedBuffer {
+  // Requested size
+  size_t bytes;
+  // Start of the buffer in the workspace
+  size_t offset;
+  size_t first_step;
+  size_t last_step;
+  // Overwrites an operand of the op producing it
+  bool inplace;
+};
+
+/**
+ * @brief Marks the operands an element-wise op reads for the last time at the
+ * same index it writes, for the lifetime of the guard.
+ *
+ * @details The next allocation on the calling thread is the output of the
+ * op. While a `MemoryPlan` is being recorded, that output may then be placed
+ * over an operand that is released before any other allocation. Only
+ * operands that are dense, start their storage, cover all of it and match
+ * the output shape and dtype qualify, and never one that another operand
+ * reads through a different view. Outside of a recording the guard has no
+ * effect.
+ */
+class InplaceHint {
+public:
+  InplaceHint(const InplaceHint &) = delete;
+  InplaceHint(InplaceHint &&) = delete;
+  auto operator=(const InplaceHint &) -> InplaceHint & = delete;
+  auto operator=(InplaceHint &&) -> InplaceHint & = delete;
+  InplaceHint(std::initializer_list<const NDArray *> operands,
+              const Shape &shape, DType dtype);
+  ~InplaceHint();
+};
+
+/**
+ * @brief Allocator replaying a `MemoryPlan` over its workspace.
+ *
+ * @details The i-th allocation since the last `rewind` is served at the
+ * offset planned for the i-th buffer of the recording. As soon as a request
+ * differs from the recording, or its block would overlap a block still in
+ * use, the rest of the pass falls back to the default allocator and is
+ * counted as misses.
+ */
+class PlannedAllocator : public Allocator {
+public:
+  explicit PlannedAllocator(std::vector<PlannedBuffer> buffers);
+  ~PlannedAllocator() override;
+
+  auto allocate(size_t bytes) -> void * override;
+  auto deallocate(void *ptr, size_t bytes) -> void override;
+  [[nodiscard]] auto stats() const -> AllocatorStats override;
+  auto reset_peak() -> void override;
+  // Outputs of a run are overwritten by the next one
+  [[nodiscard]] auto stable_blocks() const -> bool override;
+
+  /**
+   * @brief Restarts the replay from the first buffer.
+   */
+  auto rewind() -> void;
+
+  [[nodiscard]] auto buffers() const -> const std::vector<PlannedBuffer> &;
+  [[nodiscard]] auto workspace_bytes() const -> size_t;
+
+private:
+  mutable std::mutex _mutex;
+  std::vector<PlannedBuffer> _buffers;
+  size_t _workspace_bytes;
+  void *_workspace;
+  // Index of the next buffer to hand out
+  size_t _next;
+  bool _diverged;
+  // Planned buffers handed out and not yet given back
+  std::vector<size_t> _live;
+  AllocatorStats _stats;
+
+  auto _overlaps_live(size_t index) const -> bool;
+};
+
+/**
+ * @brief Static memory plan of an inference pass over a fixed graph.
+ *
+ * @details The constructor runs `forward` once, recording every storage it
+ * allocates with the step at which it is allocated and released. Buffers
+ * are then packed into a single workspace, largest first, each at the lowest
+ * offset not used by a buffer alive at the same time (interval coloring).
+ * The output of an element-wise op may also take the place of an operand
+ * that is released before the next allocation (see `InplaceHint`).
+ *
+ * The workspace is allocated once, so its size is known before any planned
+ * pass runs, and `run` serves every storage of `forward` from it without
+ * asking the system for memory. Both the recording and `run` disable
+ * gradient recording.
+ *
+ * Tensors returned by `run` live in the workspace and are only valid until
+ * the next `run`, copy them to keep them. Runs of the same plan must not
+ * overlap.
+ *
+ * ### Example
+ * ```
+ * synapse::Tensor input = synapse::Tensor::zeros({32, 784});
+ * const auto forward = [&] { return model(input); };
+ * synapse::MemoryPlan plan(forward);
+ * std::println("{} bytes of activations", plan.workspace_bytes());
+ * for (const auto &batch : batches) {
+ *   input.copy_(batch);
+ *   synapse::Tensor out = plan.run(forward);
+ * }
+ * ```
+ */
+class MemoryPlan {
+public:
+  explicit MemoryPlan(const std::function<void()> &forward);
+
+  template <typename Fn> auto run(Fn &&forward) -> std::invoke_result_t<Fn> {
+    const NoGradGuard no_grad;
+    this->_allocator->rewind();
+    const AllocatorGuard guard(this->_allocator);
+    return std::forward<Fn>(forward)();
+  }
+
+  [[nodiscard]] auto buffers() const -> const std::vector<PlannedBuffer> &;
+
+  /**
+   * @brief Peak activation memory of a planned pass.
+   */
+  [[nodiscard]] auto workspace_bytes() const -> size_t;
+
+  /**
+   * @brief Peak of the bytes alive at once during the recording, what the
+   * pass needs without the plan.
+   */
+  [[nodiscard]] auto unplanned_bytes() const -> size_t;
+
+  [[nodiscard]] auto allocator() const
+      -> const std::shared_ptr<PlannedAllocator> &;
+
+private:
+  std::shared_ptr<PlannedAllocator> _allocator;
+  size_t _unplanned_bytes;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_PLANNER_H
@@ -0,0 +1,137 @@
+#ifndef SYNAPSE_PROFILER_H
+#define SYNAPSE_PROFILER_H
+
+#include "ndarray.h"
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Set to 1 by the SYNAPSE_PROFILE CMake option
+#ifndef SYNAPSE_PROFILE
+#define SYNAPSE_PROFILE 0
+#endif
+
+namespace synapse {
+
+/**
+ * @brief Whether ops and allocations are instrumented at all.
+ */
+inline constexpr bool PROFILE = SYNAPSE_PROFILE != 0;
+
+/**
+ * @brief One timed op or allocation.
+ */
+struct ProfileEvent {
+  // String literal naming the op, such as "matmul" or "allocate"
+  const char *name;
+  std::vector<Shape> input_shapes;
+  // Since the profiler was started
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  // Bytes of the inputs read plus the bytes of the output written, or the
+  // size of the block for allocations
+  size_t bytes;
+  size_t flops;
+  // Small integer naming the thread, in order of first event
+  size_t thread;
+};
+
+/**
+ * @brief Process-wide collector of the events of instrumented ops.
+ *
+ * @details Every op of func.h and nn.h and every storage allocation and
+ * release is timed while the profiler runs. The instrumentation only exists
+ * when synapse is built with the `SYNAPSE_PROFILE` CMake option, otherwise
+ * it compiles to nothing and the profiler never records anything.
+ *
+ * Ops called by other ops are recorded too, so the times in the summary are
+ * inclusive and overlap.
+ *
+ * ### Example
+ * ```
+ * synapse::Profiler::start();
+ * synapse::Tensor out = model(batch);
+ * synapse::Profiler::stop();
+ * std::print("{}", synapse::Profiler::summary());
+ * std::ofstream trace("trace.json"); // Opened in chrome://tracing or Perfetto
+ * synapse::Profiler::write_chrome_trace(trace);
+ * ```
+ */
+class Profiler {
+public:
+  /**
+   * @brief Starts recording, with timestamps relative to the first start
+   * since the last `clear`.
+   */
+  static auto start() -> void;
+  static auto stop() -> void;
+  static auto is_enabled() -> bool;
+
+  // Drops every recorded event
+  static auto clear() -> void;
+  static auto record(ProfileEvent event) -> void;
+  static auto events() -> std::vector<ProfileEvent>;
+
+  /**
+   * @brief Table of the recorded events aggregated by name, the most time
+   * consuming first, with their count, total and mean time, share of the
+   * total time, memory bandwidth and arithmetic throughput.
+   */
+  static auto summary() -> std::string;
+
+  /**
+   * @brief Writes the recorded events in the Chrome trace event format, one
+   * complete event per op on the track of its thread.
+   */
+  static auto write_chrome_trace(std::ostream &out) -> void;
+
+  // Nanoseconds since the profiler was started
+  static auto now_ns() -> uint64_t;
+};
+
+#if SYNAPSE_PROFILE
+/**
+ * @brief Times the enclosing op and records it when it goes out of scope,
+ * if the profiler is running.
+ */
+class ProfileScope {
+public:
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope(ProfileScope &&) = delete;
+  auto operator=(const ProfileScope &) -> ProfileScope & = delete;
+  auto operator=(ProfileScope &&) -> ProfileScope & = delete;
+  explicit ProfileScope(const char *name,
+                        std::initializer_list<const NDArray *> inputs = {});
+  ~ProfileScope();
+
+  // Counts the bytes of `output`, and one operation per element of it
+  auto set_output(const NDArray &output) -> void;
+  // Same, with one operation per element of the inputs
+  auto set_reduced_output(const NDArray &output) -> void;
+  auto set_output(const NDArray &output, size_t flops) -> void;
+  auto add_bytes(size_t bytes) -> void;
+
+private:
+  bool _active;
+  size_t _input_elements;
+  ProfileEvent _event;
+};
+#else
+// Compiled out, see the SYNAPSE_PROFILE CMake option
+class ProfileScope {
+public:
+  explicit ProfileScope(const char * /*name*/,
+                        std::initializer_list<const NDArray *> /*inputs*/ =
+                            {}) {}
+  auto set_output(const NDArray & /*output*/) -> void {}
+  auto set_reduced_output(const NDArray & /*output*/) -> void {}
+  auto set_output(const NDArray & /*output*/, size_t /*flops*/) -> void {}
+  auto add_bytes(size_t /*bytes*/) -> void {}
+};
+#endif
+} // namespace synapse
+
+#endif // !SYNAPSE_PROFILER_H
@@ -0,0 +1,170 @@
+#ifndef SYNAPSE_QUANTIZE_H
+#define SYNAPSE_QUANTIZE_H
+
+#include "gemm.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "tensor.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Affine mapping between real values and int8, `real = scale * (q -
+ * zero_point)`.
+ *
+ * @details A single scale and zero point cover the whole tensor, unless
+ * `axis` is set: then there is one pair per slice along that dimension, such
+ * as one per output channel of a weight.
+ */
+struct QuantParams {
+  std::vector<float> scales;
+  std::vector<int32_t> zero_points;
+  std::optional<size_t> axis;
+
+  /**
+   * @brief Parameters mapping [min, max], widened to contain 0, onto the
+   * int8 range.
+   *
+   * @details Symmetric parameters have a zero point of 0 and use [-127, 127],
+   * which weights favour since `igemm` then has no correction to apply.
+   * Asymmetric ones use the whole [-128, 127].
+   */
+  static auto from_range(float min, float max, bool symmetric = false)
+      -> QuantParams;
+
+  [[nodiscard]] auto per_channel() const -> bool { return axis.has_value(); }
+};
+
+/**
+ * @brief Int8 values together with the parameters to read them back.
+ */
+class QuantizedTensor {
+public:
+  /**
+   * @throws std::invalid_argument if `values` is not Int8, or if the
+   * parameters do not match its shape or have non-positive scales.
+   */
+  QuantizedTensor(NDArray values, QuantParams params);
+
+  [[nodiscard]] auto values() const -> const NDArray &;
+  [[nodiscard]] auto params() const -> const QuantParams &;
+  [[nodiscard]] auto shape() const -> const Shape &;
+
+  // Real values as Float32
+  [[nodiscard]] auto dequantize() const -> Tensor;
+
+private:
+  NDArray _values;
+  QuantParams _params;
+};
+
+/**
+ * @brief Rounds `tensor / scale + zero_point` to the nearest int8, saturating.
+ * @throws std::invalid_argument if the parameters do not match the shape.
+ */
+auto quantize(const Tensor &tensor, const QuantParams &params)
+    -> QuantizedTensor;
+
+/**
+ * @brief Calibration hook recording the range of the tensors it sees.
+ *
+ * @details Called on the activations of a few representative batches, it
+ * yields the parameters to quantize them with. It can be inserted in a
+ * forward pass as an identity, since calling it returns its input.
+ *
+ * ### Example
+ * ```
+ * synapse::Observer observer;
+ * for (const synapse::Tensor &batch : calibration_batches) {
+ *   layer(observer(batch));
+ * }
+ * const synapse::nn::QuantizedLinear quantized(layer, observer.params());
+ * ```
+ */
+class Observer {
+public:
+  // Per-tensor range, or one range per slice along `axis`
+  explicit Observer(std::optional<size_t> axis = std::nullopt,
+                    bool symmetric = false);
+
+  auto observe(const Tensor &tensor) -> void;
+  auto operator()(const Tensor &tensor) -> const Tensor &;
+
+  /**
+   * @throws std::logic_error if nothing was observed yet.
+   */
+  [[nodiscard]] auto params() const -> QuantParams;
+
+private:
+  std::optional<size_t> _axis;
+  bool _symmetric;
+  std::vector<float> _min;
+  std::vector<float> _max;
+};
+
+/**
+ * @brief Product of two quantized matrices computed by `igemm`, dequantized
+ * to Float32.
+ *
+ * @throws std::invalid_argument if the operands are not 2-dimensional with
+ * matching inner sizes, if `lhs` is quantized per channel, or if `rhs` is
+ * quantized per channel along another axis than its columns.
+ */
+auto quantized_matmul(const QuantizedTensor &lhs, const QuantizedTensor &rhs)
+    -> Tensor;
+
+/**
+ * @brief Same, requantized per tensor with `output` inside the kernel.
+ */
+auto quantized_matmul(const QuantizedTensor &lhs, const QuantizedTensor &rhs,
+                      const QuantParams &output) -> QuantizedTensor;
+
+namespace nn {
+/**
+ * @brief Int8 version of a trained `Linear` layer for inference.
+ *
+ * @details Weights are quantized symmetrically per output feature. Inputs
+ * are quantized per tensor with calibrated parameters, or dynamically from
+ * the range of each input when none are given. Bias and activation are
+ * applied by `igemm` while dequantizing, so a float input gives a float
+ * output with a single pass over it. The weight is packed for `igemm` once,
+ * and takes a quarter of the bytes of the float one.
+ */
+class QuantizedLinear : public Module {
+public:
+  /**
+   * @throws std::invalid_argument if `input` is quantized per channel.
+   */
+  explicit QuantizedLinear(Linear &layer,
+                           std::optional<QuantParams> input = std::nullopt);
+
+  [[nodiscard]] auto forward(const Tensor &input) const -> Tensor override;
+
+  /**
+   * @brief Int8 in and out, for chaining quantized layers.
+   */
+  [[nodiscard]] auto forward(const QuantizedTensor &input,
+                             const QuantParams &output) const
+      -> QuantizedTensor;
+
+  [[nodiscard]] auto weight() const -> const QuantizedTensor &;
+
+private:
+  QuantizedTensor _weight;
+  // The transposed weight, which is the rhs of the product
+  PackedInt8Matrix _packed;
+  std::optional<Tensor> _bias;
+  Activation _activation;
+  std::optional<QuantParams> _input;
+
+  // Bias and activation of the layer
+  [[nodiscard]] auto _requantization() const -> Requantization;
+};
+} // namespace nn
+} // namespace synapse
+
+#endif // !SYNAPSE_QUANTIZE_H
@@ -0,0 +1,60 @@
+#ifndef SYNAPSE_REDUCE_H
+#define SYNAPSE_REDUCE_H
+
+#include "ndarray.h"
+#include <cstddef>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief Reductions computed by `reduce`.
+ */
+enum class ReduceOp { Sum, Mean, Max, Min, ArgMax, ArgMin, Var, Norm };
+
+/**
+ * @brief Shape of the result of reducing `shape` over `dims`, every
+ * dimension when `dims` is empty.
+ *
+ * @throws std::out_of_range if a dimension is out of range.
+ * @throws std::invalid_argument if a dimension is repeated.
+ */
+auto reduced_shape(const Shape &shape, const std::vector<size_t> &dims,
+                   bool keepdim) -> Shape;
+
+/**
+ * @brief Reduces `input` over `dims`, every dimension when `dims` is empty.
+ *
+ * @param input Array to reduce, read through its strides.
+ * @param op Reduction to compute. `Norm` is the L2 norm and `Var` divides by
+ * `count - correction`.
+ * @param dims Dimensions to reduce. `ArgMax` and `ArgMin` take exactly one.
+ * @param keepdim Keeps the reduced dimensions with size 1.
+ * @param correction Bessel's correction of `Var`.
+ * @return `ArgMax` and `ArgMin` return Int32 indices, `Max` and `Min` keep
+ * the dtype of `input`. The other reductions return the dtype of a floating
+ * point input, Int32 for the sum of integers and Float32 otherwise.
+ * @throws std::invalid_argument if `Max`, `Min`, `ArgMax` or `ArgMin` reduce
+ * an empty dimension.
+ *
+ * @details Dimensions are reordered and merged by stride before reducing, so
+ * the reduction walks memory in the most favourable order:
+ * - when the reduced elements of every output are contiguous, each output
+ *   reduces a dense run with independent accumulators the compiler turns
+ *   into SIMD lanes, and a single output is split across the thread pool;
+ * - when a kept dimension is contiguous instead (e.g. summing the rows of a
+ *   row-major matrix), whole rows are accumulated into a vector of outputs;
+ * - any other layout is gathered into blocks and reduced as dense runs.
+ *
+ * Sums use pairwise summation over dense runs and Kahan summation across
+ * rows, so the error barely grows with the number of elements. Floating
+ * point inputs are reduced in single precision (half precision types
+ * included), Float64 and integers in double precision. NaNs propagate
+ * through `Max` and `Min`, and are the extremum found by `ArgMax` and
+ * `ArgMin`.
+ */
+auto reduce(const NDArray &input, ReduceOp op, const std::vector<size_t> &dims,
+            bool keepdim = false, size_t correction = 1) -> NDArray;
+} // namespace synapse
+
+#endif // !SYNAPSE_REDUCE_H
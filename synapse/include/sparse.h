@@ -0,0 +1,164 @@
+#ifndef SYNAPSE_SPARSE_H
+#define SYNAPSE_SPARSE_H
+
+#include "ndarray.h"
+#include "tensor.h"
+#include <cstddef>
+#include <vector>
+
+namespace synapse {
+
+/**
+ * @brief How the nonzeros of a `SparseTensor` are indexed.
+ *
+ * @details COO stores the row and the column of every nonzero. CSR stores
+ * the columns, and for every row the offset of its first nonzero, so the
+ * nonzeros of row `i` are the ones in `[row_offsets[i], row_offsets[i + 1])`.
+ */
+enum class SparseLayout { Coo, Csr };
+
+/**
+ * @brief Float32 matrix storing only its nonzero elements.
+ *
+ * @details Nonzeros are kept sorted by row then column, without duplicates,
+ * whatever the layout, so memory and every op scale with the number of
+ * nonzeros rather than with the dense size. Explicit zeros are allowed and
+ * kept. Converting between layouts costs a pass over the rows.
+ *
+ * ### Example
+ * ```
+ * const synapse::SparseTensor adjacency = synapse::SparseTensor::coo(
+ *     {3, 3}, {0, 1, 2}, {1, 2, 0}, {1.0F, 1.0F, 1.0F});
+ * synapse::Tensor out = synapse::spmm(adjacency, features);
+ * ```
+ */
+class SparseTensor {
+public:
+  /**
+   * @brief Matrix of shape `shape` with `values[i]` at `(rows[i], cols[i])`.
+   *
+   * @details The triplets may come in any order, duplicates are summed.
+   * @throws std::invalid_argument if the shape is not 2-dimensional, the
+   * vectors differ in size or an index is out of range.
+   */
+  static auto coo(const Shape &shape, std::vector<size_t> rows,
+                  std::vector<size_t> cols, std::vector<float> values)
+      -> SparseTensor;
+
+  /**
+   * @brief Matrix of shape `shape` in compressed rows, see `SparseLayout`.
+   *
+   * @details Columns within a row may come in any order, duplicates are
+   * summed.
+   * @throws std::invalid_argument if the shape is not 2-dimensional, the
+   * offsets are not `shape[0] + 1` non-decreasing values from 0 to the
+   * number of values, or a column is out of range.
+   */
+  static auto csr(const Shape &shape, std::vector<size_t> row_offsets,
+                  std::vector<size_t> cols, std::vector<float> values)
+      -> SparseTensor;
+
+  /**
+   * @brief The nonzero elements of a 2-dimensional tensor.
+   * @throws std::invalid_argument if `dense` is not 2-dimensional.
+   */
+  static auto from_dense(const Tensor &dense,
+                         SparseLayout layout = SparseLayout::Csr)
+      -> SparseTensor;
+
+  [[nodiscard]] auto layout() const -> SparseLayout;
+  [[nodiscard]] auto shape() const -> const Shape &;
+  // Number of stored elements
+  [[nodiscard]] auto nnz() const -> size_t;
+
+  /**
+   * @brief Row of every nonzero.
+   * @throws std::logic_error if the layout is not COO.
+   */
+  [[nodiscard]] auto row_indices() const -> const std::vector<size_t> &;
+  /**
+   * @brief Offset of the first nonzero of every row, plus the end.
+   * @throws std::logic_error if the layout is not CSR.
+   */
+  [[nodiscard]] auto row_offsets() const -> const std::vector<size_t> &;
+  [[nodiscard]] auto col_indices() const -> const std::vector<size_t> &;
+  [[nodiscard]] auto values() const -> const std::vector<float> &;
+
+  [[nodiscard]] auto to(SparseLayout layout) const -> SparseTensor;
+  [[nodiscard]] auto to_dense() const -> Tensor;
+  // Same layout, in O(nnz + columns)
+  [[nodiscard]] auto transpose() const -> SparseTensor;
+
+  /**
+   * @brief Adds `alpha` times this matrix into `dense`, in place.
+   *
+   * @details Touches the stored elements only, such as the rows an
+   * embedding lookup read for a sparse gradient step. Writes go through the
+   * strides of `dense`, whatever its dtype.
+   * @throws std::invalid_argument if the shapes differ.
+   */
+  auto add_to(NDArray &dense, float alpha = 1.0F) const -> void;
+
+private:
+  SparseLayout _layout;
+  Shape _shape;
+  // Row of every nonzero for COO, row offsets for CSR
+  std::vector<size_t> _rows;
+  std::vector<size_t> _cols;
+  std::vector<float> _values;
+
+  SparseTensor(SparseLayout layout, Shape shape, std::vector<size_t> rows,
+               std::vector<size_t> cols, std::vector<float> values);
+};
+
+/**
+ * @brief Sparse times dense matrix product, `sparse (m x k) @ dense (k x n)`.
+ *
+ * @details Rows of the output are computed in parallel, each one scaling and
+ * adding the rows of `dense` selected by the nonzeros of the matching sparse
+ * row, so the work is `2 * nnz * n`. The gradient flows to `dense`.
+ * @throws std::invalid_argument if `dense` is not 2-dimensional with `k`
+ * rows.
+ * @return A Float32 tensor, whatever the dtype of `dense`.
+ */
+auto spmm(const SparseTensor &sparse, const Tensor &dense) -> Tensor;
+
+/**
+ * @brief Sparse matrix times dense vector, `sparse (m x k) @ dense (k)`.
+ * @throws std::invalid_argument if `dense` is not a vector of size `k`.
+ */
+auto spmv(const SparseTensor &sparse, const Tensor &dense) -> Tensor;
+
+// Sparse-dense element-wise ops, following func.h: the dense operand is
+// broadcasted to the sparse shape, and a dense result has the promoted dtype.
+// Only the dense sum is differentiable, with respect to its dense operand.
+
+/**
+ * @brief Dense sum, the dense operand plus the stored elements. The
+ * gradient flows to `dense`.
+ * @throws std::invalid_argument if `dense` cannot be broadcasted to the
+ * sparse shape.
+ */
+auto add(const SparseTensor &sparse, const Tensor &dense) -> Tensor;
+auto add(const Tensor &dense, const SparseTensor &sparse) -> Tensor;
+
+/**
+ * @brief Sparse product, with the pattern of `sparse` since every other
+ * element is zero. Not differentiable, since a `SparseTensor` has no
+ * gradient.
+ * @throws std::invalid_argument if `dense` cannot be broadcasted to the
+ * sparse shape.
+ * @throws std::logic_error if `dense` requires a gradient.
+ */
+auto mul(const SparseTensor &sparse, const Tensor &dense) -> SparseTensor;
+auto mul(const Tensor &dense, const SparseTensor &sparse) -> SparseTensor;
+
+/**
+ * @brief Sparse sum over the union of both patterns, in the layout of
+ * `lhs`.
+ * @throws std::invalid_argument if the shapes differ.
+ */
+auto add(const SparseTensor &lhs, const SparseTensor &rhs) -> SparseTensor;
+} // namespace synapse
+
+#endif // !SYNAPSE_SPARSE_H
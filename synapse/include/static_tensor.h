@@ -0,0 +1,311 @@
+#ifndef SYNAPSE_STATIC_TENSOR_H
+#define SYNAPSE_STATIC_TENSOR_H
+
+#include "accessor.h"
+#include "dtype.h"
+#include "elementwise.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace synapse {
+
+/**
+ * @brief Largest number of scalar operations a StaticTensor op spells out
+ * one by one, beyond which it runs a loop with constant bounds.
+ */
+constexpr size_t STATIC_UNROLL_LIMIT = 256;
+
+/**
+ * @brief Dense tensor whose shape is part of its type.
+ *
+ * @details The elements live inline in a `std::array`, so a StaticTensor is
+ * a plain value as large as its elements: creating, copying or returning one
+ * never allocates. Strides are constant expressions, so indexing needs no
+ * loop over the rank, and the element-wise ops and `matmul` are unrolled
+ * completely for small shapes (see `STATIC_UNROLL_LIMIT`). Shape mismatches
+ * are compile errors.
+ *
+ * Ops compute in `compute_type_t<T>` through the same scalar definitions as
+ * the ops of func.h, so both give the same values. Conversions from and to
+ * `Tensor` copy the elements.
+ *
+ * ### Example
+ * ```
+ * using Mat3 = synapse::StaticTensor<float, 3, 3>;
+ * const Mat3 rotation({0, -1, 0, 1, 0, 0, 0, 0, 1});
+ * const synapse::StaticTensor<float, 3> point({1, 2, 3});
+ * const auto moved = synapse::matmul(rotation, point) + point; // No allocation
+ * synapse::Tensor tensor = moved.to_tensor();
+ * ```
+ */
+template <typename T, size_t... Dims> class StaticTensor {
+public:
+  using value_type = T;
+  static constexpr size_t rank = sizeof...(Dims);
+  static constexpr size_t numel = (size_t{1} * ... * Dims);
+  static constexpr std::array<size_t, rank> shape{Dims...};
+  static constexpr std::array<size_t, rank> strides = [] {
+    std::array<size_t, rank> out{};
+    size_t stride = 1;
+    for (size_t d = rank; d-- > 0;) {
+      out[d] = stride;
+      stride *= shape[d];
+    }
+    return out;
+  }();
+
+  // Zero-filled
+  constexpr StaticTensor() = default;
+  constexpr explicit StaticTensor(const std::array<T, numel> &values)
+      : _data(values) {}
+
+  /**
+   * @brief Copies the elements of `tensor`, converted to `T`.
+   * @throws std::invalid_argument if the shape of `tensor` differs.
+   */
+  explicit StaticTensor(const Tensor &tensor) : _data() {
+    if (!std::ranges::equal(tensor.shape(), shape)) {
+      throw std::invalid_argument(
+          std::format("Expected a tensor of shape {}, got shape {}.", shape,
+                      tensor.shape()));
+    }
+    const NDArray dense = tensor.NDArray::to(dtype_of<T>::value).contiguous();
+    std::copy_n(dense.data_ptr<T>(), numel, this->_data.begin());
+  }
+
+  static constexpr auto full(T value) -> StaticTensor {
+    StaticTensor out;
+    out._data.fill(value);
+    return out;
+  }
+
+  // Accessors
+  constexpr auto data() -> T * { return this->_data.data(); }
+  [[nodiscard]] constexpr auto data() const -> const T * {
+    return this->_data.data();
+  }
+  [[nodiscard]] constexpr auto values() const -> const std::array<T, numel> & {
+    return this->_data;
+  }
+
+  /**
+   * @brief Element at the given indices, checked only with
+   * `SYNAPSE_BOUNDS_CHECK`.
+   */
+  template <std::integral... Indices>
+    requires(sizeof...(Indices) == rank)
+  constexpr auto operator()(Indices... indices) -> T & {
+    return this->_data[StaticTensor::_position<BOUNDS_CHECK>(
+        {static_cast<size_t>(indices)...})];
+  }
+  template <std::integral... Indices>
+    requires(sizeof...(Indices) == rank)
+  constexpr auto operator()(Indices... indices) const -> const T & {
+    return this->_data[StaticTensor::_position<BOUNDS_CHECK>(
+        {static_cast<size_t>(indices)...})];
+  }
+
+  /**
+   * @brief Element at the given indices.
+   * @throws std::out_of_range if an index is out of bounds.
+   */
+  template <std::integral... Indices>
+    requires(sizeof...(Indices) == rank)
+  constexpr auto at(Indices... indices) -> T & {
+    return this->_data[StaticTensor::_position<true>(
+        {static_cast<size_t>(indices)...})];
+  }
+  template <std::integral... Indices>
+    requires(sizeof...(Indices) == rank)
+  [[nodiscard]] constexpr auto at(Indices... indices) const -> const T & {
+    return this->_data[StaticTensor::_position<true>(
+        {static_cast<size_t>(indices)...})];
+  }
+
+  /**
+   * @brief Copies the elements into a new dense tensor of dtype `T`.
+   */
+  [[nodiscard]] auto to_tensor() const -> Tensor {
+    Tensor out =
+        Tensor::empty(Shape(shape.begin(), shape.end()), dtype_of<T>::value);
+    std::copy_n(this->_data.begin(), numel, out.data_ptr<T>());
+    return out;
+  }
+
+  friend constexpr auto operator==(const StaticTensor &,
+                                   const StaticTensor &) -> bool = default;
+
+private:
+  std::array<T, numel> _data{};
+
+  template <bool Check>
+  static constexpr auto _position(const std::array<size_t, rank> &index)
+      -> size_t {
+    size_t pos = 0;
+    for (size_t d = 0; d < rank; ++d) {
+      if constexpr (Check) {
+        if (index[d] >= shape[d]) {
+          throw std::out_of_range(std::format(
+              "Index {} is out of bounds for dimension {} of size {}.",
+              index[d], d, shape[d]));
+        }
+      }
+      pos += index[d] * strides[d];
+    }
+    return pos;
+  }
+};
+
+/**
+ * @brief Calls `fn(i)` for every `i` in [0, N), spelled out one call at a
+ * time when `Unroll` holds.
+ */
+template <size_t N, bool Unroll = N <= STATIC_UNROLL_LIMIT, typename Fn>
+constexpr auto static_for(Fn &&fn) -> void {
+  if constexpr (Unroll) {
+    [&fn]<size_t... I>(std::index_sequence<I...>) {
+      (fn(I), ...);
+    }(std::make_index_sequence<N>{});
+  } else {
+    for (size_t i = 0; i < N; ++i) {
+      fn(i);
+    }
+  }
+}
+
+/**
+ * @brief Applies the element-wise op `Op` of func.h to every element.
+ */
+template <ElementwiseOp Op, typename T, size_t... Dims>
+auto apply(const StaticTensor<T, Dims...> &tensor)
+    -> StaticTensor<T, Dims...> {
+  static_assert(!is_floating_point_op(Op) || !std::is_integral_v<T>,
+                "Convert integer tensors to a floating point type first.");
+  using C = compute_type_t<T>;
+  StaticTensor<T, Dims...> out;
+  static_for<StaticTensor<T, Dims...>::numel>([&](size_t i) {
+    out.data()[i] = scalar_cast<T>(
+        unary_scalar<Op, C>(scalar_cast<C>(tensor.data()[i])));
+  });
+  return out;
+}
+
+template <ElementwiseOp Op, typename T, size_t... Dims>
+auto apply(const StaticTensor<T, Dims...> &lhs,
+           const StaticTensor<T, Dims...> &rhs) -> StaticTensor<T, Dims...> {
+  static_assert(!is_floating_point_op(Op) || !std::is_integral_v<T>,
+                "Convert integer tensors to a floating point type first.");
+  using C = compute_type_t<T>;
+  StaticTensor<T, Dims...> out;
+  static_for<StaticTensor<T, Dims...>::numel>([&](size_t i) {
+    out.data()[i] = scalar_cast<T>(binary_scalar<Op, C>(
+        scalar_cast<C>(lhs.data()[i]), scalar_cast<C>(rhs.data()[i])));
+  });
+  return out;
+}
+
+template <typename T, size_t... Dims>
+auto operator+(const StaticTensor<T, Dims...> &lhs,
+               const StaticTensor<T, Dims...> &rhs)
+    -> StaticTensor<T, Dims...> {
+  return apply<ElementwiseOp::Add>(lhs, rhs);
+}
+
+template <typename T, size_t... Dims>
+auto operator-(const StaticTensor<T, Dims...> &lhs,
+               const StaticTensor<T, Dims...> &rhs)
+    -> StaticTensor<T, Dims...> {
+  return apply<ElementwiseOp::Sub>(lhs, rhs);
+}
+
+template <typename T, size_t... Dims>
+auto operator*(const StaticTensor<T, Dims...> &lhs,
+               const StaticTensor<T, Dims...> &rhs)
+    -> StaticTensor<T, Dims...> {
+  return apply<ElementwiseOp::Mul>(lhs, rhs);
+}
+
+template <typename T, size_t... Dims>
+auto operator/(const StaticTensor<T, Dims...> &lhs,
+               const StaticTensor<T, Dims...> &rhs)
+    -> StaticTensor<T, Dims...> {
+  return apply<ElementwiseOp::Div>(lhs, rhs);
+}
+
+template <typename T, size_t... Dims>
+auto operator-(const StaticTensor<T, Dims...> &tensor)
+    -> StaticTensor<T, Dims...> {
+  return apply<ElementwiseOp::Neg>(tensor);
+}
+
+template <typename T, size_t... Dims>
+auto operator*(const StaticTensor<T, Dims...> &tensor,
+               std::type_identity_t<T> scalar)
+    -> StaticTensor<T, Dims...> {
+  return tensor * StaticTensor<T, Dims...>::full(scalar);
+}
+
+/**
+ * @brief Matrix product, accumulated in `compute_type_t<T>`.
+ */
+template <typename T, size_t M, size_t K, size_t N>
+auto matmul(const StaticTensor<T, M, K> &lhs, const StaticTensor<T, K, N> &rhs)
+    -> StaticTensor<T, M, N> {
+  using C = compute_type_t<T>;
+  constexpr bool unroll = M * K * N <= STATIC_UNROLL_LIMIT;
+  // Rows of the output are built as sums of scaled rows of `rhs`, so the
+  // innermost loop runs over contiguous elements
+  std::array<C, M * N> acc{};
+  static_for<M, unroll>([&](size_t i) {
+    static_for<K, unroll>([&](size_t k) {
+      const C scale = scalar_cast<C>(lhs.data()[(i * K) + k]);
+      static_for<N, unroll>([&](size_t j) {
+        acc[(i * N) + j] += scale * scalar_cast<C>(rhs.data()[(k * N) + j]);
+      });
+    });
+  });
+  StaticTensor<T, M, N> out;
+  static_for<M * N, unroll>(
+      [&](size_t i) { out.data()[i] = scalar_cast<T>(acc[i]); });
+  return out;
+}
+
+/**
+ * @brief Matrix-vector product, accumulated in `compute_type_t<T>`.
+ */
+template <typename T, size_t M, size_t K>
+auto matmul(const StaticTensor<T, M, K> &lhs, const StaticTensor<T, K> &rhs)
+    -> StaticTensor<T, M> {
+  using C = compute_type_t<T>;
+  constexpr bool unroll = M * K <= STATIC_UNROLL_LIMIT;
+  StaticTensor<T, M> out;
+  static_for<M, unroll>([&](size_t i) {
+    C acc{};
+    static_for<K, unroll>([&](size_t k) {
+      acc += scalar_cast<C>(lhs.data()[(i * K) + k]) *
+             scalar_cast<C>(rhs.data()[k]);
+    });
+    out.data()[i] = scalar_cast<T>(acc);
+  });
+  return out;
+}
+
+template <typename T, size_t M, size_t N>
+auto transpose(const StaticTensor<T, M, N> &tensor) -> StaticTensor<T, N, M> {
+  StaticTensor<T, N, M> out;
+  static_for<M * N>([&](size_t i) {
+    out.data()[((i % N) * M) + (i / N)] = tensor.data()[i];
+  });
+  return out;
+}
+} // namespace synapse
+
+#endif // !SYNAPSE_STATIC_TENSOR_H
@@ -0,0 +1,115 @@
+#ifndef SYNAPSE_STORAGE_H
+#define SYNAPSE_STORAGE_H
+
+#include "allocator.h"
+#include "dtype.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace synapse {
+struct LazyExpr;
+
+/**
+ * @brief Flat, reference-counted buffer backing one or more NDArrays.
+ *
+ * @details A Storage is always held through a `std::shared_ptr`. Every view
+ * created from an NDArray (slices, transposes, reshapes, broadcasts) points to
+ * the same Storage with its own offset and strides, so creating a view never
+ * copies elements and writes through a view are visible in the original.
+ *
+ * The buffer comes from the allocator current on the creating thread (see
+ * `AllocatorGuard`) and is therefore 64-byte aligned. The storage keeps its
+ * allocator alive until the buffer has been given back.
+ *
+ * Elements are typed by the storage's `DType`; `data()` is the raw buffer and
+ * NDArray provides typed access on top of it.
+ *
+ * A storage created from a lazy expression (see lazy.h) starts out pending:
+ * its buffer is only allocated and filled, once, on the first access to
+ * `data()`.
+ *
+ * A storage can also wrap memory it does not own, such as a memory-mapped
+ * checkpoint (see checkpoint.h). It then has no allocator and keeps the
+ * owner of the memory alive instead.
+ *
+ * Copies of an NDArray share the buffer through `share`, copy-on-write: the
+ * buffer is reference counted, atomically, and the first write through
+ * `data()` to a storage whose buffer is shared copies it into a buffer of
+ * its own. Every view of that storage sees the new buffer, the other
+ * storages keep the old one. Pointers obtained from `data()` before the
+ * storage was shared still point to the shared buffer, so they must not be
+ * written through once a copy has been taken.
+ *
+ * Sharing and detaching are safe across threads for distinct storages,
+ * including storages sharing one buffer. A single storage is not: the
+ * non-const `data()` may replace `_buffer`, so two threads calling it on the
+ * same storage race, as does one calling it while another reads the
+ * storage. Threads writing disjoint parts of one storage should detach it
+ * first, by calling `data()` once before they start.
+ */
+class Storage {
+public:
+  Storage(const Storage &) = delete;
+  Storage(Storage &&) = delete;
+  auto operator=(const Storage &) -> Storage & = delete;
+  auto operator=(Storage &&) -> Storage & = delete;
+  // Uninitialised buffer of `size` elements
+  explicit Storage(size_t size, DType dtype = DType::Float32);
+  Storage(size_t size, DType dtype, std::shared_ptr<Allocator> allocator);
+  explicit Storage(const std::vector<float> &data);
+  // Pending Float32 buffer of `size` elements, holding the result of `expr`
+  Storage(size_t size, std::shared_ptr<const LazyExpr> expr);
+  // `size` elements at `data`, valid as long as `owner` is alive
+  Storage(void *data, size_t size, DType dtype, std::shared_ptr<void> owner);
+  ~Storage();
+
+  // Accessors, `data()` evaluates a pending storage and the non-const one
+  // detaches a shared buffer
+  auto data() -> void *;
+  [[nodiscard]] auto data() const -> const void *;
+  [[nodiscard]] auto size() const -> size_t;
+  [[nodiscard]] auto nbytes() const -> size_t;
+  [[nodiscard]] auto dtype() const -> DType;
+  // Null for storages wrapping external memory, until a write copies it
+  [[nodiscard]] auto allocator() const -> const std::shared_ptr<Allocator> &;
+
+  // Copy-on-write
+
+  /**
+   * @brief New storage sharing the buffer, see `shareable`.
+   *
+   * @details Evaluates a pending storage first.
+   */
+  [[nodiscard]] auto share() const -> std::shared_ptr<Storage>;
+  // Whether the buffer can be shared, which the blocks of allocators
+  // without `stable_blocks` cannot
+  [[nodiscard]] auto shareable() const -> bool;
+  // Whether another storage still shares the buffer
+  [[nodiscard]] auto is_shared() const -> bool;
+
+  // Lazy evaluation
+  [[nodiscard]] auto pending() const -> bool;
+  // Expression still to be evaluated, null once the buffer is filled
+  [[nodiscard]] auto expr() const -> std::shared_ptr<const LazyExpr>;
+
+private:
+  struct Deferred;
+
+  std::shared_ptr<Allocator> _allocator;
+  mutable void *_data;
+  size_t _size;
+  DType _dtype;
+  // Only set on storages created from an expression
+  std::unique_ptr<Deferred> _deferred;
+  // Owns the elements, shared by the storages created with `share`
+  mutable std::shared_ptr<void> _buffer;
+
+  // Storage over the buffer of `other`
+  Storage(const Storage &other, std::shared_ptr<void> buffer);
+  auto _materialize() const -> void;
+  auto _detach() -> void;
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_STORAGE_H
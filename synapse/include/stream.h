@@ -0,0 +1,331 @@
+#ifndef SYNAPSE_STREAM_H
+#define SYNAPSE_STREAM_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace synapse {
+
+template <typename T> class Future;
+
+/**
+ * @brief Producer side of a `Future`, completed exactly once with a value or
+ * an exception.
+ *
+ * @details Copies share the same result, so a promise can be handed to a
+ * callback of an I/O library while the future is passed around.
+ */
+template <typename T> class Promise {
+public:
+  Promise() : _state(std::make_shared<State>()) {}
+
+  [[nodiscard]] auto get_future() const -> Future<T> {
+    return Future<T>(this->_state);
+  }
+
+  /**
+   * @throws std::logic_error if the promise was already completed.
+   */
+  template <typename... Args>
+    requires std::is_void_v<T> || std::is_constructible_v<T, Args...>
+  auto set_value(Args &&...args) -> void {
+    this->_complete([&](State &state) {
+      state.value.emplace(std::forward<Args>(args)...);
+    });
+  }
+
+  auto set_exception(std::exception_ptr error) -> void {
+    this->_complete([&](State &state) { state.error = std::move(error); });
+  }
+
+private:
+  friend class Future<T>;
+
+  // Unit value of the futures of functions returning void
+  using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  struct State {
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    bool ready = false;
+    std::optional<Value> value;
+    std::exception_ptr error;
+    // Run once the result is set, on the completing thread
+    std::vector<std::function<void()>> continuations;
+  };
+
+  std::shared_ptr<State> _state;
+
+  template <typename Fn> auto _complete(const Fn &fn) -> void {
+    std::vector<std::function<void()>> continuations;
+    {
+      const std::lock_guard<std::mutex> lock(this->_state->mutex);
+      if (this->_state->ready) {
+        throw std::logic_error("The promise was already completed.");
+      }
+      fn(*this->_state);
+      this->_state->ready = true;
+      continuations.swap(this->_state->continuations);
+    }
+    this->_state->ready_cv.notify_all();
+    for (const std::function<void()> &continuation : continuations) {
+      continuation();
+    }
+  }
+};
+
+/**
+ * @brief Result of a computation that may still be running.
+ *
+ * @details Copies share the same result, so one future can feed several
+ * dependent tasks. A future is awaitable, and a coroutine returning
+ * `Future<T>` starts eagerly and completes its future on `co_return`.
+ *
+ * `get` and `co_await` give a reference to the result owned by the future,
+ * so binding them by value copies it.
+ */
+template <typename T> class Future {
+public:
+  struct promise_type;
+  // What `get` returns
+  using reference = std::conditional_t<std::is_void_v<T>, void,
+                                       std::add_lvalue_reference_t<const T>>;
+
+  // Invalid, not associated with any promise
+  Future() : _state(nullptr) {}
+
+  [[nodiscard]] auto valid() const -> bool { return this->_state != nullptr; }
+
+  [[nodiscard]] auto is_ready() const -> bool {
+    const std::lock_guard<std::mutex> lock(this->_state->mutex);
+    return this->_state->ready;
+  }
+
+  // Blocks until the result is set
+  auto wait() const -> void {
+    std::unique_lock<std::mutex> lock(this->_state->mutex);
+    this->_state->ready_cv.wait(lock, [this] { return this->_state->ready; });
+  }
+
+  /**
+   * @brief Waits for the result and returns it.
+   * @throws the exception the computation failed with, if any.
+   */
+  auto get() const -> reference {
+    this->wait();
+    if (this->_state->error) {
+      std::rethrow_exception(this->_state->error);
+    }
+    if constexpr (!std::is_void_v<T>) {
+      return *this->_state->value;
+    }
+  }
+
+  /**
+   * @brief Calls `fn()` once the result is set, right away on the calling
+   * thread if it already is, otherwise on the thread that sets it.
+   */
+  auto on_ready(std::function<void()> fn) const -> void {
+    {
+      const std::lock_guard<std::mutex> lock(this->_state->mutex);
+      if (!this->_state->ready) {
+        this->_state->continuations.push_back(std::move(fn));
+        return;
+      }
+    }
+    fn();
+  }
+
+  // Awaitable
+  [[nodiscard]] auto await_ready() const -> bool { return this->is_ready(); }
+  // Does not suspend if the result was set since `await_ready`
+  auto await_suspend(std::coroutine_handle<> handle) const -> bool {
+    const std::lock_guard<std::mutex> lock(this->_state->mutex);
+    if (this->_state->ready) {
+      return false;
+    }
+    this->_state->continuations.emplace_back([handle] { handle.resume(); });
+    return true;
+  }
+  auto await_resume() const -> reference { return this->get(); }
+
+private:
+  friend class Promise<T>;
+  using State = typename Promise<T>::State;
+
+  std::shared_ptr<State> _state;
+
+  explicit Future(std::shared_ptr<State> state) : _state(std::move(state)) {}
+};
+
+// Coroutine promises, split since a promise may only declare one of
+// `return_value` and `return_void`
+template <typename T> struct FuturePromiseBase {
+  Promise<T> promise;
+  template <typename U>
+    requires std::is_convertible_v<U, T>
+  auto return_value(U &&value) -> void {
+    this->promise.set_value(std::forward<U>(value));
+  }
+};
+
+template <> struct FuturePromiseBase<void> {
+  Promise<void> promise;
+  auto return_void() -> void { this->promise.set_value(); }
+};
+
+template <typename T> struct Future<T>::promise_type : FuturePromiseBase<T> {
+  auto get_return_object() -> Future<T> {
+    return this->promise.get_future();
+  }
+  // Runs eagerly up to its first suspension
+  static auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+  // The frame is gone once done, the result lives on in the future
+  static auto final_suspend() noexcept -> std::suspend_never { return {}; }
+  auto unhandled_exception() -> void {
+    this->promise.set_exception(std::current_exception());
+  }
+};
+
+/**
+ * @brief In-order queue of tasks run by a dedicated thread.
+ *
+ * @details `submit` enqueues a call and returns the future of its result
+ * right away. Arguments that are futures are dependencies: the task waits
+ * for them and receives their results instead, and fails with their
+ * exception if they failed. A `Future<void>` has no result, so the task
+ * receives the completed future itself. Tasks of one stream run one after
+ * the other in submission order, while tasks of different streams overlap,
+ * so loading, preprocessing and compute can each get their own stream.
+ *
+ * Tasks run with the grad mode and the allocator of the thread that
+ * submitted them. Parallel ops of overlapping tasks share the intra-op
+ * thread pool: whichever task reaches it second runs inline on its stream.
+ *
+ * Arguments are copied into the task like for `std::thread`. Destroying a
+ * stream waits for its queued tasks to finish.
+ *
+ * ### Example
+ * ```
+ * synapse::Stream io;
+ * synapse::Stream compute;
+ * synapse::Future<synapse::Tensor> batch = io.submit(load_batch, path);
+ * synapse::Future<synapse::Tensor> out = compute.submit(
+ *     [&](const synapse::Tensor &input) { return model(input); }, batch);
+ * // The caller is free until it needs the result
+ * const synapse::Tensor &logits = out.get();
+ * ```
+ *
+ * Coroutines returning a `Future` can hop between streams instead:
+ * ```
+ * auto handle(synapse::Stream &compute, std::string path)
+ *     -> synapse::Future<synapse::Tensor> {
+ *   synapse::Tensor batch = load_batch(path); // On the caller
+ *   co_await compute.schedule();
+ *   co_return model(batch); // On the compute stream
+ * }
+ * ```
+ */
+class Stream {
+public:
+  Stream(const Stream &) = delete;
+  Stream(Stream &&) = delete;
+  auto operator=(const Stream &) -> Stream & = delete;
+  auto operator=(Stream &&) -> Stream & = delete;
+  Stream();
+  ~Stream();
+
+  template <typename Fn, typename... Args>
+  auto submit(Fn fn, Args... args) {
+    using R = std::invoke_result_t<Fn &, decltype(Stream::_resolve(args))...>;
+    Promise<R> promise;
+    Future<R> future = promise.get_future();
+    this->_enqueue([promise, fn = std::move(fn),
+                    ... args = std::move(args)]() mutable {
+      try {
+        if constexpr (std::is_void_v<R>) {
+          std::invoke(fn, Stream::_resolve(args)...);
+          promise.set_value();
+        } else {
+          promise.set_value(std::invoke(fn, Stream::_resolve(args)...));
+        }
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    });
+    return future;
+  }
+
+  /**
+   * @brief Makes the tasks submitted from now on wait for `future`, without
+   * blocking the caller.
+   */
+  template <typename T> auto wait(Future<T> future) -> void {
+    this->_enqueue([future = std::move(future)] { future.wait(); });
+  }
+
+  // Blocks until every task submitted so far has finished
+  auto synchronize() -> void;
+
+  /**
+   * @brief Awaitable resuming the awaiting coroutine as a task of the stream.
+   */
+  [[nodiscard]] auto schedule() {
+    struct Awaiter {
+      Stream *stream;
+      static auto await_ready() noexcept -> bool { return false; }
+      auto await_suspend(std::coroutine_handle<> handle) const -> void {
+        this->stream->_enqueue([handle] { handle.resume(); });
+      }
+      static auto await_resume() noexcept -> void {}
+    };
+    return Awaiter{this};
+  }
+
+  // Whether the calling thread is the one running the tasks of the stream
+  [[nodiscard]] auto is_current() const -> bool;
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+  std::deque<std::function<void()>> _queue;
+  // Queued plus running tasks
+  size_t _pending;
+  bool _stop;
+  std::thread _worker;
+
+  auto _enqueue(std::function<void()> task) -> void;
+  auto _worker_loop() -> void;
+
+  // Argument a task receives for `arg`
+  template <typename Arg> static auto _resolve(Arg &arg) -> Arg & {
+    return arg;
+  }
+  template <typename T>
+    requires(!std::is_void_v<T>)
+  static auto _resolve(Future<T> &arg) -> const T & {
+    return arg.get();
+  }
+  // No result to receive, the task gets the future back once it is done
+  static auto _resolve(Future<void> &arg) -> const Future<void> & {
+    arg.get();
+    return arg;
+  }
+};
+} // namespace synapse
+
+#endif // !SYNAPSE_STREAM_H
@@ -2,6 +2,9 @@
 #define SYNAPSE_TENSOR_H
 
 #include "ndarray.h"
+#include <cstddef>
+#include <format>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -9,6 +12,9 @@
  * @brief Tensor container
  */
 namespace synapse {
+class Node;
+struct AutogradMeta;
+
 class Tensor : public NDArray {
 public:
   Tensor(const Tensor &) = default;
@@ -16,10 +22,89 @@ public:
   auto operator=(const Tensor &) -> Tensor & = default;
   auto operator=(Tensor &&) -> Tensor & = default;
   Tensor(std::vector<float> data, synapse::Shape shape);
+  Tensor(const std::vector<float> &data, synapse::Shape shape, DType dtype);
+  explicit Tensor(NDArray array);
   ~Tensor();
 
+  // Factories, see the NDArray counterparts
+  static auto empty(const Shape &shape, DType dtype = DType::Float32)
+      -> Tensor;
+  static auto zeros(const Shape &shape, DType dtype = DType::Float32)
+      -> Tensor;
+
   [[nodiscard]] auto to_string() const -> std::string;
+
+  // Lazy evaluation, see lazy.h
+
+  /**
+   * @brief Computes the elements of a deferred tensor, no-op otherwise.
+   */
+  auto eval() const -> const Tensor &;
+  [[nodiscard]] auto is_lazy() const -> bool;
+
+  // Views, see the NDArray counterparts
+  [[nodiscard]] auto slice(size_t dim, size_t start, size_t end,
+                           size_t step = 1) const -> Tensor;
+  [[nodiscard]] auto transpose(size_t dim_0, size_t dim_1) const -> Tensor;
+  [[nodiscard]] auto permute(const Shape &dims) const -> Tensor;
+  [[nodiscard]] auto reshape(const Shape &shape) const -> Tensor;
+  [[nodiscard]] auto broadcast_to(const Shape &shape) const -> Tensor;
+  [[nodiscard]] auto expand(const Shape &shape) const -> Tensor;
+  [[nodiscard]] auto contiguous() const -> Tensor;
+
+  /**
+   * @brief Converts the elements to `dtype`, see `NDArray::to`.
+   *
+   * @details The gradient flows back converted to the source dtype.
+   */
+  [[nodiscard]] auto to(DType dtype) const -> Tensor;
+
+  // Autograd, see autograd.h
+
+  /**
+   * @brief Marks a leaf tensor as requiring gradients.
+   * @throws std::logic_error if the tensor is not a leaf.
+   * @throws std::invalid_argument if the tensor is not Float32, the only
+   * dtype the backward formulas are implemented for.
+   */
+  auto set_requires_grad(bool requires_grad = true) -> Tensor &;
+  [[nodiscard]] auto requires_grad() const -> bool;
+  [[nodiscard]] auto is_leaf() const -> bool;
+
+  /**
+   * @brief Gradient accumulated by `backward`.
+   * @throws std::logic_error if no gradient has been computed.
+   */
+  [[nodiscard]] auto grad() const -> const Tensor &;
+  [[nodiscard]] auto has_grad() const -> bool;
+  auto zero_grad() -> void;
+
+  [[nodiscard]] auto grad_fn() const -> std::shared_ptr<Node>;
+  auto set_grad_fn(std::shared_ptr<Node> grad_fn) -> void;
+  [[nodiscard]] auto autograd_meta() const
+      -> const std::shared_ptr<AutogradMeta> &;
+
+  /**
+   * @brief Returns an alias sharing the storage but outside of the graph.
+   */
+  [[nodiscard]] auto detach() const -> Tensor;
+
+  /**
+   * @brief Computes the gradients of this tensor w.r.t. the graph leaves.
+   *
+   * @details Without an explicit gradient the tensor must hold a single
+   * element, and is seeded with 1.
+   */
+  auto backward(bool retain_graph = false) const -> void;
+  auto backward(const Tensor &grad, bool retain_graph = false) const -> void;
+
+private:
+  std::shared_ptr<AutogradMeta> _autograd;
 };
 } // namespace synapse
 
+// Tensors format like arrays
+template <>
+struct std::formatter<synapse::Tensor> : std::formatter<synapse::NDArray> {};
+
 #endif // !SYNAPSE_TENSOR_H
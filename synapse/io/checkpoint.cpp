@@ -0,0 +1,241 @@
+#include "checkpoint.h"
+#include "allocator.h"
+#include "dtype.h"
+#include "mapped_file.h"
+#include "ndarray.h"
+#include "storage.h"
+#include "tensor.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+// Headers and elements are read in place from the mapping
+static_assert(std::endian::native == std::endian::little,
+              "Checkpoints are only supported on little endian hosts.");
+
+namespace {
+
+constexpr std::string_view MAGIC{"SYNAPSE\0", 8};
+constexpr uint32_t VERSION = 1;
+// Magic, version, number of tensors and header size
+constexpr size_t PREAMBLE_BYTES = 24;
+
+// Codes of the dtypes in the file, independent of the order of DType
+constexpr std::array<synapse::DType, 6> DTYPE_CODES{
+    synapse::DType::Float64, synapse::DType::Float32,
+    synapse::DType::Float16, synapse::DType::BFloat16,
+    synapse::DType::Int32,   synapse::DType::Int8};
+
+auto align(size_t offset) -> size_t {
+  constexpr size_t alignment = synapse::Allocator::alignment;
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Bytes of a tensor of `shape` and `dtype`, nullopt if they overflow size_t
+auto tensor_bytes(const synapse::Shape &shape, synapse::DType dtype)
+    -> std::optional<size_t> {
+  if (std::ranges::find(shape, 0) != shape.end()) {
+    return 0;
+  }
+  size_t bytes = synapse::dtype_size(dtype);
+  for (const size_t dim : shape) {
+    if (bytes > SIZE_MAX / dim) {
+      return std::nullopt;
+    }
+    bytes *= dim;
+  }
+  return bytes;
+}
+
+template <typename T> auto append(std::string &buffer, T value) -> void {
+  const auto bytes = std::bit_cast<std::array<char, sizeof(T)>>(value);
+  buffer.append(bytes.data(), bytes.size());
+}
+
+auto dtype_code(synapse::DType dtype) -> uint8_t {
+  return static_cast<uint8_t>(std::ranges::find(DTYPE_CODES, dtype) -
+                              DTYPE_CODES.begin());
+}
+
+// Bounds-checked reads from the header of a mapped checkpoint
+class HeaderReader {
+public:
+  HeaderReader(const std::byte *data, size_t size)
+      : _data(data), _size(size), _pos(0) {}
+
+  template <typename T> auto read() -> T {
+    this->_require(sizeof(T));
+    T value;
+    std::memcpy(&value, this->_data + this->_pos, sizeof(T));
+    this->_pos += sizeof(T);
+    return value;
+  }
+
+  [[nodiscard]] auto position() const -> size_t { return this->_pos; }
+
+  auto read_string(size_t length) -> std::string {
+    this->_require(length);
+    std::string value(reinterpret_cast<const char *>(this->_data + this->_pos),
+                      length);
+    this->_pos += length;
+    return value;
+  }
+
+private:
+  const std::byte *_data;
+  size_t _size;
+  size_t _pos;
+
+  auto _require(size_t bytes) const -> void {
+    if (bytes > this->_size - this->_pos) {
+      throw std::runtime_error("Truncated checkpoint header.");
+    }
+  }
+};
+} // namespace
+
+auto synapse::save_checkpoint(
+    const std::filesystem::path &path,
+    const std::map<std::string, synapse::Tensor> &tensors) -> void {
+  // The offsets of the elements depend on the size of the header
+  size_t header_bytes = PREAMBLE_BYTES;
+  for (const auto &[name, tensor] : tensors) {
+    if (tensor.ndim() > UINT8_MAX) {
+      throw std::invalid_argument(std::format(
+          "Cannot save tensor {} of {} dimensions.", name, tensor.ndim()));
+    }
+    header_bytes += 4 + name.size() + 2 + (8 * tensor.ndim()) + 16;
+  }
+  header_bytes = align(header_bytes);
+
+  std::string header;
+  header.reserve(header_bytes);
+  header.append(MAGIC);
+  append<uint32_t>(header, VERSION);
+  append<uint32_t>(header, static_cast<uint32_t>(tensors.size()));
+  append<uint64_t>(header, header_bytes);
+  size_t offset = header_bytes;
+  for (const auto &[name, tensor] : tensors) {
+    const size_t nbytes = tensor.size() * tensor.element_size();
+    append<uint32_t>(header, static_cast<uint32_t>(name.size()));
+    header.append(name);
+    append<uint8_t>(header, dtype_code(tensor.dtype()));
+    append<uint8_t>(header, static_cast<uint8_t>(tensor.ndim()));
+    for (const size_t dim : tensor.shape()) {
+      append<uint64_t>(header, dim);
+    }
+    append<uint64_t>(header, offset);
+    append<uint64_t>(header, nbytes);
+    offset = align(offset + nbytes);
+  }
+  header.resize(header_bytes, '\0');
+
+  // Written next to `path` and renamed over it, so a failed save, or one
+  // reading tensors mapped from `path` itself, leaves the old file intact
+  std::filesystem::path temp = path;
+  temp += ".tmp";
+  std::error_code error;
+  try {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    const std::array<char, synapse::Allocator::alignment> zeros{};
+    for (const auto &[name, tensor] : tensors) {
+      const synapse::NDArray dense = tensor.NDArray::contiguous();
+      const size_t nbytes = dense.size() * dense.element_size();
+      file.write(static_cast<const char *>(dense.raw_data()),
+                 static_cast<std::streamsize>(nbytes));
+      file.write(zeros.data(),
+                 static_cast<std::streamsize>(align(nbytes) - nbytes));
+    }
+    file.close();
+    if (!file) {
+      throw std::runtime_error(
+          std::format("Cannot write checkpoint {}.", path.string()));
+    }
+    std::filesystem::rename(temp, path, error);
+  } catch (...) {
+    std::filesystem::remove(temp, error);
+    throw;
+  }
+  if (error) {
+    std::filesystem::remove(temp, error);
+    throw std::runtime_error(std::format("Cannot write checkpoint {}: {}.",
+                                         path.string(), error.message()));
+  }
+}
+
+auto synapse::load_checkpoint(const std::filesystem::path &path)
+    -> std::map<std::string, synapse::Tensor> {
+  auto mapping = std::make_shared<synapse::MappedFile>(path);
+  HeaderReader reader(mapping->data(), mapping->size());
+  if (mapping->size() < PREAMBLE_BYTES || reader.read_string(8) != MAGIC) {
+    throw std::runtime_error(
+        std::format("{} is not a synapse checkpoint.", path.string()));
+  }
+  const auto version = reader.read<uint32_t>();
+  if (version != VERSION) {
+    throw std::runtime_error(
+        std::format("Unsupported checkpoint version {}.", version));
+  }
+  const auto count = reader.read<uint32_t>();
+  // Elements start at the aligned end of the header, which must fit the file
+  const auto header_bytes = reader.read<uint64_t>();
+  if (header_bytes < PREAMBLE_BYTES ||
+      header_bytes % synapse::Allocator::alignment != 0 ||
+      header_bytes > mapping->size()) {
+    throw std::runtime_error(
+        std::format("Invalid header size {} in checkpoint {}.", header_bytes,
+                    path.string()));
+  }
+
+  std::map<std::string, synapse::Tensor> tensors;
+  for (uint32_t i = 0; i < count; ++i) {
+    std::string name = reader.read_string(reader.read<uint32_t>());
+    const auto code = reader.read<uint8_t>();
+    if (code >= DTYPE_CODES.size()) {
+      throw std::runtime_error(
+          std::format("Unknown dtype code {} for tensor {}.", code, name));
+    }
+    const synapse::DType dtype = DTYPE_CODES[code];
+    synapse::Shape shape(reader.read<uint8_t>());
+    for (size_t &dim : shape) {
+      dim = static_cast<size_t>(reader.read<uint64_t>());
+    }
+    const auto offset = static_cast<size_t>(reader.read<uint64_t>());
+    const auto nbytes = static_cast<size_t>(reader.read<uint64_t>());
+    const std::optional<size_t> expected = tensor_bytes(shape, dtype);
+    if (!expected || nbytes != *expected ||
+        offset % synapse::Allocator::alignment != 0 || offset < header_bytes ||
+        offset > mapping->size() || nbytes > mapping->size() - offset) {
+      throw std::runtime_error(
+          std::format("Tensor {} is corrupted in checkpoint {}.", name,
+                      path.string()));
+    }
+    auto storage = std::make_shared<synapse::Storage>(
+        mapping->data() + offset, synapse::shape_numel(shape), dtype, mapping);
+    synapse::Strides strides = synapse::contiguous_strides(shape);
+    tensors.emplace(std::move(name),
+                    synapse::Tensor{synapse::NDArray{
+                        std::move(storage), 0, std::move(shape),
+                        std::move(strides)}});
+  }
+  if (reader.position() > header_bytes) {
+    throw std::runtime_error(
+        std::format("Header of checkpoint {} overruns its size {}.",
+                    path.string(), header_bytes));
+  }
+  return tensors;
+}
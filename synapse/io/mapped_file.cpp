@@ -0,0 +1,52 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstddef>
+#include <fcntl.h>
+#include <filesystem>
+#include <format>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+synapse::MappedFile::MappedFile(const std::filesystem::path &path)
+    : _data(nullptr), _size(0) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(),
+                            std::format("Cannot open {}", path.string()));
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(),
+                            std::format("Cannot stat {}", path.string()));
+  }
+  this->_size = static_cast<size_t>(info.st_size);
+  if (this->_size == 0) {
+    ::close(fd);
+    return;
+  }
+  // Writable but private: writes copy the page instead of reaching the file
+  this->_data = ::mmap(nullptr, this->_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  const int error = errno;
+  ::close(fd);
+  if (this->_data == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(),
+                            std::format("Cannot map {}", path.string()));
+  }
+}
+
+synapse::MappedFile::~MappedFile() {
+  if (this->_data != nullptr) {
+    ::munmap(this->_data, this->_size);
+  }
+}
+
+auto synapse::MappedFile::data() const -> std::byte * {
+  return static_cast<std::byte *>(this->_data);
+}
+
+auto synapse::MappedFile::size() const -> size_t { return this->_size; }
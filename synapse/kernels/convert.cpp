@@ -0,0 +1,169 @@
+#include "cpu.h"
+#include "dtype.h"
+#include "parallel.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYNAPSE_CONVERT_X86 1
+#include <immintrin.h>
+#else
+#define SYNAPSE_CONVERT_X86 0
+#endif
+
+namespace {
+
+template <typename To, typename From>
+auto convert_scalar(const From *src, To *dst, size_t n) -> void {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = synapse::scalar_cast<To>(src[i]);
+  }
+}
+
+#if SYNAPSE_CONVERT_X86
+// F16C is not a level of its own, so it follows the AVX2 one
+auto has_f16c() -> bool {
+  static const bool supported = __builtin_cpu_supports("f16c");
+  return supported && synapse::cpu_level() >= synapse::CpuLevel::Avx2;
+}
+
+auto has_avx2() -> bool {
+  return synapse::cpu_level() >= synapse::CpuLevel::Avx2;
+}
+
+[[gnu::target("avx,f16c")]] auto float_to_half_f16c(const float *src,
+                                                    synapse::Half *dst,
+                                                    size_t n) -> void {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i halves =
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), halves);
+  }
+  convert_scalar(src + i, dst + i, n - i);
+}
+
+[[gnu::target("avx,f16c")]] auto half_to_float_f16c(const synapse::Half *src,
+                                                    float *dst, size_t n)
+    -> void {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i halves =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(halves));
+  }
+  convert_scalar(src + i, dst + i, n - i);
+}
+
+// Rounds 8 floats to bfloat16, each result in the low half of a 32-bit lane
+[[gnu::target("avx2")]] inline auto round_to_bfloat16(__m256 values)
+    -> __m256i {
+  const __m256i bits = _mm256_castps_si256(values);
+  const __m256i lsb =
+      _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+  const __m256i rounded = _mm256_srli_epi32(
+      _mm256_add_epi32(bits, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))),
+      16);
+  // NaNs are truncated and made quiet instead, rounding could turn them into
+  // infinities
+  const __m256i quiet = _mm256_or_si256(_mm256_srli_epi32(bits, 16),
+                                        _mm256_set1_epi32(0x40));
+  const __m256i nan =
+      _mm256_castps_si256(_mm256_cmp_ps(values, values, _CMP_UNORD_Q));
+  return _mm256_blendv_epi8(rounded, quiet, nan);
+}
+
+[[gnu::target("avx2")]] auto float_to_bfloat16_avx2(const float *src,
+                                                    synapse::BFloat16 *dst,
+                                                    size_t n) -> void {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i lo = round_to_bfloat16(_mm256_loadu_ps(src + i));
+    const __m256i hi = round_to_bfloat16(_mm256_loadu_ps(src + i + 8));
+    // Packing works per 128-bit lane, the permute restores the order
+    const __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+  }
+  convert_scalar(src + i, dst + i, n - i);
+}
+
+[[gnu::target("avx2")]] auto bfloat16_to_float_avx2(
+    const synapse::BFloat16 *src, float *dst, size_t n) -> void {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i widened = _mm256_cvtepu16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)));
+    _mm256_storeu_ps(dst + i,
+                     _mm256_castsi256_ps(_mm256_slli_epi32(widened, 16)));
+  }
+  convert_scalar(src + i, dst + i, n - i);
+}
+
+// Runs the vectorized kernel for the pair if there is one
+auto convert_vectorized(const void *src, synapse::DType src_dtype, void *dst,
+                        synapse::DType dst_dtype, size_t n) -> bool {
+  using synapse::DType;
+  if (src_dtype == DType::Float32 && dst_dtype == DType::Float16 &&
+      has_f16c()) {
+    float_to_half_f16c(static_cast<const float *>(src),
+                       static_cast<synapse::Half *>(dst), n);
+  } else if (src_dtype == DType::Float16 && dst_dtype == DType::Float32 &&
+             has_f16c()) {
+    half_to_float_f16c(static_cast<const synapse::Half *>(src),
+                       static_cast<float *>(dst), n);
+  } else if (src_dtype == DType::Float32 && dst_dtype == DType::BFloat16 &&
+             has_avx2()) {
+    float_to_bfloat16_avx2(static_cast<const float *>(src),
+                           static_cast<synapse::BFloat16 *>(dst), n);
+  } else if (src_dtype == DType::BFloat16 && dst_dtype == DType::Float32 &&
+             has_avx2()) {
+    bfloat16_to_float_avx2(static_cast<const synapse::BFloat16 *>(src),
+                           static_cast<float *>(dst), n);
+  } else {
+    return false;
+  }
+  return true;
+}
+#else
+auto convert_vectorized(const void * /*src*/, synapse::DType /*src_dtype*/,
+                        void * /*dst*/, synapse::DType /*dst_dtype*/,
+                        size_t /*n*/) -> bool {
+  return false;
+}
+#endif
+
+auto convert_chunk(const void *src, synapse::DType src_dtype, void *dst,
+                   synapse::DType dst_dtype, size_t n) -> void {
+  if (src_dtype == dst_dtype) {
+    std::memcpy(dst, src, n * synapse::dtype_size(src_dtype));
+    return;
+  }
+  if (convert_vectorized(src, src_dtype, dst, dst_dtype, n)) {
+    return;
+  }
+  synapse::dispatch(src_dtype, [&](auto src_tag) {
+    using From = typename decltype(src_tag)::type;
+    synapse::dispatch(dst_dtype, [&](auto dst_tag) {
+      using To = typename decltype(dst_tag)::type;
+      convert_scalar(static_cast<const From *>(src), static_cast<To *>(dst),
+                     n);
+    });
+  });
+}
+} // namespace
+
+auto synapse::convert(const void *src, synapse::DType src_dtype, void *dst,
+                      synapse::DType dst_dtype, size_t numel) -> void {
+  const size_t src_size = synapse::dtype_size(src_dtype);
+  const size_t dst_size = synapse::dtype_size(dst_dtype);
+  const auto *src_bytes = static_cast<const std::byte *>(src);
+  auto *dst_bytes = static_cast<std::byte *>(dst);
+  synapse::parallel_for(
+      0, numel, synapse::GRAIN_SIZE, [&](size_t begin, size_t end) {
+        convert_chunk(src_bytes + (begin * src_size), src_dtype,
+                      dst_bytes + (begin * dst_size), dst_dtype, end - begin);
+      });
+}
@@ -0,0 +1,83 @@
+#include "cpu.h"
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+auto detect_level() -> synapse::CpuLevel {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx512f")) {
+    return synapse::CpuLevel::Avx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return synapse::CpuLevel::Avx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return synapse::CpuLevel::Sse42;
+  }
+#endif
+  return synapse::CpuLevel::Baseline;
+}
+
+auto parse_level(std::string_view name) -> std::optional<synapse::CpuLevel> {
+  for (const auto level :
+       {synapse::CpuLevel::Baseline, synapse::CpuLevel::Sse42,
+        synapse::CpuLevel::Avx2, synapse::CpuLevel::Avx512}) {
+    if (name == synapse::cpu_level_name(level)) {
+      return level;
+    }
+  }
+  return std::nullopt;
+}
+
+// The detected level, lowered by SYNAPSE_CPU_LEVEL. Unknown names are
+// ignored, so a typo never disables the fast paths silently for good
+auto initial_level() -> synapse::CpuLevel {
+  const synapse::CpuLevel detected = synapse::detected_cpu_level();
+  const char *name = std::getenv("SYNAPSE_CPU_LEVEL");
+  const std::optional<synapse::CpuLevel> forced =
+      name == nullptr ? std::nullopt : parse_level(name);
+  return forced.has_value() && *forced < detected ? *forced : detected;
+}
+
+auto level_slot() -> std::atomic<synapse::CpuLevel> & {
+  static std::atomic<synapse::CpuLevel> slot{initial_level()};
+  return slot;
+}
+} // namespace
+
+auto synapse::detected_cpu_level() -> synapse::CpuLevel {
+  static const synapse::CpuLevel level = detect_level();
+  return level;
+}
+
+auto synapse::cpu_level() -> synapse::CpuLevel {
+  return level_slot().load(std::memory_order_relaxed);
+}
+
+auto synapse::set_cpu_level(synapse::CpuLevel level) -> void {
+  if (level > synapse::detected_cpu_level()) {
+    throw std::invalid_argument(std::format(
+        "CPU level {} is not supported by this host, which supports up to {}.",
+        synapse::cpu_level_name(level),
+        synapse::cpu_level_name(synapse::detected_cpu_level())));
+  }
+  level_slot().store(level, std::memory_order_relaxed);
+}
+
+auto synapse::cpu_level_name(synapse::CpuLevel level) -> std::string_view {
+  switch (level) {
+  case synapse::CpuLevel::Sse42:
+    return "sse4.2";
+  case synapse::CpuLevel::Avx2:
+    return "avx2";
+  case synapse::CpuLevel::Avx512:
+    return "avx512";
+  case synapse::CpuLevel::Baseline:
+  default:
+    return "baseline";
+  }
+}
@@ -0,0 +1,183 @@
+#include "elementwise.h"
+#include "cpu.h"
+#include "dtype.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYNAPSE_ELEMENTWISE_X86 1
+#else
+#define SYNAPSE_ELEMENTWISE_X86 0
+#endif
+
+namespace {
+using Registry =
+    synapse::KernelRegistry<synapse::ElementwiseOp, synapse::ElementwiseKernel>;
+
+// Every dtype is computed in its `compute_type_t`, like the lazy evaluator
+template <synapse::ElementwiseOp Op, typename T> auto apply(T lhs, T rhs) -> T {
+  using C = synapse::compute_type_t<T>;
+  return synapse::scalar_cast<T>(synapse::binary_scalar<Op, C>(
+      synapse::scalar_cast<C>(lhs), synapse::scalar_cast<C>(rhs)));
+}
+
+template <synapse::ElementwiseOp Op, typename T> auto apply(T value) -> T {
+  using C = synapse::compute_type_t<T>;
+  return synapse::scalar_cast<T>(
+      synapse::unary_scalar<Op, C>(synapse::scalar_cast<C>(value)));
+}
+
+// Loops shared by every level, inlined into each target-specific copy so
+// the compiler vectorizes them for its instruction set. Dense runs and runs
+// where one side is a broadcasted scalar get their own branch. An output
+// may alias an operand at the same index only, so iterations never depend
+// on each other (ivdep).
+template <synapse::ElementwiseOp Op, typename T>
+[[gnu::always_inline]] inline auto binary_body(void *out_ptr,
+                                               const void *const *in,
+                                               const size_t *strides, size_t n)
+    -> void {
+  T *out = static_cast<T *>(out_ptr);
+  const T *lhs = static_cast<const T *>(in[0]);
+  const T *rhs = static_cast<const T *>(in[1]);
+  if (strides[0] == 1 && strides[1] == 1 && strides[2] == 1) {
+#pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = apply<Op>(lhs[i], rhs[i]);
+    }
+  } else if (strides[0] == 1 && strides[1] == 1 && strides[2] == 0) {
+    const T scalar = *rhs;
+#pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = apply<Op>(lhs[i], scalar);
+    }
+  } else if (strides[0] == 1 && strides[1] == 0 && strides[2] == 1) {
+    const T scalar = *lhs;
+#pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = apply<Op>(scalar, rhs[i]);
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      out[i * strides[0]] = apply<Op>(lhs[i * strides[1]], rhs[i * strides[2]]);
+    }
+  }
+}
+
+template <synapse::ElementwiseOp Op, typename T>
+[[gnu::always_inline]] inline auto unary_body(void *out_ptr,
+                                              const void *const *in,
+                                              const size_t *strides, size_t n)
+    -> void {
+  T *out = static_cast<T *>(out_ptr);
+  const T *src = static_cast<const T *>(in[0]);
+  if (strides[0] == 1 && strides[1] == 1) {
+#pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = apply<Op>(src[i]);
+    }
+  } else {
+    for (size_t i = 0; i < n; ++i) {
+      out[i * strides[0]] = apply<Op>(src[i * strides[1]]);
+    }
+  }
+}
+
+template <synapse::ElementwiseOp Op, typename T>
+auto body(void *out, const void *const *in, const size_t *strides, size_t n)
+    -> void {
+  if constexpr (synapse::is_binary(Op)) {
+    binary_body<Op, T>(out, in, strides, n);
+  } else {
+    unary_body<Op, T>(out, in, strides, n);
+  }
+}
+
+#if SYNAPSE_ELEMENTWISE_X86
+template <synapse::ElementwiseOp Op, typename T>
+[[gnu::target("sse4.2")]] auto body_sse42(void *out, const void *const *in,
+                                          const size_t *strides, size_t n)
+    -> void {
+  if constexpr (synapse::is_binary(Op)) {
+    binary_body<Op, T>(out, in, strides, n);
+  } else {
+    unary_body<Op, T>(out, in, strides, n);
+  }
+}
+
+template <synapse::ElementwiseOp Op, typename T>
+[[gnu::target("avx2,fma")]] auto body_avx2(void *out, const void *const *in,
+                                           const size_t *strides, size_t n)
+    -> void {
+  if constexpr (synapse::is_binary(Op)) {
+    binary_body<Op, T>(out, in, strides, n);
+  } else {
+    unary_body<Op, T>(out, in, strides, n);
+  }
+}
+
+// Full width vectors, where the compiler defaults to 256 bits
+template <synapse::ElementwiseOp Op, typename T>
+[[gnu::target("avx512f,prefer-vector-width=512")]] auto
+body_avx512(void *out, const void *const *in, const size_t *strides, size_t n)
+    -> void {
+  if constexpr (synapse::is_binary(Op)) {
+    binary_body<Op, T>(out, in, strides, n);
+  } else {
+    unary_body<Op, T>(out, in, strides, n);
+  }
+}
+#endif
+
+// Dtypes whose loops vectorize, and so get a kernel per level
+template <typename T>
+constexpr bool VECTORIZED = std::is_same_v<T, float> ||
+                            std::is_same_v<T, double> ||
+                            std::is_same_v<T, int32_t>;
+
+template <synapse::ElementwiseOp Op, typename T>
+auto register_kernels(Registry &registry) -> void {
+  // Floating point ops never run on integers, see `is_floating_point_op`
+  if constexpr (!synapse::is_floating_point_op(Op) ||
+                !std::is_integral_v<T>) {
+    const synapse::DType dtype = synapse::dtype_of<T>::value;
+    registry.add(Op, dtype, synapse::CpuLevel::Baseline, body<Op, T>);
+#if SYNAPSE_ELEMENTWISE_X86
+    if constexpr (VECTORIZED<T>) {
+      registry.add(Op, dtype, synapse::CpuLevel::Sse42, body_sse42<Op, T>);
+      registry.add(Op, dtype, synapse::CpuLevel::Avx2, body_avx2<Op, T>);
+      registry.add(Op, dtype, synapse::CpuLevel::Avx512, body_avx512<Op, T>);
+    }
+#endif
+  }
+}
+
+template <synapse::ElementwiseOp Op>
+auto register_op(Registry &registry) -> void {
+  register_kernels<Op, double>(registry);
+  register_kernels<Op, float>(registry);
+  register_kernels<Op, synapse::Half>(registry);
+  register_kernels<Op, synapse::BFloat16>(registry);
+  register_kernels<Op, int32_t>(registry);
+  register_kernels<Op, int8_t>(registry);
+}
+
+template <size_t... I>
+auto register_all(Registry &registry, std::index_sequence<I...> /*ops*/)
+    -> void {
+  (register_op<static_cast<synapse::ElementwiseOp>(I)>(registry), ...);
+}
+} // namespace
+
+auto synapse::elementwise_kernels() -> Registry & {
+  static Registry registry;
+  static std::once_flag registered;
+  std::call_once(registered, [] {
+    register_all(registry,
+                 std::make_index_sequence<synapse::ELEMENTWISE_OPS>{});
+  });
+  return registry;
+}
@@ -0,0 +1,800 @@
+#include "gemm.h"
+#include "cpu.h"
+#include "elementwise.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYNAPSE_GEMM_X86 1
+#include <immintrin.h>
+#else
+#define SYNAPSE_GEMM_X86 0
+#endif
+
+namespace {
+
+// Computes an MR x NR tile of C from a packed MR x kc sliver of A and a packed
+// kc x NR sliver of B. When `accumulate` is false the tile is overwritten.
+using MicroKernel = void (*)(size_t kc, const float *a, const float *b,
+                             float *c, size_t ldc, bool accumulate);
+
+// Computes `rows` dot products of k floats, out[i * inc_out] = x_i . y, where
+// the rows x_i start `ldx` apart and y is contiguous.
+using DotKernel = void (*)(size_t rows, size_t k, const float *x, size_t ldx,
+                           const float *y, float *out, size_t inc_out,
+                           bool accumulate);
+
+// Combines k rows of n contiguous floats, c[j] = sum_p alpha_p * b_p[j], where
+// the rows b_p start `ldb` apart and alpha_p is alpha[p * inc_alpha].
+using AxpyKernel = void (*)(size_t n, size_t k, const float *alpha,
+                            size_t inc_alpha, const float *b, size_t ldb,
+                            float *c, bool accumulate);
+
+// Register and cache blocking parameters of a micro-kernel family, with the
+// matrix-vector kernels of the same instruction set.
+// - mr x nr: C tile held in registers.
+// - kc: depth of the packed slivers, sized so a B sliver stays in L1.
+// - mc: rows of the packed A block, sized so it stays in L2.
+// - nc: columns of the packed B panel, sized so it stays in L3.
+struct KernelConfig {
+  size_t mr;
+  size_t nr;
+  size_t mc;
+  size_t kc;
+  size_t nc;
+  MicroKernel kernel;
+  DotKernel dot;
+  AxpyKernel axpy;
+};
+
+// Largest tile over all kernels, used to size the edge buffer.
+constexpr size_t MAX_TILE = 12 * 32;
+
+// Multiply-adds below which a product is not worth splitting across threads.
+constexpr size_t PARALLEL_MIN_WORK = size_t{1} << 18;
+
+// Products with at most this many rows or columns skip packing and run as
+// one matrix-vector product per row or column, since a register tile would
+// mostly compute padding.
+constexpr size_t SKINNY_MAX = 8;
+
+// Depth of the blocks the axpy kernels stream B in, so the rows they walk
+// stay few enough for the prefetchers.
+constexpr size_t AXPY_KC = 256;
+
+// Floats of A a dot product block keeps in cache while every column of B
+// is run against it.
+constexpr size_t DOT_BLOCK = size_t{1} << 12;
+
+template <size_t MR, size_t NR>
+auto kernel_scalar(size_t kc, const float *a, const float *b, float *c,
+                   size_t ldc, bool accumulate) -> void {
+  float acc[MR][NR] = {};
+  for (size_t p = 0; p < kc; ++p) {
+    for (size_t i = 0; i < MR; ++i) {
+      for (size_t j = 0; j < NR; ++j) {
+        acc[i][j] += a[i] * b[j];
+      }
+    }
+    a += MR;
+    b += NR;
+  }
+  for (size_t i = 0; i < MR; ++i) {
+    float *c_row = c + (i * ldc);
+    for (size_t j = 0; j < NR; ++j) {
+      c_row[j] = accumulate ? c_row[j] + acc[i][j] : acc[i][j];
+    }
+  }
+}
+
+// Partial sums in independent accumulators, which a single running sum
+// would serialize on the latency of every addition.
+auto dot_scalar(size_t rows, size_t k, const float *x, size_t ldx,
+                const float *y, float *out, size_t inc_out, bool accumulate)
+    -> void {
+  for (size_t i = 0; i < rows; ++i) {
+    const float *x_row = x + (i * ldx);
+    float acc[4] = {};
+    size_t p = 0;
+    for (; p + 4 <= k; p += 4) {
+      for (size_t q = 0; q < 4; ++q) {
+        acc[q] += x_row[p + q] * y[p + q];
+      }
+    }
+    for (; p < k; ++p) {
+      acc[0] += x_row[p] * y[p];
+    }
+    const float dot = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    float *dst = out + (i * inc_out);
+    *dst = accumulate ? *dst + dot : dot;
+  }
+}
+
+auto axpy_scalar(size_t n, size_t k, const float *alpha, size_t inc_alpha,
+                 const float *b, size_t ldb, float *c, bool accumulate)
+    -> void {
+  if (!accumulate) {
+    std::fill(c, c + n, 0.0F);
+  }
+  for (size_t p = 0; p < k; ++p) {
+    const float alpha_p = alpha[p * inc_alpha];
+    const float *b_row = b + (p * ldb);
+    for (size_t j = 0; j < n; ++j) {
+      c[j] += alpha_p * b_row[j];
+    }
+  }
+}
+
+#if SYNAPSE_GEMM_X86
+[[gnu::target("avx2,fma")]] auto kernel_avx2_6x16(size_t kc, const float *a,
+                                                  const float *b, float *c,
+                                                  size_t ldc, bool accumulate)
+    -> void {
+  __m256 acc[6][2];
+  for (auto &row : acc) {
+    row[0] = _mm256_setzero_ps();
+    row[1] = _mm256_setzero_ps();
+  }
+  for (size_t p = 0; p < kc; ++p) {
+    const __m256 b_0 = _mm256_loadu_ps(b);
+    const __m256 b_1 = _mm256_loadu_ps(b + 8);
+    for (size_t i = 0; i < 6; ++i) {
+      const __m256 a_i = _mm256_broadcast_ss(a + i);
+      acc[i][0] = _mm256_fmadd_ps(a_i, b_0, acc[i][0]);
+      acc[i][1] = _mm256_fmadd_ps(a_i, b_1, acc[i][1]);
+    }
+    a += 6;
+    b += 16;
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    float *c_row = c + (i * ldc);
+    if (accumulate) {
+      acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(c_row));
+      acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(c_row + 8));
+    }
+    _mm256_storeu_ps(c_row, acc[i][0]);
+    _mm256_storeu_ps(c_row + 8, acc[i][1]);
+  }
+}
+
+[[gnu::target("avx512f")]] auto kernel_avx512_12x32(size_t kc, const float *a,
+                                                    const float *b, float *c,
+                                                    size_t ldc,
+                                                    bool accumulate) -> void {
+  __m512 acc[12][2];
+  for (auto &row : acc) {
+    row[0] = _mm512_setzero_ps();
+    row[1] = _mm512_setzero_ps();
+  }
+  for (size_t p = 0; p < kc; ++p) {
+    const __m512 b_0 = _mm512_loadu_ps(b);
+    const __m512 b_1 = _mm512_loadu_ps(b + 16);
+    for (size_t i = 0; i < 12; ++i) {
+      const __m512 a_i = _mm512_set1_ps(a[i]);
+      acc[i][0] = _mm512_fmadd_ps(a_i, b_0, acc[i][0]);
+      acc[i][1] = _mm512_fmadd_ps(a_i, b_1, acc[i][1]);
+    }
+    a += 12;
+    b += 32;
+  }
+  for (size_t i = 0; i < 12; ++i) {
+    float *c_row = c + (i * ldc);
+    if (accumulate) {
+      acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_loadu_ps(c_row));
+      acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_loadu_ps(c_row + 16));
+    }
+    _mm512_storeu_ps(c_row, acc[i][0]);
+    _mm512_storeu_ps(c_row + 16, acc[i][1]);
+  }
+}
+
+[[gnu::target("avx2,fma")]] auto sum_avx2(__m256 v) -> float {
+  const __m128 half = _mm_add_ps(_mm256_castps256_ps128(v),
+                                 _mm256_extractf128_ps(v, 1));
+  const __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+  return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehdup_ps(pairs)));
+}
+
+[[gnu::target("avx2,fma")]] auto dot_avx2(size_t rows, size_t k,
+                                          const float *x, size_t ldx,
+                                          const float *y, float *out,
+                                          size_t inc_out, bool accumulate)
+    -> void {
+  size_t i = 0;
+  // Four rows share every load of y, with two accumulators each
+  for (; i + 4 <= rows; i += 4) {
+    const float *x_rows[4] = {x + (i * ldx), x + ((i + 1) * ldx),
+                              x + ((i + 2) * ldx), x + ((i + 3) * ldx)};
+    __m256 acc[4][2];
+    for (auto &row : acc) {
+      row[0] = _mm256_setzero_ps();
+      row[1] = _mm256_setzero_ps();
+    }
+    size_t p = 0;
+    for (; p + 16 <= k; p += 16) {
+      const __m256 y_0 = _mm256_loadu_ps(y + p);
+      const __m256 y_1 = _mm256_loadu_ps(y + p + 8);
+      for (size_t r = 0; r < 4; ++r) {
+        acc[r][0] =
+            _mm256_fmadd_ps(_mm256_loadu_ps(x_rows[r] + p), y_0, acc[r][0]);
+        acc[r][1] = _mm256_fmadd_ps(_mm256_loadu_ps(x_rows[r] + p + 8), y_1,
+                                    acc[r][1]);
+      }
+    }
+    for (size_t r = 0; r < 4; ++r) {
+      float dot = sum_avx2(_mm256_add_ps(acc[r][0], acc[r][1]));
+      for (size_t q = p; q < k; ++q) {
+        dot += x_rows[r][q] * y[q];
+      }
+      float *dst = out + ((i + r) * inc_out);
+      *dst = accumulate ? *dst + dot : dot;
+    }
+  }
+  for (; i < rows; ++i) {
+    const float *x_row = x + (i * ldx);
+    __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(),
+                     _mm256_setzero_ps(), _mm256_setzero_ps()};
+    size_t p = 0;
+    for (; p + 32 <= k; p += 32) {
+      for (size_t v = 0; v < 4; ++v) {
+        acc[v] = _mm256_fmadd_ps(_mm256_loadu_ps(x_row + p + (v * 8)),
+                                 _mm256_loadu_ps(y + p + (v * 8)), acc[v]);
+      }
+    }
+    for (; p + 8 <= k; p += 8) {
+      acc[0] = _mm256_fmadd_ps(_mm256_loadu_ps(x_row + p),
+                               _mm256_loadu_ps(y + p), acc[0]);
+    }
+    float dot = sum_avx2(_mm256_add_ps(_mm256_add_ps(acc[0], acc[1]),
+                                       _mm256_add_ps(acc[2], acc[3])));
+    for (; p < k; ++p) {
+      dot += x_row[p] * y[p];
+    }
+    float *dst = out + (i * inc_out);
+    *dst = accumulate ? *dst + dot : dot;
+  }
+}
+
+[[gnu::target("avx2,fma")]] auto axpy_avx2(size_t n, size_t k,
+                                           const float *alpha,
+                                           size_t inc_alpha, const float *b,
+                                           size_t ldb, float *c,
+                                           bool accumulate) -> void {
+  for (size_t pc = 0; pc < k; pc += AXPY_KC) {
+    const size_t kc = std::min(AXPY_KC, k - pc);
+    const bool load = accumulate || pc > 0;
+    const float *b_block = b + (pc * ldb);
+    const float *alpha_block = alpha + (pc * inc_alpha);
+    size_t j = 0;
+    // 64 columns stay in registers over the whole depth block
+    for (; j + 64 <= n; j += 64) {
+      __m256 acc[8];
+      for (size_t v = 0; v < 8; ++v) {
+        acc[v] =
+            load ? _mm256_loadu_ps(c + j + (v * 8)) : _mm256_setzero_ps();
+      }
+      for (size_t p = 0; p < kc; ++p) {
+        const __m256 alpha_p =
+            _mm256_broadcast_ss(alpha_block + (p * inc_alpha));
+        const float *b_row = b_block + (p * ldb) + j;
+        for (size_t v = 0; v < 8; ++v) {
+          acc[v] = _mm256_fmadd_ps(alpha_p, _mm256_loadu_ps(b_row + (v * 8)),
+                                   acc[v]);
+        }
+      }
+      for (size_t v = 0; v < 8; ++v) {
+        _mm256_storeu_ps(c + j + (v * 8), acc[v]);
+      }
+    }
+    for (; j + 8 <= n; j += 8) {
+      __m256 acc = load ? _mm256_loadu_ps(c + j) : _mm256_setzero_ps();
+      for (size_t p = 0; p < kc; ++p) {
+        acc = _mm256_fmadd_ps(
+            _mm256_broadcast_ss(alpha_block + (p * inc_alpha)),
+            _mm256_loadu_ps(b_block + (p * ldb) + j), acc);
+      }
+      _mm256_storeu_ps(c + j, acc);
+    }
+    for (; j < n; ++j) {
+      float sum = load ? c[j] : 0.0F;
+      for (size_t p = 0; p < kc; ++p) {
+        sum += alpha_block[p * inc_alpha] * b_block[(p * ldb) + j];
+      }
+      c[j] = sum;
+    }
+  }
+}
+
+// Folds the halves onto each other in registers. The unmasked shuffles and
+// extracts, _mm512_reduce_add_ps included, trip GCC's uninitialized
+// warnings, which the zero-masked forms do not.
+[[gnu::target("avx512f")]] auto sum_avx512(__m512 v) -> float {
+  constexpr __mmask16 ALL = 0xFFFF;
+  v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(ALL, v, v, 0x4E));
+  v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4(ALL, v, v, 0xB1));
+  const __m128 quad = _mm512_maskz_extractf32x4_ps(0xF, v, 0);
+  const __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+  return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehdup_ps(pairs)));
+}
+
+[[gnu::target("avx512f")]] auto dot_avx512(size_t rows, size_t k,
+                                           const float *x, size_t ldx,
+                                           const float *y, float *out,
+                                           size_t inc_out, bool accumulate)
+    -> void {
+  size_t i = 0;
+  // Four rows share every load of y, with two accumulators each
+  for (; i + 4 <= rows; i += 4) {
+    const float *x_rows[4] = {x + (i * ldx), x + ((i + 1) * ldx),
+                              x + ((i + 2) * ldx), x + ((i + 3) * ldx)};
+    __m512 acc[4][2];
+    for (auto &row : acc) {
+      row[0] = _mm512_setzero_ps();
+      row[1] = _mm512_setzero_ps();
+    }
+    size_t p = 0;
+    for (; p + 32 <= k; p += 32) {
+      const __m512 y_0 = _mm512_loadu_ps(y + p);
+      const __m512 y_1 = _mm512_loadu_ps(y + p + 16);
+      for (size_t r = 0; r < 4; ++r) {
+        acc[r][0] =
+            _mm512_fmadd_ps(_mm512_loadu_ps(x_rows[r] + p), y_0, acc[r][0]);
+        acc[r][1] = _mm512_fmadd_ps(_mm512_loadu_ps(x_rows[r] + p + 16), y_1,
+                                    acc[r][1]);
+      }
+    }
+    for (size_t r = 0; r < 4; ++r) {
+      float dot = sum_avx512(_mm512_add_ps(acc[r][0], acc[r][1]));
+      for (size_t q = p; q < k; ++q) {
+        dot += x_rows[r][q] * y[q];
+      }
+      float *dst = out + ((i + r) * inc_out);
+      *dst = accumulate ? *dst + dot : dot;
+    }
+  }
+  for (; i < rows; ++i) {
+    const float *x_row = x + (i * ldx);
+    __m512 acc[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(),
+                     _mm512_setzero_ps(), _mm512_setzero_ps()};
+    size_t p = 0;
+    for (; p + 64 <= k; p += 64) {
+      for (size_t v = 0; v < 4; ++v) {
+        acc[v] = _mm512_fmadd_ps(_mm512_loadu_ps(x_row + p + (v * 16)),
+                                 _mm512_loadu_ps(y + p + (v * 16)), acc[v]);
+      }
+    }
+    for (; p + 16 <= k; p += 16) {
+      acc[0] = _mm512_fmadd_ps(_mm512_loadu_ps(x_row + p),
+                               _mm512_loadu_ps(y + p), acc[0]);
+    }
+    float dot = sum_avx512(_mm512_add_ps(_mm512_add_ps(acc[0], acc[1]),
+                                         _mm512_add_ps(acc[2], acc[3])));
+    for (; p < k; ++p) {
+      dot += x_row[p] * y[p];
+    }
+    float *dst = out + (i * inc_out);
+    *dst = accumulate ? *dst + dot : dot;
+  }
+}
+
+[[gnu::target("avx512f")]] auto axpy_avx512(size_t n, size_t k,
+                                            const float *alpha,
+                                            size_t inc_alpha, const float *b,
+                                            size_t ldb, float *c,
+                                            bool accumulate) -> void {
+  for (size_t pc = 0; pc < k; pc += AXPY_KC) {
+    const size_t kc = std::min(AXPY_KC, k - pc);
+    const bool load = accumulate || pc > 0;
+    const float *b_block = b + (pc * ldb);
+    const float *alpha_block = alpha + (pc * inc_alpha);
+    size_t j = 0;
+    // 128 columns stay in registers over the whole depth block
+    for (; j + 128 <= n; j += 128) {
+      __m512 acc[8];
+      for (size_t v = 0; v < 8; ++v) {
+        acc[v] =
+            load ? _mm512_loadu_ps(c + j + (v * 16)) : _mm512_setzero_ps();
+      }
+      for (size_t p = 0; p < kc; ++p) {
+        const __m512 alpha_p = _mm512_set1_ps(alpha_block[p * inc_alpha]);
+        const float *b_row = b_block + (p * ldb) + j;
+        for (size_t v = 0; v < 8; ++v) {
+          acc[v] = _mm512_fmadd_ps(alpha_p, _mm512_loadu_ps(b_row + (v * 16)),
+                                   acc[v]);
+        }
+      }
+      for (size_t v = 0; v < 8; ++v) {
+        _mm512_storeu_ps(c + j + (v * 16), acc[v]);
+      }
+    }
+    for (; j + 16 <= n; j += 16) {
+      __m512 acc = load ? _mm512_loadu_ps(c + j) : _mm512_setzero_ps();
+      for (size_t p = 0; p < kc; ++p) {
+        acc = _mm512_fmadd_ps(_mm512_set1_ps(alpha_block[p * inc_alpha]),
+                              _mm512_loadu_ps(b_block + (p * ldb) + j), acc);
+      }
+      _mm512_storeu_ps(c + j, acc);
+    }
+    for (; j < n; ++j) {
+      float sum = load ? c[j] : 0.0F;
+      for (size_t p = 0; p < kc; ++p) {
+        sum += alpha_block[p * inc_alpha] * b_block[(p * ldb) + j];
+      }
+      c[j] = sum;
+    }
+  }
+}
+#endif
+
+auto kernel_config(synapse::GemmBackend backend) -> KernelConfig {
+  switch (backend) {
+#if SYNAPSE_GEMM_X86
+  case synapse::GemmBackend::Avx512:
+    return {12, 32, 144, 192, 3072, kernel_avx512_12x32, dot_avx512,
+            axpy_avx512};
+  case synapse::GemmBackend::Avx2:
+    return {6, 16, 120, 256, 3072, kernel_avx2_6x16, dot_avx2, axpy_avx2};
+#else
+  case synapse::GemmBackend::Avx512:
+  case synapse::GemmBackend::Avx2:
+#endif
+  case synapse::GemmBackend::Scalar:
+  default:
+    return {4, 8, 128, 256, 2048, kernel_scalar<4, 8>,
+            dot_scalar, axpy_scalar};
+  }
+}
+
+// Best backend for the starting CPU level, see `cpu_level`
+auto detect_backend() -> synapse::GemmBackend {
+  const synapse::CpuLevel level = synapse::cpu_level();
+  if (level >= synapse::CpuLevel::Avx512 &&
+      synapse::gemm_backend_supported(synapse::GemmBackend::Avx512)) {
+    return synapse::GemmBackend::Avx512;
+  }
+  if (level >= synapse::CpuLevel::Avx2 &&
+      synapse::gemm_backend_supported(synapse::GemmBackend::Avx2)) {
+    return synapse::GemmBackend::Avx2;
+  }
+  return synapse::GemmBackend::Scalar;
+}
+
+auto backend_slot() -> std::atomic<synapse::GemmBackend> & {
+  static std::atomic<synapse::GemmBackend> slot{detect_backend()};
+  return slot;
+}
+
+// Applies the epilogue to a rows x cols block of C starting at C(row, col)
+template <typename Activation>
+auto epilogue_loop(const synapse::GemmEpilogue &epilogue, size_t rows,
+                   size_t cols, size_t row, size_t col, float *c, size_t ldc,
+                   Activation activation) -> void {
+  for (size_t i = 0; i < rows; ++i) {
+    float *c_row = c + (i * ldc);
+    if (epilogue.bias == nullptr) {
+      for (size_t j = 0; j < cols; ++j) {
+        c_row[j] = activation(c_row[j]);
+      }
+      continue;
+    }
+    const float *bias = epilogue.bias + ((row + i) * epilogue.rs_bias) +
+                        (col * epilogue.cs_bias);
+    if (epilogue.cs_bias == 0) {
+      const float scalar = *bias;
+      for (size_t j = 0; j < cols; ++j) {
+        c_row[j] = activation(c_row[j] + scalar);
+      }
+    } else if (epilogue.cs_bias == 1) {
+      for (size_t j = 0; j < cols; ++j) {
+        c_row[j] = activation(c_row[j] + bias[j]);
+      }
+    } else {
+      for (size_t j = 0; j < cols; ++j) {
+        c_row[j] = activation(c_row[j] + bias[j * epilogue.cs_bias]);
+      }
+    }
+  }
+}
+
+auto apply_epilogue(const synapse::GemmEpilogue &epilogue, size_t rows,
+                    size_t cols, size_t row, size_t col, float *c, size_t ldc)
+    -> void {
+  using synapse::ElementwiseOp;
+  switch (epilogue.activation) {
+  case synapse::Activation::Relu:
+    return epilogue_loop(epilogue, rows, cols, row, col, c, ldc, [](float x) {
+      return synapse::unary_scalar<ElementwiseOp::Relu>(x);
+    });
+  case synapse::Activation::Gelu:
+    return epilogue_loop(epilogue, rows, cols, row, col, c, ldc, [](float x) {
+      return synapse::unary_scalar<ElementwiseOp::Gelu>(x);
+    });
+  case synapse::Activation::None:
+  default:
+    if (epilogue.bias != nullptr) {
+      epilogue_loop(epilogue, rows, cols, row, col, c, ldc,
+                    [](float x) { return x; });
+    }
+    return;
+  }
+}
+
+// Packs an mc x kc block of A into row slivers of height mr. Each sliver is
+// stored column by column so the micro-kernel reads it sequentially. Rows past
+// the end of the block are zero padded.
+auto pack_a(size_t mc, size_t kc, const float *a, size_t rs_a, size_t cs_a,
+            size_t mr, float *dst) -> void {
+  for (size_t ir = 0; ir < mc; ir += mr) {
+    const size_t rows = std::min(mr, mc - ir);
+    for (size_t p = 0; p < kc; ++p) {
+      const float *src = a + (ir * rs_a) + (p * cs_a);
+      for (size_t i = 0; i < rows; ++i) {
+        dst[i] = src[i * rs_a];
+      }
+      std::fill(dst + rows, dst + mr, 0.0F);
+      dst += mr;
+    }
+  }
+}
+
+// Packs a kc x nc panel of B into column slivers of width nr, stored row by
+// row. Columns past the end of the panel are zero padded.
+auto pack_b(size_t kc, size_t nc, const float *b, size_t rs_b, size_t cs_b,
+            size_t nr, float *dst) -> void {
+  for (size_t jr = 0; jr < nc; jr += nr) {
+    const size_t cols = std::min(nr, nc - jr);
+    for (size_t p = 0; p < kc; ++p) {
+      const float *src = b + (p * rs_b) + (jr * cs_b);
+      if (cs_b == 1) {
+        std::memcpy(dst, src, cols * sizeof(float));
+      } else {
+        for (size_t j = 0; j < cols; ++j) {
+          dst[j] = src[j * cs_b];
+        }
+      }
+      std::fill(dst + cols, dst + nr, 0.0F);
+      dst += nr;
+    }
+  }
+}
+
+// Multiplies a packed mc x kc block of A by a packed kc x nc panel of B.
+// `epilogue` is only given for the last depth block, and is applied to each
+// tile as soon as it is final. `row` and `col` locate `c` in the whole C.
+auto macro_kernel(const KernelConfig &cfg, size_t mc, size_t nc, size_t kc,
+                  const float *a_pack, const float *b_pack, float *c,
+                  size_t ldc, bool accumulate,
+                  const synapse::GemmEpilogue *epilogue, size_t row,
+                  size_t col) -> void {
+  alignas(64) float tile[MAX_TILE];
+  for (size_t jr = 0; jr < nc; jr += cfg.nr) {
+    const size_t cols = std::min(cfg.nr, nc - jr);
+    for (size_t ir = 0; ir < mc; ir += cfg.mr) {
+      const size_t rows = std::min(cfg.mr, mc - ir);
+      const float *a_sliver = a_pack + (ir * kc);
+      const float *b_sliver = b_pack + (jr * kc);
+      float *c_tile = c + (ir * ldc) + jr;
+
+      if (rows == cfg.mr && cols == cfg.nr) {
+        cfg.kernel(kc, a_sliver, b_sliver, c_tile, ldc, accumulate);
+      } else {
+        // Edge tile: compute the full register tile into scratch and only
+        // copy back the valid part.
+        cfg.kernel(kc, a_sliver, b_sliver, tile, cfg.nr, false);
+        for (size_t i = 0; i < rows; ++i) {
+          float *c_row = c_tile + (i * ldc);
+          const float *t_row = tile + (i * cfg.nr);
+          for (size_t j = 0; j < cols; ++j) {
+            c_row[j] = accumulate ? c_row[j] + t_row[j] : t_row[j];
+          }
+        }
+      }
+      if (epilogue != nullptr) {
+        apply_epilogue(*epilogue, rows, cols, row + ir, col + jr, c_tile, ldc);
+      }
+    }
+  }
+}
+
+// C(i, j) = x_i . y_j over `rows` rows x_i of k contiguous floats, `ldx`
+// apart, and `cols` vectors y_j whose elements are `inc_y` apart and which
+// start `ld_y` apart. C(i, j) is at out[i * rs_out + j * cs_out]. Strided
+// vectors are gathered first, and the rows are run in blocks kept in cache
+// across every vector. `finish(begin, end)` runs on every finished block of
+// rows.
+template <typename Finish>
+auto gemm_dot(const KernelConfig &cfg, size_t rows, size_t cols, size_t k,
+              const float *x, size_t ldx, const float *y, size_t inc_y,
+              size_t ld_y, float *out, size_t rs_out, size_t cs_out,
+              bool accumulate, bool parallel, const Finish &finish) -> void {
+  thread_local std::vector<float> y_pack;
+  if (inc_y != 1) {
+    y_pack.resize(cols * k);
+    for (size_t j = 0; j < cols; ++j) {
+      for (size_t p = 0; p < k; ++p) {
+        y_pack[(j * k) + p] = y[(j * ld_y) + (p * inc_y)];
+      }
+    }
+    y = y_pack.data();
+    ld_y = k;
+  }
+  const size_t block = std::max<size_t>(DOT_BLOCK / k, 4);
+  const size_t grain =
+      parallel ? std::max<size_t>(PARALLEL_MIN_WORK / (k * cols), 1) : rows;
+  synapse::parallel_for(0, rows, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += block) {
+      const size_t count = std::min(block, end - i);
+      for (size_t j = 0; j < cols; ++j) {
+        cfg.dot(count, k, x + (i * ldx), ldx, y + (j * ld_y),
+                out + (i * rs_out) + (j * cs_out), rs_out, accumulate);
+      }
+    }
+    finish(begin, end);
+  });
+}
+
+// Row i of C (rows x n, `ldc` apart) combines the k rows of B, `ldb` apart
+// with contiguous columns, weighted by alpha(i, p) at
+// alpha[i * rs_alpha + p * cs_alpha]. `finish(begin, end)` runs on every
+// finished block of columns.
+template <typename Finish>
+auto gemm_axpy(const KernelConfig &cfg, size_t rows, size_t n, size_t k,
+               const float *alpha, size_t rs_alpha, size_t cs_alpha,
+               const float *b, size_t ldb, float *c, size_t ldc,
+               bool accumulate, bool parallel, const Finish &finish) -> void {
+  const size_t grain =
+      parallel ? std::max<size_t>(PARALLEL_MIN_WORK / (k * rows), 1) : n;
+  synapse::parallel_for(0, n, grain, [&](size_t begin, size_t end) {
+    for (size_t i = 0; i < rows; ++i) {
+      cfg.axpy(end - begin, k, alpha + (i * rs_alpha), cs_alpha, b + begin,
+               ldb, c + (i * ldc) + begin, accumulate);
+    }
+    finish(begin, end);
+  });
+}
+
+} // namespace
+
+auto synapse::gemm_backend() -> synapse::GemmBackend {
+  return backend_slot().load(std::memory_order_relaxed);
+}
+
+auto synapse::gemm_backend_supported(synapse::GemmBackend backend) -> bool {
+  switch (backend) {
+  case synapse::GemmBackend::Scalar:
+    return true;
+#if SYNAPSE_GEMM_X86
+  case synapse::GemmBackend::Avx2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case synapse::GemmBackend::Avx512:
+    return __builtin_cpu_supports("avx512f");
+#else
+  case synapse::GemmBackend::Avx2:
+  case synapse::GemmBackend::Avx512:
+#endif
+  default:
+    return false;
+  }
+}
+
+auto synapse::set_gemm_backend(synapse::GemmBackend backend) -> void {
+  if (!synapse::gemm_backend_supported(backend)) {
+    throw std::invalid_argument("GEMM backend is not supported by this CPU.");
+  }
+  backend_slot().store(backend, std::memory_order_relaxed);
+}
+
+auto synapse::sgemm(size_t m, size_t n, size_t k, const float *a, size_t rs_a,
+                    size_t cs_a, const float *b, size_t rs_b, size_t cs_b,
+                    float *c, size_t ldc, bool accumulate,
+                    const synapse::GemmEpilogue &epilogue) -> void {
+  if (m == 0 || n == 0) {
+    return;
+  }
+  if (k == 0) {
+    if (!accumulate) {
+      for (size_t i = 0; i < m; ++i) {
+        std::fill(c + (i * ldc), c + (i * ldc) + n, 0.0F);
+      }
+    }
+    apply_epilogue(epilogue, m, n, 0, 0, c, ldc);
+    return;
+  }
+  // Products too small to amortize waking the pool get a grain covering the
+  // whole range, which keeps them on the calling thread
+  const bool parallel = m * n * k >= PARALLEL_MIN_WORK;
+  const KernelConfig cfg = kernel_config(synapse::gemm_backend());
+  // Blocks of rows and of columns of C the skinny paths finish
+  const auto finish_rows = [&](size_t begin, size_t end) {
+    apply_epilogue(epilogue, end - begin, n, begin, 0, c + (begin * ldc),
+                   ldc);
+  };
+  const auto finish_cols = [&](size_t begin, size_t end) {
+    apply_epilogue(epilogue, m, end - begin, 0, begin, c + begin, ldc);
+  };
+  // Skinny products run one matrix-vector product per column or row of C,
+  // in whichever form reads the operands contiguously
+  if (n <= SKINNY_MAX && cs_a == 1) {
+    // Rows of A against the columns of B
+    gemm_dot(cfg, m, n, k, a, rs_a, b, rs_b, cs_b, c, ldc, 1, accumulate,
+             parallel, finish_rows);
+    return;
+  }
+  if (m <= SKINNY_MAX && cs_b == 1) {
+    // Rows of C as combinations of the rows of B
+    gemm_axpy(cfg, m, n, k, a, rs_a, cs_a, b, rs_b, c, ldc, accumulate,
+              parallel, finish_cols);
+    return;
+  }
+  if (m <= SKINNY_MAX && rs_b == 1) {
+    // Columns of B, contiguous when B is read transposed, against the rows
+    // of A
+    gemm_dot(cfg, n, m, k, b, cs_b, a, cs_a, rs_a, c, 1, ldc, accumulate,
+             parallel, finish_cols);
+    return;
+  }
+  if (n == 1 && rs_a == 1 && ldc == 1) {
+    // The column of C as a combination of the columns of A
+    gemm_axpy(cfg, 1, m, k, b, 0, rs_b, a, cs_a, c, 0, accumulate, parallel,
+              finish_rows);
+    return;
+  }
+
+  // Packing buffers are reused across calls to avoid hitting the allocator on
+  // every multiplication. The B panel is shared by every thread working on a
+  // region, while each thread packs its own blocks of A.
+  thread_local std::vector<float> b_pack;
+  b_pack.resize(cfg.kc * (cfg.nc + cfg.nr));
+
+  // Work is split over row blocks of A and, when there are fewer row blocks
+  // than threads, over groups of column slivers of the B panel as well.
+  const size_t threads = parallel ? synapse::get_num_threads() : 1;
+  const size_t row_blocks = (m + cfg.mc - 1) / cfg.mc;
+
+  for (size_t jc = 0; jc < n; jc += cfg.nc) {
+    const size_t nc = std::min(cfg.nc, n - jc);
+    const size_t slivers = (nc + cfg.nr - 1) / cfg.nr;
+    const size_t col_groups =
+        std::min((threads + row_blocks - 1) / row_blocks, slivers);
+    const size_t tasks = row_blocks * col_groups;
+    for (size_t pc = 0; pc < k; pc += cfg.kc) {
+      const size_t kc = std::min(cfg.kc, k - pc);
+      // Only the first depth block may overwrite C, the rest accumulate.
+      // The epilogue runs with the last one.
+      const bool beta = accumulate || pc > 0;
+      const synapse::GemmEpilogue *last =
+          pc + kc == k ? &epilogue : nullptr;
+      const float *b_panel = b + (pc * rs_b) + (jc * cs_b);
+      float *b_dst = b_pack.data();
+      synapse::parallel_for(
+          0, slivers, parallel ? 1 : slivers, [&](size_t begin, size_t end) {
+            const size_t jr = begin * cfg.nr;
+            pack_b(kc, std::min(end * cfg.nr, nc) - jr, b_panel + (jr * cs_b),
+                   rs_b, cs_b, cfg.nr, b_dst + (jr * kc));
+          });
+      synapse::parallel_for(
+          0, tasks, parallel ? 1 : tasks, [&](size_t begin, size_t end) {
+            thread_local std::vector<float> a_pack;
+            a_pack.resize(cfg.mc * cfg.kc);
+            for (size_t task = begin; task < end; ++task) {
+              const size_t ic = (task / col_groups) * cfg.mc;
+              const size_t group = task % col_groups;
+              const size_t mc = std::min(cfg.mc, m - ic);
+              const size_t jr = (group * slivers / col_groups) * cfg.nr;
+              const size_t jr_end =
+                  std::min(((group + 1) * slivers / col_groups) * cfg.nr, nc);
+              pack_a(mc, kc, a + (ic * rs_a) + (pc * cs_a), rs_a, cs_a, cfg.mr,
+                     a_pack.data());
+              macro_kernel(cfg, mc, jr_end - jr, kc, a_pack.data(),
+                           b_dst + (jr * kc), c + (ic * ldc) + jc + jr, ldc,
+                           beta, last, ic, jc + jr);
+            }
+          });
+    }
+  }
+}
@@ -0,0 +1,496 @@
+#include "elementwise.h"
+#include "gemm.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYNAPSE_GEMM_X86 1
+#include <immintrin.h>
+#else
+#define SYNAPSE_GEMM_X86 0
+#endif
+
+namespace {
+
+// Depth elements packed next to each other, one 32-bit lane of the kernels
+constexpr size_t K_GROUP = 4;
+
+// Rows of A packed at once, a multiple of every mr. 96 rows of a few thousand
+// bytes stay in L2.
+constexpr size_t MC = 96;
+
+// Largest tile over all kernels
+constexpr size_t MAX_TILE = 8 * 32;
+
+// Multiply-adds below which a product is not worth splitting across threads
+constexpr size_t PARALLEL_MIN_WORK = size_t{1} << 18;
+
+// Layout the micro-kernel expects the elements of A in
+enum class PackA { Int8, ShiftedUint8, Int16 };
+
+// Computes an MR x NR tile, with rows NR apart, from packed slivers of A and
+// B that are `groups` groups of K_GROUP deep.
+using Int8Kernel = void (*)(size_t groups, const int8_t *a, const int8_t *b,
+                            int32_t *tile);
+
+struct Int8Config {
+  size_t mr;
+  size_t nr;
+  PackA pack_a;
+  Int8Kernel kernel;
+};
+
+template <size_t MR, size_t NR>
+auto kernel_scalar(size_t groups, const int8_t *a, const int8_t *b,
+                   int32_t *tile) -> void {
+  int32_t acc[MR][NR] = {};
+  for (size_t g = 0; g < groups; ++g) {
+    for (size_t i = 0; i < MR; ++i) {
+      for (size_t j = 0; j < NR; ++j) {
+        for (size_t q = 0; q < K_GROUP; ++q) {
+          acc[i][j] += int32_t{a[(i * K_GROUP) + q]} *
+                       int32_t{b[(j * K_GROUP) + q]};
+        }
+      }
+    }
+    a += MR * K_GROUP;
+    b += NR * K_GROUP;
+  }
+  for (size_t i = 0; i < MR; ++i) {
+    std::copy_n(acc[i], NR, tile + (i * NR));
+  }
+}
+
+#if SYNAPSE_GEMM_X86
+// A is packed as 16-bit integers. Each column of a B group is sign-extended
+// to 16 bits, and `vpmaddwd` leaves two partial sums per column that are
+// folded once at the end.
+[[gnu::target("avx2")]] auto kernel_avx2_6x8(size_t groups, const int8_t *a,
+                                             const int8_t *b, int32_t *tile)
+    -> void {
+  __m256i acc[6][2];
+  for (auto &row : acc) {
+    row[0] = _mm256_setzero_si256();
+    row[1] = _mm256_setzero_si256();
+  }
+  for (size_t g = 0; g < groups; ++g) {
+    const __m256i packed =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+    const __m256i b_0 = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(packed));
+    const __m256i b_1 =
+        _mm256_cvtepi8_epi16(_mm256_extracti128_si256(packed, 1));
+    for (size_t i = 0; i < 6; ++i) {
+      long long word = 0;
+      std::memcpy(&word, a + (i * K_GROUP * 2), sizeof(word));
+      const __m256i a_i = _mm256_set1_epi64x(word);
+      acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(a_i, b_0));
+      acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(a_i, b_1));
+    }
+    a += 6 * K_GROUP * 2;
+    b += 8 * K_GROUP;
+  }
+  for (size_t i = 0; i < 6; ++i) {
+    // Pairs are added within 128-bit lanes, leaving columns 0 1 4 5 | 2 3 6 7
+    const __m256i sums = _mm256_hadd_epi32(acc[i][0], acc[i][1]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(tile + (i * 8)),
+                        _mm256_permute4x64_epi64(sums, 0xD8));
+  }
+}
+
+// A is packed as unsigned bytes shifted by +128, see igemm
+[[gnu::target("avx512f,avx512vnni")]] auto
+kernel_vnni_8x32(size_t groups, const int8_t *a, const int8_t *b,
+                 int32_t *tile) -> void {
+  __m512i acc[8][2];
+  for (auto &row : acc) {
+    row[0] = _mm512_setzero_si512();
+    row[1] = _mm512_setzero_si512();
+  }
+  for (size_t g = 0; g < groups; ++g) {
+    const __m512i b_0 = _mm512_loadu_si512(b);
+    const __m512i b_1 = _mm512_loadu_si512(b + 64);
+    for (size_t i = 0; i < 8; ++i) {
+      int word = 0;
+      std::memcpy(&word, a + (i * K_GROUP), sizeof(word));
+      const __m512i a_i = _mm512_set1_epi32(word);
+      acc[i][0] = _mm512_dpbusd_epi32(acc[i][0], a_i, b_0);
+      acc[i][1] = _mm512_dpbusd_epi32(acc[i][1], a_i, b_1);
+    }
+    a += 8 * K_GROUP;
+    b += 32 * K_GROUP;
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    _mm512_storeu_si512(tile + (i * 32), acc[i][0]);
+    _mm512_storeu_si512(tile + (i * 32) + 16, acc[i][1]);
+  }
+}
+
+auto vnni_supported() -> bool {
+  static const bool supported = __builtin_cpu_supports("avx512f") &&
+                                __builtin_cpu_supports("avx512vnni");
+  return supported;
+}
+#endif
+
+// Follows the float backend, so `set_gemm_backend` selects both
+auto int8_config(synapse::GemmBackend backend) -> Int8Config {
+  switch (backend) {
+#if SYNAPSE_GEMM_X86
+  case synapse::GemmBackend::Avx512:
+    if (vnni_supported()) {
+      return {8, 32, PackA::ShiftedUint8, kernel_vnni_8x32};
+    }
+    return {6, 8, PackA::Int16, kernel_avx2_6x8};
+  case synapse::GemmBackend::Avx2:
+    return {6, 8, PackA::Int16, kernel_avx2_6x8};
+#else
+  case synapse::GemmBackend::Avx512:
+  case synapse::GemmBackend::Avx2:
+#endif
+  case synapse::GemmBackend::Scalar:
+  default:
+    return {4, 8, PackA::Int8, kernel_scalar<4, 8>};
+  }
+}
+
+// Packs rows [0, mc) of A into row slivers of height mr. Each sliver stores
+// the K_GROUP elements of a row in a group next to each other, group after
+// group. Rows and depth past the end are zero padded. `row_sums` receives
+// the sum of every row.
+auto pack_a(size_t mc, size_t k, const int8_t *a, size_t rs_a, size_t cs_a,
+            const Int8Config &cfg, int8_t *dst, int32_t *row_sums) -> void {
+  const size_t depth = (k + K_GROUP - 1) / K_GROUP * K_GROUP;
+  for (size_t ir = 0; ir < mc; ir += cfg.mr) {
+    const size_t rows = std::min(cfg.mr, mc - ir);
+    for (size_t g = 0; g < depth; g += K_GROUP) {
+      for (size_t i = 0; i < cfg.mr; ++i) {
+        for (size_t p = g; p < g + K_GROUP; ++p) {
+          const int8_t value =
+              i < rows && p < k ? a[((ir + i) * rs_a) + (p * cs_a)] : 0;
+          switch (cfg.pack_a) {
+          case PackA::ShiftedUint8:
+            *dst++ = static_cast<int8_t>(static_cast<uint8_t>(value) ^ 0x80U);
+            break;
+          case PackA::Int16: {
+            const int16_t wide = value;
+            std::memcpy(dst, &wide, sizeof(wide));
+            dst += sizeof(wide);
+            break;
+          }
+          case PackA::Int8:
+          default:
+            *dst++ = value;
+            break;
+          }
+        }
+      }
+    }
+  }
+  for (size_t i = 0; i < mc; ++i) {
+    int32_t sum = 0;
+    for (size_t p = 0; p < k; ++p) {
+      sum += a[(i * rs_a) + (p * cs_a)];
+    }
+    row_sums[i] = sum;
+  }
+}
+
+// Packs columns [0, cols) of B into a sliver of width nr, laid out like the
+// slivers of A. `col_sums` receives the sum of every column.
+auto pack_b(size_t cols, size_t k, const int8_t *b, size_t rs_b, size_t cs_b,
+            size_t nr, int8_t *dst, int32_t *col_sums) -> void {
+  const size_t depth = (k + K_GROUP - 1) / K_GROUP * K_GROUP;
+  std::fill(col_sums, col_sums + nr, 0);
+  for (size_t g = 0; g < depth; g += K_GROUP) {
+    for (size_t j = 0; j < nr; ++j) {
+      for (size_t p = g; p < g + K_GROUP; ++p) {
+        const int8_t value = j < cols && p < k ? b[(p * rs_b) + (j * cs_b)] : 0;
+        col_sums[j] += value;
+        *dst++ = value;
+      }
+    }
+  }
+}
+
+auto check_depth(size_t k) -> void {
+  if (k > synapse::IGEMM_MAX_DEPTH) {
+    throw std::invalid_argument(
+        std::format("igemm depth {} exceeds the maximum of {}.", k,
+                    synapse::IGEMM_MAX_DEPTH));
+  }
+}
+
+// Packs every column of B into consecutive slivers
+auto pack_b_slivers(size_t k, size_t n, const int8_t *b, size_t rs_b,
+                    size_t cs_b, size_t nr, bool parallel, int8_t *dst,
+                    int32_t *col_sums) -> void {
+  const size_t depth = (k + K_GROUP - 1) / K_GROUP * K_GROUP;
+  const size_t slivers = (n + nr - 1) / nr;
+  synapse::parallel_for(
+      0, slivers, parallel ? 1 : slivers, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+          const size_t jr = s * nr;
+          pack_b(std::min(nr, n - jr), k, b + (jr * cs_b), rs_b, cs_b, nr,
+                 dst + (jr * depth), col_sums + jr);
+        }
+      });
+}
+
+/**
+ * Multiplies A by B packed for `cfg`. The rows of A are split in blocks of
+ * MC, and the column slivers of B in groups when there are fewer blocks than
+ * threads. Each finished tile is handed to `store(row, col, rows, cols, tile,
+ * ld, row_sums, col_sums)`.
+ */
+template <typename Store>
+auto igemm_packed(const Int8Config &cfg, size_t m, size_t n, size_t k,
+                  const int8_t *a, size_t rs_a, size_t cs_a,
+                  const int8_t *b_pack, const int32_t *col_sums,
+                  const Store &store) -> void {
+  const size_t groups = (k + K_GROUP - 1) / K_GROUP;
+  const size_t depth = groups * K_GROUP;
+  const size_t a_width = cfg.pack_a == PackA::Int16 ? 2 : 1;
+  const size_t slivers = (n + cfg.nr - 1) / cfg.nr;
+  const bool parallel = m * n * k >= PARALLEL_MIN_WORK;
+  const size_t threads = parallel ? synapse::get_num_threads() : 1;
+  const size_t row_blocks = (m + MC - 1) / MC;
+  const size_t col_groups =
+      std::min((threads + row_blocks - 1) / row_blocks, slivers);
+  const size_t tasks = row_blocks * col_groups;
+  synapse::parallel_for(
+      0, tasks, parallel ? 1 : tasks, [&](size_t begin, size_t end) {
+        thread_local std::vector<int8_t> a_pack;
+        thread_local std::vector<int32_t> row_sums;
+        a_pack.resize(MC * depth * a_width);
+        row_sums.resize(MC);
+        alignas(64) int32_t tile[MAX_TILE];
+        for (size_t task = begin; task < end; ++task) {
+          const size_t ic = (task / col_groups) * MC;
+          const size_t group = task % col_groups;
+          const size_t mc = std::min(MC, m - ic);
+          pack_a(mc, k, a + (ic * rs_a), rs_a, cs_a, cfg, a_pack.data(),
+                 row_sums.data());
+          const size_t jr_end =
+              std::min(((group + 1) * slivers / col_groups) * cfg.nr, n);
+          for (size_t jr = (group * slivers / col_groups) * cfg.nr;
+               jr < jr_end; jr += cfg.nr) {
+            const size_t cols = std::min(cfg.nr, n - jr);
+            for (size_t ir = 0; ir < mc; ir += cfg.mr) {
+              const size_t rows = std::min(cfg.mr, mc - ir);
+              cfg.kernel(groups, a_pack.data() + (ir * depth * a_width),
+                         b_pack + (jr * depth), tile);
+              if (cfg.pack_a == PackA::ShiftedUint8) {
+                for (size_t i = 0; i < rows; ++i) {
+                  for (size_t j = 0; j < cols; ++j) {
+                    tile[(i * cfg.nr) + j] -= 128 * col_sums[jr + j];
+                  }
+                }
+              }
+              store(ic + ir, jr, rows, cols, tile, cfg.nr,
+                    row_sums.data() + ir, col_sums + jr);
+            }
+          }
+        }
+      });
+}
+
+// Packs B into buffers reused across calls, then multiplies
+template <typename Store>
+auto igemm_driver(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+                  size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b,
+                  const Store &store) -> void {
+  check_depth(k);
+  if (m == 0 || n == 0) {
+    return;
+  }
+  const Int8Config cfg = int8_config(synapse::gemm_backend());
+  const size_t depth = (k + K_GROUP - 1) / K_GROUP * K_GROUP;
+  const size_t padded = (n + cfg.nr - 1) / cfg.nr * cfg.nr;
+  // Only pointers reach the packing threads, which have their own
+  // thread_local instances
+  thread_local std::vector<int8_t> b_pack;
+  thread_local std::vector<int32_t> col_sums;
+  b_pack.resize(padded * depth);
+  col_sums.resize(padded);
+  pack_b_slivers(k, n, b, rs_b, cs_b, cfg.nr,
+                 m * n * k >= PARALLEL_MIN_WORK, b_pack.data(),
+                 col_sums.data());
+  igemm_packed(cfg, m, n, k, a, rs_a, cs_a, b_pack.data(), col_sums.data(),
+               store);
+}
+
+// Copies the raw int32 products
+auto store_int32(int32_t *c, size_t ldc) {
+  return [c, ldc](size_t row, size_t col, size_t rows, size_t cols,
+                  const int32_t *tile, size_t ld, const int32_t * /*row_sums*/,
+                  const int32_t * /*col_sums*/) {
+    for (size_t i = 0; i < rows; ++i) {
+      std::copy_n(tile + (i * ld), cols, c + ((row + i) * ldc) + col);
+    }
+  };
+}
+
+auto activate(float x, synapse::Activation activation) -> float {
+  switch (activation) {
+  case synapse::Activation::Relu:
+    return synapse::unary_scalar<synapse::ElementwiseOp::Relu>(x);
+  case synapse::Activation::Gelu:
+    return synapse::unary_scalar<synapse::ElementwiseOp::Gelu>(x);
+  case synapse::Activation::None:
+  default:
+    return x;
+  }
+}
+
+// Removes the zero points from a tile and writes it dequantized, or
+// requantized when `Out` is int8_t
+template <typename Out>
+auto requantize_tile(const synapse::Requantization &rq, size_t k, size_t row,
+                     size_t col, size_t rows, size_t cols,
+                     const int32_t *tile, size_t ld, const int32_t *row_sums,
+                     const int32_t *col_sums, Out *c, size_t ldc) -> void {
+  const float inv_out_scale = 1.0F / rq.out_scale;
+  const int32_t depth = static_cast<int32_t>(k);
+  for (size_t i = 0; i < rows; ++i) {
+    Out *c_row = c + ((row + i) * ldc) + col;
+    for (size_t j = 0; j < cols; ++j) {
+      const size_t column = col + j;
+      const int32_t b_zero =
+          rq.b_zero_points == nullptr
+              ? 0
+              : rq.b_zero_points[column * rq.cs_b_zero_points];
+      // sum((a - za) * (b - zb)) expanded over the raw products
+      const int32_t acc = tile[(i * ld) + j] -
+                          (rq.a_zero_point * col_sums[j]) -
+                          (b_zero * row_sums[i]) +
+                          (depth * rq.a_zero_point * b_zero);
+      float x = rq.scales[column * rq.cs_scales] * static_cast<float>(acc);
+      if (rq.bias != nullptr) {
+        x += rq.bias[column * rq.cs_bias];
+      }
+      x = activate(x, rq.activation);
+      if constexpr (std::is_same_v<Out, int8_t>) {
+        const float q = std::nearbyint(x * inv_out_scale) +
+                        static_cast<float>(rq.out_zero_point);
+        c_row[j] = static_cast<int8_t>(std::clamp(q, -128.0F, 127.0F));
+      } else {
+        c_row[j] = x;
+      }
+    }
+  }
+}
+
+auto check_requantization(const synapse::Requantization &rq, bool int8_out)
+    -> void {
+  if (rq.scales == nullptr) {
+    throw std::invalid_argument("Requantization needs the output scales.");
+  }
+  if (int8_out && !(rq.out_scale > 0.0F)) {
+    throw std::invalid_argument("Requantization needs a positive out_scale.");
+  }
+}
+
+template <typename Out>
+auto store_requantized(const synapse::Requantization &rq, size_t k, Out *c,
+                       size_t ldc) {
+  check_requantization(rq, std::is_same_v<Out, int8_t>);
+  return [&rq, k, c, ldc](size_t row, size_t col, size_t rows, size_t cols,
+                          const int32_t *tile, size_t ld,
+                          const int32_t *row_sums, const int32_t *col_sums) {
+    requantize_tile(rq, k, row, col, rows, cols, tile, ld, row_sums, col_sums,
+                    c, ldc);
+  };
+}
+
+template <typename Store>
+auto igemm_prepacked(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+                     const synapse::PackedInt8Matrix &b, const Store &store)
+    -> void {
+  if (m == 0 || b.cols() == 0) {
+    return;
+  }
+  igemm_packed(int8_config(b.backend()), m, b.cols(), b.rows(), a, rs_a, cs_a,
+               b.data(), b.col_sums(), store);
+}
+} // namespace
+
+synapse::PackedInt8Matrix::PackedInt8Matrix(size_t k, size_t n,
+                                            const int8_t *b, size_t rs_b,
+                                            size_t cs_b)
+    : _k(k), _n(n), _backend(synapse::gemm_backend()), _data(),
+      _col_sums() {
+  check_depth(k);
+  const Int8Config cfg = int8_config(this->_backend);
+  const size_t depth = (k + K_GROUP - 1) / K_GROUP * K_GROUP;
+  const size_t padded = (n + cfg.nr - 1) / cfg.nr * cfg.nr;
+  this->_data.resize(padded * depth);
+  this->_col_sums.resize(padded);
+  pack_b_slivers(k, n, b, rs_b, cs_b, cfg.nr, n * k >= PARALLEL_MIN_WORK,
+                 this->_data.data(), this->_col_sums.data());
+}
+
+auto synapse::PackedInt8Matrix::rows() const -> size_t { return this->_k; }
+
+auto synapse::PackedInt8Matrix::cols() const -> size_t { return this->_n; }
+
+auto synapse::PackedInt8Matrix::backend() const -> synapse::GemmBackend {
+  return this->_backend;
+}
+
+auto synapse::PackedInt8Matrix::data() const -> const int8_t * {
+  return this->_data.data();
+}
+
+auto synapse::PackedInt8Matrix::col_sums() const -> const int32_t * {
+  return this->_col_sums.data();
+}
+
+auto synapse::igemm(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+                    size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b,
+                    int32_t *c, size_t ldc) -> void {
+  igemm_driver(m, n, k, a, rs_a, cs_a, b, rs_b, cs_b, store_int32(c, ldc));
+}
+
+auto synapse::igemm(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+                    size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b,
+                    float *c, size_t ldc,
+                    const synapse::Requantization &requantization) -> void {
+  igemm_driver(m, n, k, a, rs_a, cs_a, b, rs_b, cs_b,
+               store_requantized(requantization, k, c, ldc));
+}
+
+auto synapse::igemm(size_t m, size_t n, size_t k, const int8_t *a, size_t rs_a,
+                    size_t cs_a, const int8_t *b, size_t rs_b, size_t cs_b,
+                    int8_t *c, size_t ldc,
+                    const synapse::Requantization &requantization) -> void {
+  igemm_driver(m, n, k, a, rs_a, cs_a, b, rs_b, cs_b,
+               store_requantized(requantization, k, c, ldc));
+}
+
+auto synapse::igemm(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+                    const synapse::PackedInt8Matrix &b, int32_t *c,
+                    size_t ldc) -> void {
+  igemm_prepacked(m, a, rs_a, cs_a, b, store_int32(c, ldc));
+}
+
+auto synapse::igemm(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+                    const synapse::PackedInt8Matrix &b, float *c, size_t ldc,
+                    const synapse::Requantization &requantization) -> void {
+  igemm_prepacked(m, a, rs_a, cs_a, b,
+                  store_requantized(requantization, b.rows(), c, ldc));
+}
+
+auto synapse::igemm(size_t m, const int8_t *a, size_t rs_a, size_t cs_a,
+                    const synapse::PackedInt8Matrix &b, int8_t *c, size_t ldc,
+                    const synapse::Requantization &requantization) -> void {
+  igemm_prepacked(m, a, rs_a, cs_a, b,
+                  store_requantized(requantization, b.rows(), c, ldc));
+}
@@ -0,0 +1,680 @@
+#include "reduce.h"
+#include "cpu.h"
+#include "dtype.h"
+#include "parallel.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYNAPSE_REDUCE_X86 1
+#include <immintrin.h>
+#else
+#define SYNAPSE_REDUCE_X86 0
+#endif
+
+namespace {
+
+using synapse::ReduceOp;
+
+// Independent accumulators of the dense kernels, enough to fill the SIMD
+// registers and hide the latency of the additions.
+constexpr size_t LANES = 16;
+
+// Length under which pairwise summation stops splitting.
+constexpr size_t PAIRWISE_BLOCK = 512;
+
+// Elements gathered at once from layouts without a dense reduction.
+constexpr size_t GATHER_BLOCK = 4096;
+
+// Outputs accumulated together when reducing row by row.
+constexpr size_t COLUMN_BLOCK = 256;
+
+// A dimension of the iteration, with its input and output strides.
+struct Dim {
+  size_t size;
+  size_t in_stride;
+  size_t out_stride;
+};
+
+// Kept dimensions in output order and reduced dimensions by decreasing input
+// stride, both without size 1 dimensions and merged where possible.
+struct Layout {
+  std::vector<Dim> kept;
+  std::vector<Dim> reduced;
+  size_t outputs;
+  size_t count;
+};
+
+auto coalesce(std::vector<Dim> &dims) -> void {
+  std::vector<Dim> merged;
+  for (const Dim &dim : dims) {
+    if (!merged.empty()) {
+      Dim &outer = merged.back();
+      if (outer.in_stride == dim.size * dim.in_stride &&
+          outer.out_stride == dim.size * dim.out_stride) {
+        outer = {outer.size * dim.size, dim.in_stride, dim.out_stride};
+        continue;
+      }
+    }
+    merged.push_back(dim);
+  }
+  dims = std::move(merged);
+}
+
+auto make_layout(const synapse::NDArray &input, const std::vector<bool> &mask,
+                 const synapse::Strides &out_strides) -> Layout {
+  Layout layout{{}, {}, 1, 1};
+  for (size_t d = 0; d < input.ndim(); ++d) {
+    const size_t size = input.shape()[d];
+    (mask[d] ? layout.count : layout.outputs) *= size;
+    if (size == 1) {
+      continue;
+    }
+    if (mask[d]) {
+      layout.reduced.push_back({size, input.strides()[d], 0});
+    } else {
+      layout.kept.push_back({size, input.strides()[d], out_strides[d]});
+    }
+  }
+  // The reduction order is free, so the smallest stride goes innermost
+  std::ranges::stable_sort(layout.reduced, std::greater{}, &Dim::in_stride);
+  coalesce(layout.kept);
+  coalesce(layout.reduced);
+  return layout;
+}
+
+// Walks the positions of `dims` in row-major order, tracking the input and
+// output offsets.
+class Walker {
+public:
+  Walker(const std::vector<Dim> &dims, size_t start)
+      : _dims(dims), _index(dims.size(), 0), _in(0), _out(0) {
+    for (size_t d = dims.size(); d-- > 0;) {
+      this->_index[d] = start % dims[d].size;
+      start /= dims[d].size;
+      this->_in += this->_index[d] * dims[d].in_stride;
+      this->_out += this->_index[d] * dims[d].out_stride;
+    }
+  }
+
+  [[nodiscard]] auto in() const -> size_t { return this->_in; }
+  [[nodiscard]] auto out() const -> size_t { return this->_out; }
+
+  auto next() -> void {
+    for (size_t d = this->_dims.size(); d-- > 0;) {
+      const Dim &dim = this->_dims[d];
+      this->_in += dim.in_stride;
+      this->_out += dim.out_stride;
+      if (++this->_index[d] < dim.size) {
+        return;
+      }
+      this->_in -= dim.size * dim.in_stride;
+      this->_out -= dim.size * dim.out_stride;
+      this->_index[d] = 0;
+    }
+  }
+
+private:
+  const std::vector<Dim> &_dims;
+  std::vector<size_t> _index;
+  size_t _in;
+  size_t _out;
+};
+
+// Sums f(x[i]) with LANES accumulators, and pairwise above PAIRWISE_BLOCK
+// so the rounding error grows with log(n) instead of n.
+template <typename T, typename F>
+auto pairwise_sum(const T *x, size_t n, const F &f) -> T {
+  if (n > PAIRWISE_BLOCK) {
+    const size_t half = (n / 2 + LANES - 1) / LANES * LANES;
+    return pairwise_sum(x, half, f) + pairwise_sum(x + half, n - half, f);
+  }
+  std::array<T, LANES> acc{};
+  size_t i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    for (size_t k = 0; k < LANES; ++k) {
+      acc[k] += f(x[i + k]);
+    }
+  }
+  for (size_t k = 0; i < n; ++i, ++k) {
+    acc[k] += f(x[i]);
+  }
+  for (size_t width = LANES / 2; width > 0; width /= 2) {
+    for (size_t k = 0; k < width; ++k) {
+      acc[k] += acc[k + width];
+    }
+  }
+  return acc[0];
+}
+
+// Whether `value` replaces `best`: it compares better, or it is the first NaN.
+template <bool Max, typename T> auto replaces(T value, T best) -> bool {
+  const bool first_nan = value != value && best == best;
+  if constexpr (Max) {
+    return value > best || first_nan;
+  } else {
+    return value < best || first_nan;
+  }
+}
+
+// Compilers do not vectorize max and min without -ffinite-math-only, as
+// maxps/minps disagree with the NaN semantics of the scalar comparison.
+#if SYNAPSE_REDUCE_X86
+// Available from the AVX2 level on, AVX itself not being a level
+auto has_avx() -> bool {
+  return synapse::cpu_level() >= synapse::CpuLevel::Avx2;
+}
+
+template <typename T> struct AvxOps;
+
+template <> struct AvxOps<float> {
+  using Vec = __m256;
+  static constexpr size_t WIDTH = 8;
+
+  [[gnu::target("avx")]] static auto load(const float *x) -> Vec {
+    return _mm256_loadu_ps(x);
+  }
+  [[gnu::target("avx")]] static auto store(float *x, Vec value) -> void {
+    _mm256_storeu_ps(x, value);
+  }
+  [[gnu::target("avx")]] static auto set1(float value) -> Vec {
+    return _mm256_set1_ps(value);
+  }
+  // NaN-propagating max or min. maxps returns `best` when either is NaN,
+  // OR-ing a NaN `value` back into the result keeps it a NaN
+  template <bool Max>
+  [[gnu::target("avx")]] static auto merge(Vec best, Vec value) -> Vec {
+    const Vec better =
+        Max ? _mm256_max_ps(value, best) : _mm256_min_ps(value, best);
+    return _mm256_or_ps(
+        better,
+        _mm256_and_ps(_mm256_cmp_ps(value, value, _CMP_UNORD_Q), value));
+  }
+};
+
+template <> struct AvxOps<double> {
+  using Vec = __m256d;
+  static constexpr size_t WIDTH = 4;
+
+  [[gnu::target("avx")]] static auto load(const double *x) -> Vec {
+    return _mm256_loadu_pd(x);
+  }
+  [[gnu::target("avx")]] static auto store(double *x, Vec value) -> void {
+    _mm256_storeu_pd(x, value);
+  }
+  [[gnu::target("avx")]] static auto set1(double value) -> Vec {
+    return _mm256_set1_pd(value);
+  }
+  template <bool Max>
+  [[gnu::target("avx")]] static auto merge(Vec best, Vec value) -> Vec {
+    const Vec better =
+        Max ? _mm256_max_pd(value, best) : _mm256_min_pd(value, best);
+    return _mm256_or_pd(
+        better,
+        _mm256_and_pd(_mm256_cmp_pd(value, value, _CMP_UNORD_Q), value));
+  }
+};
+
+template <bool Max, typename T>
+[[gnu::target("avx")]] auto extremum_avx(const T *x, size_t n) -> T {
+  using Ops = AvxOps<T>;
+  constexpr size_t width = Ops::WIDTH;
+  typename Ops::Vec best[4];
+  for (auto &lane : best) {
+    lane = Ops::set1(x[0]);
+  }
+  size_t i = 0;
+  for (; i + (4 * width) <= n; i += 4 * width) {
+    for (size_t u = 0; u < 4; ++u) {
+      best[u] =
+          Ops::template merge<Max>(best[u], Ops::load(x + i + (u * width)));
+    }
+  }
+  for (size_t u = 1; u < 4; ++u) {
+    best[0] = Ops::template merge<Max>(best[0], best[u]);
+  }
+  std::array<T, width> lanes{};
+  Ops::store(lanes.data(), best[0]);
+  T out = lanes[0];
+  for (size_t k = 1; k < width; ++k) {
+    out = replaces<Max>(lanes[k], out) ? lanes[k] : out;
+  }
+  for (; i < n; ++i) {
+    out = replaces<Max>(x[i], out) ? x[i] : out;
+  }
+  return out;
+}
+
+template <bool Max, typename T>
+[[gnu::target("avx")]] auto merge_row_avx(T *best, const T *x, size_t k)
+    -> void {
+  using Ops = AvxOps<T>;
+  size_t j = 0;
+  for (; j + Ops::WIDTH <= k; j += Ops::WIDTH) {
+    Ops::store(best + j,
+               Ops::template merge<Max>(Ops::load(best + j), Ops::load(x + j)));
+  }
+  for (; j < k; ++j) {
+    best[j] = replaces<Max>(x[j], best[j]) ? x[j] : best[j];
+  }
+}
+#endif
+
+// Maximum (or minimum) of x[0..n), n > 0.
+template <bool Max, typename T> auto extremum(const T *x, size_t n) -> T {
+#if SYNAPSE_REDUCE_X86
+  if (has_avx()) {
+    return extremum_avx<Max>(x, n);
+  }
+#endif
+  T out = x[0];
+  for (size_t i = 1; i < n; ++i) {
+    out = replaces<Max>(x[i], out) ? x[i] : out;
+  }
+  return out;
+}
+
+// best[j] = extremum(best[j], x[j]) for j < k.
+template <bool Max, typename T>
+auto merge_row(T *best, const T *x, size_t k) -> void {
+#if SYNAPSE_REDUCE_X86
+  if (has_avx()) {
+    merge_row_avx<Max>(best, x, k);
+    return;
+  }
+#endif
+  for (size_t j = 0; j < k; ++j) {
+    best[j] = replaces<Max>(x[j], best[j]) ? x[j] : best[j];
+  }
+}
+
+// Sums the elements, or the squares of their deviations from a center.
+template <typename T, bool Square> struct SumReducer {
+  using Partial = T;
+  using Out = T;
+
+  static auto identity() -> Partial { return T{0}; }
+
+  static auto span(const T *x, size_t n, size_t /*first*/, T center)
+      -> Partial {
+    if constexpr (Square) {
+      return pairwise_sum(x, n, [center](T value) {
+        const T deviation = value - center;
+        return deviation * deviation;
+      });
+    } else {
+      return pairwise_sum(x, n, [](T value) { return value; });
+    }
+  }
+
+  static auto combine(Partial a, Partial b) -> Partial { return a + b; }
+
+  // Reduces the `count` rows of `k` contiguous elements starting at `x`
+  static auto rows(const T *x, const std::vector<Dim> &reduced, size_t count,
+                   size_t k, const T *centers, Partial *out) -> void {
+    std::array<T, COLUMN_BLOCK> sum{};
+    std::array<T, COLUMN_BLOCK> compensation{};
+    Walker row(reduced, 0);
+    for (size_t r = 0; r < count; ++r, row.next()) {
+      const T *values = x + row.in();
+      for (size_t j = 0; j < k; ++j) {
+        T value = values[j];
+        if constexpr (Square) {
+          value = (value - centers[j]) * (value - centers[j]);
+        }
+        // Kahan summation, the compensation keeps the lost low-order bits
+        const T y = value - compensation[j];
+        const T t = sum[j] + y;
+        compensation[j] = (t - sum[j]) - y;
+        sum[j] = t;
+      }
+    }
+    std::copy_n(sum.begin(), k, out);
+  }
+
+  static auto finish(Partial partial) -> Out { return partial; }
+};
+
+// Maximum (or minimum) of the elements, or its first index.
+template <typename T> struct Extremum {
+  T value;
+  size_t index;
+  bool valid;
+};
+
+template <typename T, bool Max, bool Arg> struct ExtremumReducer {
+  using Partial = Extremum<T>;
+  using Out = std::conditional_t<Arg, int32_t, T>;
+
+  static auto identity() -> Partial { return {T{0}, 0, false}; }
+
+  static auto span(const T *x, size_t n, size_t first, T /*center*/)
+      -> Partial {
+    const T best = extremum<Max>(x, n);
+    size_t index = 0;
+    if constexpr (Arg) {
+      const bool nan = best != best;
+      while (!(x[index] == best || (nan && x[index] != x[index]))) {
+        ++index;
+      }
+    }
+    return {best, first + index, true};
+  }
+
+  static auto combine(Partial a, Partial b) -> Partial {
+    if (!a.valid) {
+      return b;
+    }
+    return b.valid && replaces<Max>(b.value, a.value) ? b : a;
+  }
+
+  static auto rows(const T *x, const std::vector<Dim> &reduced, size_t count,
+                   size_t k, const T * /*centers*/, Partial *out) -> void {
+    std::array<T, COLUMN_BLOCK> best{};
+    std::array<size_t, COLUMN_BLOCK> index{};
+    Walker row(reduced, 0);
+    std::copy_n(x + row.in(), k, best.begin());
+    for (size_t r = 1; r < count; ++r) {
+      row.next();
+      const T *values = x + row.in();
+      if constexpr (Arg) {
+        for (size_t j = 0; j < k; ++j) {
+          if (replaces<Max>(values[j], best[j])) {
+            best[j] = values[j];
+            index[j] = r;
+          }
+        }
+      } else {
+        merge_row<Max>(best.data(), values, k);
+      }
+    }
+    for (size_t j = 0; j < k; ++j) {
+      out[j] = {best[j], index[j], true};
+    }
+  }
+
+  static auto finish(Partial partial) -> Out {
+    if constexpr (Arg) {
+      return static_cast<int32_t>(partial.index);
+    } else {
+      return partial.value;
+    }
+  }
+};
+
+// Reduces every output of `layout` into `out`. `centers`, indexed like `out`,
+// are the centers of squared deviations, null for none.
+template <typename Reducer, typename T>
+auto run(const T *data, const Layout &layout, typename Reducer::Out *out,
+         const std::type_identity_t<T> *centers) -> void {
+  using Partial = typename Reducer::Partial;
+  const size_t count = layout.count;
+  const auto center_at = [centers](size_t pos) {
+    return centers == nullptr ? T{0} : centers[pos];
+  };
+
+  // The reduced elements of every output are contiguous
+  if (layout.reduced.empty() ||
+      (layout.reduced.size() == 1 && layout.reduced[0].in_stride == 1)) {
+    if (layout.outputs == 1) {
+      // A single output is split across the pool instead
+      const T center = center_at(0);
+      const Partial result = synapse::parallel_reduce(
+          size_t{0}, count, synapse::GRAIN_SIZE, Reducer::identity(),
+          [&](size_t begin, size_t end, Partial init) {
+            return Reducer::combine(
+                init, Reducer::span(data + begin, end - begin, begin, center));
+          },
+          [](Partial a, Partial b) { return Reducer::combine(a, b); });
+      out[0] = Reducer::finish(result);
+      return;
+    }
+    synapse::parallel_for(
+        0, layout.outputs, std::max<size_t>(synapse::GRAIN_SIZE / count, 1),
+        [&](size_t begin, size_t end) {
+          Walker kept(layout.kept, begin);
+          for (size_t o = begin; o < end; ++o, kept.next()) {
+            out[kept.out()] = Reducer::finish(Reducer::span(
+                data + kept.in(), count, 0, center_at(kept.out())));
+          }
+        });
+    return;
+  }
+
+  // A kept dimension is contiguous: rows of outputs are reduced together
+  const auto column =
+      std::ranges::find(layout.kept, size_t{1}, &Dim::in_stride);
+  if (column != layout.kept.end()) {
+    std::vector<Dim> outer(layout.kept.begin(), column);
+    outer.insert(outer.end(), std::next(column), layout.kept.end());
+    const size_t size = column->size;
+    const size_t stride = column->out_stride;
+    const size_t blocks = (size + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+    synapse::parallel_for(
+        0, layout.outputs / size * blocks,
+        std::max<size_t>(synapse::GRAIN_SIZE / (count * COLUMN_BLOCK), 1),
+        [&](size_t begin, size_t end) {
+          std::array<Partial, COLUMN_BLOCK> partials{};
+          std::array<T, COLUMN_BLOCK> block_centers{};
+          for (size_t unit = begin; unit < end; ++unit) {
+            const Walker position(outer, unit / blocks);
+            const size_t first = (unit % blocks) * COLUMN_BLOCK;
+            const size_t k = std::min(COLUMN_BLOCK, size - first);
+            const size_t out_pos = position.out() + (first * stride);
+            for (size_t j = 0; j < k; ++j) {
+              block_centers[j] = center_at(out_pos + (j * stride));
+            }
+            Reducer::rows(data + position.in() + first, layout.reduced, count,
+                          k, block_centers.data(), partials.data());
+            for (size_t j = 0; j < k; ++j) {
+              out[out_pos + (j * stride)] = Reducer::finish(partials[j]);
+            }
+          }
+        });
+    return;
+  }
+
+  // Anything else is gathered into dense blocks
+  synapse::parallel_for(
+      0, layout.outputs, std::max<size_t>(synapse::GRAIN_SIZE / count, 1),
+      [&](size_t begin, size_t end) {
+        std::vector<T> buffer(std::min(count, GATHER_BLOCK));
+        Walker kept(layout.kept, begin);
+        for (size_t o = begin; o < end; ++o, kept.next()) {
+          const T *base = data + kept.in();
+          const T center = center_at(kept.out());
+          Walker row(layout.reduced, 0);
+          Partial result = Reducer::identity();
+          for (size_t first = 0; first < count; first += buffer.size()) {
+            const size_t n = std::min(buffer.size(), count - first);
+            for (size_t i = 0; i < n; ++i, row.next()) {
+              buffer[i] = base[row.in()];
+            }
+            result = Reducer::combine(
+                result, Reducer::span(buffer.data(), n, first, center));
+          }
+          out[kept.out()] = Reducer::finish(result);
+        }
+      });
+}
+
+template <typename T, typename Fn>
+auto transform(synapse::NDArray &array, const Fn &fn) -> void {
+  T *data = array.data_ptr<T>();
+  for (size_t i = 0; i < array.size(); ++i) {
+    data[i] = fn(data[i]);
+  }
+}
+
+// Reduces an input of the compute type into an output of keepdim shape
+template <typename T>
+auto reduce_typed(const synapse::NDArray &input, ReduceOp op,
+                  const std::vector<bool> &mask, size_t correction)
+    -> synapse::NDArray {
+  synapse::Shape shape = input.shape();
+  for (size_t d = 0; d < shape.size(); ++d) {
+    shape[d] = mask[d] ? 1 : shape[d];
+  }
+  const bool arg = op == ReduceOp::ArgMax || op == ReduceOp::ArgMin;
+  const synapse::DType dtype = synapse::dtype_of<T>::value;
+  synapse::NDArray out =
+      synapse::NDArray::empty(shape, arg ? synapse::DType::Int32 : dtype);
+  const Layout layout =
+      make_layout(input, mask, synapse::contiguous_strides(shape));
+  if (layout.outputs == 0) {
+    return out;
+  }
+
+  const T count = static_cast<T>(layout.count);
+  if (layout.count == 0) {
+    switch (op) {
+    case ReduceOp::Sum:
+    case ReduceOp::Norm:
+      return synapse::NDArray::zeros(shape, dtype);
+    case ReduceOp::Mean:
+    case ReduceOp::Var:
+      transform<T>(out, [](T) { return std::numeric_limits<T>::quiet_NaN(); });
+      return out;
+    case ReduceOp::Max:
+    case ReduceOp::Min:
+    case ReduceOp::ArgMax:
+    case ReduceOp::ArgMin:
+    default:
+      throw std::invalid_argument(
+          "Cannot compute an extremum over an empty dimension.");
+    }
+  }
+
+  const T *data = input.data_ptr<T>();
+  switch (op) {
+  case ReduceOp::Sum:
+    run<SumReducer<T, false>>(data, layout, out.data_ptr<T>(), nullptr);
+    break;
+  case ReduceOp::Mean:
+    run<SumReducer<T, false>>(data, layout, out.data_ptr<T>(), nullptr);
+    transform<T>(out, [count](T sum) { return sum / count; });
+    break;
+  case ReduceOp::Var: {
+    // Two passes: the mean, then the squared deviations from it
+    synapse::NDArray means = synapse::NDArray::empty(shape, dtype);
+    run<SumReducer<T, false>>(data, layout, means.data_ptr<T>(), nullptr);
+    transform<T>(means, [count](T sum) { return sum / count; });
+    run<SumReducer<T, true>>(data, layout, out.data_ptr<T>(),
+                             std::as_const(means).data_ptr<T>());
+    const T dof = count - static_cast<T>(correction);
+    transform<T>(out, [dof](T sum) { return sum / dof; });
+    break;
+  }
+  case ReduceOp::Norm:
+    run<SumReducer<T, true>>(data, layout, out.data_ptr<T>(), nullptr);
+    transform<T>(out, [](T sum) { return std::sqrt(sum); });
+    break;
+  case ReduceOp::Max:
+    run<ExtremumReducer<T, true, false>>(data, layout, out.data_ptr<T>(),
+                                         nullptr);
+    break;
+  case ReduceOp::Min:
+    run<ExtremumReducer<T, false, false>>(data, layout, out.data_ptr<T>(),
+                                          nullptr);
+    break;
+  case ReduceOp::ArgMax:
+    run<ExtremumReducer<T, true, true>>(data, layout,
+                                        out.data_ptr<int32_t>(), nullptr);
+    break;
+  case ReduceOp::ArgMin:
+    run<ExtremumReducer<T, false, true>>(data, layout,
+                                         out.data_ptr<int32_t>(), nullptr);
+    break;
+  default:
+    break;
+  }
+  return out;
+}
+
+auto reduce_mask(size_t ndim, const std::vector<size_t> &dims)
+    -> std::vector<bool> {
+  std::vector<bool> mask(ndim, dims.empty());
+  for (const size_t dim : dims) {
+    if (dim >= ndim) {
+      throw std::out_of_range(std::format(
+          "Dimension {} is out of range for a {}D array.", dim, ndim));
+    }
+    if (mask[dim]) {
+      throw std::invalid_argument(
+          std::format("Dimension {} is reduced more than once.", dim));
+    }
+    mask[dim] = true;
+  }
+  return mask;
+}
+
+auto result_dtype(ReduceOp op, synapse::DType dtype) -> synapse::DType {
+  switch (op) {
+  case ReduceOp::ArgMax:
+  case ReduceOp::ArgMin:
+    return synapse::DType::Int32;
+  case ReduceOp::Max:
+  case ReduceOp::Min:
+    return dtype;
+  case ReduceOp::Sum:
+    return synapse::is_floating_point(dtype) ? dtype : synapse::DType::Int32;
+  case ReduceOp::Mean:
+  case ReduceOp::Var:
+  case ReduceOp::Norm:
+  default:
+    return synapse::is_floating_point(dtype) ? dtype : synapse::DType::Float32;
+  }
+}
+} // namespace
+
+auto synapse::reduced_shape(const synapse::Shape &shape,
+                            const std::vector<size_t> &dims, bool keepdim)
+    -> synapse::Shape {
+  const std::vector<bool> mask = reduce_mask(shape.size(), dims);
+  synapse::Shape out;
+  for (size_t d = 0; d < shape.size(); ++d) {
+    if (!mask[d]) {
+      out.push_back(shape[d]);
+    } else if (keepdim) {
+      out.push_back(1);
+    }
+  }
+  return out;
+}
+
+auto synapse::reduce(const synapse::NDArray &input, synapse::ReduceOp op,
+                     const std::vector<size_t> &dims, bool keepdim,
+                     size_t correction) -> synapse::NDArray {
+  const std::vector<bool> mask = reduce_mask(input.ndim(), dims);
+  if ((op == ReduceOp::ArgMax || op == ReduceOp::ArgMin) && dims.size() != 1) {
+    throw std::invalid_argument(std::format(
+        "Arg reductions take exactly one dimension, got {}.", dims.size()));
+  }
+
+  // Half precision types accumulate in float, integers in double which holds
+  // every int32 exactly
+  const synapse::DType dtype = input.dtype();
+  const synapse::DType compute =
+      dtype == synapse::DType::Float64 || !synapse::is_floating_point(dtype)
+          ? synapse::DType::Float64
+          : synapse::DType::Float32;
+  const synapse::NDArray source = input.to(compute);
+  synapse::NDArray out =
+      compute == synapse::DType::Float32
+          ? reduce_typed<float>(source, op, mask, correction)
+          : reduce_typed<double>(source, op, mask, correction);
+  out = out.to(result_dtype(op, dtype));
+  if (keepdim) {
+    return out;
+  }
+  return out.reshape(synapse::reduced_shape(input.shape(), dims, false));
+}
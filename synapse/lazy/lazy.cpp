@@ -0,0 +1,246 @@
+#include "lazy.h"
+#include "elementwise.h"
+#include "iterator.h"
+#include "ndarray.h"
+#include "storage.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+thread_local bool lazy_mode_enabled = false;
+
+// Elements processed per block, small enough for every register of a long
+// chain to stay in L1
+constexpr size_t BLOCK = 256;
+
+// One step of the flattened expression. Registers [0, leaves) hold the
+// leaves and register leaves + i holds the result of instruction i.
+struct Instruction {
+  synapse::ElementwiseOp op;
+  size_t lhs;
+  size_t rhs;
+};
+
+struct Program {
+  std::vector<const synapse::NDArray *> leaves;
+  std::vector<Instruction> code;
+};
+
+template <synapse::ElementwiseOp Op>
+auto run_binary(const float *lhs, const float *rhs, float *out, size_t n)
+    -> void {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = synapse::binary_scalar<Op>(lhs[i], rhs[i]);
+  }
+}
+
+template <synapse::ElementwiseOp Op>
+auto run_unary(const float *src, float *out, size_t n) -> void {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = synapse::unary_scalar<Op>(src[i]);
+  }
+}
+
+// Dispatches once per block, so every op runs as its own tight loop
+auto run(synapse::ElementwiseOp op, const float *lhs, const float *rhs,
+         float *out, size_t n) -> void {
+  using synapse::ElementwiseOp;
+  switch (op) {
+  case ElementwiseOp::Add:
+    return run_binary<ElementwiseOp::Add>(lhs, rhs, out, n);
+  case ElementwiseOp::Sub:
+    return run_binary<ElementwiseOp::Sub>(lhs, rhs, out, n);
+  case ElementwiseOp::Mul:
+    return run_binary<ElementwiseOp::Mul>(lhs, rhs, out, n);
+  case ElementwiseOp::Div:
+    return run_binary<ElementwiseOp::Div>(lhs, rhs, out, n);
+  case ElementwiseOp::Maximum:
+    return run_binary<ElementwiseOp::Maximum>(lhs, rhs, out, n);
+  case ElementwiseOp::Minimum:
+    return run_binary<ElementwiseOp::Minimum>(lhs, rhs, out, n);
+  case ElementwiseOp::Neg:
+    return run_unary<ElementwiseOp::Neg>(lhs, out, n);
+  case ElementwiseOp::Abs:
+    return run_unary<ElementwiseOp::Abs>(lhs, out, n);
+  case ElementwiseOp::Exp:
+    return run_unary<ElementwiseOp::Exp>(lhs, out, n);
+  case ElementwiseOp::Log:
+    return run_unary<ElementwiseOp::Log>(lhs, out, n);
+  case ElementwiseOp::Sqrt:
+    return run_unary<ElementwiseOp::Sqrt>(lhs, out, n);
+  case ElementwiseOp::Relu:
+    return run_unary<ElementwiseOp::Relu>(lhs, out, n);
+  case ElementwiseOp::Sigmoid:
+    return run_unary<ElementwiseOp::Sigmoid>(lhs, out, n);
+  case ElementwiseOp::Tanh:
+    return run_unary<ElementwiseOp::Tanh>(lhs, out, n);
+  case ElementwiseOp::Gelu:
+    return run_unary<ElementwiseOp::Gelu>(lhs, out, n);
+  default:
+    throw std::logic_error("Unknown element-wise op.");
+  }
+}
+
+auto same_view(const synapse::NDArray &lhs, const synapse::NDArray &rhs)
+    -> bool {
+  return lhs.storage() == rhs.storage() && lhs.offset() == rhs.offset() &&
+         lhs.shape() == rhs.shape() && lhs.strides() == rhs.strides();
+}
+
+// Appends `expr` to the program in post-order and returns its register.
+// Nodes reached through several paths are only emitted once.
+auto compile(const synapse::LazyExpr &expr, Program &program,
+             std::unordered_map<const synapse::LazyExpr *, size_t> &registers)
+    -> size_t {
+  const auto known = registers.find(&expr);
+  if (known != registers.end()) {
+    return known->second;
+  }
+  size_t reg = 0;
+  if (expr.leaf) {
+    // Leaves are numbered first, instructions are renumbered afterwards
+    const auto &leaves = program.leaves;
+    const auto it = std::find_if(
+        leaves.begin(), leaves.end(), [&expr](const synapse::NDArray *leaf) {
+          return same_view(*leaf, *expr.leaf);
+        });
+    reg = static_cast<size_t>(it - leaves.begin());
+    if (it == leaves.end()) {
+      program.leaves.push_back(expr.leaf.get());
+    }
+  } else {
+    const size_t lhs = compile(*expr.operands[0], program, registers);
+    const size_t rhs = expr.operands.size() > 1
+                           ? compile(*expr.operands[1], program, registers)
+                           : lhs;
+    program.code.push_back(Instruction{expr.op, lhs, rhs});
+    // Instruction registers are tagged until the number of leaves is known
+    reg = ~(program.code.size() - 1);
+  }
+  registers.emplace(&expr, reg);
+  return reg;
+}
+
+// Operand of a new expression reading `input`
+auto operand(const synapse::NDArray &input)
+    -> std::shared_ptr<const synapse::LazyExpr> {
+  const auto &storage = input.storage();
+  // A deferred result read as a whole is inlined instead of being evaluated
+  if (storage->pending() && input.offset() == 0 &&
+      input.strides() == synapse::contiguous_strides(input.shape())) {
+    std::shared_ptr<const synapse::LazyExpr> pending = storage->expr();
+    if (pending && pending->shape == input.shape()) {
+      return pending;
+    }
+  }
+  return std::make_shared<const synapse::LazyExpr>(synapse::LazyExpr{
+      synapse::ElementwiseOp::Add, input.shape(),
+      std::make_unique<synapse::NDArray>(storage, input.offset(),
+                                         input.shape(), input.strides()),
+      {}});
+}
+} // namespace
+
+auto synapse::LazyMode::is_enabled() -> bool { return lazy_mode_enabled; }
+
+auto synapse::LazyMode::set_enabled(bool enabled) -> void {
+  lazy_mode_enabled = enabled;
+}
+
+synapse::LazyGuard::LazyGuard(bool enabled)
+    : _previous(synapse::LazyMode::is_enabled()) {
+  synapse::LazyMode::set_enabled(enabled);
+}
+
+synapse::LazyGuard::~LazyGuard() {
+  synapse::LazyMode::set_enabled(this->_previous);
+}
+
+auto synapse::lazy_elementwise(synapse::ElementwiseOp op,
+                               const std::vector<const synapse::NDArray *>
+                                   &inputs) -> synapse::NDArray {
+  if (inputs.size() != (synapse::is_binary(op) ? 2 : 1)) {
+    throw std::invalid_argument("Wrong number of operands for the op.");
+  }
+  synapse::Shape shape = inputs[0]->shape();
+  if (inputs.size() > 1) {
+    shape = synapse::shape_broadcast(shape, inputs[1]->shape());
+  }
+  std::vector<std::shared_ptr<const synapse::LazyExpr>> operands;
+  operands.reserve(inputs.size());
+  for (const synapse::NDArray *input : inputs) {
+    operands.push_back(operand(*input));
+  }
+  auto expr = std::make_shared<const synapse::LazyExpr>(
+      synapse::LazyExpr{op, shape, nullptr, std::move(operands)});
+  const size_t numel = synapse::shape_numel(shape);
+  return {std::make_shared<synapse::Storage>(numel, std::move(expr)), 0,
+          shape, synapse::contiguous_strides(shape)};
+}
+
+auto synapse::evaluate(const synapse::LazyExpr &expr, float *out) -> void {
+  Program program;
+  std::unordered_map<const synapse::LazyExpr *, size_t> registers;
+  compile(expr, program, registers);
+  const size_t nleaves = program.leaves.size();
+  const size_t nregs = nleaves + program.code.size();
+  const auto resolve = [nleaves](size_t reg) {
+    return reg < nleaves ? reg : nleaves + ~reg;
+  };
+  for (Instruction &instruction : program.code) {
+    instruction.lhs = resolve(instruction.lhs);
+    instruction.rhs = resolve(instruction.rhs);
+  }
+
+  // Reading the leaves evaluates any deferred array they are a view of
+  const synapse::TensorIterator iter(out, expr.shape,
+                                     synapse::contiguous_strides(expr.shape),
+                                     program.leaves);
+  iter.parallel_for_each([&program, nleaves, nregs](
+                             float *dst, const float *const *in,
+                             const size_t *strides, size_t n) {
+    thread_local std::vector<float> scratch;
+    thread_local std::vector<const float *> regs;
+    scratch.resize(nregs * BLOCK);
+    regs.resize(nregs);
+    for (size_t start = 0; start < n; start += BLOCK) {
+      const size_t len = std::min(BLOCK, n - start);
+      // Dense leaves are read in place, the others gathered into scratch
+      for (size_t l = 0; l < nleaves; ++l) {
+        const size_t stride = strides[l + 1];
+        const float *src = in[l] + (start * stride);
+        if (stride == 1) {
+          regs[l] = src;
+          continue;
+        }
+        float *buffer = scratch.data() + (l * BLOCK);
+        for (size_t i = 0; i < len; ++i) {
+          buffer[i] = src[i * stride];
+        }
+        regs[l] = buffer;
+      }
+      // The last instruction writes straight into a dense output
+      for (size_t i = 0; i < program.code.size(); ++i) {
+        const Instruction &instruction = program.code[i];
+        const bool last = i + 1 == program.code.size();
+        float *target = last && strides[0] == 1
+                            ? dst + start
+                            : scratch.data() + ((nleaves + i) * BLOCK);
+        run(instruction.op, regs[instruction.lhs], regs[instruction.rhs],
+            target, len);
+        regs[nleaves + i] = target;
+      }
+      if (strides[0] != 1) {
+        const float *result = regs[nregs - 1];
+        for (size_t i = 0; i < len; ++i) {
+          dst[(start + i) * strides[0]] = result[i];
+        }
+      }
+    }
+  });
+}
@@ -0,0 +1,218 @@
+#include "allocator.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace {
+thread_local std::shared_ptr<synapse::Allocator> thread_allocator = nullptr;
+
+auto system_allocate(size_t bytes) -> void * {
+  return ::operator new(bytes,
+                        std::align_val_t{synapse::Allocator::alignment});
+}
+
+auto system_deallocate(void *ptr) -> void {
+  ::operator delete(ptr, std::align_val_t{synapse::Allocator::alignment});
+}
+
+auto round_up(size_t bytes, size_t multiple) -> size_t {
+  return (bytes + multiple - 1) / multiple * multiple;
+}
+
+// Accounts for a block of `bytes` bytes being handed out
+auto track_allocation(synapse::AllocatorStats &stats, size_t bytes, bool hit)
+    -> void {
+  ++stats.allocations;
+  if (hit) {
+    ++stats.hits;
+  } else {
+    ++stats.misses;
+  }
+  stats.live_bytes += bytes;
+  stats.peak_bytes = std::max(stats.peak_bytes, stats.live_bytes);
+}
+} // namespace
+
+synapse::Allocator::~Allocator() = default;
+
+synapse::CachingAllocator::CachingAllocator(size_t max_cached_bytes)
+    : _mutex(), _max_cached_bytes(max_cached_bytes), _free_blocks(),
+      _stats() {}
+
+synapse::CachingAllocator::~CachingAllocator() { this->empty_cache(); }
+
+auto synapse::CachingAllocator::size_class(size_t bytes) -> size_t {
+  if (bytes <= synapse::Allocator::alignment) {
+    return synapse::Allocator::alignment;
+  }
+  // Four classes between consecutive powers of two
+  const size_t step = std::max(synapse::Allocator::alignment,
+                               std::bit_floor(bytes - 1) / 4);
+  return round_up(bytes, step);
+}
+
+auto synapse::CachingAllocator::allocate(size_t bytes) -> void * {
+  if (bytes == 0) {
+    return nullptr;
+  }
+  const size_t block = synapse::CachingAllocator::size_class(bytes);
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    auto &free_list = this->_free_blocks[block];
+    if (!free_list.empty()) {
+      void *ptr = free_list.back();
+      free_list.pop_back();
+      this->_stats.cached_bytes -= block;
+      track_allocation(this->_stats, block, true);
+      return ptr;
+    }
+  }
+  // Only the bookkeeping needs the lock, the system call does not
+  void *ptr = system_allocate(block);
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  track_allocation(this->_stats, block, false);
+  return ptr;
+}
+
+auto synapse::CachingAllocator::deallocate(void *ptr, size_t bytes) -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  const size_t block = synapse::CachingAllocator::size_class(bytes);
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_stats.live_bytes -= block;
+    if (this->_stats.cached_bytes + block <= this->_max_cached_bytes) {
+      this->_free_blocks[block].push_back(ptr);
+      this->_stats.cached_bytes += block;
+      return;
+    }
+  }
+  system_deallocate(ptr);
+}
+
+auto synapse::CachingAllocator::stats() const -> synapse::AllocatorStats {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_stats;
+}
+
+auto synapse::CachingAllocator::reset_peak() -> void {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.peak_bytes = this->_stats.live_bytes;
+}
+
+auto synapse::CachingAllocator::empty_cache() -> void {
+  std::unordered_map<size_t, std::vector<void *>> blocks;
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    blocks.swap(this->_free_blocks);
+    this->_stats.cached_bytes = 0;
+  }
+  for (const auto &[size, free_list] : blocks) {
+    for (void *ptr : free_list) {
+      system_deallocate(ptr);
+    }
+  }
+}
+
+synapse::Arena::Arena(size_t chunk_bytes)
+    : _mutex(), _chunk_bytes(round_up(std::max<size_t>(chunk_bytes, 1),
+                                      synapse::Allocator::alignment)),
+      _chunks(), _offset(0), _capacity(0), _stats() {}
+
+synapse::Arena::~Arena() {
+  for (const Chunk &chunk : this->_chunks) {
+    system_deallocate(chunk.data);
+  }
+}
+
+auto synapse::Arena::allocate(size_t bytes) -> void * {
+  if (bytes == 0) {
+    return nullptr;
+  }
+  const size_t block = round_up(bytes, synapse::Allocator::alignment);
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  const bool hit = !this->_chunks.empty() &&
+                   this->_offset + block <= this->_chunks.back().bytes;
+  if (!hit) {
+    // The remainder of the current chunk is abandoned until the next rewind
+    const size_t size = std::max(this->_chunk_bytes, block);
+    this->_chunks.push_back(Chunk{system_allocate(size), size});
+    this->_capacity += size;
+    this->_offset = 0;
+  }
+  void *ptr = static_cast<std::byte *>(this->_chunks.back().data) +
+              this->_offset;
+  this->_offset += block;
+  track_allocation(this->_stats, block, hit);
+  this->_stats.cached_bytes = this->_capacity - this->_stats.live_bytes;
+  return ptr;
+}
+
+auto synapse::Arena::deallocate(void *ptr, size_t bytes) -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.live_bytes -= round_up(bytes, synapse::Allocator::alignment);
+  if (this->_stats.live_bytes == 0) {
+    this->_rewind();
+  }
+  this->_stats.cached_bytes = this->_capacity - this->_stats.live_bytes;
+}
+
+auto synapse::Arena::stats() const -> synapse::AllocatorStats {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_stats;
+}
+
+auto synapse::Arena::reset_peak() -> void {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.peak_bytes = this->_stats.live_bytes;
+}
+
+auto synapse::Arena::capacity() const -> size_t {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_capacity;
+}
+
+auto synapse::Arena::_rewind() -> void {
+  this->_offset = 0;
+  if (this->_chunks.size() <= 1) {
+    return;
+  }
+  // A single chunk holding everything the last round needed
+  for (const Chunk &chunk : this->_chunks) {
+    system_deallocate(chunk.data);
+  }
+  this->_chunks.clear();
+  this->_chunks.push_back(
+      Chunk{system_allocate(this->_capacity), this->_capacity});
+}
+
+auto synapse::default_allocator()
+    -> const std::shared_ptr<synapse::CachingAllocator> & {
+  static const std::shared_ptr<synapse::CachingAllocator> allocator =
+      std::make_shared<synapse::CachingAllocator>();
+  return allocator;
+}
+
+auto synapse::current_allocator() -> std::shared_ptr<synapse::Allocator> {
+  if (thread_allocator) {
+    return thread_allocator;
+  }
+  return synapse::default_allocator();
+}
+
+synapse::AllocatorGuard::AllocatorGuard(
+    std::shared_ptr<synapse::Allocator> allocator)
+    : _previous(std::exchange(thread_allocator, std::move(allocator))) {}
+
+synapse::AllocatorGuard::~AllocatorGuard() {
+  thread_allocator = std::move(this->_previous);
+}
@@ -0,0 +1,296 @@
+#include "placement.h"
+#include "allocator.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// Thread affinity is Linux only, other systems run unpinned
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#if SYNAPSE_HAS_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+namespace {
+struct Topology {
+  bool enabled;
+  // Allowed CPUs of every node
+  std::vector<std::vector<size_t>> node_cpus;
+  // Node of every CPU, indexed by CPU
+  std::vector<size_t> cpu_nodes;
+};
+
+auto load_topology() -> Topology {
+  Topology out{false, {}, {}};
+  std::vector<size_t> cpus = synapse::current_thread_cpus();
+  if (cpus.empty()) {
+    cpus.push_back(0);
+  }
+#if SYNAPSE_HAS_NUMA
+  if (::numa_available() >= 0) {
+    out.enabled = true;
+    out.node_cpus.resize(static_cast<size_t>(::numa_max_node()) + 1);
+    for (const size_t cpu : cpus) {
+      const int node = ::numa_node_of_cpu(static_cast<int>(cpu));
+      out.node_cpus[node < 0 ? 0 : static_cast<size_t>(node)].push_back(cpu);
+    }
+  }
+#endif
+  if (!out.enabled) {
+    out.node_cpus.push_back(cpus);
+  }
+  out.cpu_nodes.resize(std::ranges::max(cpus) + 1, 0);
+  for (size_t node = 0; node < out.node_cpus.size(); ++node) {
+    for (const size_t cpu : out.node_cpus[node]) {
+      out.cpu_nodes[cpu] = node;
+    }
+  }
+  return out;
+}
+
+// Read once, before any worker is pinned
+auto topology() -> const Topology & {
+  static const Topology topology = load_topology();
+  return topology;
+}
+
+auto page_size() -> size_t {
+  static const auto size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+// Applies `policy` to the untouched pages of a mapping. Placement is only a
+// hint, so a kernel refusing it leaves the pages to the default policy.
+auto place(void *ptr, size_t bytes, synapse::NumaPolicy policy, size_t node)
+    -> void {
+#if SYNAPSE_HAS_NUMA
+  if (!topology().enabled || policy == synapse::NumaPolicy::FirstTouch) {
+    return;
+  }
+  constexpr size_t BITS = sizeof(unsigned long) * 8;
+  const size_t nodes = synapse::numa_num_nodes();
+  std::vector<unsigned long> mask((nodes + BITS - 1) / BITS, 0);
+  if (policy == synapse::NumaPolicy::Interleave) {
+    for (size_t n = 0; n < nodes; ++n) {
+      mask[n / BITS] |= 1UL << (n % BITS);
+    }
+  } else {
+    mask[node / BITS] |= 1UL << (node % BITS);
+  }
+  const int mode =
+      policy == synapse::NumaPolicy::Interleave ? MPOL_INTERLEAVE : MPOL_BIND;
+  // The kernel reads one bit less than `maxnode`
+  static_cast<void>(
+      ::mbind(ptr, bytes, mode, mask.data(), (mask.size() * BITS) + 1, 0));
+#else
+  static_cast<void>(ptr);
+  static_cast<void>(bytes);
+  static_cast<void>(policy);
+  static_cast<void>(node);
+#endif
+}
+} // namespace
+
+auto synapse::numa_enabled() -> bool { return topology().enabled; }
+
+auto synapse::numa_num_nodes() -> size_t {
+  return topology().node_cpus.size();
+}
+
+auto synapse::numa_node_cpus(size_t node) -> std::vector<size_t> {
+  const Topology &topo = topology();
+  if (node >= topo.node_cpus.size()) {
+    throw std::invalid_argument(
+        std::format("Node {} does not exist, the host has {} nodes.", node,
+                    topo.node_cpus.size()));
+  }
+  return topo.node_cpus[node];
+}
+
+auto synapse::numa_cpu_nodes() -> std::vector<size_t> {
+  const Topology &topo = topology();
+  std::vector<size_t> out;
+  for (size_t node = 0; node < topo.node_cpus.size(); ++node) {
+    if (!topo.node_cpus[node].empty()) {
+      out.push_back(node);
+    }
+  }
+  return out;
+}
+
+auto synapse::numa_current_node() -> size_t {
+#ifdef __linux__
+  const Topology &topo = topology();
+  const int cpu = ::sched_getcpu();
+  if (cpu < 0 || static_cast<size_t>(cpu) >= topo.cpu_nodes.size()) {
+    return 0;
+  }
+  return topo.cpu_nodes[static_cast<size_t>(cpu)];
+#else
+  return 0;
+#endif
+}
+
+auto synapse::pin_current_thread(std::span<const size_t> cpus) -> bool {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  bool any = false;
+  for (const size_t cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+      any = true;
+    }
+  }
+  // A pid of 0 is the calling thread
+  return any && ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  static_cast<void>(cpus);
+  return false;
+#endif
+}
+
+auto synapse::current_thread_cpus() -> std::vector<size_t> {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  std::vector<size_t> out;
+  if (::sched_getaffinity(0, sizeof(set), &set) != 0) {
+    return out;
+  }
+  for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &set)) {
+      out.push_back(cpu);
+    }
+  }
+  return out;
+#else
+  std::vector<size_t> out(
+      std::max<size_t>(std::thread::hardware_concurrency(), 1));
+  for (size_t cpu = 0; cpu < out.size(); ++cpu) {
+    out[cpu] = cpu;
+  }
+  return out;
+#endif
+}
+
+synapse::NumaAllocator::NumaAllocator(synapse::NumaPolicy policy, size_t node)
+    : _policy(policy), _node(node), _mutex(), _stats() {
+  if (policy == synapse::NumaPolicy::Bind &&
+      node >= synapse::numa_num_nodes()) {
+    throw std::invalid_argument(
+        std::format("Cannot bind to node {}, the host has {} nodes.", node,
+                    synapse::numa_num_nodes()));
+  }
+}
+
+synapse::NumaAllocator::~NumaAllocator() = default;
+
+auto synapse::NumaAllocator::block_size(size_t bytes) -> size_t {
+  return (bytes + page_size() - 1) / page_size() * page_size();
+}
+
+auto synapse::NumaAllocator::allocate(size_t bytes) -> void * {
+  if (bytes == 0) {
+    return nullptr;
+  }
+  const size_t block = synapse::NumaAllocator::block_size(bytes);
+  void *ptr = ::mmap(nullptr, block, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  place(ptr, block, this->_policy, this->_node);
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  ++this->_stats.allocations;
+  ++this->_stats.misses;
+  this->_stats.live_bytes += block;
+  this->_stats.peak_bytes =
+      std::max(this->_stats.peak_bytes, this->_stats.live_bytes);
+  return ptr;
+}
+
+auto synapse::NumaAllocator::deallocate(void *ptr, size_t bytes) -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  const size_t block = synapse::NumaAllocator::block_size(bytes);
+  ::munmap(ptr, block);
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.live_bytes -= block;
+}
+
+auto synapse::NumaAllocator::stats() const -> synapse::AllocatorStats {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_stats;
+}
+
+auto synapse::NumaAllocator::reset_peak() -> void {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.peak_bytes = this->_stats.live_bytes;
+}
+
+auto synapse::NumaAllocator::policy() const -> synapse::NumaPolicy {
+  return this->_policy;
+}
+
+auto synapse::NumaAllocator::node() const -> size_t { return this->_node; }
+
+synapse::ReplicatedTensor::ReplicatedTensor(const synapse::Tensor &tensor)
+    : _replicas(), _index() {
+  const size_t nodes = synapse::numa_num_nodes();
+  if (nodes == 1) {
+    this->_replicas.emplace_back(
+        static_cast<const synapse::NDArray &>(tensor));
+    this->_index.push_back(0);
+    return;
+  }
+  const std::vector<size_t> cpu_nodes = synapse::numa_cpu_nodes();
+  this->_replicas.reserve(cpu_nodes.size());
+  this->_index.assign(nodes, cpu_nodes.size());
+  for (const size_t node : cpu_nodes) {
+    this->_index[node] = this->_replicas.size();
+    const synapse::AllocatorGuard guard(
+        std::make_shared<synapse::NumaAllocator>(synapse::NumaPolicy::Bind,
+                                                 node));
+    synapse::Tensor replica =
+        synapse::Tensor::empty(tensor.shape(), tensor.dtype());
+    replica.copy_(tensor);
+    this->_replicas.push_back(std::move(replica));
+  }
+}
+
+auto synapse::ReplicatedTensor::local() const -> const synapse::Tensor & {
+  const size_t node = synapse::numa_current_node();
+  const size_t index =
+      node < this->_index.size() ? this->_index[node] : this->_replicas.size();
+  return this->_replicas[index < this->_replicas.size() ? index : 0];
+}
+
+auto synapse::ReplicatedTensor::replica(size_t node) const
+    -> const synapse::Tensor & {
+  if (node >= this->_index.size() ||
+      this->_index[node] == this->_replicas.size()) {
+    throw std::out_of_range(
+        std::format("No replica on node {}, it has no CPU to read it.", node));
+  }
+  return this->_replicas[this->_index[node]];
+}
+
+auto synapse::ReplicatedTensor::num_replicas() const -> size_t {
+  return this->_replicas.size();
+}
@@ -0,0 +1,386 @@
+#include "planner.h"
+#include "allocator.h"
+#include "autograd.h"
+#include "dtype.h"
+#include "ndarray.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr size_t none = std::numeric_limits<size_t>::max();
+
+// Storages the next allocation on this thread may overwrite, see InplaceHint
+thread_local std::vector<const void *> inplace_candidates;
+
+auto round_up(size_t bytes) -> size_t {
+  constexpr size_t alignment = synapse::Allocator::alignment;
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+struct Recorded {
+  size_t bytes;
+  size_t first_step;
+  // `none` while the buffer is alive
+  size_t last_step;
+  // Buffers the allocation may overwrite
+  std::vector<size_t> sources;
+};
+
+// Allocator of the recording pass, serving every request from the default
+// allocator and keeping track of when each buffer lives
+class Recorder : public synapse::Allocator {
+public:
+  Recorder() : _mutex(), _buffers(), _live(), _step(0), _stats() {}
+
+  auto allocate(size_t bytes) -> void * override {
+    std::vector<const void *> candidates;
+    candidates.swap(inplace_candidates);
+    if (bytes == 0) {
+      return nullptr;
+    }
+    void *ptr = synapse::default_allocator()->allocate(bytes);
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    std::vector<size_t> sources;
+    for (const void *candidate : candidates) {
+      const auto it = this->_live.find(candidate);
+      if (it != this->_live.end() &&
+          this->_buffers[it->second].bytes == bytes) {
+        sources.push_back(it->second);
+      }
+    }
+    this->_live.emplace(ptr, this->_buffers.size());
+    this->_buffers.push_back(
+        Recorded{bytes, this->_step++, none, std::move(sources)});
+    ++this->_stats.allocations;
+    ++this->_stats.misses;
+    this->_stats.live_bytes += round_up(bytes);
+    this->_stats.peak_bytes =
+        std::max(this->_stats.peak_bytes, this->_stats.live_bytes);
+    return ptr;
+  }
+
+  auto deallocate(void *ptr, size_t bytes) -> void override {
+    if (ptr == nullptr) {
+      return;
+    }
+    {
+      const std::lock_guard<std::mutex> lock(this->_mutex);
+      const auto it = this->_live.find(ptr);
+      this->_buffers[it->second].last_step = this->_step++;
+      this->_live.erase(it);
+      this->_stats.live_bytes -= round_up(bytes);
+    }
+    synapse::default_allocator()->deallocate(ptr, bytes);
+  }
+
+  [[nodiscard]] auto stats() const -> synapse::AllocatorStats override {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_stats;
+  }
+
+  auto reset_peak() -> void override {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_stats.peak_bytes = this->_stats.live_bytes;
+  }
+
+  // Copies allocate like they do during the replay
+  [[nodiscard]] auto stable_blocks() const -> bool override { return false; }
+
+  // Buffers recorded so far, the ones still alive ending on the last step
+  [[nodiscard]] auto buffers() const -> std::vector<Recorded> {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    std::vector<Recorded> buffers = this->_buffers;
+    for (Recorded &buffer : buffers) {
+      buffer.last_step = std::min(buffer.last_step, this->_step);
+    }
+    return buffers;
+  }
+
+private:
+  mutable std::mutex _mutex;
+  std::vector<Recorded> _buffers;
+  std::unordered_map<const void *, size_t> _live;
+  size_t _step;
+  synapse::AllocatorStats _stats;
+};
+
+// Buffers sharing one block of the workspace: a buffer and the chain of
+// outputs computed in place over it
+struct Slot {
+  size_t bytes;
+  size_t first_step;
+  size_t last_step;
+  size_t offset;
+};
+
+// Lowest offset at which `slot` fits between the slots already placed that
+// are alive at the same time, picking the tightest gap
+auto place(const Slot &slot, const std::vector<const Slot *> &placed)
+    -> size_t {
+  std::vector<const Slot *> alive;
+  for (const Slot *other : placed) {
+    if (other->first_step <= slot.last_step &&
+        slot.first_step <= other->last_step) {
+      alive.push_back(other);
+    }
+  }
+  std::ranges::sort(alive, {}, &Slot::offset);
+  size_t best = none;
+  size_t best_gap = none;
+  size_t end = 0;
+  for (const Slot *other : alive) {
+    if (other->offset >= end + slot.bytes && other->offset - end < best_gap) {
+      best = end;
+      best_gap = other->offset - end;
+    }
+    end = std::max(end, other->offset + other->bytes);
+  }
+  return best == none ? end : best;
+}
+
+auto plan(const std::vector<Recorded> &recorded)
+    -> std::vector<synapse::PlannedBuffer> {
+  std::vector<synapse::PlannedBuffer> buffers;
+  buffers.reserve(recorded.size());
+  std::vector<Slot> slots;
+  std::vector<size_t> slot_of(recorded.size());
+  for (size_t i = 0; i < recorded.size(); ++i) {
+    const Recorded &buffer = recorded[i];
+    // The operand must be gone before any other op allocates, so nothing
+    // reads it after the op overwrote it
+    const size_t next_step =
+        i + 1 < recorded.size() ? recorded[i + 1].first_step : none;
+    const auto source = std::ranges::find_if(
+        buffer.sources, [&recorded, next_step](size_t index) {
+          return recorded[index].last_step < next_step;
+        });
+    const bool inplace = source != buffer.sources.end();
+    if (inplace) {
+      slot_of[i] = slot_of[*source];
+      Slot &slot = slots[slot_of[i]];
+      slot.last_step = std::max(slot.last_step, buffer.last_step);
+    } else {
+      slot_of[i] = slots.size();
+      slots.push_back(
+          Slot{round_up(buffer.bytes), buffer.first_step, buffer.last_step, 0});
+    }
+    buffers.push_back(synapse::PlannedBuffer{
+        buffer.bytes, 0, buffer.first_step, buffer.last_step, inplace});
+  }
+
+  // Largest first, as small buffers fill the gaps left between large ones
+  std::vector<size_t> order(slots.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::ranges::stable_sort(order, [&slots](size_t lhs, size_t rhs) {
+    return slots[lhs].bytes > slots[rhs].bytes;
+  });
+  std::vector<const Slot *> placed;
+  placed.reserve(slots.size());
+  for (const size_t index : order) {
+    slots[index].offset = place(slots[index], placed);
+    placed.push_back(&slots[index]);
+  }
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    buffers[i].offset = slots[slot_of[i]].offset;
+  }
+  return buffers;
+}
+
+// Peak of the bytes alive at once during the recording
+auto live_peak(const std::vector<Recorded> &recorded) -> size_t {
+  // Each step allocates or releases a single buffer
+  std::vector<size_t> allocated(2 * recorded.size() + 1, 0);
+  std::vector<size_t> released(2 * recorded.size() + 1, 0);
+  for (const Recorded &buffer : recorded) {
+    allocated[buffer.first_step] = round_up(buffer.bytes);
+    released[buffer.last_step] += round_up(buffer.bytes);
+  }
+  size_t live = 0;
+  size_t peak = 0;
+  for (size_t step = 0; step < allocated.size(); ++step) {
+    live += allocated[step];
+    peak = std::max(peak, live);
+    live -= released[step];
+  }
+  return peak;
+}
+} // namespace
+
+synapse::InplaceHint::InplaceHint(
+    std::initializer_list<const synapse::NDArray *> operands,
+    const synapse::Shape &shape, synapse::DType dtype) {
+  inplace_candidates.clear();
+  const size_t bytes = synapse::shape_numel(shape) * synapse::dtype_size(dtype);
+  for (const synapse::NDArray *operand : operands) {
+    const bool whole = operand->dtype() == dtype &&
+                       operand->shape() == shape && operand->offset() == 0 &&
+                       operand->is_contigous() &&
+                       operand->storage()->nbytes() == bytes;
+    // Another view of the same storage would read elements already written
+    const bool aliased = std::ranges::any_of(
+        operands, [operand](const synapse::NDArray *other) {
+          return other->storage() == operand->storage() &&
+                 (other->offset() != operand->offset() ||
+                  other->shape() != operand->shape() ||
+                  !other->is_contigous());
+        });
+    if (whole && !aliased) {
+      inplace_candidates.push_back(operand->raw_data());
+    }
+  }
+}
+
+synapse::InplaceHint::~InplaceHint() { inplace_candidates.clear(); }
+
+synapse::PlannedAllocator::PlannedAllocator(
+    std::vector<synapse::PlannedBuffer> buffers)
+    : _mutex(), _buffers(std::move(buffers)), _workspace_bytes(0),
+      _workspace(nullptr), _next(0), _diverged(false), _live(), _stats() {
+  for (const synapse::PlannedBuffer &buffer : this->_buffers) {
+    this->_workspace_bytes = std::max(this->_workspace_bytes,
+                                      buffer.offset + round_up(buffer.bytes));
+  }
+  if (this->_workspace_bytes > 0) {
+    this->_workspace =
+        ::operator new(this->_workspace_bytes,
+                       std::align_val_t{synapse::Allocator::alignment});
+  }
+  this->_stats.cached_bytes = this->_workspace_bytes;
+}
+
+synapse::PlannedAllocator::~PlannedAllocator() {
+  if (this->_workspace != nullptr) {
+    ::operator delete(this->_workspace,
+                      std::align_val_t{synapse::Allocator::alignment});
+  }
+}
+
+auto synapse::PlannedAllocator::allocate(size_t bytes) -> void * {
+  if (bytes == 0) {
+    return nullptr;
+  }
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  ++this->_stats.allocations;
+  this->_stats.live_bytes += round_up(bytes);
+  this->_stats.peak_bytes =
+      std::max(this->_stats.peak_bytes, this->_stats.live_bytes);
+  this->_diverged = this->_diverged || this->_next >= this->_buffers.size() ||
+                    this->_buffers[this->_next].bytes != bytes ||
+                    this->_overlaps_live(this->_next);
+  if (this->_diverged) {
+    ++this->_stats.misses;
+    return synapse::default_allocator()->allocate(bytes);
+  }
+  ++this->_stats.hits;
+  this->_live.push_back(this->_next);
+  return static_cast<std::byte *>(this->_workspace) +
+         this->_buffers[this->_next++].offset;
+}
+
+auto synapse::PlannedAllocator::deallocate(void *ptr, size_t bytes) -> void {
+  if (ptr == nullptr) {
+    return;
+  }
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.live_bytes -= round_up(bytes);
+  auto *const start = static_cast<std::byte *>(this->_workspace);
+  auto *const block = static_cast<std::byte *>(ptr);
+  if (this->_workspace == nullptr || block < start ||
+      block >= start + this->_workspace_bytes) {
+    synapse::default_allocator()->deallocate(ptr, bytes);
+    return;
+  }
+  const auto it = std::ranges::find_if(this->_live, [&](size_t index) {
+    return this->_buffers[index].offset ==
+               static_cast<size_t>(block - start) &&
+           this->_buffers[index].bytes == bytes;
+  });
+  // Blocks of an earlier pass were already forgotten by `rewind`
+  if (it != this->_live.end()) {
+    this->_live.erase(it);
+  }
+}
+
+auto synapse::PlannedAllocator::stats() const -> synapse::AllocatorStats {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  return this->_stats;
+}
+
+auto synapse::PlannedAllocator::reset_peak() -> void {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_stats.peak_bytes = this->_stats.live_bytes;
+}
+
+auto synapse::PlannedAllocator::stable_blocks() const -> bool {
+  return false;
+}
+
+auto synapse::PlannedAllocator::rewind() -> void {
+  const std::lock_guard<std::mutex> lock(this->_mutex);
+  this->_next = 0;
+  this->_diverged = false;
+  this->_live.clear();
+}
+
+auto synapse::PlannedAllocator::buffers() const
+    -> const std::vector<synapse::PlannedBuffer> & {
+  return this->_buffers;
+}
+
+auto synapse::PlannedAllocator::workspace_bytes() const -> size_t {
+  return this->_workspace_bytes;
+}
+
+auto synapse::PlannedAllocator::_overlaps_live(size_t index) const -> bool {
+  const synapse::PlannedBuffer &buffer = this->_buffers[index];
+  return std::ranges::any_of(this->_live, [&](size_t other_index) {
+    const synapse::PlannedBuffer &other = this->_buffers[other_index];
+    if (buffer.inplace && other.offset == buffer.offset) {
+      return false;
+    }
+    return other.offset < buffer.offset + round_up(buffer.bytes) &&
+           buffer.offset < other.offset + round_up(other.bytes);
+  });
+}
+
+synapse::MemoryPlan::MemoryPlan(const std::function<void()> &forward)
+    : _allocator(nullptr), _unplanned_bytes(0) {
+  const auto recorder = std::make_shared<Recorder>();
+  {
+    const synapse::NoGradGuard no_grad;
+    const synapse::AllocatorGuard guard(recorder);
+    forward();
+  }
+  const std::vector<Recorded> recorded = recorder->buffers();
+  this->_allocator =
+      std::make_shared<synapse::PlannedAllocator>(plan(recorded));
+  this->_unplanned_bytes = live_peak(recorded);
+}
+
+auto synapse::MemoryPlan::buffers() const
+    -> const std::vector<synapse::PlannedBuffer> & {
+  return this->_allocator->buffers();
+}
+
+auto synapse::MemoryPlan::workspace_bytes() const -> size_t {
+  return this->_allocator->workspace_bytes();
+}
+
+auto synapse::MemoryPlan::unplanned_bytes() const -> size_t {
+  return this->_unplanned_bytes;
+}
+
+auto synapse::MemoryPlan::allocator() const
+    -> const std::shared_ptr<synapse::PlannedAllocator> & {
+  return this->_allocator;
+}
@@ -0,0 +1,577 @@
+#include "autograd.h"
+#include "dtype.h"
+#include "func.h"
+#include "gemm.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+using Saved = std::vector<synapse::Tensor>;
+using Gradients = synapse::Node::Gradients;
+
+// Operands of an op, skipping the missing bias
+auto operands(const synapse::Tensor &input, const synapse::Tensor &weight,
+              const synapse::Tensor *bias)
+    -> std::vector<const synapse::Tensor *> {
+  std::vector<const synapse::Tensor *> out{&input, &weight};
+  if (bias != nullptr) {
+    out.push_back(bias);
+  }
+  return out;
+}
+
+// Whether the fused inference kernels can run on `inputs`
+auto can_fuse(const std::vector<const synapse::Tensor *> &inputs) -> bool {
+  return !synapse::needs_grad(inputs) &&
+         std::ranges::all_of(inputs, [](const synapse::Tensor *input) {
+           return input->dtype() == synapse::DType::Float32;
+         });
+}
+
+auto activate(synapse::Tensor tensor, synapse::Activation activation)
+    -> synapse::Tensor {
+  switch (activation) {
+  case synapse::Activation::Relu:
+    return synapse::relu(tensor);
+  case synapse::Activation::Gelu:
+    return synapse::gelu(tensor);
+  case synapse::Activation::None:
+  default:
+    return tensor;
+  }
+}
+
+// Dense Float32 elements of `tensor`, shared when already dense Float32
+auto dense(const synapse::Tensor &tensor) -> synapse::NDArray {
+  return tensor.NDArray::to(synapse::DType::Float32).contiguous();
+}
+
+struct ConvGeometry {
+  size_t channels;
+  size_t height;
+  size_t width;
+  size_t kernel_h;
+  size_t kernel_w;
+  size_t stride;
+  size_t padding;
+  size_t out_h;
+  size_t out_w;
+};
+
+// Calls `fn(row, c, kh, kw)` for every row of the unfolded matrix of an
+// image, `row` being the offset of the row of kernel tap (c, kh, kw)
+template <typename Fn>
+auto for_each_tap(const ConvGeometry &geo, Fn fn) -> void {
+  const size_t pixels = geo.out_h * geo.out_w;
+  for (size_t c = 0; c < geo.channels; ++c) {
+    for (size_t kh = 0; kh < geo.kernel_h; ++kh) {
+      for (size_t kw = 0; kw < geo.kernel_w; ++kw) {
+        const size_t row = (((c * geo.kernel_h) + kh) * geo.kernel_w) + kw;
+        fn(row * pixels, c, kh, kw);
+      }
+    }
+  }
+}
+
+// Unfolds a (channels, height, width) image into a (channels * kernel_h *
+// kernel_w, out_h * out_w) matrix, one column per output pixel. Taps
+// falling in the padding are zeros.
+auto im2col(const ConvGeometry &geo, const float *image, float *cols) -> void {
+  for_each_tap(geo, [&](size_t row, size_t c, size_t kh, size_t kw) {
+    float *dst = cols + row;
+    const float *plane = image + (c * geo.height * geo.width);
+    for (size_t oh = 0; oh < geo.out_h; ++oh, dst += geo.out_w) {
+      const size_t ih = (oh * geo.stride) + kh;
+      if (ih < geo.padding || ih - geo.padding >= geo.height) {
+        std::fill(dst, dst + geo.out_w, 0.0F);
+        continue;
+      }
+      const float *src = plane + ((ih - geo.padding) * geo.width);
+      for (size_t ow = 0; ow < geo.out_w; ++ow) {
+        const size_t iw = (ow * geo.stride) + kw;
+        dst[ow] = iw < geo.padding || iw - geo.padding >= geo.width
+                      ? 0.0F
+                      : src[iw - geo.padding];
+      }
+    }
+  });
+}
+
+// Inverse of im2col, adds every column entry back into its image pixel
+auto col2im(const ConvGeometry &geo, const float *cols, float *image) -> void {
+  for_each_tap(geo, [&](size_t row, size_t c, size_t kh, size_t kw) {
+    const float *src = cols + row;
+    float *plane = image + (c * geo.height * geo.width);
+    for (size_t oh = 0; oh < geo.out_h; ++oh, src += geo.out_w) {
+      const size_t ih = (oh * geo.stride) + kh;
+      if (ih < geo.padding || ih - geo.padding >= geo.height) {
+        continue;
+      }
+      float *dst = plane + ((ih - geo.padding) * geo.width);
+      for (size_t ow = 0; ow < geo.out_w; ++ow) {
+        const size_t iw = (ow * geo.stride) + kw;
+        if (iw >= geo.padding && iw - geo.padding < geo.width) {
+          dst[iw - geo.padding] += src[ow];
+        }
+      }
+    }
+  });
+}
+
+// A 1x1 kernel without stride nor padding unfolds an image into itself
+auto is_pointwise(const ConvGeometry &geo) -> bool {
+  return geo.kernel_h == 1 && geo.kernel_w == 1 && geo.stride == 1 &&
+         geo.padding == 0;
+}
+
+// Runs `fn(n, cols)` for every image `n` of the batch with its unfolded
+// matrix. A batch large enough to keep every thread busy is spread across
+// the pool, otherwise each product is parallelized by sgemm.
+template <typename Fn>
+auto for_each_image(const ConvGeometry &geo, size_t batch, const float *input,
+                    Fn fn) -> void {
+  const size_t image_size = geo.channels * geo.height * geo.width;
+  const size_t cols_size =
+      geo.channels * geo.kernel_h * geo.kernel_w * geo.out_h * geo.out_w;
+  const auto run = [&](size_t begin, size_t end) {
+    thread_local std::vector<float> cols;
+    for (size_t n = begin; n < end; ++n) {
+      const float *image = input + (n * image_size);
+      if (is_pointwise(geo)) {
+        fn(n, image);
+        continue;
+      }
+      cols.resize(cols_size);
+      im2col(geo, image, cols.data());
+      fn(n, cols.data());
+    }
+  };
+  if (batch >= synapse::get_num_threads()) {
+    synapse::parallel_for(0, batch, 1, run);
+  } else {
+    run(0, batch);
+  }
+}
+
+// Float32 convolution of dense operands, see `conv2d`
+auto conv2d_forward(const ConvGeometry &geo, size_t batch,
+                    const float *input, const float *weight,
+                    const synapse::Tensor *bias, size_t out_channels,
+                    synapse::Activation activation, float *out) -> void {
+  const size_t taps = geo.channels * geo.kernel_h * geo.kernel_w;
+  const size_t pixels = geo.out_h * geo.out_w;
+  const synapse::NDArray bias_values =
+      bias == nullptr ? synapse::NDArray::empty({0}) : dense(*bias);
+  const synapse::GemmEpilogue epilogue{
+      .bias = bias == nullptr ? nullptr : bias_values.data(),
+      .rs_bias = 1,
+      .cs_bias = 0,
+      .activation = activation};
+  for_each_image(geo, batch, input, [&](size_t n, const float *cols) {
+    synapse::sgemm(out_channels, pixels, taps, weight, taps, 1, cols, pixels,
+                   1, out + (n * out_channels * pixels), pixels, false,
+                   epilogue);
+  });
+}
+
+// Elements of a row handled together by the online softmax, small enough
+// for a block to stay in L1 between its two passes
+constexpr size_t SOFTMAX_BLOCK = 512;
+
+// Online softmax of a contiguous row. Each block finds its maximum, the
+// running sum is rescaled when the maximum grows, and the exponentials are
+// written to `dst` relative to the maximum known at that point. A last pass
+// rescales every block to the final maximum and normalizes, so the row is
+// read once and every exponential is computed once.
+auto softmax_row(const float *src, float *dst, size_t length) -> void {
+  thread_local std::vector<float> block_max;
+  block_max.resize((length + SOFTMAX_BLOCK - 1) / SOFTMAX_BLOCK);
+  float max = -std::numeric_limits<float>::infinity();
+  float sum = 0.0F;
+  for (size_t begin = 0, b = 0; begin < length; begin += SOFTMAX_BLOCK, ++b) {
+    const size_t end = std::min(begin + SOFTMAX_BLOCK, length);
+    float local = max;
+    for (size_t i = begin; i < end; ++i) {
+      local = std::max(local, src[i]);
+    }
+    if (local > max) {
+      sum *= std::exp(max - local);
+      max = local;
+    }
+    float partial = 0.0F;
+    for (size_t i = begin; i < end; ++i) {
+      dst[i] = std::exp(src[i] - max);
+      partial += dst[i];
+    }
+    sum += partial;
+    block_max[b] = max;
+  }
+  const float scale = 1.0F / sum;
+  for (size_t begin = 0, b = 0; begin < length; begin += SOFTMAX_BLOCK, ++b) {
+    const size_t end = std::min(begin + SOFTMAX_BLOCK, length);
+    const float factor =
+        block_max[b] == max ? scale : std::exp(block_max[b] - max) * scale;
+    for (size_t i = begin; i < end; ++i) {
+      dst[i] *= factor;
+    }
+  }
+}
+
+// Online softmax along the middle dimension of a (length, inner) block,
+// every inner position keeping its own running maximum and sum
+auto softmax_columns(const float *src, float *dst, size_t length,
+                     size_t inner) -> void {
+  thread_local std::vector<float> max;
+  thread_local std::vector<float> sum;
+  max.assign(inner, -std::numeric_limits<float>::infinity());
+  sum.assign(inner, 0.0F);
+  for (size_t l = 0; l < length; ++l) {
+    const float *row = src + (l * inner);
+    for (size_t i = 0; i < inner; ++i) {
+      if (row[i] > max[i]) {
+        sum[i] = (sum[i] * std::exp(max[i] - row[i])) + 1.0F;
+        max[i] = row[i];
+      } else {
+        sum[i] += std::exp(row[i] - max[i]);
+      }
+    }
+  }
+  for (size_t i = 0; i < inner; ++i) {
+    sum[i] = 1.0F / sum[i];
+  }
+  for (size_t l = 0; l < length; ++l) {
+    const float *row = src + (l * inner);
+    float *out = dst + (l * inner);
+    for (size_t i = 0; i < inner; ++i) {
+      out[i] = std::exp(row[i] - max[i]) * sum[i];
+    }
+  }
+}
+} // namespace
+
+auto synapse::nn::linear(const synapse::Tensor &input,
+                         const synapse::Tensor &weight,
+                         const synapse::Tensor *bias,
+                         synapse::Activation activation) -> synapse::Tensor {
+  synapse::ProfileScope profile("linear", {&input, &weight});
+  if (weight.ndim() != 2 || input.ndim() == 0 ||
+      input.shape().back() != weight.shape()[1]) {
+    throw std::invalid_argument(
+        std::format("Linear layer is invalid. Found input shape {} and "
+                    "weight shape {}.",
+                    input.shape(), weight.shape()));
+  }
+  const size_t in_features = weight.shape()[1];
+  const size_t out_features = weight.shape()[0];
+  if (bias != nullptr && bias->shape() != synapse::Shape{out_features}) {
+    throw std::invalid_argument(std::format(
+        "Linear bias must have shape [{}], found {}.", out_features,
+        bias->shape()));
+  }
+
+  const std::vector<const synapse::Tensor *> inputs =
+      operands(input, weight, bias);
+  if (!can_fuse(inputs)) {
+    synapse::Tensor out = synapse::matmul(input, weight.transpose(0, 1));
+    if (bias != nullptr) {
+      out = synapse::add(out, *bias);
+    }
+    return activate(std::move(out), activation);
+  }
+
+  // Every leading dimension is a row of the product, and the weight is read
+  // through its transposed strides
+  synapse::Shape out_shape = input.shape();
+  out_shape.back() = out_features;
+  const size_t rows = synapse::shape_numel(
+      synapse::Shape(input.shape().begin(), input.shape().end() - 1));
+  const synapse::NDArray lhs = input.NDArray::reshape({rows, in_features});
+  synapse::Tensor out = synapse::Tensor::empty(out_shape);
+  synapse::sgemm(
+      rows, out_features, in_features, lhs.data(), lhs.strides()[0],
+      lhs.strides()[1], weight.data(), weight.strides()[1],
+      weight.strides()[0], out.data(), out_features, false,
+      {.bias = bias == nullptr ? nullptr : bias->data(),
+       .rs_bias = 0,
+       .cs_bias = bias == nullptr ? 1 : bias->strides()[0],
+       .activation = activation});
+  profile.set_output(out, 2 * rows * out_features * in_features);
+  return out;
+}
+
+auto synapse::nn::conv2d(const synapse::Tensor &input,
+                         const synapse::Tensor &weight,
+                         const synapse::Tensor *bias, size_t stride,
+                         size_t padding, synapse::Activation activation)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("conv2d", {&input, &weight});
+  if (input.ndim() != 4 || weight.ndim() != 4 ||
+      input.shape()[1] != weight.shape()[1] || stride == 0) {
+    throw std::invalid_argument(
+        std::format("Convolution is invalid. Found input shape {}, weight "
+                    "shape {} and stride {}.",
+                    input.shape(), weight.shape(), stride));
+  }
+  const size_t out_channels = weight.shape()[0];
+  if (bias != nullptr && bias->shape() != synapse::Shape{out_channels}) {
+    throw std::invalid_argument(std::format(
+        "Convolution bias must have shape [{}], found {}.", out_channels,
+        bias->shape()));
+  }
+  const size_t padded_h = input.shape()[2] + (2 * padding);
+  const size_t padded_w = input.shape()[3] + (2 * padding);
+  if (weight.shape()[2] > padded_h || weight.shape()[3] > padded_w) {
+    throw std::invalid_argument(std::format(
+        "Convolution kernel {} does not fit in the padded input {}.",
+        weight.shape(), input.shape()));
+  }
+  const ConvGeometry geo{
+      .channels = input.shape()[1],
+      .height = input.shape()[2],
+      .width = input.shape()[3],
+      .kernel_h = weight.shape()[2],
+      .kernel_w = weight.shape()[3],
+      .stride = stride,
+      .padding = padding,
+      .out_h = ((padded_h - weight.shape()[2]) / stride) + 1,
+      .out_w = ((padded_w - weight.shape()[3]) / stride) + 1};
+  const size_t batch = input.shape()[0];
+
+  // Activations are applied by func.h ops when training, so that they are
+  // differentiated too
+  const std::vector<const synapse::Tensor *> inputs =
+      operands(input, weight, bias);
+  const bool grad = synapse::needs_grad(inputs);
+  const synapse::Tensor image{dense(input)};
+  const synapse::Tensor kernel{dense(weight)};
+  synapse::Tensor out =
+      synapse::Tensor::empty({batch, out_channels, geo.out_h, geo.out_w});
+  conv2d_forward(geo, batch, image.data(), kernel.data(), bias, out_channels,
+                 grad ? synapse::Activation::None : activation, out.data());
+  profile.set_output(out, 2 * batch * out_channels * geo.out_h * geo.out_w *
+                              geo.channels * geo.kernel_h * geo.kernel_w);
+  if (!grad) {
+    return out;
+  }
+
+  synapse::record(
+      out, "Conv2dBackward", inputs,
+      synapse::save_for_backward(image, kernel),
+      [geo, batch, out_channels,
+       has_bias = bias != nullptr](const synapse::Tensor &grad_out,
+                                   const Saved &saved) -> Gradients {
+        const size_t taps = geo.channels * geo.kernel_h * geo.kernel_w;
+        const size_t pixels = geo.out_h * geo.out_w;
+        const size_t image_size = geo.channels * geo.height * geo.width;
+        const synapse::NDArray grad_values = dense(grad_out);
+        synapse::Tensor grad_input = synapse::Tensor::zeros(saved[0].shape());
+        synapse::Tensor grad_weight = synapse::Tensor::zeros(saved[1].shape());
+        std::vector<float> grad_cols(taps * pixels);
+        // Images are walked one after the other since they all accumulate
+        // into the same weight gradient
+        for (size_t n = 0; n < batch; ++n) {
+          const float *grad_n =
+              grad_values.data() + (n * out_channels * pixels);
+          for_each_image(
+              geo, 1, saved[0].data() + (n * image_size),
+              [&](size_t, const float *cols) {
+                // dW += dY (out_channels x pixels) * cols^T
+                synapse::sgemm(out_channels, taps, pixels, grad_n, pixels, 1,
+                               cols, 1, pixels, grad_weight.data(), taps,
+                               true);
+              });
+          // dcols = W^T (taps x out_channels) * dY, folded back into dX
+          synapse::sgemm(taps, pixels, out_channels, saved[1].data(), 1, taps,
+                         grad_n, pixels, 1, grad_cols.data(), pixels);
+          col2im(geo, grad_cols.data(), grad_input.data() + (n * image_size));
+        }
+        Gradients grads =
+            synapse::make_gradients(std::move(grad_input),
+                                    std::move(grad_weight));
+        if (has_bias) {
+          grads.emplace_back(synapse::sum(grad_out, {0, 2, 3}));
+        }
+        return grads;
+      });
+  return activate(std::move(out), activation);
+}
+
+auto synapse::nn::layer_norm(const synapse::Tensor &input,
+                             const synapse::Tensor &weight,
+                             const synapse::Tensor &bias, float eps)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("layer_norm", {&input, &weight, &bias});
+  const size_t norm_dims = weight.ndim();
+  if (norm_dims > input.ndim() || bias.shape() != weight.shape() ||
+      !std::equal(weight.shape().begin(), weight.shape().end(),
+                  input.shape().end() -
+                      static_cast<std::ptrdiff_t>(norm_dims))) {
+    throw std::invalid_argument(
+        std::format("Layer norm is invalid. Found input shape {}, weight "
+                    "shape {} and bias shape {}.",
+                    input.shape(), weight.shape(), bias.shape()));
+  }
+
+  if (!can_fuse({&input, &weight, &bias})) {
+    std::vector<size_t> dims(norm_dims);
+    for (size_t i = 0; i < norm_dims; ++i) {
+      dims[i] = input.ndim() - norm_dims + i;
+    }
+    const synapse::Tensor centered =
+        synapse::sub(input, synapse::mean(input, dims, true));
+    const synapse::Tensor variance = synapse::var(input, dims, true, 0);
+    const synapse::Tensor normalized = synapse::div(
+        centered,
+        synapse::sqrt(synapse::add(variance, synapse::Tensor({eps}, {}))));
+    return synapse::add(synapse::mul(normalized, weight), bias);
+  }
+
+  const size_t length = weight.size();
+  const size_t rows = length == 0 ? 0 : input.size() / length;
+  const synapse::NDArray src = dense(input);
+  const synapse::NDArray gamma = dense(weight);
+  const synapse::NDArray beta = dense(bias);
+  synapse::Tensor out = synapse::Tensor::empty(input.shape());
+  const float *x = src.data();
+  const float *w = gamma.data();
+  const float *b = beta.data();
+  float *y = out.data();
+  const size_t grain =
+      std::max<size_t>(synapse::GRAIN_SIZE / std::max<size_t>(length, 1), 1);
+  synapse::parallel_for(0, rows, grain, [&](size_t begin, size_t end) {
+    for (size_t r = begin; r < end; ++r) {
+      const float *row = x + (r * length);
+      float *dst = y + (r * length);
+      // Welford's algorithm, a single stable pass for both moments
+      float mean = 0.0F;
+      float m2 = 0.0F;
+      for (size_t i = 0; i < length; ++i) {
+        const float delta = row[i] - mean;
+        mean += delta / static_cast<float>(i + 1);
+        m2 += delta * (row[i] - mean);
+      }
+      const float rstd =
+          1.0F / std::sqrt((m2 / static_cast<float>(length)) + eps);
+      for (size_t i = 0; i < length; ++i) {
+        dst[i] = ((row[i] - mean) * rstd * w[i]) + b[i];
+      }
+    }
+  });
+  // Five operations for the Welford update, four for the normalization
+  profile.set_output(out, 9 * rows * length);
+  return out;
+}
+
+auto synapse::nn::softmax(const synapse::Tensor &input, size_t dim)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("softmax", {&input});
+  if (dim >= input.ndim()) {
+    throw std::out_of_range(std::format(
+        "Dimension {} is out of range for a {}D tensor.", dim, input.ndim()));
+  }
+
+  if (!can_fuse({&input})) {
+    const synapse::Tensor shifted =
+        synapse::exp(synapse::sub(input, synapse::max(input, {dim}, true)));
+    return synapse::div(shifted, synapse::sum(shifted, {dim}, true));
+  }
+
+  const synapse::Shape &shape = input.shape();
+  const size_t length = shape[dim];
+  const size_t inner = synapse::shape_numel(
+      synapse::Shape(shape.begin() + static_cast<std::ptrdiff_t>(dim) + 1,
+                     shape.end()));
+  const size_t block = length * inner;
+  const size_t outer = block == 0 ? 0 : input.size() / block;
+  const synapse::NDArray src = dense(input);
+  synapse::Tensor out = synapse::Tensor::empty(shape);
+  const float *x = src.data();
+  float *y = out.data();
+  const size_t grain =
+      std::max<size_t>(synapse::GRAIN_SIZE / std::max<size_t>(block, 1), 1);
+  synapse::parallel_for(0, outer, grain, [&](size_t begin, size_t end) {
+    for (size_t o = begin; o < end; ++o) {
+      if (inner == 1) {
+        softmax_row(x + (o * block), y + (o * block), length);
+      } else {
+        softmax_columns(x + (o * block), y + (o * block), length, inner);
+      }
+    }
+  });
+  // Maximum, exponential, sum and scaling of every element
+  profile.set_output(out, 4 * outer * block);
+  return out;
+}
+
+auto synapse::nn::embedding(const synapse::Tensor &indices,
+                            const synapse::Tensor &weight) -> synapse::Tensor {
+  synapse::ProfileScope profile("embedding", {&indices, &weight});
+  if (weight.ndim() != 2) {
+    throw std::invalid_argument(std::format(
+        "Embedding weight must be 2-dimensional, found shape {}.",
+        weight.shape()));
+  }
+  const size_t num_embeddings = weight.shape()[0];
+  const size_t dim = weight.shape()[1];
+  const synapse::NDArray ids =
+      indices.NDArray::to(synapse::DType::Int32).contiguous();
+  const int32_t *id = ids.data_ptr<int32_t>();
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (id[i] < 0 || static_cast<size_t>(id[i]) >= num_embeddings) {
+      throw std::out_of_range(
+          std::format("Embedding index {} is out of range for {} rows.",
+                      id[i], num_embeddings));
+    }
+  }
+
+  const synapse::NDArray table = dense(weight);
+  synapse::Shape out_shape = indices.shape();
+  out_shape.push_back(dim);
+  synapse::Tensor out = synapse::Tensor::empty(out_shape);
+  const float *src = table.data();
+  float *dst = out.data();
+  const size_t grain =
+      std::max<size_t>(synapse::GRAIN_SIZE / std::max<size_t>(dim, 1), 1);
+  synapse::parallel_for(0, ids.size(), grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      std::copy_n(src + (static_cast<size_t>(id[i]) * dim), dim,
+                  dst + (i * dim));
+    }
+  });
+
+  if (synapse::needs_grad({&weight})) {
+    synapse::record(
+        out, "EmbeddingBackward", {&weight}, {},
+        [ids, num_embeddings, dim](const synapse::Tensor &grad,
+                                   const Saved &) -> Gradients {
+          // Serial, as repeated indices add into the same row
+          synapse::Tensor weight_grad =
+              synapse::Tensor::zeros({num_embeddings, dim});
+          const synapse::NDArray rows = dense(grad);
+          const int32_t *row_id = ids.data_ptr<int32_t>();
+          float *acc = weight_grad.data();
+          for (size_t i = 0; i < ids.size(); ++i) {
+            float *row = acc + (static_cast<size_t>(row_id[i]) * dim);
+            const float *g = rows.data() + (i * dim);
+            for (size_t j = 0; j < dim; ++j) {
+              row[j] += g[j];
+            }
+          }
+          return synapse::make_gradients(std::move(weight_grad));
+        });
+  }
+  profile.set_output(out);
+  return out;
+}
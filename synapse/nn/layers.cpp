@@ -0,0 +1,291 @@
+#include "gemm.h"
+#include "autograd.h"
+#include "func.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "sparse.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+// Shared by every layer so that consecutive layers get different values,
+// with the default seed so that models are reproducible
+auto generator_mutex() -> std::mutex & {
+  static std::mutex mutex;
+  return mutex;
+}
+
+auto generator() -> std::mt19937 & {
+  static std::mt19937 engine;
+  return engine;
+}
+
+// Tensor drawn from U(-bound, bound)
+auto uniform(const synapse::Shape &shape, float bound) -> synapse::Tensor {
+  std::vector<float> values(synapse::shape_numel(shape));
+  std::uniform_real_distribution<float> distribution(-bound, bound);
+  const std::scoped_lock lock(generator_mutex());
+  for (float &value : values) {
+    value = distribution(generator());
+  }
+  return synapse::Tensor{std::move(values), shape};
+}
+
+// Tensor drawn from N(0, 1)
+auto normal(const synapse::Shape &shape) -> synapse::Tensor {
+  std::vector<float> values(synapse::shape_numel(shape));
+  std::normal_distribution<float> distribution;
+  const std::scoped_lock lock(generator_mutex());
+  for (float &value : values) {
+    value = distribution(generator());
+  }
+  return synapse::Tensor{std::move(values), shape};
+}
+
+auto fan_in_bound(size_t fan_in) -> float {
+  return fan_in == 0 ? 0.0F : 1.0F / std::sqrt(static_cast<float>(fan_in));
+}
+
+auto bias_or_throw(std::optional<synapse::Tensor> &bias) -> synapse::Tensor & {
+  if (!bias.has_value()) {
+    throw std::logic_error("The layer has no bias.");
+  }
+  return *bias;
+}
+
+// Gradient of an embedding table of `shape` holding only the rows in `ids`,
+// the gradients of repeated rows summed
+auto row_sparse_grad(const synapse::NDArray &ids, const synapse::Tensor &grad,
+                     const synapse::Shape &shape) -> synapse::SparseTensor {
+  const size_t dim = shape[1];
+  const int32_t *id = ids.data_ptr<int32_t>();
+  const synapse::NDArray src =
+      grad.NDArray::to(synapse::DType::Float32).contiguous();
+  std::vector<size_t> order(ids.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::ranges::stable_sort(
+      order, [&](size_t lhs, size_t rhs) { return id[lhs] < id[rhs]; });
+
+  // Built sorted and without duplicates, so `coo` has nothing to reorder
+  std::vector<size_t> rows;
+  std::vector<size_t> cols;
+  std::vector<float> values;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const auto row = static_cast<size_t>(id[order[i]]);
+    const float *g = src.data() + (order[i] * dim);
+    if (i > 0 && id[order[i - 1]] == id[order[i]]) {
+      float *acc = values.data() + (values.size() - dim);
+      for (size_t j = 0; j < dim; ++j) {
+        acc[j] += g[j];
+      }
+      continue;
+    }
+    for (size_t j = 0; j < dim; ++j) {
+      rows.push_back(row);
+      cols.push_back(j);
+      values.push_back(g[j]);
+    }
+  }
+  return synapse::SparseTensor::coo(shape, std::move(rows), std::move(cols),
+                                    std::move(values));
+}
+
+auto bias_or_null(const std::optional<synapse::Tensor> &bias)
+    -> const synapse::Tensor * {
+  return bias.has_value() ? &*bias : nullptr;
+}
+} // namespace
+
+auto synapse::nn::Module::parameters() -> std::vector<synapse::Tensor *> {
+  return {};
+}
+
+auto synapse::nn::Module::operator()(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return this->forward(input);
+}
+
+synapse::nn::Linear::Linear(size_t in_features, size_t out_features,
+                            bool bias, synapse::Activation activation)
+    : _weight(uniform({out_features, in_features}, fan_in_bound(in_features))),
+      _bias(bias ? std::optional<synapse::Tensor>(uniform(
+                       {out_features}, fan_in_bound(in_features)))
+                 : std::nullopt),
+      _activation(activation) {}
+
+synapse::nn::Linear::Linear(synapse::Tensor weight,
+                            std::optional<synapse::Tensor> bias,
+                            synapse::Activation activation)
+    : _weight(std::move(weight)), _bias(std::move(bias)),
+      _activation(activation) {}
+
+auto synapse::nn::Linear::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return synapse::nn::linear(input, this->_weight, bias_or_null(this->_bias),
+                             this->_activation);
+}
+
+auto synapse::nn::Linear::parameters() -> std::vector<synapse::Tensor *> {
+  if (this->_bias.has_value()) {
+    return {&this->_weight, &*this->_bias};
+  }
+  return {&this->_weight};
+}
+
+auto synapse::nn::Linear::weight() -> synapse::Tensor & {
+  return this->_weight;
+}
+
+auto synapse::nn::Linear::bias() -> synapse::Tensor & {
+  return bias_or_throw(this->_bias);
+}
+
+auto synapse::nn::Linear::activation() const -> synapse::Activation {
+  return this->_activation;
+}
+
+synapse::nn::Conv2d::Conv2d(size_t in_channels, size_t out_channels,
+                            size_t kernel_size, size_t stride, size_t padding,
+                            bool bias, synapse::Activation activation)
+    : _weight(uniform({out_channels, in_channels, kernel_size, kernel_size},
+                      fan_in_bound(in_channels * kernel_size * kernel_size))),
+      _bias(bias ? std::optional<synapse::Tensor>(uniform(
+                       {out_channels},
+                       fan_in_bound(in_channels * kernel_size * kernel_size)))
+                 : std::nullopt),
+      _stride(stride), _padding(padding), _activation(activation) {}
+
+synapse::nn::Conv2d::Conv2d(synapse::Tensor weight,
+                            std::optional<synapse::Tensor> bias, size_t stride,
+                            size_t padding, synapse::Activation activation)
+    : _weight(std::move(weight)), _bias(std::move(bias)), _stride(stride),
+      _padding(padding), _activation(activation) {}
+
+auto synapse::nn::Conv2d::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return synapse::nn::conv2d(input, this->_weight, bias_or_null(this->_bias),
+                             this->_stride, this->_padding, this->_activation);
+}
+
+auto synapse::nn::Conv2d::parameters() -> std::vector<synapse::Tensor *> {
+  if (this->_bias.has_value()) {
+    return {&this->_weight, &*this->_bias};
+  }
+  return {&this->_weight};
+}
+
+auto synapse::nn::Conv2d::weight() -> synapse::Tensor & {
+  return this->_weight;
+}
+
+auto synapse::nn::Conv2d::bias() -> synapse::Tensor & {
+  return bias_or_throw(this->_bias);
+}
+
+synapse::nn::LayerNorm::LayerNorm(const synapse::Shape &normalized_shape,
+                                  float eps)
+    : _weight(std::vector<float>(synapse::shape_numel(normalized_shape), 1.0F),
+              normalized_shape),
+      _bias(synapse::Tensor::zeros(normalized_shape)), _eps(eps) {}
+
+auto synapse::nn::LayerNorm::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return synapse::nn::layer_norm(input, this->_weight, this->_bias,
+                                 this->_eps);
+}
+
+auto synapse::nn::LayerNorm::parameters() -> std::vector<synapse::Tensor *> {
+  return {&this->_weight, &this->_bias};
+}
+
+auto synapse::nn::LayerNorm::weight() -> synapse::Tensor & {
+  return this->_weight;
+}
+
+auto synapse::nn::LayerNorm::bias() -> synapse::Tensor & {
+  return this->_bias;
+}
+
+synapse::nn::Softmax::Softmax(size_t dim) : _dim(dim) {}
+
+auto synapse::nn::Softmax::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return synapse::nn::softmax(input, this->_dim);
+}
+
+synapse::nn::Embedding::Embedding(size_t num_embeddings, size_t embedding_dim,
+                                  bool sparse)
+    : Embedding(normal({num_embeddings, embedding_dim}), sparse) {}
+
+synapse::nn::Embedding::Embedding(synapse::Tensor weight, bool sparse)
+    : _weight(std::move(weight)), _sparse(sparse),
+      _sparse_grad(std::make_shared<std::optional<synapse::SparseTensor>>()) {}
+
+auto synapse::nn::Embedding::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  if (!this->_sparse || !synapse::needs_grad({&this->_weight})) {
+    return synapse::nn::embedding(input, this->_weight);
+  }
+  // Looks up through a detached alias, then records a node feeding the
+  // sparse gradient instead of the weight
+  synapse::Tensor out =
+      synapse::nn::embedding(input, this->_weight.detach());
+  out.set_grad_fn(std::make_shared<synapse::FunctionNode>(
+      "EmbeddingSparseBackward", std::vector<std::shared_ptr<synapse::Node>>{},
+      std::vector<synapse::Tensor>{},
+      [ids = input.NDArray::to(synapse::DType::Int32).contiguous(),
+       shape = this->_weight.shape(), slot = this->_sparse_grad](
+          const synapse::Tensor &grad, const std::vector<synapse::Tensor> &)
+          -> synapse::Node::Gradients {
+        synapse::SparseTensor rows = row_sparse_grad(ids, grad, shape);
+        *slot = slot->has_value() ? synapse::add(**slot, rows)
+                                  : std::move(rows);
+        return {};
+      }));
+  return out;
+}
+
+auto synapse::nn::Embedding::parameters() -> std::vector<synapse::Tensor *> {
+  return {&this->_weight};
+}
+
+auto synapse::nn::Embedding::weight() -> synapse::Tensor & {
+  return this->_weight;
+}
+
+auto synapse::nn::Embedding::sparse_grad() const
+    -> const synapse::SparseTensor & {
+  if (!this->has_sparse_grad()) {
+    throw std::logic_error("Embedding has no sparse gradient.");
+  }
+  return **this->_sparse_grad;
+}
+
+auto synapse::nn::Embedding::has_sparse_grad() const -> bool {
+  return this->_sparse_grad->has_value();
+}
+
+auto synapse::nn::Embedding::zero_sparse_grad() -> void {
+  this->_sparse_grad->reset();
+}
+
+auto synapse::nn::GELU::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return synapse::gelu(input);
+}
+
+auto synapse::nn::ReLU::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  return synapse::relu(input);
+}
@@ -0,0 +1,74 @@
+#include "stream.h"
+#include "allocator.h"
+#include "autograd.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+synapse::Stream::Stream()
+    : _mutex(), _wake(), _idle(), _queue(), _pending(0), _stop(false),
+      _worker([this] { this->_worker_loop(); }) {}
+
+synapse::Stream::~Stream() {
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_stop = true;
+  }
+  this->_wake.notify_one();
+  this->_worker.join();
+}
+
+auto synapse::Stream::synchronize() -> void {
+  std::unique_lock<std::mutex> lock(this->_mutex);
+  this->_idle.wait(lock, [this] { return this->_pending == 0; });
+}
+
+auto synapse::Stream::is_current() const -> bool {
+  return std::this_thread::get_id() == this->_worker.get_id();
+}
+
+auto synapse::Stream::_enqueue(std::function<void()> task) -> void {
+  // Thread-local modes of the submitting thread carry over to the task
+  const bool grad_enabled = synapse::GradMode::is_enabled();
+  std::shared_ptr<synapse::Allocator> allocator = synapse::current_allocator();
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_queue.emplace_back([task = std::move(task), grad_enabled,
+                               allocator = std::move(allocator)] {
+      const bool previous = synapse::GradMode::is_enabled();
+      synapse::GradMode::set_enabled(grad_enabled);
+      {
+        const synapse::AllocatorGuard guard(allocator);
+        task();
+      }
+      synapse::GradMode::set_enabled(previous);
+    });
+    ++this->_pending;
+  }
+  this->_wake.notify_one();
+}
+
+auto synapse::Stream::_worker_loop() -> void {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(this->_mutex);
+      this->_wake.wait(
+          lock, [this] { return this->_stop || !this->_queue.empty(); });
+      // Queued tasks still run after a stop request
+      if (this->_queue.empty()) {
+        return;
+      }
+      task = std::move(this->_queue.front());
+      this->_queue.pop_front();
+    }
+    task();
+    {
+      const std::lock_guard<std::mutex> lock(this->_mutex);
+      --this->_pending;
+    }
+    this->_idle.notify_all();
+  }
+}
@@ -0,0 +1,319 @@
+#include "parallel.h"
+#include "placement.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+thread_local bool parallel_region = false;
+
+// Marks the calling thread as running region tasks until destroyed
+class RegionScope {
+public:
+  RegionScope(const RegionScope &) = delete;
+  RegionScope(RegionScope &&) = delete;
+  auto operator=(const RegionScope &) -> RegionScope & = delete;
+  auto operator=(RegionScope &&) -> RegionScope & = delete;
+  RegionScope() : _previous(parallel_region) { parallel_region = true; }
+  ~RegionScope() { parallel_region = this->_previous; }
+
+private:
+  bool _previous;
+};
+
+// Block of chunks owned by one thread. Owners and thieves both claim chunks
+// with a fetch_add on `next`, so no chunk ever runs twice.
+struct alignas(64) Partition {
+  std::atomic<size_t> next{0};
+  size_t end{0};
+};
+
+// CPUs thread `id` of `threads` is pinned to, none when it is not pinned
+auto thread_cpus(size_t id, size_t threads, synapse::ThreadAffinity affinity)
+    -> std::vector<size_t> {
+  if (affinity == synapse::ThreadAffinity::None) {
+    return {};
+  }
+  // Nodes without allowed CPUs would leave their threads unpinned
+  const std::vector<size_t> nodes = synapse::numa_cpu_nodes();
+  const size_t slot = id * nodes.size() / threads;
+  std::vector<size_t> cpus = synapse::numa_node_cpus(nodes[slot]);
+  if (affinity == synapse::ThreadAffinity::Core) {
+    // First thread placed on the node
+    const size_t first = ((slot * threads) + nodes.size() - 1) / nodes.size();
+    return {cpus[(id - first) % cpus.size()]};
+  }
+  return cpus;
+}
+
+/**
+ * Fixed set of workers sleeping until a region is submitted. The submitting
+ * thread takes part in the region as thread 0.
+ */
+class ThreadPool {
+public:
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+  auto operator=(ThreadPool &&) -> ThreadPool & = delete;
+  ThreadPool(size_t num_threads, synapse::ThreadAffinity affinity);
+  ~ThreadPool();
+
+  [[nodiscard]] auto num_threads() const -> size_t;
+  [[nodiscard]] auto affinity() const -> synapse::ThreadAffinity;
+  auto run(size_t num_chunks, const std::function<void(size_t)> &task)
+      -> void;
+
+private:
+  std::vector<Partition> _partitions;
+  synapse::ThreadAffinity _affinity;
+  std::vector<std::thread> _workers;
+  // Held for the whole duration of a region
+  std::mutex _region_mutex;
+  // Guards everything below
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  size_t _generation;
+  size_t _active;
+  bool _stop;
+  const std::function<void(size_t)> *_task;
+  std::exception_ptr _error;
+  std::atomic<bool> _failed;
+
+  auto _worker_loop(size_t id) -> void;
+  auto _work(size_t id) -> void;
+};
+
+ThreadPool::ThreadPool(size_t num_threads, synapse::ThreadAffinity affinity)
+    : _partitions(num_threads), _affinity(affinity), _workers(),
+      _region_mutex(), _mutex(), _wake(), _done(), _generation(0), _active(0),
+      _stop(false), _task(nullptr), _error(nullptr), _failed(false) {
+  this->_workers.reserve(num_threads - 1);
+  for (size_t id = 1; id < num_threads; ++id) {
+    this->_workers.emplace_back(
+        [this, id, cpus = thread_cpus(id, num_threads, affinity)] {
+          // Pinning is best effort, an unpinned worker still runs its chunks
+          if (!cpus.empty()) {
+            static_cast<void>(synapse::pin_current_thread(cpus));
+          }
+          this->_worker_loop(id);
+        });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_stop = true;
+  }
+  this->_wake.notify_all();
+  for (std::thread &worker : this->_workers) {
+    worker.join();
+  }
+}
+
+auto ThreadPool::num_threads() const -> size_t {
+  return this->_partitions.size();
+}
+
+auto ThreadPool::affinity() const -> synapse::ThreadAffinity {
+  return this->_affinity;
+}
+
+auto ThreadPool::run(size_t num_chunks,
+                     const std::function<void(size_t)> &task) -> void {
+  std::unique_lock<std::mutex> region(this->_region_mutex, std::try_to_lock);
+  if (!region.owns_lock()) {
+    // Another thread owns the workers, so this region runs serially rather
+    // than waiting for it
+    const RegionScope scope;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  // Deals the chunks to the threads in contiguous blocks
+  const size_t threads = this->num_threads();
+  const size_t per_thread = (num_chunks + threads - 1) / threads;
+  for (size_t t = 0; t < threads; ++t) {
+    this->_partitions[t].next.store(std::min(t * per_thread, num_chunks),
+                                    std::memory_order_relaxed);
+    this->_partitions[t].end = std::min((t + 1) * per_thread, num_chunks);
+  }
+  {
+    const std::lock_guard<std::mutex> lock(this->_mutex);
+    this->_task = &task;
+    this->_error = nullptr;
+    this->_failed.store(false, std::memory_order_relaxed);
+    this->_active = this->_workers.size();
+    ++this->_generation;
+  }
+  this->_wake.notify_all();
+
+  this->_work(0);
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    this->_done.wait(lock, [this] { return this->_active == 0; });
+    this->_task = nullptr;
+    error = std::exchange(this->_error, nullptr);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+auto ThreadPool::_worker_loop(size_t id) -> void {
+  size_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(this->_mutex);
+      this->_wake.wait(lock, [this, seen] {
+        return this->_stop || this->_generation != seen;
+      });
+      if (this->_stop) {
+        return;
+      }
+      seen = this->_generation;
+    }
+    this->_work(id);
+    {
+      const std::lock_guard<std::mutex> lock(this->_mutex);
+      if (--this->_active == 0) {
+        this->_done.notify_one();
+      }
+    }
+  }
+}
+
+auto ThreadPool::_work(size_t id) -> void {
+  const RegionScope scope;
+  const size_t threads = this->num_threads();
+  // Drains the own partition first, then steals from the following ones
+  for (size_t k = 0; k < threads; ++k) {
+    Partition &partition = this->_partitions[(id + k) % threads];
+    while (!this->_failed.load(std::memory_order_relaxed)) {
+      const size_t chunk =
+          partition.next.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= partition.end) {
+        break;
+      }
+      try {
+        (*this->_task)(chunk);
+      } catch (...) {
+        const std::lock_guard<std::mutex> lock(this->_mutex);
+        if (!this->_error) {
+          this->_error = std::current_exception();
+        }
+        this->_failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+auto default_num_threads() -> size_t {
+  if (const char *env = std::getenv("SYNAPSE_NUM_THREADS")) {
+    try {
+      const unsigned long value = std::stoul(env);
+      if (value > 0) {
+        return value;
+      }
+    } catch (const std::exception &) {
+      // Ignores malformed values
+    }
+  }
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+auto num_threads_setting() -> std::atomic<size_t> & {
+  static std::atomic<size_t> setting{default_num_threads()};
+  return setting;
+}
+
+auto default_thread_affinity() -> synapse::ThreadAffinity {
+  if (const char *env = std::getenv("SYNAPSE_THREAD_AFFINITY")) {
+    const std::string_view value = env;
+    if (value == "node") {
+      return synapse::ThreadAffinity::Node;
+    }
+    if (value == "core") {
+      return synapse::ThreadAffinity::Core;
+    }
+  }
+  return synapse::ThreadAffinity::None;
+}
+
+auto thread_affinity_setting() -> std::atomic<synapse::ThreadAffinity> & {
+  static std::atomic<synapse::ThreadAffinity> setting{
+      default_thread_affinity()};
+  return setting;
+}
+
+std::mutex pool_mutex;
+std::shared_ptr<ThreadPool> pool = nullptr;
+
+// Pool matching the current setting. Callers hold a reference for the
+// duration of their region, so resizing never destroys a pool in use.
+auto current_pool() -> std::shared_ptr<ThreadPool> {
+  const size_t threads = synapse::get_num_threads();
+  const synapse::ThreadAffinity affinity = synapse::get_thread_affinity();
+  const std::lock_guard<std::mutex> lock(pool_mutex);
+  if (!pool || pool->num_threads() != threads ||
+      pool->affinity() != affinity) {
+    pool = std::make_shared<ThreadPool>(threads, affinity);
+  }
+  return pool;
+}
+} // namespace
+
+auto synapse::get_num_threads() -> size_t {
+  return num_threads_setting().load(std::memory_order_relaxed);
+}
+
+auto synapse::set_num_threads(size_t num_threads) -> void {
+  if (num_threads == 0) {
+    throw std::invalid_argument("The number of threads must be positive.");
+  }
+  num_threads_setting().store(num_threads, std::memory_order_relaxed);
+}
+
+auto synapse::get_thread_affinity() -> synapse::ThreadAffinity {
+  return thread_affinity_setting().load(std::memory_order_relaxed);
+}
+
+auto synapse::set_thread_affinity(synapse::ThreadAffinity affinity) -> void {
+  thread_affinity_setting().store(affinity, std::memory_order_relaxed);
+}
+
+auto synapse::in_parallel_region() -> bool { return parallel_region; }
+
+auto synapse::parallel_run(size_t num_chunks,
+                           const std::function<void(size_t)> &task) -> void {
+  if (num_chunks == 0) {
+    return;
+  }
+  if (num_chunks == 1 || synapse::get_num_threads() == 1 ||
+      synapse::in_parallel_region()) {
+    const RegionScope scope;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      task(i);
+    }
+    return;
+  }
+  current_pool()->run(num_chunks, task);
+}
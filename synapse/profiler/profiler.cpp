@@ -0,0 +1,212 @@
+#include "profiler.h"
+#include "ndarray.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+std::atomic<bool> enabled{false};
+// Steady clock time of the first start since the last clear, 0 when unset
+std::atomic<int64_t> epoch_ns{0};
+std::atomic<size_t> next_thread{0};
+
+auto events_mutex() -> std::mutex & {
+  static std::mutex mutex;
+  return mutex;
+}
+
+auto recorded_events() -> std::vector<synapse::ProfileEvent> & {
+  static std::vector<synapse::ProfileEvent> events;
+  return events;
+}
+
+auto steady_ns() -> int64_t {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+auto thread_index() -> size_t {
+  thread_local const size_t index = next_thread.fetch_add(1);
+  return index;
+}
+
+// Quotes and escapes a string for JSON
+auto json_string(std::string_view text) -> std::string {
+  std::string out = "\"";
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  out += '"';
+  return out;
+}
+
+// Per-nanosecond rate, which is the rate in giga-units per second
+auto giga_rate(size_t amount, uint64_t ns) -> double {
+  return ns == 0 ? 0.0
+                 : static_cast<double>(amount) / static_cast<double>(ns);
+}
+} // namespace
+
+auto synapse::Profiler::start() -> void {
+  int64_t unset = 0;
+  epoch_ns.compare_exchange_strong(unset, steady_ns());
+  enabled.store(synapse::PROFILE, std::memory_order_relaxed);
+}
+
+auto synapse::Profiler::stop() -> void {
+  enabled.store(false, std::memory_order_relaxed);
+}
+
+auto synapse::Profiler::is_enabled() -> bool {
+  return synapse::PROFILE && enabled.load(std::memory_order_relaxed);
+}
+
+auto synapse::Profiler::clear() -> void {
+  const std::lock_guard<std::mutex> lock(events_mutex());
+  recorded_events().clear();
+  epoch_ns.store(enabled.load() ? steady_ns() : 0);
+}
+
+auto synapse::Profiler::record(synapse::ProfileEvent event) -> void {
+  event.thread = thread_index();
+  const std::lock_guard<std::mutex> lock(events_mutex());
+  recorded_events().push_back(std::move(event));
+}
+
+auto synapse::Profiler::events() -> std::vector<synapse::ProfileEvent> {
+  const std::lock_guard<std::mutex> lock(events_mutex());
+  return recorded_events();
+}
+
+auto synapse::Profiler::now_ns() -> uint64_t {
+  return static_cast<uint64_t>(
+      std::max<int64_t>(steady_ns() - epoch_ns.load(), 0));
+}
+
+auto synapse::Profiler::summary() -> std::string {
+  struct Total {
+    size_t calls;
+    uint64_t ns;
+    size_t bytes;
+    size_t flops;
+  };
+  const std::vector<synapse::ProfileEvent> events = synapse::Profiler::events();
+  std::map<std::string_view, Total> totals;
+  uint64_t begin = UINT64_MAX;
+  uint64_t end = 0;
+  for (const synapse::ProfileEvent &event : events) {
+    Total &total = totals[event.name];
+    ++total.calls;
+    total.ns += event.duration_ns;
+    total.bytes += event.bytes;
+    total.flops += event.flops;
+    begin = std::min(begin, event.start_ns);
+    end = std::max(end, event.start_ns + event.duration_ns);
+  }
+  std::vector<std::pair<std::string_view, Total>> rows(totals.begin(),
+                                                       totals.end());
+  std::ranges::stable_sort(rows, [](const auto &lhs, const auto &rhs) {
+    return lhs.second.ns > rhs.second.ns;
+  });
+
+  // Shares are taken of the span between the first and last event, which
+  // nested ops may exceed
+  const auto span = static_cast<double>(end > begin ? end - begin : 0);
+  std::string out = std::format("{:<16}{:>10}{:>14}{:>14}{:>10}{:>10}{:>10}\n",
+                                "Name", "Calls", "Total (ms)", "Mean (us)",
+                                "Time (%)", "GB/s", "GFLOP/s");
+  for (const auto &[name, total] : rows) {
+    const auto ns = static_cast<double>(total.ns);
+    out += std::format(
+        "{:<16}{:>10}{:>14.3f}{:>14.3f}{:>10.2f}{:>10.2f}{:>10.2f}\n", name,
+        total.calls, ns / 1e6, ns / 1e3 / static_cast<double>(total.calls),
+        span > 0.0 ? 100.0 * ns / span : 0.0, giga_rate(total.bytes, total.ns),
+        giga_rate(total.flops, total.ns));
+  }
+  return out;
+}
+
+auto synapse::Profiler::write_chrome_trace(std::ostream &out) -> void {
+  const std::vector<synapse::ProfileEvent> events = synapse::Profiler::events();
+  out << "{\"traceEvents\":[";
+  for (size_t i = 0; i < events.size(); ++i) {
+    const synapse::ProfileEvent &event = events[i];
+    std::string shapes = "[";
+    for (size_t j = 0; j < event.input_shapes.size(); ++j) {
+      shapes += std::format("{}{}", j == 0 ? "" : ",", event.input_shapes[j]);
+    }
+    shapes += "]";
+    // Timestamps are in microseconds
+    out << std::format(
+        "{}\n{{\"name\":{},\"cat\":\"synapse\",\"ph\":\"X\",\"ts\":{:.3f},"
+        "\"dur\":{:.3f},\"pid\":0,\"tid\":{},\"args\":{{\"shapes\":{},"
+        "\"bytes\":{},\"flops\":{}}}}}",
+        i == 0 ? "" : ",", json_string(event.name),
+        static_cast<double>(event.start_ns) / 1e3,
+        static_cast<double>(event.duration_ns) / 1e3, event.thread, shapes,
+        event.bytes, event.flops);
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+#if SYNAPSE_PROFILE
+synapse::ProfileScope::ProfileScope(
+    const char *name, std::initializer_list<const synapse::NDArray *> inputs)
+    : _active(synapse::Profiler::is_enabled()), _input_elements(0),
+      _event{name, {}, 0, 0, 0, 0, 0} {
+  if (!this->_active) {
+    return;
+  }
+  this->_event.input_shapes.reserve(inputs.size());
+  for (const synapse::NDArray *input : inputs) {
+    this->_event.input_shapes.push_back(input->shape());
+    this->_event.bytes += input->size() * input->element_size();
+    this->_input_elements += input->size();
+  }
+  this->_event.start_ns = synapse::Profiler::now_ns();
+}
+
+synapse::ProfileScope::~ProfileScope() {
+  if (!this->_active) {
+    return;
+  }
+  this->_event.duration_ns =
+      synapse::Profiler::now_ns() - this->_event.start_ns;
+  synapse::Profiler::record(std::move(this->_event));
+}
+
+auto synapse::ProfileScope::set_output(const synapse::NDArray &output)
+    -> void {
+  this->set_output(output, output.size());
+}
+
+auto synapse::ProfileScope::set_reduced_output(const synapse::NDArray &output)
+    -> void {
+  this->set_output(output, this->_input_elements);
+}
+
+auto synapse::ProfileScope::set_output(const synapse::NDArray &output,
+                                       size_t flops) -> void {
+  this->_event.bytes += output.size() * output.element_size();
+  this->_event.flops += flops;
+}
+
+auto synapse::ProfileScope::add_bytes(size_t bytes) -> void {
+  this->_event.bytes += bytes;
+}
+#endif
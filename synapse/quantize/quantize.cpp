@@ -0,0 +1,396 @@
+#include "quantize.h"
+#include "gemm.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+// Number of slices along `axis` and elements per contiguous run of one slice,
+// so that element `i` of a dense array belongs to slice `(i / inner) % count`
+struct Channels {
+  size_t count;
+  size_t inner;
+};
+
+auto channels(const synapse::Shape &shape, std::optional<size_t> axis)
+    -> Channels {
+  if (!axis.has_value()) {
+    return {1, synapse::shape_numel(shape)};
+  }
+  return {shape[*axis],
+          synapse::shape_numel(synapse::Shape(
+              shape.begin() + static_cast<std::ptrdiff_t>(*axis) + 1,
+              shape.end()))};
+}
+
+auto check_params(const synapse::Shape &shape,
+                  const synapse::QuantParams &params) -> void {
+  if (params.axis.has_value() && *params.axis >= shape.size()) {
+    throw std::invalid_argument(
+        std::format("Quantization axis {} is out of range for shape {}.",
+                    *params.axis, shape));
+  }
+  const size_t count =
+      params.axis.has_value() ? shape[*params.axis] : size_t{1};
+  if (params.scales.size() != count || params.zero_points.size() != count) {
+    throw std::invalid_argument(std::format(
+        "Expected {} quantization scales and zero points for shape {}, got "
+        "{} and {}.",
+        count, shape, params.scales.size(), params.zero_points.size()));
+  }
+  if (!std::ranges::all_of(params.scales,
+                           [](float scale) { return scale > 0.0F; })) {
+    throw std::invalid_argument("Quantization scales must be positive.");
+  }
+}
+
+auto quantize_value(float value, float scale, int32_t zero_point) -> int8_t {
+  const float q =
+      std::nearbyint(value / scale) + static_cast<float>(zero_point);
+  return static_cast<int8_t>(std::clamp(q, -128.0F, 127.0F));
+}
+
+// Per-tensor parameters covering the range of `tensor`
+auto dynamic_params(const synapse::Tensor &tensor) -> synapse::QuantParams {
+  synapse::Observer observer;
+  observer.observe(tensor);
+  return observer.params();
+}
+
+// Checks the operands of a product and returns the output shape
+auto check_product(const synapse::QuantizedTensor &lhs,
+                   const synapse::QuantizedTensor &rhs) -> synapse::Shape {
+  if (lhs.shape().size() != 2 || rhs.shape().size() != 2 ||
+      lhs.shape()[1] != rhs.shape()[0]) {
+    throw std::invalid_argument(std::format(
+        "Quantized matrix multiplication is invalid. Found shapes {} and {}.",
+        lhs.shape(), rhs.shape()));
+  }
+  if (lhs.params().per_channel() ||
+      (rhs.params().per_channel() && rhs.params().axis != 1)) {
+    throw std::invalid_argument(
+        "Quantized matrix multiplication needs a per-tensor lhs and a rhs "
+        "quantized per tensor or per column.");
+  }
+  return {lhs.shape()[0], rhs.shape()[1]};
+}
+
+auto check_output(const synapse::QuantParams &output) -> void {
+  if (output.per_channel() || output.scales.size() != 1 ||
+      output.zero_points.size() != 1 || !(output.scales[0] > 0.0F)) {
+    throw std::invalid_argument(
+        "Quantized outputs need one positive scale and one zero point.");
+  }
+}
+
+/**
+ * Completes `requantization` with the zero points of the operands and their
+ * combined scales, stored in `scales`. The rhs may be quantized per column.
+ */
+auto with_operands(synapse::Requantization requantization,
+                   const synapse::QuantParams &lhs,
+                   const synapse::QuantParams &rhs, std::vector<float> &scales)
+    -> synapse::Requantization {
+  const bool per_column = rhs.per_channel();
+  scales.resize(rhs.scales.size());
+  for (size_t j = 0; j < scales.size(); ++j) {
+    scales[j] = lhs.scales[0] * rhs.scales[j];
+  }
+  requantization.a_zero_point = lhs.zero_points[0];
+  requantization.b_zero_points = rhs.zero_points.data();
+  requantization.cs_b_zero_points = per_column ? 1 : 0;
+  requantization.scales = scales.data();
+  requantization.cs_scales = per_column ? 1 : 0;
+  return requantization;
+}
+
+// `lhs` (m x k) times `rhs` (k x n) through igemm
+template <typename Out>
+auto quantized_product(const synapse::QuantizedTensor &lhs,
+                       const synapse::QuantizedTensor &rhs,
+                       const synapse::Requantization &requantization, Out *c)
+    -> void {
+  const synapse::NDArray &a = lhs.values();
+  const synapse::NDArray &b = rhs.values();
+  std::vector<float> scales;
+  synapse::igemm(a.shape()[0], b.shape()[1], a.shape()[1],
+                 a.data_ptr<int8_t>(), a.strides()[0], a.strides()[1],
+                 b.data_ptr<int8_t>(), b.strides()[0], b.strides()[1], c,
+                 b.shape()[1],
+                 with_operands(requantization, lhs.params(), rhs.params(),
+                               scales));
+}
+
+auto quantize_weight(synapse::Tensor &weight) -> synapse::QuantizedTensor {
+  synapse::Observer observer(size_t{0}, true);
+  observer.observe(weight);
+  return synapse::quantize(weight, observer.params());
+}
+} // namespace
+
+auto synapse::QuantParams::from_range(float min, float max, bool symmetric)
+    -> synapse::QuantParams {
+  min = std::min(min, 0.0F);
+  max = std::max(max, 0.0F);
+  float scale = 0.0F;
+  int32_t zero_point = 0;
+  if (symmetric) {
+    scale = std::max(-min, max) / 127.0F;
+  } else {
+    scale = (max - min) / 255.0F;
+    if (scale > 0.0F) {
+      zero_point = static_cast<int32_t>(
+          std::clamp(-128.0F - std::nearbyint(min / scale), -128.0F, 127.0F));
+    }
+  }
+  // An all-zero range maps every value to the zero point anyway
+  if (!(scale > 0.0F)) {
+    scale = 1.0F;
+  }
+  return {{scale}, {zero_point}, std::nullopt};
+}
+
+synapse::QuantizedTensor::QuantizedTensor(synapse::NDArray values,
+                                          synapse::QuantParams params)
+    : _values(std::move(values)), _params(std::move(params)) {
+  if (this->_values.dtype() != synapse::DType::Int8) {
+    throw std::invalid_argument("Quantized values must be Int8.");
+  }
+  check_params(this->_values.shape(), this->_params);
+}
+
+auto synapse::QuantizedTensor::values() const -> const synapse::NDArray & {
+  return this->_values;
+}
+
+auto synapse::QuantizedTensor::params() const -> const synapse::QuantParams & {
+  return this->_params;
+}
+
+auto synapse::QuantizedTensor::shape() const -> const synapse::Shape & {
+  return this->_values.shape();
+}
+
+auto synapse::QuantizedTensor::dequantize() const -> synapse::Tensor {
+  synapse::ProfileScope profile("dequantize", {&this->_values});
+  const synapse::NDArray values = this->_values.contiguous();
+  synapse::Tensor out = synapse::Tensor::empty(values.shape());
+  const int8_t *src = values.data_ptr<int8_t>();
+  float *dst = out.data();
+  const auto [count, inner] = channels(values.shape(), this->_params.axis);
+  const std::vector<float> &scales = this->_params.scales;
+  const std::vector<int32_t> &zero_points = this->_params.zero_points;
+  synapse::parallel_for(
+      0, values.size(), synapse::GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const size_t c = (i / inner) % count;
+          dst[i] = scales[c] * static_cast<float>(src[i] - zero_points[c]);
+        }
+      });
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::quantize(const synapse::Tensor &tensor,
+                       const synapse::QuantParams &params)
+    -> synapse::QuantizedTensor {
+  synapse::ProfileScope profile("quantize", {&tensor});
+  check_params(tensor.shape(), params);
+  const synapse::NDArray input =
+      tensor.NDArray::to(synapse::DType::Float32).contiguous();
+  synapse::NDArray values =
+      synapse::NDArray::empty(tensor.shape(), synapse::DType::Int8);
+  const float *src = input.data();
+  int8_t *dst = values.data_ptr<int8_t>();
+  const auto [count, inner] = channels(tensor.shape(), params.axis);
+  synapse::parallel_for(
+      0, input.size(), synapse::GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const size_t c = (i / inner) % count;
+          dst[i] = quantize_value(src[i], params.scales[c],
+                                  params.zero_points[c]);
+        }
+      });
+  profile.set_output(values);
+  return {std::move(values), params};
+}
+
+synapse::Observer::Observer(std::optional<size_t> axis, bool symmetric)
+    : _axis(axis), _symmetric(symmetric), _min(), _max() {}
+
+auto synapse::Observer::observe(const synapse::Tensor &tensor) -> void {
+  if (this->_axis.has_value() && *this->_axis >= tensor.ndim()) {
+    throw std::invalid_argument(
+        std::format("Observer axis {} is out of range for shape {}.",
+                    *this->_axis, tensor.shape()));
+  }
+  const auto [count, inner] = channels(tensor.shape(), this->_axis);
+  if (this->_min.empty()) {
+    this->_min.assign(count, std::numeric_limits<float>::infinity());
+    this->_max.assign(count, -std::numeric_limits<float>::infinity());
+  } else if (this->_min.size() != count) {
+    throw std::invalid_argument(
+        std::format("Observer saw {} channels before, got shape {}.",
+                    this->_min.size(), tensor.shape()));
+  }
+  const synapse::NDArray input =
+      tensor.NDArray::to(synapse::DType::Float32).contiguous();
+  const float *src = input.data();
+  for (size_t i = 0; i < input.size(); ++i) {
+    const size_t c = (i / inner) % count;
+    this->_min[c] = std::min(this->_min[c], src[i]);
+    this->_max[c] = std::max(this->_max[c], src[i]);
+  }
+}
+
+auto synapse::Observer::operator()(const synapse::Tensor &tensor)
+    -> const synapse::Tensor & {
+  this->observe(tensor);
+  return tensor;
+}
+
+auto synapse::Observer::params() const -> synapse::QuantParams {
+  if (this->_min.empty()) {
+    throw std::logic_error("The observer has not seen any tensor.");
+  }
+  synapse::QuantParams out{{}, {}, this->_axis};
+  for (size_t c = 0; c < this->_min.size(); ++c) {
+    // Empty tensors leave an inverted range, which maps to the unit scale
+    const synapse::QuantParams channel = synapse::QuantParams::from_range(
+        std::min(this->_min[c], this->_max[c]), this->_max[c],
+        this->_symmetric);
+    out.scales.push_back(channel.scales[0]);
+    out.zero_points.push_back(channel.zero_points[0]);
+  }
+  return out;
+}
+
+auto synapse::quantized_matmul(const synapse::QuantizedTensor &lhs,
+                               const synapse::QuantizedTensor &rhs)
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("quantized_matmul",
+                                {&lhs.values(), &rhs.values()});
+  synapse::Tensor out = synapse::Tensor::empty(check_product(lhs, rhs));
+  quantized_product(lhs, rhs, {}, out.data());
+  profile.set_output(out, 2 * out.size() * lhs.shape()[1]);
+  return out;
+}
+
+auto synapse::quantized_matmul(const synapse::QuantizedTensor &lhs,
+                               const synapse::QuantizedTensor &rhs,
+                               const synapse::QuantParams &output)
+    -> synapse::QuantizedTensor {
+  synapse::ProfileScope profile("quantized_matmul",
+                                {&lhs.values(), &rhs.values()});
+  check_output(output);
+  synapse::NDArray out = synapse::NDArray::empty(check_product(lhs, rhs),
+                                                 synapse::DType::Int8);
+  quantized_product(
+      lhs, rhs,
+      {.out_scale = output.scales[0], .out_zero_point = output.zero_points[0]},
+      out.data_ptr<int8_t>());
+  profile.set_output(out, 2 * out.size() * lhs.shape()[1]);
+  return {std::move(out), output};
+}
+
+synapse::nn::QuantizedLinear::QuantizedLinear(
+    synapse::nn::Linear &layer, std::optional<synapse::QuantParams> input)
+    : _weight(quantize_weight(layer.weight())),
+      _packed(this->_weight.shape()[1], this->_weight.shape()[0],
+              this->_weight.values().data_ptr<int8_t>(),
+              this->_weight.values().strides()[1],
+              this->_weight.values().strides()[0]),
+      _bias(layer.parameters().size() > 1
+                ? std::optional<synapse::Tensor>(layer.bias())
+                : std::nullopt),
+      _activation(layer.activation()), _input(std::move(input)) {
+  if (this->_input.has_value() && this->_input->per_channel()) {
+    throw std::invalid_argument(
+        "Quantized linear layers need per-tensor input parameters.");
+  }
+}
+
+auto synapse::nn::QuantizedLinear::forward(const synapse::Tensor &input) const
+    -> synapse::Tensor {
+  synapse::ProfileScope profile("quantized_linear", {&input});
+  const size_t in_features = this->_weight.shape()[1];
+  const size_t out_features = this->_weight.shape()[0];
+  if (input.ndim() == 0 || input.shape().back() != in_features) {
+    throw std::invalid_argument(
+        std::format("Linear layer is invalid. Found input shape {} and "
+                    "weight shape {}.",
+                    input.shape(), this->_weight.shape()));
+  }
+  const synapse::QuantizedTensor quantized = synapse::quantize(
+      input, this->_input.has_value() ? *this->_input : dynamic_params(input));
+  synapse::Shape out_shape = input.shape();
+  out_shape.back() = out_features;
+  synapse::Tensor out = synapse::Tensor::empty(out_shape);
+  const size_t rows = input.size() / std::max<size_t>(in_features, 1);
+  const synapse::NDArray lhs =
+      quantized.values().reshape({rows, in_features});
+  std::vector<float> scales;
+  synapse::igemm(rows, lhs.data_ptr<int8_t>(), lhs.strides()[0],
+                 lhs.strides()[1], this->_packed, out.data(), out_features,
+                 with_operands(this->_requantization(), quantized.params(),
+                               this->_weight.params(), scales));
+  profile.set_output(out, 2 * rows * out_features * in_features);
+  return out;
+}
+
+auto synapse::nn::QuantizedLinear::forward(
+    const synapse::QuantizedTensor &input,
+    const synapse::QuantParams &output) const -> synapse::QuantizedTensor {
+  synapse::ProfileScope profile("quantized_linear", {&input.values()});
+  const size_t in_features = this->_weight.shape()[1];
+  const size_t out_features = this->_weight.shape()[0];
+  if (input.shape().empty() || input.shape().back() != in_features ||
+      input.params().per_channel()) {
+    throw std::invalid_argument(
+        std::format("Quantized linear layer is invalid. Found input shape {} "
+                    "and weight shape {}, with a per-tensor input needed.",
+                    input.shape(), this->_weight.shape()));
+  }
+  check_output(output);
+  synapse::Shape out_shape = input.shape();
+  out_shape.back() = out_features;
+  synapse::NDArray out =
+      synapse::NDArray::empty(out_shape, synapse::DType::Int8);
+  const size_t rows = input.values().size() / std::max<size_t>(in_features, 1);
+  const synapse::NDArray lhs = input.values().reshape({rows, in_features});
+  synapse::Requantization requantization = this->_requantization();
+  requantization.out_scale = output.scales[0];
+  requantization.out_zero_point = output.zero_points[0];
+  std::vector<float> scales;
+  synapse::igemm(rows, lhs.data_ptr<int8_t>(), lhs.strides()[0],
+                 lhs.strides()[1], this->_packed, out.data_ptr<int8_t>(),
+                 out_features,
+                 with_operands(requantization, input.params(),
+                               this->_weight.params(), scales));
+  profile.set_output(out, 2 * rows * out_features * in_features);
+  return {std::move(out), output};
+}
+
+auto synapse::nn::QuantizedLinear::weight() const
+    -> const synapse::QuantizedTensor & {
+  return this->_weight;
+}
+
+auto synapse::nn::QuantizedLinear::_requantization() const
+    -> synapse::Requantization {
+  return {.bias = this->_bias.has_value() ? this->_bias->data() : nullptr,
+          .cs_bias = this->_bias.has_value() ? this->_bias->strides()[0] : 1,
+          .activation = this->_activation};
+}
@@ -0,0 +1,498 @@
+#include "sparse.h"
+#include "autograd.h"
+#include "dtype.h"
+#include "ndarray.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+using Saved = std::vector<synapse::Tensor>;
+using Gradients = synapse::Node::Gradients;
+
+auto check_shape(const synapse::Shape &shape) -> void {
+  if (shape.size() != 2) {
+    throw std::invalid_argument(std::format(
+        "Sparse tensors are 2-dimensional, found shape {}.", shape));
+  }
+}
+
+auto check_indices(const std::vector<size_t> &indices, size_t bound,
+                   const char *name) -> void {
+  for (const size_t index : indices) {
+    if (index >= bound) {
+      throw std::invalid_argument(std::format(
+          "Sparse {} index {} is out of range for size {}.", name, index,
+          bound));
+    }
+  }
+}
+
+// Whether the triplets are sorted by row then column, without duplicates
+auto is_coalesced(const std::vector<size_t> &rows,
+                  const std::vector<size_t> &cols) -> bool {
+  for (size_t i = 1; i < rows.size(); ++i) {
+    if (rows[i] < rows[i - 1] ||
+        (rows[i] == rows[i - 1] && cols[i] <= cols[i - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sorts the triplets by row then column and sums the duplicates, in place
+auto coalesce(std::vector<size_t> &rows, std::vector<size_t> &cols,
+              std::vector<float> &values) -> void {
+  if (is_coalesced(rows, cols)) {
+    return;
+  }
+  std::vector<size_t> order(rows.size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::ranges::stable_sort(order, [&](size_t lhs, size_t rhs) {
+    return rows[lhs] != rows[rhs] ? rows[lhs] < rows[rhs]
+                                  : cols[lhs] < cols[rhs];
+  });
+  std::vector<size_t> out_rows;
+  std::vector<size_t> out_cols;
+  std::vector<float> out_values;
+  out_rows.reserve(order.size());
+  out_cols.reserve(order.size());
+  out_values.reserve(order.size());
+  for (const size_t i : order) {
+    if (!out_rows.empty() && out_rows.back() == rows[i] &&
+        out_cols.back() == cols[i]) {
+      out_values.back() += values[i];
+    } else {
+      out_rows.push_back(rows[i]);
+      out_cols.push_back(cols[i]);
+      out_values.push_back(values[i]);
+    }
+  }
+  rows = std::move(out_rows);
+  cols = std::move(out_cols);
+  values = std::move(out_values);
+}
+
+// Row offsets of coalesced triplets
+auto compress(const std::vector<size_t> &rows, size_t num_rows)
+    -> std::vector<size_t> {
+  std::vector<size_t> offsets(num_rows + 1, 0);
+  for (const size_t row : rows) {
+    ++offsets[row + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  return offsets;
+}
+
+// Row of every nonzero, from row offsets
+auto expand(const std::vector<size_t> &offsets) -> std::vector<size_t> {
+  std::vector<size_t> rows(offsets.empty() ? 0 : offsets.back());
+  for (size_t row = 0; row + 1 < offsets.size(); ++row) {
+    std::fill(rows.begin() + static_cast<std::ptrdiff_t>(offsets[row]),
+              rows.begin() + static_cast<std::ptrdiff_t>(offsets[row + 1]),
+              row);
+  }
+  return rows;
+}
+
+// Row offsets of `sparse`, computed for COO
+auto offsets_of(const synapse::SparseTensor &sparse) -> std::vector<size_t> {
+  return sparse.layout() == synapse::SparseLayout::Csr
+             ? sparse.row_offsets()
+             : compress(sparse.row_indices(), sparse.shape()[0]);
+}
+
+// Row of every nonzero of `sparse`, computed for CSR
+auto rows_of(const synapse::SparseTensor &sparse) -> std::vector<size_t> {
+  return sparse.layout() == synapse::SparseLayout::Coo
+             ? sparse.row_indices()
+             : expand(sparse.row_offsets());
+}
+
+// Rows per chunk so that a chunk does about GRAIN_SIZE operations
+auto row_grain(const synapse::SparseTensor &sparse, size_t row_cost)
+    -> size_t {
+  const size_t rows = std::max<size_t>(sparse.shape()[0], 1);
+  const size_t per_row = std::max<size_t>(sparse.nnz() / rows, 1) * row_cost;
+  return std::max<size_t>(synapse::GRAIN_SIZE / std::max<size_t>(per_row, 1),
+                          1);
+}
+
+auto check_broadcast(const synapse::SparseTensor &sparse,
+                     const synapse::Tensor &dense) -> void {
+  if (synapse::shape_broadcast(sparse.shape(), dense.shape()) !=
+      sparse.shape()) {
+    throw std::invalid_argument(
+        std::format("Dense shape {} cannot be broadcasted to sparse shape {}.",
+                    dense.shape(), sparse.shape()));
+  }
+}
+} // namespace
+
+synapse::SparseTensor::SparseTensor(synapse::SparseLayout layout,
+                                    synapse::Shape shape,
+                                    std::vector<size_t> rows,
+                                    std::vector<size_t> cols,
+                                    std::vector<float> values)
+    : _layout(layout), _shape(std::move(shape)), _rows(std::move(rows)),
+      _cols(std::move(cols)), _values(std::move(values)) {}
+
+auto synapse::SparseTensor::coo(const synapse::Shape &shape,
+                                std::vector<size_t> rows,
+                                std::vector<size_t> cols,
+                                std::vector<float> values)
+    -> synapse::SparseTensor {
+  check_shape(shape);
+  if (rows.size() != values.size() || cols.size() != values.size()) {
+    throw std::invalid_argument(std::format(
+        "COO tensor has {} rows and {} columns for {} values.", rows.size(),
+        cols.size(), values.size()));
+  }
+  check_indices(rows, shape[0], "row");
+  check_indices(cols, shape[1], "column");
+  coalesce(rows, cols, values);
+  return {synapse::SparseLayout::Coo, shape, std::move(rows), std::move(cols),
+          std::move(values)};
+}
+
+auto synapse::SparseTensor::csr(const synapse::Shape &shape,
+                                std::vector<size_t> row_offsets,
+                                std::vector<size_t> cols,
+                                std::vector<float> values)
+    -> synapse::SparseTensor {
+  check_shape(shape);
+  if (cols.size() != values.size() || row_offsets.size() != shape[0] + 1 ||
+      row_offsets.front() != 0 || row_offsets.back() != values.size() ||
+      !std::ranges::is_sorted(row_offsets)) {
+    throw std::invalid_argument(std::format(
+        "CSR tensor of shape {} has invalid row offsets {} for {} columns and "
+        "{} values.",
+        shape, row_offsets, cols.size(), values.size()));
+  }
+  check_indices(cols, shape[1], "column");
+  std::vector<size_t> rows = expand(row_offsets);
+  if (!is_coalesced(rows, cols)) {
+    coalesce(rows, cols, values);
+    row_offsets = compress(rows, shape[0]);
+  }
+  return {synapse::SparseLayout::Csr, shape, std::move(row_offsets),
+          std::move(cols), std::move(values)};
+}
+
+auto synapse::SparseTensor::from_dense(const synapse::Tensor &dense,
+                                       synapse::SparseLayout layout)
+    -> synapse::SparseTensor {
+  synapse::ProfileScope profile("to_sparse", {&dense});
+  check_shape(dense.shape());
+  const synapse::NDArray src =
+      dense.NDArray::to(synapse::DType::Float32).contiguous();
+  const size_t num_rows = dense.shape()[0];
+  const size_t num_cols = dense.shape()[1];
+  const float *data = src.data();
+  const size_t grain =
+      std::max<size_t>(synapse::GRAIN_SIZE / std::max<size_t>(num_cols, 1), 1);
+
+  // Counts the nonzeros of every row, then writes them at their offsets
+  std::vector<size_t> offsets(num_rows + 1, 0);
+  synapse::parallel_for(0, num_rows, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      offsets[i + 1] = static_cast<size_t>(
+          std::count_if(data + (i * num_cols), data + ((i + 1) * num_cols),
+                        [](float value) { return value != 0.0F; }));
+    }
+  });
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<size_t> cols(offsets.back());
+  std::vector<float> values(offsets.back());
+  synapse::parallel_for(0, num_rows, grain, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      size_t pos = offsets[i];
+      for (size_t j = 0; j < num_cols; ++j) {
+        const float value = data[(i * num_cols) + j];
+        if (value != 0.0F) {
+          cols[pos] = j;
+          values[pos] = value;
+          ++pos;
+        }
+      }
+    }
+  });
+  synapse::SparseTensor out(synapse::SparseLayout::Csr, dense.shape(),
+                            std::move(offsets), std::move(cols),
+                            std::move(values));
+  return layout == synapse::SparseLayout::Csr ? out : out.to(layout);
+}
+
+auto synapse::SparseTensor::layout() const -> synapse::SparseLayout {
+  return this->_layout;
+}
+
+auto synapse::SparseTensor::shape() const -> const synapse::Shape & {
+  return this->_shape;
+}
+
+auto synapse::SparseTensor::nnz() const -> size_t {
+  return this->_values.size();
+}
+
+auto synapse::SparseTensor::row_indices() const
+    -> const std::vector<size_t> & {
+  if (this->_layout != synapse::SparseLayout::Coo) {
+    throw std::logic_error("Row indices are only stored by COO tensors.");
+  }
+  return this->_rows;
+}
+
+auto synapse::SparseTensor::row_offsets() const
+    -> const std::vector<size_t> & {
+  if (this->_layout != synapse::SparseLayout::Csr) {
+    throw std::logic_error("Row offsets are only stored by CSR tensors.");
+  }
+  return this->_rows;
+}
+
+auto synapse::SparseTensor::col_indices() const
+    -> const std::vector<size_t> & {
+  return this->_cols;
+}
+
+auto synapse::SparseTensor::values() const -> const std::vector<float> & {
+  return this->_values;
+}
+
+auto synapse::SparseTensor::to(synapse::SparseLayout layout) const
+    -> synapse::SparseTensor {
+  if (layout == this->_layout) {
+    return *this;
+  }
+  return {layout, this->_shape,
+          layout == synapse::SparseLayout::Csr ? offsets_of(*this)
+                                               : rows_of(*this),
+          this->_cols, this->_values};
+}
+
+auto synapse::SparseTensor::to_dense() const -> synapse::Tensor {
+  synapse::ProfileScope profile("to_dense");
+  synapse::Tensor out = synapse::Tensor::zeros(this->_shape);
+  this->add_to(out);
+  profile.set_output(out);
+  return out;
+}
+
+auto synapse::SparseTensor::transpose() const -> synapse::SparseTensor {
+  // Counting sort by column, stable so that rows stay sorted within columns
+  const size_t num_cols = this->_shape[1];
+  const std::vector<size_t> rows = rows_of(*this);
+  std::vector<size_t> offsets = compress(this->_cols, num_cols);
+  std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+  std::vector<size_t> out_cols(this->nnz());
+  std::vector<float> out_values(this->nnz());
+  for (size_t i = 0; i < this->nnz(); ++i) {
+    const size_t pos = next[this->_cols[i]]++;
+    out_cols[pos] = rows[i];
+    out_values[pos] = this->_values[i];
+  }
+  const synapse::Shape shape{num_cols, this->_shape[0]};
+  if (this->_layout == synapse::SparseLayout::Csr) {
+    return {synapse::SparseLayout::Csr, shape, std::move(offsets),
+            std::move(out_cols), std::move(out_values)};
+  }
+  return {synapse::SparseLayout::Coo, shape, expand(offsets),
+          std::move(out_cols), std::move(out_values)};
+}
+
+auto synapse::SparseTensor::add_to(synapse::NDArray &dense, float alpha) const
+    -> void {
+  if (dense.shape() != this->_shape) {
+    throw std::invalid_argument(
+        std::format("Cannot add a sparse tensor of shape {} to shape {}.",
+                    this->_shape, dense.shape()));
+  }
+  const std::vector<size_t> rows = rows_of(*this);
+  const size_t rs = dense.strides()[0];
+  const size_t cs = dense.strides()[1];
+  synapse::dispatch(dense.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    using C = synapse::compute_type_t<T>;
+    T *data = dense.data_ptr<T>();
+    // Serial, as a broadcasted destination aliases its elements
+    for (size_t i = 0; i < this->nnz(); ++i) {
+      T &element = data[(rows[i] * rs) + (this->_cols[i] * cs)];
+      element = synapse::scalar_cast<T>(
+          static_cast<C>(element) +
+          static_cast<C>(alpha * this->_values[i]));
+    }
+  });
+}
+
+auto synapse::spmm(const synapse::SparseTensor &sparse,
+                   const synapse::Tensor &dense) -> synapse::Tensor {
+  synapse::ProfileScope profile("spmm", {&dense});
+  if (dense.ndim() != 2 || dense.shape()[0] != sparse.shape()[1]) {
+    throw std::invalid_argument(
+        std::format("Cannot multiply sparse shape {} by dense shape {}.",
+                    sparse.shape(), dense.shape()));
+  }
+  const size_t m = sparse.shape()[0];
+  const size_t n = dense.shape()[1];
+  const synapse::NDArray rhs =
+      dense.NDArray::to(synapse::DType::Float32).contiguous();
+  synapse::Tensor out = synapse::Tensor::zeros({m, n});
+  const std::vector<size_t> offsets = offsets_of(sparse);
+  const std::vector<size_t> &cols = sparse.col_indices();
+  const std::vector<float> &values = sparse.values();
+  const float *b = rhs.data();
+  float *c = out.data();
+  synapse::parallel_for(
+      0, m, row_grain(sparse, n), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          float *row = c + (i * n);
+          for (size_t p = offsets[i]; p < offsets[i + 1]; ++p) {
+            const float value = values[p];
+            const float *src = b + (cols[p] * n);
+            for (size_t j = 0; j < n; ++j) {
+              row[j] += value * src[j];
+            }
+          }
+        }
+      });
+  if (synapse::needs_grad({&dense})) {
+    synapse::record(
+        out, "SpmmBackward", {&dense}, {},
+        [transposed = sparse.transpose()](const synapse::Tensor &grad,
+                                          const Saved &) -> Gradients {
+          return synapse::make_gradients(synapse::spmm(transposed, grad));
+        });
+  }
+  profile.set_output(out, 2 * sparse.nnz() * n);
+  return out;
+}
+
+auto synapse::spmv(const synapse::SparseTensor &sparse,
+                   const synapse::Tensor &dense) -> synapse::Tensor {
+  if (dense.ndim() != 1 || dense.shape()[0] != sparse.shape()[1]) {
+    throw std::invalid_argument(
+        std::format("Cannot multiply sparse shape {} by dense shape {}.",
+                    sparse.shape(), dense.shape()));
+  }
+  // A one column spmm, whose inner loop is a single multiply-add
+  return synapse::spmm(sparse, dense.reshape({dense.shape()[0], 1}))
+      .reshape({sparse.shape()[0]});
+}
+
+auto synapse::add(const synapse::SparseTensor &sparse,
+                  const synapse::Tensor &dense) -> synapse::Tensor {
+  synapse::ProfileScope profile("sparse_add", {&dense});
+  check_broadcast(sparse, dense);
+  synapse::Tensor out = synapse::Tensor::empty(
+      sparse.shape(),
+      synapse::promote_types(synapse::DType::Float32, dense.dtype()));
+  out.copy_(dense);
+  sparse.add_to(out);
+  if (synapse::needs_grad({&dense})) {
+    synapse::record(out, "SparseAddBackward", {&dense}, {},
+                    [shape = dense.shape()](const synapse::Tensor &grad,
+                                            const Saved &) -> Gradients {
+                      return synapse::make_gradients(
+                          synapse::sum_to(grad, shape));
+                    });
+  }
+  profile.set_output(out, sparse.nnz());
+  return out;
+}
+
+auto synapse::add(const synapse::Tensor &dense,
+                  const synapse::SparseTensor &sparse) -> synapse::Tensor {
+  return synapse::add(sparse, dense);
+}
+
+auto synapse::mul(const synapse::SparseTensor &sparse,
+                  const synapse::Tensor &dense) -> synapse::SparseTensor {
+  synapse::ProfileScope profile("sparse_mul", {&dense});
+  check_broadcast(sparse, dense);
+  // A sparse result has no graph to record the product on
+  if (synapse::needs_grad({&dense})) {
+    throw std::logic_error(
+        "The sparse-dense product is not differentiable, detach the dense "
+        "operand or multiply with to_dense().");
+  }
+  const synapse::NDArray rhs = dense.NDArray::broadcast_to(sparse.shape());
+  const std::vector<size_t> rows = rows_of(sparse);
+  const std::vector<size_t> &cols = sparse.col_indices();
+  std::vector<float> values = sparse.values();
+  const size_t rs = rhs.strides()[0];
+  const size_t cs = rhs.strides()[1];
+  synapse::dispatch(rhs.dtype(), [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    const T *data = rhs.data_ptr<T>();
+    synapse::parallel_for(
+        0, values.size(), synapse::GRAIN_SIZE, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            values[i] *= synapse::scalar_cast<float>(
+                data[(rows[i] * rs) + (cols[i] * cs)]);
+          }
+        });
+  });
+  synapse::SparseTensor out =
+      sparse.layout() == synapse::SparseLayout::Coo
+          ? synapse::SparseTensor::coo(sparse.shape(), rows, cols,
+                                       std::move(values))
+          : synapse::SparseTensor::csr(sparse.shape(), sparse.row_offsets(),
+                                       cols, std::move(values));
+  profile.add_bytes(out.nnz() * sizeof(float));
+  return out;
+}
+
+auto synapse::mul(const synapse::Tensor &dense,
+                  const synapse::SparseTensor &sparse)
+    -> synapse::SparseTensor {
+  return synapse::mul(sparse, dense);
+}
+
+auto synapse::add(const synapse::SparseTensor &lhs,
+                  const synapse::SparseTensor &rhs) -> synapse::SparseTensor {
+  if (lhs.shape() != rhs.shape()) {
+    throw std::invalid_argument(
+        std::format("Cannot add sparse shapes {} and {}.", lhs.shape(),
+                    rhs.shape()));
+  }
+  // Merges the two sorted lists of nonzeros
+  const std::vector<size_t> lhs_rows = rows_of(lhs);
+  const std::vector<size_t> rhs_rows = rows_of(rhs);
+  const std::vector<size_t> &lhs_cols = lhs.col_indices();
+  const std::vector<size_t> &rhs_cols = rhs.col_indices();
+  std::vector<size_t> rows;
+  std::vector<size_t> cols;
+  std::vector<float> values;
+  rows.reserve(lhs.nnz() + rhs.nnz());
+  cols.reserve(lhs.nnz() + rhs.nnz());
+  values.reserve(lhs.nnz() + rhs.nnz());
+  size_t i = 0;
+  size_t j = 0;
+  while (i < lhs.nnz() || j < rhs.nnz()) {
+    const bool take_lhs =
+        j == rhs.nnz() ||
+        (i < lhs.nnz() && std::pair(lhs_rows[i], lhs_cols[i]) <=
+                              std::pair(rhs_rows[j], rhs_cols[j]));
+    const bool take_rhs =
+        i == lhs.nnz() ||
+        (j < rhs.nnz() && std::pair(rhs_rows[j], rhs_cols[j]) <=
+                              std::pair(lhs_rows[i], lhs_cols[i]));
+    rows.push_back(take_lhs ? lhs_rows[i] : rhs_rows[j]);
+    cols.push_back(take_lhs ? lhs_cols[i] : rhs_cols[j]);
+    values.push_back((take_lhs ? lhs.values()[i] : 0.0F) +
+                     (take_rhs ? rhs.values()[j] : 0.0F));
+    i += take_lhs ? 1 : 0;
+    j += take_rhs ? 1 : 0;
+  }
+  const synapse::SparseTensor out = synapse::SparseTensor::coo(
+      lhs.shape(), std::move(rows), std::move(cols), std::move(values));
+  return out.to(lhs.layout());
+}
@@ -0,0 +1,72 @@
+#include "dtype.h"
+#include <cstddef>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+// Rank of a dtype within its category, wider types rank higher
+auto width_rank(synapse::DType dtype) -> int {
+  switch (dtype) {
+  case synapse::DType::Int8:
+    return 0;
+  case synapse::DType::Int32:
+    return 1;
+  case synapse::DType::Float16:
+  case synapse::DType::BFloat16:
+    return 2;
+  case synapse::DType::Float32:
+    return 3;
+  case synapse::DType::Float64:
+    return 4;
+  default:
+    throw std::invalid_argument("Unknown dtype.");
+  }
+}
+} // namespace
+
+auto synapse::dtype_size(synapse::DType dtype) -> size_t {
+  return synapse::dispatch(dtype, [](auto tag) {
+    return sizeof(typename decltype(tag)::type);
+  });
+}
+
+auto synapse::dtype_name(synapse::DType dtype) -> std::string_view {
+  switch (dtype) {
+  case synapse::DType::Float64:
+    return "float64";
+  case synapse::DType::Float32:
+    return "float32";
+  case synapse::DType::Float16:
+    return "float16";
+  case synapse::DType::BFloat16:
+    return "bfloat16";
+  case synapse::DType::Int32:
+    return "int32";
+  case synapse::DType::Int8:
+    return "int8";
+  default:
+    throw std::invalid_argument("Unknown dtype.");
+  }
+}
+
+auto synapse::is_floating_point(synapse::DType dtype) -> bool {
+  return dtype != synapse::DType::Int32 && dtype != synapse::DType::Int8;
+}
+
+auto synapse::promote_types(synapse::DType lhs, synapse::DType rhs)
+    -> synapse::DType {
+  if (lhs == rhs) {
+    return lhs;
+  }
+  const bool lhs_float = synapse::is_floating_point(lhs);
+  if (lhs_float != synapse::is_floating_point(rhs)) {
+    return lhs_float ? lhs : rhs;
+  }
+  const int lhs_rank = width_rank(lhs);
+  const int rhs_rank = width_rank(rhs);
+  if (lhs_rank == rhs_rank) {
+    // Float16 and BFloat16, neither holds the other
+    return synapse::DType::Float32;
+  }
+  return lhs_rank > rhs_rank ? lhs : rhs;
+}
@@ -0,0 +1,212 @@
+#include "dtype.h"
+#include "ndarray.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+namespace {
+// Size of the chunks handed to the sinks
+constexpr size_t CHUNK_BYTES = 4096;
+// Longest fixed or scientific representation tried for an element
+constexpr size_t ELEMENT_BYTES = 128;
+
+auto print_options_mutex() -> std::mutex & {
+  static std::mutex mutex;
+  return mutex;
+}
+
+auto current_print_options() -> synapse::PrintOptions & {
+  static synapse::PrintOptions options;
+  return options;
+}
+
+// Gathers small writes into a fixed buffer handed to the sink once full
+class ChunkWriter {
+public:
+  ChunkWriter(const ChunkWriter &) = delete;
+  ChunkWriter(ChunkWriter &&) = delete;
+  auto operator=(const ChunkWriter &) -> ChunkWriter & = delete;
+  auto operator=(ChunkWriter &&) -> ChunkWriter & = delete;
+
+  explicit ChunkWriter(const std::function<void(std::string_view)> &sink)
+      : _sink(sink), _buffer(), _used(0) {}
+  ~ChunkWriter() = default;
+
+  auto write(std::string_view text) -> void {
+    if (text.size() > CHUNK_BYTES - this->_used) {
+      this->flush();
+    }
+    if (text.size() > CHUNK_BYTES) {
+      this->_sink(text);
+      return;
+    }
+    std::memcpy(this->_buffer.data() + this->_used, text.data(), text.size());
+    this->_used += text.size();
+  }
+
+  auto write_spaces(size_t count) -> void {
+    constexpr std::string_view spaces{"                                "};
+    for (; count > spaces.size(); count -= spaces.size()) {
+      this->write(spaces);
+    }
+    this->write(spaces.substr(0, count));
+  }
+
+  auto flush() -> void {
+    if (this->_used > 0) {
+      this->_sink({this->_buffer.data(), this->_used});
+      this->_used = 0;
+    }
+  }
+
+private:
+  const std::function<void(std::string_view)> &_sink;
+  std::array<char, CHUNK_BYTES> _buffer;
+  size_t _used;
+};
+
+// Writes the elements of an array of `T`, summarized or not
+template <typename T> class ArrayWriter {
+public:
+  ArrayWriter(const synapse::NDArray &array,
+              const synapse::PrintOptions &options, ChunkWriter &out)
+      : _array(array), _data(array.data_ptr<T>()), _out(out),
+        _precision(static_cast<int>(std::min<size_t>(options.precision, 64))),
+        _edge_items(options.edge_items),
+        _summarize(array.size() > options.threshold) {}
+
+  auto write() -> void {
+    if (this->_array.ndim() == 0) {
+      this->_write_element(0);
+    } else {
+      this->_write_dim(0, 0);
+    }
+  }
+
+private:
+  const synapse::NDArray &_array;
+  const T *_data;
+  ChunkWriter &_out;
+  int _precision;
+  size_t _edge_items;
+  bool _summarize;
+
+  // Writes the subarray at `offset` from the first element, starting at
+  // dimension `dim`
+  auto _write_dim(size_t offset, size_t dim) -> void {
+    const size_t length = this->_array.shape()[dim];
+    const size_t stride = this->_array.strides()[dim];
+    const bool innermost = dim + 1 == this->_array.ndim();
+    const bool elide = this->_summarize && length > 2 * this->_edge_items;
+    const auto separate = [this, dim, innermost]() {
+      if (innermost) {
+        this->_out.write(", ");
+      } else {
+        this->_out.write(",\n");
+        this->_out.write_spaces(dim + 1);
+      }
+    };
+    const auto write_item = [this, dim, innermost](size_t pos) {
+      if (innermost) {
+        this->_write_element(pos);
+      } else {
+        this->_write_dim(pos, dim + 1);
+      }
+    };
+
+    this->_out.write("[");
+    for (size_t i = 0; i < length; ++i) {
+      if (i > 0) {
+        separate();
+      }
+      if (elide && i == this->_edge_items) {
+        this->_out.write("...");
+        // Without edges there is no tail to write
+        if (this->_edge_items == 0) {
+          break;
+        }
+        separate();
+        i = length - this->_edge_items;
+      }
+      write_item(offset + (i * stride));
+    }
+    this->_out.write("]");
+  }
+
+  auto _write_element(size_t pos) -> void {
+    std::array<char, ELEMENT_BYTES> buffer{};
+    char *const first = buffer.data();
+    char *const last = first + buffer.size();
+    std::to_chars_result result{};
+    if constexpr (std::is_integral_v<T>) {
+      result =
+          std::to_chars(first, last, static_cast<int64_t>(this->_data[pos]));
+    } else {
+      const auto value =
+          synapse::scalar_cast<synapse::compute_type_t<T>>(this->_data[pos]);
+      result = std::to_chars(first, last, value, std::chars_format::fixed,
+                             this->_precision);
+      // Huge magnitudes do not fit in fixed notation
+      if (result.ec != std::errc{}) {
+        result = std::to_chars(first, last, value,
+                               std::chars_format::scientific, this->_precision);
+      }
+    }
+    this->_out.write({first, result.ptr});
+  }
+};
+} // namespace
+
+auto synapse::print_options() -> synapse::PrintOptions {
+  const std::scoped_lock lock(print_options_mutex());
+  return current_print_options();
+}
+
+auto synapse::set_print_options(const synapse::PrintOptions &options)
+    -> void {
+  const std::scoped_lock lock(print_options_mutex());
+  current_print_options() = options;
+}
+
+auto synapse::write_array(const synapse::NDArray &array,
+                          const synapse::PrintOptions &options,
+                          const std::function<void(std::string_view)> &sink)
+    -> void {
+  if (array.size() == 0) {
+    sink("[]");
+    return;
+  }
+  ChunkWriter out(sink);
+  synapse::dispatch(array.dtype(), [&array, &options, &out](auto tag) {
+    using T = typename decltype(tag)::type;
+    ArrayWriter<T>(array, options, out).write();
+  });
+  out.flush();
+}
+
+auto synapse::operator<<(std::ostream &os, const synapse::NDArray &array)
+    -> std::ostream & {
+  synapse::write_array(array, synapse::print_options(),
+                       [&os](std::string_view chunk) {
+                         os.write(chunk.data(),
+                                  static_cast<std::streamsize>(chunk.size()));
+                       });
+  return os;
+}
+
+auto synapse::NDArray::to_string() const -> std::string {
+  std::string out;
+  synapse::write_array(*this, synapse::print_options(),
+                       [&out](std::string_view chunk) { out.append(chunk); });
+  return out;
+}
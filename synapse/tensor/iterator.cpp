@@ -0,0 +1,137 @@
+#include "iterator.h"
+#include "dtype.h"
+#include "ndarray.h"
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+synapse::TensorIterator::TensorIterator(
+    synapse::NDArray &output,
+    const std::vector<const synapse::NDArray *> &inputs)
+    : synapse::TensorIterator(output.raw_data(), output.dtype(),
+                              output.shape(), output.strides(), inputs) {}
+
+synapse::TensorIterator::TensorIterator(
+    float *output, synapse::Shape shape, synapse::Strides output_strides,
+    const std::vector<const synapse::NDArray *> &inputs)
+    : synapse::TensorIterator(output, synapse::DType::Float32,
+                              std::move(shape), std::move(output_strides),
+                              inputs) {}
+
+synapse::TensorIterator::TensorIterator(
+    void *output, synapse::DType dtype, synapse::Shape shape,
+    synapse::Strides output_strides,
+    const std::vector<const synapse::NDArray *> &inputs)
+    : _output(output), _inputs(), _dtype(dtype), _shape(std::move(shape)),
+      _strides(), _numel(synapse::shape_numel(this->_shape)) {
+  this->_inputs.reserve(inputs.size());
+  this->_strides.reserve(inputs.size() + 1);
+  this->_strides.push_back(std::move(output_strides));
+  for (const synapse::NDArray *input : inputs) {
+    if (input->dtype() != dtype) {
+      throw std::invalid_argument(std::format(
+          "Operands of an iteration must share a dtype, found {} and {}.",
+          synapse::dtype_name(dtype), synapse::dtype_name(input->dtype())));
+    }
+    if (input->ndim() > this->_shape.size()) {
+      throw std::invalid_argument(
+          std::format("Cannot broadcast shape {} to shape {}.", input->shape(),
+                      this->_shape));
+    }
+    // Aligns the input to the right of the output, using stride 0 for
+    // missing and broadcasted dimensions
+    synapse::Strides strides(this->_shape.size(), 0);
+    const size_t lead = this->_shape.size() - input->ndim();
+    for (size_t i = 0; i < input->ndim(); ++i) {
+      if (input->shape()[i] == this->_shape[lead + i]) {
+        strides[lead + i] = input->strides()[i];
+      } else if (input->shape()[i] != 1) {
+        throw std::invalid_argument(
+            std::format("Cannot broadcast shape {} to shape {}.",
+                        input->shape(), this->_shape));
+      }
+    }
+    this->_inputs.push_back(input->raw_data());
+    this->_strides.push_back(std::move(strides));
+  }
+  this->_coalesce();
+}
+
+auto synapse::TensorIterator::shape() const -> const synapse::Shape & {
+  return this->_shape;
+}
+
+auto synapse::TensorIterator::strides(size_t operand) const
+    -> const synapse::Strides & {
+  return this->_strides[operand];
+}
+
+auto synapse::TensorIterator::ninputs() const -> size_t {
+  return this->_inputs.size();
+}
+
+auto synapse::TensorIterator::numel() const -> size_t { return this->_numel; }
+
+auto synapse::TensorIterator::dtype() const -> synapse::DType {
+  return this->_dtype;
+}
+
+auto synapse::TensorIterator::_check_dtype(synapse::DType dtype) const
+    -> void {
+  if (dtype != this->_dtype) {
+    throw std::invalid_argument(
+        std::format("Cannot iterate over {} operands as {}.",
+                    synapse::dtype_name(this->_dtype),
+                    synapse::dtype_name(dtype)));
+  }
+}
+
+auto synapse::TensorIterator::_coalesce() -> void {
+  // Walks from the innermost dimension outwards, merging dimension d into the
+  // last kept one when it is laid out right after it in every operand
+  synapse::Shape shape;
+  std::vector<synapse::Strides> strides(this->_strides.size());
+  for (size_t d = this->_shape.size(); d-- > 0;) {
+    const size_t size = this->_shape[d];
+    if (size == 1) {
+      continue;
+    }
+    bool mergeable = !shape.empty();
+    for (size_t t = 0; mergeable && t < strides.size(); ++t) {
+      mergeable = this->_strides[t][d] == shape.back() * strides[t].back();
+    }
+    if (mergeable) {
+      shape.back() *= size;
+      continue;
+    }
+    shape.push_back(size);
+    for (size_t t = 0; t < strides.size(); ++t) {
+      strides[t].push_back(this->_strides[t][d]);
+    }
+  }
+
+  // Scalars and all-ones shapes still need one dimension to loop over
+  if (shape.empty()) {
+    shape.push_back(1);
+    for (auto &operand : strides) {
+      operand.push_back(0);
+    }
+  }
+
+  // Dimensions were collected innermost first
+  this->_shape.assign(shape.rbegin(), shape.rend());
+  for (size_t t = 0; t < strides.size(); ++t) {
+    this->_strides[t].assign(strides[t].rbegin(), strides[t].rend());
+  }
+}
+
+auto synapse::TensorIterator::_overlapping_output() const -> bool {
+  for (size_t d = 0; d < this->_shape.size(); ++d) {
+    if (this->_shape[d] > 1 && this->_strides[0][d] == 0) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -1,26 +1,162 @@
 #include "ndarray.h"
+#include "dtype.h"
+#include "iterator.h"
+#include "parallel.h"
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <format>
-#include <functional>
-#include <iomanip>
-#include <iostream>
-#include <sstream>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+namespace {
+// Calls `func(pos)` for every element of a strided layout in row-major order,
+// where `pos` is the element offset relative to the first element.
+template <typename Func>
+auto for_each_strided(const synapse::Shape &shape,
+                      const synapse::Strides &strides, Func &&func) -> void {
+  const size_t numel = synapse::shape_numel(shape);
+  if (numel == 0) {
+    return;
+  }
+  const size_t ndim = shape.size();
+  synapse::Shape index(ndim, 0);
+  size_t pos = 0;
+  for (size_t i = 0; i < numel; ++i) {
+    func(pos);
+    for (size_t d = ndim; d-- > 0;) {
+      pos += strides[d];
+      if (++index[d] < shape[d]) {
+        break;
+      }
+      pos -= strides[d] * shape[d];
+      index[d] = 0;
+    }
+  }
+}
+
+// Computes the strides that let a view with `old_shape`/`old_strides` be read
+// as `new_shape` without moving data. Dimensions can only be merged or split
+// when they are laid out contiguously relative to each other, otherwise there
+// is no valid answer and false is returned.
+auto view_strides(const synapse::Shape &old_shape,
+                  const synapse::Strides &old_strides,
+                  const synapse::Shape &new_shape, synapse::Strides &out)
+    -> bool {
+  out = synapse::Strides(new_shape.size(), 0);
+  if (old_shape.empty() || synapse::shape_numel(old_shape) == 0) {
+    out = synapse::contiguous_strides(new_shape);
+    return true;
+  }
+
+  size_t view_d = new_shape.size();
+  size_t chunk_base_stride = old_strides.back();
+  size_t tensor_numel = 1;
+  size_t view_numel = 1;
+  for (size_t tensor_d = old_shape.size(); tensor_d-- > 0;) {
+    tensor_numel *= old_shape[tensor_d];
+    // A chunk ends where the next outer dimension is not contiguous with it
+    const bool chunk_end =
+        tensor_d == 0 ||
+        (old_shape[tensor_d - 1] != 1 &&
+         old_strides[tensor_d - 1] != tensor_numel * chunk_base_stride);
+    if (!chunk_end) {
+      continue;
+    }
+    while (view_d > 0 &&
+           (view_numel < tensor_numel || new_shape[view_d - 1] == 1)) {
+      out[view_d - 1] = view_numel * chunk_base_stride;
+      view_numel *= new_shape[view_d - 1];
+      --view_d;
+    }
+    if (view_numel != tensor_numel) {
+      return false;
+    }
+    if (tensor_d > 0) {
+      chunk_base_stride = old_strides[tensor_d - 1];
+      tensor_numel = 1;
+      view_numel = 1;
+    }
+  }
+  return view_d == 0;
+}
+} // namespace
+
 synapse::NDArray::NDArray(std::vector<float> data, synapse::Shape shape)
-    : _data(std::move(data)), _shape(std::move(shape)),
-      _ndim(this->_shape.size()), _size(this->_data.size()) {
+    : _storage(nullptr), _offset(0), _shape(std::move(shape)),
+      _strides(synapse::contiguous_strides(this->_shape)),
+      _ndim(this->_shape.size()), _size(synapse::shape_numel(this->_shape)) {
+  if (data.size() != this->_size) {
+    throw std::invalid_argument(
+        std::format("Data size {} does not match shape {}.", data.size(),
+                    this->_shape));
+  }
+  this->_storage = std::make_shared<synapse::Storage>(std::move(data));
+}
+
+synapse::NDArray::NDArray(const std::vector<float> &data, synapse::Shape shape,
+                          synapse::DType dtype)
+    : synapse::NDArray(synapse::NDArray(data, std::move(shape)).to(dtype)) {}
+
+synapse::NDArray::NDArray(const synapse::NDArray &other)
+    : _storage(other._shares_on_copy()
+                   ? other._storage->share()
+                   : std::make_shared<synapse::Storage>(other._size,
+                                                        other.dtype())),
+      _offset(0), _shape(other._shape),
+      _strides(synapse::contiguous_strides(this->_shape)), _ndim(other._ndim),
+      _size(other._size) {
+  if (!other._shares_on_copy()) {
+    this->copy_(other);
+  }
+}
 
-  // Computes strides where stride_i = shape_i * stride_i-1
-  this->_strides = synapse::Strides(this->_ndim, 0);
-  this->_strides[this->_ndim - 1] = 1;
-  for (size_t i = this->_ndim - 1; i > 0; --i) {
-    this->_strides[i - 1] = this->_shape[i] * this->_strides[i];
+auto synapse::NDArray::operator=(const synapse::NDArray &other)
+    -> synapse::NDArray & {
+  if (this != &other) {
+    *this = synapse::NDArray(other);
   }
+  return *this;
+}
+
+synapse::NDArray::NDArray(std::shared_ptr<synapse::Storage> storage,
+                          size_t offset, synapse::Shape shape,
+                          synapse::Strides strides)
+    : _storage(std::move(storage)), _offset(offset), _shape(std::move(shape)),
+      _strides(std::move(strides)), _ndim(this->_shape.size()),
+      _size(synapse::shape_numel(this->_shape)) {
+  if (this->_strides.size() != this->_ndim) {
+    throw std::invalid_argument(
+        std::format("Shape {} and strides {} have different ranks.",
+                    this->_shape, this->_strides));
+  }
+}
+
+auto synapse::NDArray::empty(const synapse::Shape &shape,
+                             synapse::DType dtype) -> synapse::NDArray {
+  return {std::make_shared<synapse::Storage>(synapse::shape_numel(shape),
+                                             dtype),
+          0, shape, synapse::contiguous_strides(shape)};
+}
+
+auto synapse::NDArray::zeros(const synapse::Shape &shape,
+                             synapse::DType dtype) -> synapse::NDArray {
+  synapse::NDArray out = synapse::NDArray::empty(shape, dtype);
+  // Every dtype represents zero with all bits cleared. Filled with the split
+  // of the element-wise kernels, so fresh pages are first touched by the
+  // workers that later process them (see `NumaPolicy::FirstTouch`).
+  auto *data = static_cast<std::byte *>(out.raw_data());
+  const size_t element_size = out.element_size();
+  synapse::parallel_for(0, out.size(), synapse::GRAIN_SIZE,
+                        [&](size_t begin, size_t end) {
+                          std::fill_n(data + (begin * element_size),
+                                      (end - begin) * element_size,
+                                      std::byte{0});
+                        });
+  return out;
 }
 
 auto synapse::NDArray::shape() const -> const synapse::Shape & {
@@ -31,70 +167,226 @@ auto synapse::NDArray::strides() const -> const synapse::Strides & {
   return this->_strides;
 }
 
-auto synapse::NDArray::data() -> std::vector<float> & { return this->_data; }
-auto synapse::NDArray::data() const -> const std::vector<float> & {
-  return this->_data;
+auto synapse::NDArray::storage() const
+    -> const std::shared_ptr<synapse::Storage> & {
+  return this->_storage;
+}
+
+auto synapse::NDArray::offset() const -> size_t { return this->_offset; }
+
+auto synapse::NDArray::dtype() const -> synapse::DType {
+  return this->_storage->dtype();
+}
+
+auto synapse::NDArray::element_size() const -> size_t {
+  return synapse::dtype_size(this->dtype());
+}
+
+auto synapse::NDArray::raw_data() -> void * {
+  return static_cast<std::byte *>(this->_storage->data()) +
+         (this->_offset * this->element_size());
+}
+auto synapse::NDArray::raw_data() const -> const void * {
+  // Reads never detach a shared buffer
+  return static_cast<const std::byte *>(std::as_const(*this->_storage).data()) +
+         (this->_offset * this->element_size());
+}
+auto synapse::NDArray::data() -> float * {
+  return this->data_ptr<float>();
+}
+auto synapse::NDArray::data() const -> const float * {
+  return this->data_ptr<float>();
 }
 auto synapse::NDArray::ndim() const -> size_t { return this->_ndim; }
 auto synapse::NDArray::size() const -> size_t { return this->_size; }
 
-auto synapse::NDArray::is_contigous() -> bool {
-  if (this->_ndim == 1) {
-    return true;
-  }
-
-  for (size_t i = this->_ndim - 1; i > 0; --i) {
-    if (this->_strides[i - 1] != this->_shape[i] * this->_strides[i]) {
+auto synapse::NDArray::is_contigous() const -> bool {
+  // Size 1 dimensions never move the pointer, so their stride is irrelevant
+  size_t expected = 1;
+  for (size_t i = this->_ndim; i-- > 0;) {
+    if (this->_shape[i] != 1 && this->_strides[i] != expected) {
       return false;
     }
+    expected *= this->_shape[i];
   }
   return true;
 }
 
-auto synapse::NDArray::to_string() const -> std::string {
-  if (this->size() == 0) {
-    return "[]";
-  }
-
-  std::ostringstream oss;
-
-  // Recursive helper function.
-  // 'offset' is the starting index into _data.
-  // 'current_dim' indicates the dimension we are printing (0 is outermost).
-  // 'indent' is the string of spaces to prepend when starting a new line at
-  // this level.
-  std::function<void(size_t, size_t, const std::string &)> rec;
-  rec = [this, &oss, &rec](size_t offset, size_t current_dim,
-                           const std::string &indent) -> void {
-    oss << "[";
-    // If we are at the last dimension, simply print the numbers.
-    if (current_dim == this->ndim() - 1) {
-      for (size_t i = 0; i < this->shape()[current_dim]; i++) {
-        if (i > 0) {
-          oss << ", ";
-        }
-        oss << std::fixed << std::setprecision(3) << this->data()[offset + i];
-      }
-    } else {
-      // Compute the product of the remaining dimensions.
-      size_t subarray_size = 1;
-      for (size_t j = current_dim + 1; j < this->ndim(); j++) {
-        subarray_size *= this->shape()[j];
-      }
-      // Loop over the current dimension.
-      for (size_t i = 0; i < this->shape()[current_dim]; i++) {
-        if (i > 0) {
-          oss << ",\n" << indent << " ";
-        }
-        // Recursively print the subarray.
-        rec(offset + (i * subarray_size), current_dim + 1, indent + " ");
-      }
+auto synapse::NDArray::to_vector() const -> std::vector<float> {
+  std::vector<float> out;
+  out.reserve(this->_size);
+  synapse::dispatch(this->dtype(), [this, &out](auto tag) {
+    using T = typename decltype(tag)::type;
+    const T *src = this->data_ptr<T>();
+    for_each_strided(this->_shape, this->_strides, [&out, src](size_t pos) {
+      out.push_back(synapse::scalar_cast<float>(src[pos]));
+    });
+  });
+  return out;
+}
+
+auto synapse::NDArray::to(synapse::DType dtype) const -> synapse::NDArray {
+  if (dtype == this->dtype()) {
+    return {this->_storage, this->_offset, this->_shape, this->_strides};
+  }
+  const synapse::NDArray src = this->contiguous();
+  synapse::NDArray out = synapse::NDArray::empty(this->_shape, dtype);
+  synapse::convert(src.raw_data(), src.dtype(), out.raw_data(), dtype,
+                   this->_size);
+  return out;
+}
+
+auto synapse::NDArray::_shares_on_copy() const -> bool {
+  // A copy of a view would keep the rest of the storage alive
+  return this->_offset == 0 && this->_size == this->_storage->size() &&
+         this->is_contigous() && this->_storage->shareable();
+}
+
+auto synapse::NDArray::_check_dtype(synapse::DType dtype) const -> void {
+  if (dtype != this->dtype()) {
+    throw std::invalid_argument(std::format(
+        "Cannot access {} elements as {}.",
+        synapse::dtype_name(this->dtype()), synapse::dtype_name(dtype)));
+  }
+}
+
+auto synapse::NDArray::slice(size_t dim, size_t start, size_t end,
+                             size_t step) const -> synapse::NDArray {
+  if (dim >= this->_ndim) {
+    throw std::out_of_range(std::format(
+        "Dimension {} is out of range for a {}D array.", dim, this->_ndim));
+  }
+  end = std::min(end, this->_shape[dim]);
+  if (step == 0 || start > end) {
+    throw std::out_of_range(std::format(
+        "Invalid slice [{}, {}) with step {} for dimension {} of size {}.",
+        start, end, step, dim, this->_shape[dim]));
+  }
+
+  synapse::Shape shape = this->_shape;
+  synapse::Strides strides = this->_strides;
+  shape[dim] = (end - start + step - 1) / step;
+  strides[dim] *= step;
+  const size_t offset =
+      shape[dim] == 0 ? this->_offset
+                      : this->_offset + (start * this->_strides[dim]);
+  return {this->_storage, offset, std::move(shape), std::move(strides)};
+}
+
+auto synapse::NDArray::transpose(size_t dim_0, size_t dim_1) const
+    -> synapse::NDArray {
+  if (dim_0 >= this->_ndim || dim_1 >= this->_ndim) {
+    throw std::out_of_range(
+        std::format("Cannot transpose dimensions {} and {} of a {}D array.",
+                    dim_0, dim_1, this->_ndim));
+  }
+  synapse::Shape shape = this->_shape;
+  synapse::Strides strides = this->_strides;
+  std::swap(shape[dim_0], shape[dim_1]);
+  std::swap(strides[dim_0], strides[dim_1]);
+  return {this->_storage, this->_offset, std::move(shape), std::move(strides)};
+}
+
+auto synapse::NDArray::permute(const synapse::Shape &dims) const
+    -> synapse::NDArray {
+  if (dims.size() != this->_ndim) {
+    throw std::invalid_argument(std::format(
+        "Permutation {} does not match a {}D array.", dims, this->_ndim));
+  }
+  std::vector<bool> seen(this->_ndim, false);
+  synapse::Shape shape(this->_ndim);
+  synapse::Strides strides(this->_ndim);
+  for (size_t i = 0; i < dims.size(); ++i) {
+    if (dims[i] >= this->_ndim || seen[dims[i]]) {
+      throw std::invalid_argument(
+          std::format("{} is not a valid permutation.", dims));
     }
-    oss << "]";
-  };
+    seen[dims[i]] = true;
+    shape[i] = this->_shape[dims[i]];
+    strides[i] = this->_strides[dims[i]];
+  }
+  return {this->_storage, this->_offset, std::move(shape), std::move(strides)};
+}
 
-  rec(0, 0, "");
-  return oss.str();
+auto synapse::NDArray::reshape(const synapse::Shape &shape) const
+    -> synapse::NDArray {
+  if (synapse::shape_numel(shape) != this->_size) {
+    throw std::invalid_argument(
+        std::format("Cannot reshape array of shape {} into shape {}.",
+                    this->_shape, shape));
+  }
+  synapse::Strides strides;
+  if (view_strides(this->_shape, this->_strides, shape, strides)) {
+    return {this->_storage, this->_offset, shape, std::move(strides)};
+  }
+  return this->contiguous().reshape(shape);
+}
+
+auto synapse::NDArray::broadcast_to(const synapse::Shape &shape) const
+    -> synapse::NDArray {
+  if (shape.size() < this->_ndim) {
+    throw std::invalid_argument(
+        std::format("Cannot broadcast shape {} to shape {}.", this->_shape,
+                    shape));
+  }
+  const size_t lead = shape.size() - this->_ndim;
+  synapse::Strides strides(shape.size(), 0);
+  for (size_t i = 0; i < this->_ndim; ++i) {
+    if (this->_shape[i] == shape[lead + i]) {
+      strides[lead + i] = this->_strides[i];
+    } else if (this->_shape[i] != 1) {
+      throw std::invalid_argument(
+          std::format("Cannot broadcast shape {} to shape {}.", this->_shape,
+                      shape));
+    }
+  }
+  return {this->_storage, this->_offset, shape, std::move(strides)};
+}
+
+auto synapse::NDArray::expand(const synapse::Shape &shape) const
+    -> synapse::NDArray {
+  return this->broadcast_to(shape);
+}
+
+auto synapse::NDArray::contiguous() const -> synapse::NDArray {
+  if (this->is_contigous()) {
+    return {this->_storage, this->_offset, this->_shape, this->_strides};
+  }
+  return synapse::NDArray{*this};
+}
+
+auto synapse::NDArray::copy_(const synapse::NDArray &src)
+    -> synapse::NDArray & {
+  const synapse::NDArray converted = src.to(this->dtype());
+  const synapse::TensorIterator iter(*this, {&converted});
+  synapse::dispatch(this->dtype(), [&iter](auto tag) {
+    using T = typename decltype(tag)::type;
+    iter.parallel_for_each<T>([](T *out, const T *const *in,
+                                 const size_t *strides, size_t n) {
+      for (size_t i = 0; i < n; ++i) {
+        out[i * strides[0]] = in[0][i * strides[1]];
+      }
+    });
+  });
+  return *this;
+}
+
+// Computes strides where stride_i = shape_i+1 * stride_i+1
+auto synapse::contiguous_strides(const synapse::Shape &shape)
+    -> synapse::Strides {
+  synapse::Strides strides(shape.size(), 1);
+  for (size_t i = shape.size(); i-- > 1;) {
+    strides[i - 1] = shape[i] * strides[i];
+  }
+  return strides;
+}
+
+auto synapse::shape_numel(const synapse::Shape &shape) -> size_t {
+  size_t numel = 1;
+  for (const size_t dim : shape) {
+    numel *= dim;
+  }
+  return numel;
 }
 
 // Converts an N dimensional index into a position in the vector of data
@@ -0,0 +1,175 @@
+#include "storage.h"
+#include "allocator.h"
+#include "dtype.h"
+#include "lazy.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+// Allocation and release of a buffer, timed as events of their own
+auto allocate(synapse::Allocator &allocator, size_t bytes) -> void * {
+  synapse::ProfileScope profile("allocate");
+  profile.add_bytes(bytes);
+  return allocator.allocate(bytes);
+}
+
+auto deallocate(synapse::Allocator &allocator, void *ptr, size_t bytes)
+    -> void {
+  synapse::ProfileScope profile("deallocate");
+  profile.add_bytes(bytes);
+  allocator.deallocate(ptr, bytes);
+}
+
+// Buffer given back to `allocator` once no storage shares it anymore
+auto own(void *ptr, size_t bytes, std::shared_ptr<synapse::Allocator> allocator)
+    -> std::shared_ptr<void> {
+  return {ptr, [bytes, allocator = std::move(allocator)](void *buffer) {
+            deallocate(*allocator, buffer, bytes);
+          }};
+}
+} // namespace
+
+struct synapse::Storage::Deferred {
+  std::once_flag once;
+  std::atomic<bool> done{false};
+  std::mutex mutex;
+  std::shared_ptr<const synapse::LazyExpr> expr;
+};
+
+synapse::Storage::Storage(size_t size, synapse::DType dtype)
+    : synapse::Storage(size, dtype, synapse::current_allocator()) {}
+
+synapse::Storage::Storage(size_t size, synapse::DType dtype,
+                          std::shared_ptr<synapse::Allocator> allocator)
+    : _allocator(std::move(allocator)),
+      _data(allocate(*this->_allocator, size * synapse::dtype_size(dtype))),
+      _size(size), _dtype(dtype), _deferred(nullptr),
+      _buffer(own(this->_data, this->nbytes(), this->_allocator)) {}
+
+synapse::Storage::Storage(const std::vector<float> &data)
+    : synapse::Storage(data.size()) {
+  std::copy(data.begin(), data.end(), static_cast<float *>(this->_data));
+}
+
+synapse::Storage::Storage(size_t size,
+                          std::shared_ptr<const synapse::LazyExpr> expr)
+    : _allocator(synapse::current_allocator()), _data(nullptr), _size(size),
+      _dtype(synapse::DType::Float32),
+      _deferred(std::make_unique<Deferred>()), _buffer(nullptr) {
+  this->_deferred->expr = std::move(expr);
+}
+
+synapse::Storage::Storage(void *data, size_t size, synapse::DType dtype,
+                          std::shared_ptr<void> owner)
+    : _allocator(nullptr), _data(data), _size(size), _dtype(dtype),
+      _deferred(nullptr),
+      // A count of its own, the owner may back several storages
+      _buffer(std::make_shared<std::shared_ptr<void>>(std::move(owner)),
+              data) {}
+
+synapse::Storage::Storage(const synapse::Storage &other,
+                          std::shared_ptr<void> buffer)
+    : _allocator(other._allocator), _data(buffer.get()), _size(other._size),
+      _dtype(other._dtype), _deferred(nullptr), _buffer(std::move(buffer)) {}
+
+synapse::Storage::~Storage() = default;
+
+auto synapse::Storage::data() -> void * {
+  if (this->_deferred) {
+    this->_materialize();
+  }
+  if (this->is_shared()) {
+    this->_detach();
+  }
+  return this->_data;
+}
+
+auto synapse::Storage::data() const -> const void * {
+  if (this->_deferred) {
+    this->_materialize();
+  }
+  return this->_data;
+}
+
+auto synapse::Storage::size() const -> size_t { return this->_size; }
+
+auto synapse::Storage::nbytes() const -> size_t {
+  return this->_size * synapse::dtype_size(this->_dtype);
+}
+
+auto synapse::Storage::dtype() const -> synapse::DType { return this->_dtype; }
+
+auto synapse::Storage::allocator() const
+    -> const std::shared_ptr<synapse::Allocator> & {
+  return this->_allocator;
+}
+
+auto synapse::Storage::share() const -> std::shared_ptr<synapse::Storage> {
+  if (this->_deferred) {
+    this->_materialize();
+  }
+  // The constructor is private
+  return std::shared_ptr<synapse::Storage>(
+      new synapse::Storage(*this, this->_buffer));
+}
+
+auto synapse::Storage::shareable() const -> bool {
+  return this->_allocator == nullptr || this->_allocator->stable_blocks();
+}
+
+auto synapse::Storage::is_shared() const -> bool {
+  return this->_buffer.use_count() > 1;
+}
+
+auto synapse::Storage::pending() const -> bool {
+  return this->_deferred &&
+         !this->_deferred->done.load(std::memory_order_acquire);
+}
+
+auto synapse::Storage::expr() const
+    -> std::shared_ptr<const synapse::LazyExpr> {
+  if (!this->_deferred) {
+    return nullptr;
+  }
+  const std::lock_guard<std::mutex> lock(this->_deferred->mutex);
+  return this->_deferred->expr;
+}
+
+auto synapse::Storage::_materialize() const -> void {
+  std::call_once(this->_deferred->once, [this] {
+    auto *buffer =
+        static_cast<float *>(allocate(*this->_allocator, this->nbytes()));
+    try {
+      synapse::evaluate(*this->expr(), buffer);
+    } catch (...) {
+      deallocate(*this->_allocator, buffer, this->nbytes());
+      throw;
+    }
+    this->_data = buffer;
+    this->_buffer = own(buffer, this->nbytes(), this->_allocator);
+    {
+      // Drops the expression, and with it the operands it kept alive
+      const std::lock_guard<std::mutex> lock(this->_deferred->mutex);
+      this->_deferred->expr.reset();
+    }
+    this->_deferred->done.store(true, std::memory_order_release);
+  });
+}
+
+auto synapse::Storage::_detach() -> void {
+  // Memory the storage does not own is copied to the current allocator
+  if (this->_allocator == nullptr) {
+    this->_allocator = synapse::current_allocator();
+  }
+  void *buffer = allocate(*this->_allocator, this->nbytes());
+  std::copy_n(static_cast<const std::byte *>(this->_data), this->nbytes(),
+              static_cast<std::byte *>(buffer));
+  this->_data = buffer;
+  this->_buffer = own(buffer, this->nbytes(), this->_allocator);
+}
@@ -1,18 +1,243 @@
 #include "tensor.h"
+#include "autograd.h"
+#include "dtype.h"
 #include "ndarray.h"
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+namespace {
+using Saved = std::vector<synapse::Tensor>;
+using Gradients = synapse::Node::Gradients;
+} // namespace
+
 synapse::Tensor::Tensor(std::vector<float> data, synapse::Shape shape)
-    : synapse::NDArray(std::move(data), std::move(shape)) {
+    : synapse::NDArray(std::move(data), std::move(shape)), _autograd(nullptr) {
   // Move the data into the parent class instead of copying
 }
 
+synapse::Tensor::Tensor(const std::vector<float> &data, synapse::Shape shape,
+                        synapse::DType dtype)
+    : synapse::NDArray(data, std::move(shape), dtype), _autograd(nullptr) {}
+
+synapse::Tensor::Tensor(synapse::NDArray array)
+    : synapse::NDArray(std::move(array)), _autograd(nullptr) {
+  // Shares the storage of the array, no elements are copied
+}
+
 synapse::Tensor::~Tensor() = default; // Does not need to deallocate anything
 
+auto synapse::Tensor::empty(const synapse::Shape &shape,
+                            synapse::DType dtype) -> synapse::Tensor {
+  return synapse::Tensor{synapse::NDArray::empty(shape, dtype)};
+}
+
+auto synapse::Tensor::zeros(const synapse::Shape &shape,
+                            synapse::DType dtype) -> synapse::Tensor {
+  return synapse::Tensor{synapse::NDArray::zeros(shape, dtype)};
+}
+
 auto synapse::Tensor::to_string() const -> std::string {
   std::string out;
   out += synapse::NDArray::to_string();
   return out;
 }
+
+auto synapse::Tensor::eval() const -> const synapse::Tensor & {
+  static_cast<void>(this->raw_data());
+  return *this;
+}
+
+auto synapse::Tensor::is_lazy() const -> bool {
+  return this->storage()->pending();
+}
+
+auto synapse::Tensor::slice(size_t dim, size_t start, size_t end,
+                            size_t step) const -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::slice(dim, start, end, step)};
+  if (synapse::needs_grad({this})) {
+    synapse::record(out, "SliceBackward", {this}, {},
+                    [shape = this->shape(), dim, start, end,
+                     step](const synapse::Tensor &grad, const Saved &)
+                        -> Gradients {
+                      // Scatters the gradient back into the sliced region
+                      synapse::Tensor grad_input =
+                          synapse::Tensor::zeros(shape);
+                      grad_input.NDArray::slice(dim, start, end, step)
+                          .copy_(grad);
+                      return synapse::make_gradients(grad_input);
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::transpose(size_t dim_0, size_t dim_1) const
+    -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::transpose(dim_0, dim_1)};
+  if (synapse::needs_grad({this})) {
+    synapse::record(out, "TransposeBackward", {this}, {},
+                    [dim_0, dim_1](const synapse::Tensor &grad,
+                                   const Saved &) -> Gradients {
+                      return synapse::make_gradients(
+                          grad.transpose(dim_0, dim_1));
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::permute(const synapse::Shape &dims) const
+    -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::permute(dims)};
+  if (synapse::needs_grad({this})) {
+    synapse::Shape inverse(dims.size());
+    for (size_t i = 0; i < dims.size(); ++i) {
+      inverse[dims[i]] = i;
+    }
+    synapse::record(out, "PermuteBackward", {this}, {},
+                    [inverse](const synapse::Tensor &grad,
+                              const Saved &) -> Gradients {
+                      return synapse::make_gradients(grad.permute(inverse));
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::reshape(const synapse::Shape &shape) const
+    -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::reshape(shape)};
+  if (synapse::needs_grad({this})) {
+    synapse::record(out, "ReshapeBackward", {this}, {},
+                    [shape = this->shape()](const synapse::Tensor &grad,
+                                            const Saved &) -> Gradients {
+                      return synapse::make_gradients(grad.reshape(shape));
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::broadcast_to(const synapse::Shape &shape) const
+    -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::broadcast_to(shape)};
+  if (synapse::needs_grad({this})) {
+    synapse::record(out, "BroadcastBackward", {this}, {},
+                    [shape = this->shape()](const synapse::Tensor &grad,
+                                            const Saved &) -> Gradients {
+                      return synapse::make_gradients(
+                          synapse::sum_to(grad, shape));
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::expand(const synapse::Shape &shape) const
+    -> synapse::Tensor {
+  return this->broadcast_to(shape);
+}
+
+auto synapse::Tensor::contiguous() const -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::contiguous()};
+  if (synapse::needs_grad({this})) {
+    synapse::record(out, "ContiguousBackward", {this}, {},
+                    [](const synapse::Tensor &grad, const Saved &)
+                        -> Gradients {
+                      return synapse::make_gradients(grad.detach());
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::to(synapse::DType dtype) const -> synapse::Tensor {
+  synapse::Tensor out{synapse::NDArray::to(dtype)};
+  if (synapse::needs_grad({this})) {
+    synapse::record(out, "ToBackward", {this}, {},
+                    [source = this->dtype()](const synapse::Tensor &grad,
+                                             const Saved &) -> Gradients {
+                      return synapse::make_gradients(grad.to(source));
+                    });
+  }
+  return out;
+}
+
+auto synapse::Tensor::set_requires_grad(bool requires_grad)
+    -> synapse::Tensor & {
+  if (!this->is_leaf()) {
+    throw std::logic_error(
+        "requires_grad can only be changed on leaf tensors.");
+  }
+  if (requires_grad && this->dtype() != synapse::DType::Float32) {
+    throw std::invalid_argument(
+        std::format("Only float32 tensors can require gradients, found {}.",
+                    synapse::dtype_name(this->dtype())));
+  }
+  if (!this->_autograd) {
+    this->_autograd = std::make_shared<synapse::AutogradMeta>();
+  }
+  this->_autograd->requires_grad = requires_grad;
+  return *this;
+}
+
+auto synapse::Tensor::requires_grad() const -> bool {
+  return this->_autograd &&
+         (this->_autograd->requires_grad || this->_autograd->grad_fn);
+}
+
+auto synapse::Tensor::is_leaf() const -> bool {
+  return !this->_autograd || !this->_autograd->grad_fn;
+}
+
+auto synapse::Tensor::grad() const -> const synapse::Tensor & {
+  if (!this->has_grad()) {
+    throw std::logic_error("Tensor has no gradient.");
+  }
+  return *this->_autograd->grad;
+}
+
+auto synapse::Tensor::has_grad() const -> bool {
+  return this->_autograd && this->_autograd->grad;
+}
+
+auto synapse::Tensor::zero_grad() -> void {
+  if (this->_autograd) {
+    this->_autograd->grad.reset();
+  }
+}
+
+auto synapse::Tensor::grad_fn() const -> std::shared_ptr<synapse::Node> {
+  return this->_autograd ? this->_autograd->grad_fn : nullptr;
+}
+
+auto synapse::Tensor::set_grad_fn(std::shared_ptr<synapse::Node> grad_fn)
+    -> void {
+  if (!this->_autograd) {
+    this->_autograd = std::make_shared<synapse::AutogradMeta>();
+  }
+  this->_autograd->grad_fn = std::move(grad_fn);
+}
+
+auto synapse::Tensor::autograd_meta() const
+    -> const std::shared_ptr<synapse::AutogradMeta> & {
+  return this->_autograd;
+}
+
+auto synapse::Tensor::detach() const -> synapse::Tensor {
+  return synapse::Tensor{synapse::NDArray{this->storage(), this->offset(),
+                                          this->shape(), this->strides()}};
+}
+
+auto synapse::Tensor::backward(bool retain_graph) const -> void {
+  if (this->size() != 1) {
+    throw std::runtime_error(
+        "Gradients can only be implicitly created for single element tensors.");
+  }
+  synapse::backward(*this, synapse::Tensor{{1.0F}, this->shape()},
+                    retain_graph);
+}
+
+auto synapse::Tensor::backward(const synapse::Tensor &grad,
+                               bool retain_graph) const -> void {
+  synapse::backward(*this, grad, retain_graph);
+}
@@ -0,0 +1,123 @@
+#include "allocator.h"
+#include "func.h"
+#include "ndarray.h"
+#include "storage.h"
+#include "tensor.h"
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+TEST(AllocatorTests, SizeClasses) {
+  EXPECT_EQ(synapse::CachingAllocator::size_class(1), 64);
+  EXPECT_EQ(synapse::CachingAllocator::size_class(64), 64);
+  EXPECT_EQ(synapse::CachingAllocator::size_class(65), 128);
+  EXPECT_EQ(synapse::CachingAllocator::size_class(1000), 1024);
+  EXPECT_EQ(synapse::CachingAllocator::size_class(1025), 1280);
+  EXPECT_EQ(synapse::CachingAllocator::size_class(4096), 4096);
+}
+
+TEST(AllocatorTests, CachingAllocatorReusesBlocks) {
+  synapse::CachingAllocator allocator;
+  void *first = allocator.allocate(1000);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) %
+                synapse::Allocator::alignment,
+            0);
+  allocator.deallocate(first, 1000);
+  // Same size class, so the cached block comes back
+  void *second = allocator.allocate(900);
+  EXPECT_EQ(first, second);
+
+  synapse::AllocatorStats stats = allocator.stats();
+  EXPECT_EQ(stats.allocations, 2);
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.live_bytes, 1024);
+  EXPECT_EQ(stats.peak_bytes, 1024);
+  EXPECT_EQ(stats.cached_bytes, 0);
+
+  allocator.deallocate(second, 900);
+  stats = allocator.stats();
+  EXPECT_EQ(stats.live_bytes, 0);
+  EXPECT_EQ(stats.cached_bytes, 1024);
+  allocator.empty_cache();
+  EXPECT_EQ(allocator.stats().cached_bytes, 0);
+  EXPECT_EQ(allocator.allocate(0), nullptr);
+}
+
+TEST(AllocatorTests, CachingAllocatorRespectsCacheLimit) {
+  synapse::CachingAllocator allocator(128);
+  void *small = allocator.allocate(64);
+  void *large = allocator.allocate(256);
+  allocator.deallocate(large, 256);
+  allocator.deallocate(small, 64);
+  EXPECT_EQ(allocator.stats().cached_bytes, 64);
+}
+
+TEST(AllocatorTests, ArenaRewindsOnceEmpty) {
+  synapse::Arena arena(256);
+  void *first = arena.allocate(100);
+  void *second = arena.allocate(100);
+  EXPECT_EQ(static_cast<std::byte *>(second) - static_cast<std::byte *>(first),
+            128);
+  // Does not fit in the first chunk anymore
+  void *third = arena.allocate(100);
+  EXPECT_EQ(arena.capacity(), 512);
+  EXPECT_EQ(arena.stats().misses, 2);
+
+  arena.deallocate(first, 100);
+  arena.deallocate(second, 100);
+  arena.deallocate(third, 100);
+  EXPECT_EQ(arena.stats().live_bytes, 0);
+  EXPECT_EQ(arena.stats().peak_bytes, 384);
+
+  // The next round fits in the merged chunk
+  arena.reset_peak();
+  for (int i = 0; i < 3; ++i) {
+    static_cast<void>(arena.allocate(100));
+  }
+  const synapse::AllocatorStats stats = arena.stats();
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.hits, 4);
+  EXPECT_EQ(stats.peak_bytes, 384);
+}
+
+TEST(AllocatorTests, StoragesAreAligned) {
+  const synapse::Tensor tensor{std::vector<float>{1.0F, 2.0F, 3.0F},
+                               synapse::Shape{3}};
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(tensor.data()) %
+                synapse::Allocator::alignment,
+            0);
+  EXPECT_EQ(tensor.storage()->allocator(), synapse::default_allocator());
+}
+
+TEST(AllocatorTests, GuardRedirectsNewStorages) {
+  const auto arena = std::make_shared<synapse::Arena>();
+  const synapse::Tensor lhs{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2}};
+  std::shared_ptr<synapse::Storage> kept;
+  {
+    const synapse::AllocatorGuard guard(arena);
+    EXPECT_EQ(synapse::current_allocator(), arena);
+    const synapse::Tensor sum = synapse::add(lhs, lhs);
+    const synapse::Tensor prod = synapse::mul(sum, lhs);
+    EXPECT_EQ(prod.to_vector(), (std::vector<float>{2.0F, 8.0F}));
+    EXPECT_EQ(arena.get(), prod.storage()->allocator().get());
+    EXPECT_EQ(arena->stats().allocations, 2);
+    kept = prod.storage();
+  }
+  EXPECT_EQ(synapse::current_allocator(), synapse::default_allocator());
+  // Tensors may outlive the guard
+  EXPECT_EQ(static_cast<const float *>(kept->data())[1], 8.0F);
+  EXPECT_EQ(arena->stats().live_bytes, synapse::Allocator::alignment);
+  kept.reset();
+  EXPECT_EQ(arena->stats().live_bytes, 0);
+}
+
+TEST(AllocatorTests, ZerosAndEmptyFactories) {
+  const synapse::Tensor zeros = synapse::Tensor::zeros({2, 3});
+  EXPECT_EQ(zeros.to_vector(), std::vector<float>(6, 0.0F));
+  const synapse::Tensor empty = synapse::Tensor::empty({4});
+  EXPECT_EQ(empty.shape(), (synapse::Shape{4}));
+  EXPECT_TRUE(empty.is_contigous());
+}
@@ -0,0 +1,257 @@
+#include "autograd.h"
+#include "func.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <cstddef>
+#include <functional>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Central finite differences of sum(fn(x)) w.r.t. every element of x
+auto numeric_grad(
+    const std::function<synapse::Tensor(const synapse::Tensor &)> &fn,
+    const synapse::Tensor &input) -> std::vector<float> {
+  const float eps = 1e-2F;
+  std::vector<float> values = input.to_vector();
+  std::vector<float> out(values.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    const float original = values[i];
+    values[i] = original + eps;
+    const auto plus = fn(synapse::Tensor{values, input.shape()}).to_vector();
+    values[i] = original - eps;
+    const auto minus = fn(synapse::Tensor{values, input.shape()}).to_vector();
+    values[i] = original;
+    float diff = 0.0F;
+    for (size_t j = 0; j < plus.size(); ++j) {
+      diff += plus[j] - minus[j];
+    }
+    out[i] = diff / (2.0F * eps);
+  }
+  return out;
+}
+
+auto expect_grad_matches(
+    const std::function<synapse::Tensor(const synapse::Tensor &)> &fn,
+    std::vector<float> values, const synapse::Shape &shape) -> void {
+  synapse::Tensor input{std::move(values), shape};
+  input.set_requires_grad();
+  const synapse::Tensor out = fn(input);
+  out.backward(synapse::Tensor{std::vector<float>(out.size(), 1.0F),
+                               out.shape()});
+  const auto expected = numeric_grad(fn, input);
+  const auto actual = input.grad().to_vector();
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_NEAR(actual[i], expected[i], 2e-2F) << "at position " << i;
+  }
+}
+} // namespace
+
+TEST(AutogradTests, LeafRequiresGrad) {
+  synapse::Tensor leaf{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2}};
+  EXPECT_FALSE(leaf.requires_grad());
+  leaf.set_requires_grad();
+  EXPECT_TRUE(leaf.requires_grad());
+  EXPECT_TRUE(leaf.is_leaf());
+  EXPECT_FALSE(leaf.has_grad());
+  EXPECT_THROW(static_cast<void>(leaf.grad()), std::logic_error);
+
+  synapse::Tensor out = synapse::mul(leaf, leaf);
+  EXPECT_TRUE(out.requires_grad());
+  EXPECT_FALSE(out.is_leaf());
+  EXPECT_EQ(out.grad_fn()->name(), "MulBackward");
+  EXPECT_THROW(out.set_requires_grad(), std::logic_error);
+}
+
+TEST(AutogradTests, ReusedInputsAccumulate) {
+  synapse::Tensor x{std::vector<float>{1.0F, 2.0F, 3.0F}, synapse::Shape{3}};
+  x.set_requires_grad();
+  // y = x * x + x, dy/dx = 2x + 1
+  synapse::Tensor y = synapse::add(synapse::mul(x, x), x);
+  y.backward(synapse::Tensor{std::vector<float>{1.0F, 1.0F, 1.0F},
+                             synapse::Shape{3}});
+  EXPECT_EQ(x.grad().to_vector(), (std::vector<float>{3.0F, 5.0F, 7.0F}));
+
+  // A second backward through a new graph accumulates into the leaf
+  synapse::Tensor z = synapse::mul(x, x);
+  z.backward(synapse::Tensor{std::vector<float>{1.0F, 1.0F, 1.0F},
+                             synapse::Shape{3}});
+  EXPECT_EQ(x.grad().to_vector(), (std::vector<float>{5.0F, 9.0F, 13.0F}));
+
+  x.zero_grad();
+  EXPECT_FALSE(x.has_grad());
+}
+
+TEST(AutogradTests, BroadcastedGradientsAreReduced) {
+  synapse::Tensor batch{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F},
+                        synapse::Shape{2, 3}};
+  synapse::Tensor bias{std::vector<float>{0.5F, 0.5F, 0.5F}, synapse::Shape{3}};
+  bias.set_requires_grad();
+  batch.set_requires_grad();
+  synapse::Tensor out = synapse::mul(batch, bias);
+  out.backward(synapse::Tensor{std::vector<float>(6, 1.0F), out.shape()});
+  EXPECT_EQ(bias.grad().shape(), (synapse::Shape{3}));
+  EXPECT_EQ(bias.grad().to_vector(), (std::vector<float>{5.0F, 7.0F, 9.0F}));
+  EXPECT_EQ(batch.grad().to_vector(), std::vector<float>(6, 0.5F));
+}
+
+TEST(AutogradTests, ElementwiseGradientsMatchFiniteDifferences) {
+  const std::vector<float> values{0.3F, -1.2F, 2.1F, 0.7F};
+  const synapse::Shape shape{2, 2};
+  const synapse::Tensor other{std::vector<float>{1.5F, -0.5F},
+                              synapse::Shape{2}};
+  const synapse::Tensor offset{std::vector<float>{1.0F, -2.0F, 0.5F, 0.6F},
+                               synapse::Shape{2, 2}};
+
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::sub(other, x); }, values,
+      shape);
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::div(x, other); }, values,
+      shape);
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::div(other, x); }, values,
+      shape);
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::maximum(x, offset); },
+      values, shape);
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::minimum(x, offset); },
+      values, shape);
+  expect_grad_matches([](const synapse::Tensor &x) { return synapse::neg(x); },
+                      values, shape);
+  expect_grad_matches([](const synapse::Tensor &x) { return synapse::abs(x); },
+                      values, shape);
+  expect_grad_matches([](const synapse::Tensor &x) { return synapse::exp(x); },
+                      values, shape);
+  expect_grad_matches([](const synapse::Tensor &x) { return synapse::relu(x); },
+                      values, shape);
+  expect_grad_matches(
+      [](const synapse::Tensor &x) { return synapse::sigmoid(x); }, values,
+      shape);
+  expect_grad_matches([](const synapse::Tensor &x) { return synapse::tanh(x); },
+                      values, shape);
+  expect_grad_matches([](const synapse::Tensor &x) { return synapse::gelu(x); },
+                      values, shape);
+  expect_grad_matches(
+      [](const synapse::Tensor &x) { return synapse::log(synapse::abs(x)); },
+      values, shape);
+  expect_grad_matches(
+      [](const synapse::Tensor &x) { return synapse::sqrt(synapse::abs(x)); },
+      values, shape);
+}
+
+TEST(AutogradTests, MatmulGradients) {
+  const synapse::Tensor weight{
+      std::vector<float>{0.1F, -0.4F, 0.7F, 0.2F, 0.5F, -0.3F},
+      synapse::Shape{3, 2}};
+  const synapse::Tensor vec{std::vector<float>{0.6F, -0.9F, 0.4F},
+                            synapse::Shape{3}};
+
+  // Batched lhs against a shared weight matrix
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::matmul(x, weight); },
+      {0.3F, -1.2F, 2.1F, 0.7F, 0.1F, -0.5F, 1.1F, 0.4F, -0.8F, 0.9F, 0.2F,
+       -0.6F},
+      {2, 2, 3});
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::matmul(vec, x); },
+      {0.3F, -1.2F, 2.1F, 0.7F, 0.1F, -0.5F}, {3, 2});
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) { return synapse::matmul(x, vec); },
+      {0.3F, -1.2F, 2.1F}, {3});
+}
+
+TEST(AutogradTests, ViewGradients) {
+  const std::vector<float> values{0.3F, -1.2F, 2.1F, 0.7F, 0.1F, -0.5F};
+  const synapse::Shape shape{2, 3};
+  const synapse::Tensor scale{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F},
+                              synapse::Shape{2, 2}};
+
+  expect_grad_matches(
+      [&](const synapse::Tensor &x) {
+        return synapse::mul(x.slice(1, 1, 3), scale);
+      },
+      values, shape);
+  expect_grad_matches(
+      [](const synapse::Tensor &x) {
+        return synapse::exp(x.transpose(0, 1).reshape({6}));
+      },
+      values, shape);
+  expect_grad_matches(
+      [](const synapse::Tensor &x) {
+        return synapse::exp(x.reshape({3, 1, 2}).permute({2, 0, 1}));
+      },
+      values, shape);
+  expect_grad_matches(
+      [](const synapse::Tensor &x) {
+        return synapse::exp(x.broadcast_to({2, 2, 3}).contiguous());
+      },
+      values, shape);
+}
+
+TEST(AutogradTests, SavedTensorsAreReleasedEagerly) {
+  synapse::Tensor x{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2}};
+  x.set_requires_grad();
+  synapse::Tensor y = synapse::exp(x);
+  // The backward node keeps a copy-on-write copy of the output alive
+  EXPECT_TRUE(y.storage()->is_shared());
+
+  synapse::Tensor z = synapse::mul(y, y);
+  z.backward(synapse::Tensor{std::vector<float>{1.0F, 1.0F}, z.shape()});
+  EXPECT_FALSE(y.storage()->is_shared());
+
+  // Running backward again needs the freed activations
+  EXPECT_THROW(
+      z.backward(synapse::Tensor{std::vector<float>{1.0F, 1.0F}, z.shape()}),
+      std::runtime_error);
+}
+
+TEST(AutogradTests, InPlaceWritesKeepSavedTensors) {
+  synapse::Tensor x{std::vector<float>{1.0F, -2.0F, 3.0F}, synapse::Shape{3}};
+  synapse::Tensor w{std::vector<float>{4.0F, 5.0F, 6.0F}, synapse::Shape{3}};
+  w.set_requires_grad();
+  const synapse::Tensor ten{std::vector<float>{10.0F}, synapse::Shape{}};
+  const synapse::Tensor y = synapse::mul(x, w);
+  // Backward reads the values `x` had when `y` was computed
+  synapse::add_(x, ten);
+  synapse::sum(y).backward();
+  EXPECT_EQ(w.grad().to_vector(), (std::vector<float>{1.0F, -2.0F, 3.0F}));
+  EXPECT_EQ(x.to_vector(), (std::vector<float>{11.0F, 8.0F, 13.0F}));
+}
+
+TEST(AutogradTests, RetainGraph) {
+  synapse::Tensor x{std::vector<float>{3.0F}, synapse::Shape{}};
+  x.set_requires_grad();
+  synapse::Tensor y = synapse::mul(x, x);
+  y.backward(true);
+  y.backward();
+  EXPECT_EQ(x.grad().to_vector(), (std::vector<float>{12.0F}));
+}
+
+TEST(AutogradTests, NoGradGuard) {
+  synapse::Tensor x{std::vector<float>{1.0F}, synapse::Shape{1}};
+  x.set_requires_grad();
+  {
+    synapse::NoGradGuard guard;
+    EXPECT_FALSE(synapse::GradMode::is_enabled());
+    EXPECT_FALSE(synapse::exp(x).requires_grad());
+  }
+  EXPECT_TRUE(synapse::GradMode::is_enabled());
+  EXPECT_TRUE(synapse::exp(x).requires_grad());
+  EXPECT_FALSE(x.detach().requires_grad());
+}
+
+TEST(AutogradTests, BackwardErrors) {
+  synapse::Tensor plain{std::vector<float>{1.0F}, synapse::Shape{1}};
+  EXPECT_THROW(plain.backward(), std::runtime_error);
+
+  synapse::Tensor x{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2}};
+  x.set_requires_grad();
+  synapse::Tensor y = synapse::exp(x);
+  EXPECT_THROW(y.backward(), std::runtime_error);
+  EXPECT_THROW(y.backward(synapse::Tensor{{1.0F}, synapse::Shape{1}}),
+               std::runtime_error);
+}
@@ -0,0 +1,132 @@
+#include "allocator.h"
+#include "checkpoint.h"
+#include "dtype.h"
+#include "func.h"
+#include "tensor.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class CheckpointTests : public ::testing::Test {
+protected:
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "synapse_checkpoint_test.bin";
+
+  void TearDown() override { std::filesystem::remove(this->path); }
+
+  // Overwrites the 8 bytes at `offset` of the file
+  auto patch(size_t offset, uint64_t value) const -> void {
+    std::fstream file(this->path,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+};
+
+TEST_F(CheckpointTests, RoundTrip) {
+  std::map<std::string, synapse::Tensor> tensors;
+  tensors.emplace("weight", synapse::Tensor{{1.0F, 2.0F, 3.0F, 4.0F, 5.0F,
+                                             6.0F},
+                                            {2, 3}}
+                                .transpose(0, 1));
+  tensors.emplace("bias", synapse::Tensor{{0.5F, -0.5F}, {2},
+                                          synapse::DType::Float16});
+  tensors.emplace("steps", synapse::Tensor{{7.0F}, {}, synapse::DType::Int32});
+  tensors.emplace("empty", synapse::Tensor::zeros({0, 4}));
+  synapse::save_checkpoint(this->path, tensors);
+
+  const std::map<std::string, synapse::Tensor> loaded =
+      synapse::load_checkpoint(this->path);
+  ASSERT_EQ(loaded.size(), tensors.size());
+  for (const auto &[name, tensor] : tensors) {
+    const synapse::Tensor &other = loaded.at(name);
+    EXPECT_EQ(other.shape(), tensor.shape()) << name;
+    EXPECT_EQ(other.dtype(), tensor.dtype()) << name;
+    EXPECT_EQ(other.to_vector(), tensor.to_vector()) << name;
+  }
+  // Saved views are written dense
+  EXPECT_TRUE(loaded.at("weight").is_contigous());
+}
+
+TEST_F(CheckpointTests, TensorsAliasTheMapping) {
+  const synapse::Tensor weight{std::vector<float>(1000, 1.5F), {10, 100}};
+  synapse::save_checkpoint(this->path, {{"a", weight}, {"b", weight}});
+
+  std::map<std::string, synapse::Tensor> loaded =
+      synapse::load_checkpoint(this->path);
+  synapse::Tensor &a = loaded.at("a");
+  EXPECT_EQ(a.storage()->allocator(), nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a.raw_data()) %
+                synapse::Allocator::alignment,
+            0U);
+
+  // Writes are private to the process and outlive the map of tensors
+  const synapse::NDArray row = a.NDArray::slice(0, 0, 1);
+  a.data()[0] = -1.0F;
+  loaded.clear();
+  EXPECT_EQ(row.data()[0], -1.0F);
+  EXPECT_EQ(synapse::load_checkpoint(this->path).at("a").data()[0], 1.5F);
+}
+
+TEST_F(CheckpointTests, SavesOverItsOwnMapping) {
+  std::vector<float> values(1 << 20);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<float>(i);
+  }
+  synapse::save_checkpoint(
+      this->path, {{"x", synapse::Tensor{values, synapse::Shape{1024, 1024}}}});
+  const std::map<std::string, synapse::Tensor> loaded =
+      synapse::load_checkpoint(this->path);
+  const synapse::Tensor doubled = synapse::add(loaded.at("x"), loaded.at("x"));
+  synapse::save_checkpoint(this->path,
+                           {{"x", loaded.at("x")}, {"y", doubled}});
+
+  // The tensors still mapped from the old file keep their values
+  EXPECT_EQ(loaded.at("x").to_vector(), values);
+  const std::map<std::string, synapse::Tensor> reloaded =
+      synapse::load_checkpoint(this->path);
+  EXPECT_EQ(reloaded.at("x").to_vector(), values);
+  EXPECT_TRUE(synapse::is_close(reloaded.at("y"), doubled));
+  EXPECT_FALSE(std::filesystem::exists(this->path.string() + ".tmp"));
+}
+
+TEST_F(CheckpointTests, RejectsInvalidFiles) {
+  EXPECT_THROW(synapse::load_checkpoint(this->path), std::runtime_error);
+
+  {
+    std::ofstream file(this->path, std::ios::binary);
+    file << "definitely not a checkpoint";
+  }
+  EXPECT_THROW(synapse::load_checkpoint(this->path), std::runtime_error);
+
+  // Truncated elements
+  synapse::save_checkpoint(this->path,
+                           {{"x", synapse::Tensor::zeros({64, 64})}});
+  std::filesystem::resize_file(this->path,
+                               std::filesystem::file_size(this->path) / 2);
+  EXPECT_THROW(synapse::load_checkpoint(this->path), std::runtime_error);
+
+  // The header size follows the magic, version and count, the shape of the
+  // only tensor its name length, name, dtype and rank
+  constexpr size_t header_size = 16;
+  constexpr size_t dims = 24 + 4 + 1 + 2;
+  for (const uint64_t header_bytes :
+       {uint64_t{0}, uint64_t{65}, uint64_t{1} << 40}) {
+    synapse::save_checkpoint(this->path,
+                             {{"x", synapse::Tensor::zeros({2, 2})}});
+    this->patch(header_size, header_bytes);
+    EXPECT_THROW(synapse::load_checkpoint(this->path), std::runtime_error);
+  }
+
+  // 4 x (2^60 + 1) floats are 16 bytes once the size wraps around
+  synapse::save_checkpoint(this->path, {{"x", synapse::Tensor::zeros({2, 2})}});
+  this->patch(dims, 4);
+  this->patch(dims + 8, (uint64_t{1} << 60) + 1);
+  EXPECT_THROW(synapse::load_checkpoint(this->path), std::runtime_error);
+}
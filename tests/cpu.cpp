@@ -0,0 +1,114 @@
+#include "cpu.h"
+#include "dtype.h"
+#include "elementwise.h"
+#include "func.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+enum class TestOp { Scale };
+
+using TestKernel = auto (*)(float) -> float;
+
+auto identity(float value) -> float { return value; }
+auto twice(float value) -> float { return 2.0F * value; }
+
+auto make_tensor(size_t numel, float seed) -> synapse::Tensor {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(seed + static_cast<float>(i)) + 1.5F;
+  }
+  return synapse::Tensor{std::move(out), synapse::Shape{numel}};
+}
+
+auto supported_levels() -> std::vector<synapse::CpuLevel> {
+  std::vector<synapse::CpuLevel> out;
+  for (const auto level :
+       {synapse::CpuLevel::Baseline, synapse::CpuLevel::Sse42,
+        synapse::CpuLevel::Avx2, synapse::CpuLevel::Avx512}) {
+    if (level <= synapse::detected_cpu_level()) {
+      out.push_back(level);
+    }
+  }
+  return out;
+}
+} // namespace
+
+class CpuTests : public ::testing::Test {
+protected:
+  synapse::CpuLevel initial = synapse::cpu_level();
+  void TearDown() override { synapse::set_cpu_level(initial); }
+};
+
+TEST_F(CpuTests, RegistryFallsBackToLowerLevels) {
+  synapse::KernelRegistry<TestOp, TestKernel> registry;
+  EXPECT_EQ(registry.find(TestOp::Scale, synapse::DType::Float32), nullptr);
+  registry.add(TestOp::Scale, synapse::DType::Float32,
+               synapse::CpuLevel::Baseline, identity);
+  registry.add(TestOp::Scale, synapse::DType::Float32,
+               synapse::CpuLevel::Avx2, twice);
+  EXPECT_EQ(registry.find(TestOp::Scale, synapse::DType::Float32,
+                          synapse::CpuLevel::Sse42),
+            identity);
+  EXPECT_EQ(registry.find(TestOp::Scale, synapse::DType::Float32,
+                          synapse::CpuLevel::Avx512),
+            twice);
+  EXPECT_EQ(registry.find(TestOp::Scale, synapse::DType::Int8), nullptr);
+  EXPECT_EQ(registry.levels(TestOp::Scale, synapse::DType::Float32),
+            (std::vector<synapse::CpuLevel>{synapse::CpuLevel::Baseline,
+                                            synapse::CpuLevel::Avx2}));
+}
+
+TEST_F(CpuTests, LevelCanOnlyBeLowered) {
+  EXPECT_LE(synapse::cpu_level(), synapse::detected_cpu_level());
+  synapse::set_cpu_level(synapse::CpuLevel::Baseline);
+  EXPECT_EQ(synapse::cpu_level(), synapse::CpuLevel::Baseline);
+  if (synapse::detected_cpu_level() != synapse::CpuLevel::Avx512) {
+    EXPECT_THROW(synapse::set_cpu_level(synapse::CpuLevel::Avx512),
+                 std::invalid_argument);
+  }
+  EXPECT_EQ(synapse::cpu_level_name(synapse::CpuLevel::Sse42), "sse4.2");
+}
+
+TEST_F(CpuTests, EveryOpHasABaselineKernel) {
+  for (size_t i = 0; i < synapse::ELEMENTWISE_OPS; ++i) {
+    const auto op = static_cast<synapse::ElementwiseOp>(i);
+    for (const auto dtype :
+         {synapse::DType::Float64, synapse::DType::Float32,
+          synapse::DType::Float16, synapse::DType::BFloat16}) {
+      EXPECT_NE(synapse::elementwise_kernels().find(
+                    op, dtype, synapse::CpuLevel::Baseline),
+                nullptr);
+    }
+  }
+  EXPECT_EQ(synapse::elementwise_kernels()
+                .levels(synapse::ElementwiseOp::Mul, synapse::DType::Float32)
+                .size(),
+            synapse::CPU_LEVELS);
+}
+
+TEST_F(CpuTests, LevelsAgree) {
+  // Long enough for full vectors and a remainder, plus a broadcasted scalar
+  const synapse::Tensor lhs = make_tensor(1003, 0.0F);
+  const synapse::Tensor rhs = make_tensor(1003, 2.0F);
+  const synapse::Tensor scalar{{0.75F}, synapse::Shape{1}};
+  const synapse::Tensor ints = lhs.to(synapse::DType::Int32);
+  synapse::set_cpu_level(synapse::CpuLevel::Baseline);
+  const std::vector<float> sum = synapse::add(lhs, rhs).to_vector();
+  const std::vector<float> quotient = synapse::div(scalar, rhs).to_vector();
+  const std::vector<float> root = synapse::sqrt(lhs).to_vector();
+  const std::vector<float> maximum = synapse::maximum(ints, ints).to_vector();
+  for (const auto level : supported_levels()) {
+    synapse::set_cpu_level(level);
+    EXPECT_EQ(synapse::add(lhs, rhs).to_vector(), sum);
+    EXPECT_EQ(synapse::div(scalar, rhs).to_vector(), quotient);
+    EXPECT_EQ(synapse::sqrt(lhs).to_vector(), root);
+    EXPECT_EQ(synapse::maximum(ints, ints).to_vector(), maximum);
+  }
+}
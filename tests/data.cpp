@@ -0,0 +1,193 @@
+#include "data.h"
+#include "dtype.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Sample i has features {i, -i} and label i
+auto make_dataset(size_t samples)
+    -> std::shared_ptr<synapse::data::TensorDataset> {
+  std::vector<float> features;
+  std::vector<float> labels;
+  for (size_t i = 0; i < samples; ++i) {
+    features.push_back(static_cast<float>(i));
+    features.push_back(-static_cast<float>(i));
+    labels.push_back(static_cast<float>(i));
+  }
+  return std::make_shared<synapse::data::TensorDataset>(
+      std::vector<synapse::Tensor>{
+          synapse::Tensor{features, {samples, 2}},
+          synapse::Tensor{labels, {samples}, synapse::DType::Int32}});
+}
+
+// Labels of every batch of an epoch, in order
+auto epoch_labels(synapse::data::DataLoader &loader) -> std::vector<float> {
+  std::vector<float> out;
+  while (const std::optional<synapse::data::Batch> batch = loader.next()) {
+    for (const float label : (*batch)[1].to_vector()) {
+      out.push_back(label);
+    }
+  }
+  return out;
+}
+
+// Reads fail for the sample 5
+class FailingDataset : public synapse::data::Dataset {
+public:
+  FailingDataset() : _fields{{{}, synapse::DType::Float32}} {}
+
+  [[nodiscard]] auto size() const -> size_t override { return 8; }
+  [[nodiscard]] auto fields() const
+      -> const std::vector<synapse::data::Field> & override {
+    return this->_fields;
+  }
+  auto read(size_t index, std::span<void *const> out) const -> void override {
+    if (index == 5) {
+      throw std::runtime_error("Unreadable sample.");
+    }
+    *static_cast<float *>(out[0]) = static_cast<float>(index);
+  }
+
+private:
+  std::vector<synapse::data::Field> _fields;
+};
+} // namespace
+
+TEST(DataTests, BatchesCollateSamplesInOrder) {
+  for (const size_t workers : {0, 1, 3}) {
+    synapse::data::DataLoader loader(
+        make_dataset(10), {.batch_size = 4, .num_workers = workers});
+    EXPECT_EQ(loader.num_batches(), 3);
+
+    std::optional<synapse::data::Batch> first = loader.next();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->size(), 4);
+    EXPECT_EQ((*first)[0].shape(), (synapse::Shape{4, 2}));
+    EXPECT_EQ((*first)[0].to_vector(),
+              (std::vector<float>{0, 0, 1, -1, 2, -2, 3, -3}));
+    EXPECT_EQ((*first)[1].dtype(), synapse::DType::Int32);
+    first.reset();
+
+    const std::vector<float> rest = epoch_labels(loader);
+    EXPECT_EQ(rest, (std::vector<float>{4, 5, 6, 7, 8, 9})) << workers;
+    EXPECT_FALSE(loader.next().has_value());
+  }
+}
+
+TEST(DataTests, PartialBatchIsDroppedOnRequest) {
+  synapse::data::DataLoader loader(
+      make_dataset(10), {.batch_size = 4, .drop_last = true});
+  EXPECT_EQ(loader.num_batches(), 2);
+  EXPECT_EQ(epoch_labels(loader).size(), 8);
+
+  synapse::data::DataLoader partial(make_dataset(10), {.batch_size = 4});
+  static_cast<void>(partial.next());
+  static_cast<void>(partial.next());
+  const std::optional<synapse::data::Batch> last = partial.next();
+  ASSERT_TRUE(last.has_value());
+  EXPECT_EQ(last->size(), 2);
+  EXPECT_EQ((*last)[0].shape(), (synapse::Shape{2, 2}));
+}
+
+TEST(DataTests, ShuffleIsSeededPerEpoch) {
+  const synapse::data::LoaderOptions options{
+      .batch_size = 3, .shuffle = true, .seed = 7, .num_workers = 2};
+  synapse::data::DataLoader loader(make_dataset(20), options);
+  synapse::data::DataLoader same(make_dataset(20), options);
+
+  const std::vector<float> first = epoch_labels(loader);
+  EXPECT_EQ(first, epoch_labels(same));
+  std::vector<float> sorted = first;
+  std::ranges::sort(sorted);
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    EXPECT_EQ(sorted[i], static_cast<float>(i));
+  }
+  EXPECT_NE(first, sorted);
+
+  loader.reset();
+  EXPECT_NE(epoch_labels(loader), first);
+}
+
+TEST(DataTests, BuffersAreReused) {
+  synapse::data::DataLoader loader(
+      make_dataset(64), {.batch_size = 8, .num_workers = 2, .prefetch = 2});
+  std::vector<const void *> buffers;
+  while (const std::optional<synapse::data::Batch> batch = loader.next()) {
+    const void *data = (*batch)[0].raw_data();
+    if (std::ranges::find(buffers, data) == buffers.end()) {
+      buffers.push_back(data);
+    }
+  }
+  EXPECT_EQ(buffers.size(), 2);
+
+  // The consumer holding every buffer cannot get a further batch
+  loader.reset();
+  const std::optional<synapse::data::Batch> a = loader.next();
+  const std::optional<synapse::data::Batch> b = loader.next();
+  EXPECT_THROW(static_cast<void>(loader.next()), std::logic_error);
+}
+
+TEST(DataTests, ResetMidEpochRestarts) {
+  synapse::data::DataLoader loader(make_dataset(12), {.batch_size = 2});
+  static_cast<void>(loader.next());
+  static_cast<void>(loader.next());
+  loader.reset();
+  EXPECT_EQ(epoch_labels(loader),
+            (std::vector<float>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}));
+}
+
+TEST(DataTests, ReadErrorsReachTheConsumer) {
+  for (const size_t workers : {0, 2}) {
+    synapse::data::DataLoader loader(
+        std::make_shared<FailingDataset>(),
+        {.batch_size = 2, .num_workers = workers});
+    EXPECT_TRUE(loader.next().has_value());
+    EXPECT_TRUE(loader.next().has_value());
+    EXPECT_THROW(static_cast<void>(loader.next()), std::runtime_error);
+    const std::optional<synapse::data::Batch> last = loader.next();
+    ASSERT_TRUE(last.has_value());
+    EXPECT_EQ((*last)[0].to_vector(), (std::vector<float>{6, 7}));
+  }
+}
+
+TEST(DataTests, MappedDatasetStreamsRecords) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "synapse_data_test.bin";
+  {
+    std::ofstream file(path, std::ios::binary);
+    // Header, then records of 3 floats and an int32
+    file.write("HEAD", 4);
+    for (int32_t i = 0; i < 5; ++i) {
+      const float features[3] = {static_cast<float>(i), 0.5F, -1.0F};
+      file.write(reinterpret_cast<const char *>(features), sizeof(features));
+      file.write(reinterpret_cast<const char *>(&i), sizeof(i));
+    }
+  }
+  const std::vector<synapse::data::Field> fields{
+      {{3}, synapse::DType::Float32}, {{}, synapse::DType::Int32}};
+  const auto dataset =
+      std::make_shared<synapse::data::MappedDataset>(path, fields, 4);
+  EXPECT_EQ(dataset->size(), 5);
+
+  synapse::data::DataLoader loader(dataset, {.batch_size = 5});
+  const std::optional<synapse::data::Batch> batch = loader.next();
+  ASSERT_TRUE(batch.has_value());
+  EXPECT_EQ((*batch)[0].shape(), (synapse::Shape{5, 3}));
+  EXPECT_EQ((*batch)[0].to_vector()[9], 3.0F);
+  EXPECT_EQ((*batch)[1].to_vector(), (std::vector<float>{0, 1, 2, 3, 4}));
+
+  EXPECT_THROW(synapse::data::MappedDataset(path, fields, 0),
+               std::invalid_argument);
+  std::filesystem::remove(path);
+}
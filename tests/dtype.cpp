@@ -0,0 +1,233 @@
+#include "dtype.h"
+#include "func.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Values spanning the normal, subnormal and overflowing range of Float16,
+// with a tail that is not a multiple of the vector width
+auto wide_values() -> std::vector<float> {
+  std::vector<float> values;
+  for (int i = 0; i < 1003; ++i) {
+    const float scale = std::ldexp(1.0F, (i % 60) - 30);
+    values.push_back(std::sin(static_cast<float>(i)) * scale);
+  }
+  values.push_back(std::numeric_limits<float>::infinity());
+  values.push_back(-std::numeric_limits<float>::infinity());
+  values.push_back(-0.0F);
+  return values;
+}
+} // namespace
+
+TEST(DTypeTests, HalfRoundsToNearestEven) {
+  EXPECT_EQ(synapse::Half(1.0F).bits, 0x3C00);
+  EXPECT_EQ(synapse::Half(-2.0F).bits, 0xC000);
+  EXPECT_EQ(synapse::Half(-0.0F).bits, 0x8000);
+  EXPECT_EQ(synapse::Half(65504.0F).bits, 0x7BFF);
+  // Halfway between the largest half and 2^16 rounds to infinity
+  EXPECT_EQ(synapse::Half(65519.0F).bits, 0x7BFF);
+  EXPECT_EQ(synapse::Half(65520.0F).bits, 0x7C00);
+  // Subnormals, 2^-25 is a tie between 0 and the smallest subnormal
+  EXPECT_EQ(synapse::Half(0x1p-24F).bits, 0x0001);
+  EXPECT_EQ(synapse::Half(0x1p-25F).bits, 0x0000);
+  EXPECT_EQ(synapse::Half(0x1.8p-24F).bits, 0x0002);
+  // 1 + 2^-11 is a tie between 1 and 1 + 2^-10
+  EXPECT_EQ(synapse::Half(1.0F + 0x1p-11F).bits, 0x3C00);
+  EXPECT_EQ(synapse::Half(1.0F + 0x3p-11F).bits, 0x3C02);
+  EXPECT_TRUE(std::isnan(static_cast<float>(
+      synapse::Half(std::numeric_limits<float>::quiet_NaN()))));
+
+  // Every half survives a round trip through float
+  for (uint32_t bits = 0; bits <= 0xFFFF; ++bits) {
+    const auto half = synapse::Half::from_bits(static_cast<uint16_t>(bits));
+    const auto value = static_cast<float>(half);
+    if (!std::isnan(value)) {
+      ASSERT_EQ(synapse::Half(value).bits, bits);
+    }
+  }
+}
+
+TEST(DTypeTests, BFloat16RoundsToNearestEven) {
+  EXPECT_EQ(synapse::BFloat16(1.0F).bits, 0x3F80);
+  EXPECT_EQ(synapse::BFloat16(-3.0F).bits, 0xC040);
+  EXPECT_EQ(static_cast<float>(synapse::BFloat16::from_bits(0x3F81)),
+            1.0F + 0x1p-7F);
+  // 1 + 2^-8 is a tie between 1 and 1 + 2^-7
+  EXPECT_EQ(synapse::BFloat16(1.0F + 0x1p-8F).bits, 0x3F80);
+  EXPECT_EQ(synapse::BFloat16(1.0F + 0x3p-8F).bits, 0x3F82);
+  EXPECT_EQ(synapse::BFloat16(3e38F).bits, 0x7F62);
+  EXPECT_EQ(synapse::BFloat16(std::numeric_limits<float>::max()).bits,
+            0x7F80);
+  EXPECT_TRUE(std::isnan(static_cast<float>(
+      synapse::BFloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST(DTypeTests, VectorizedConversionsMatchScalar) {
+  const std::vector<float> values = wide_values();
+  const size_t n = values.size();
+
+  std::vector<synapse::Half> halves(n);
+  std::vector<synapse::BFloat16> brains(n);
+  synapse::convert(values.data(), synapse::DType::Float32, halves.data(),
+                   synapse::DType::Float16, n);
+  synapse::convert(values.data(), synapse::DType::Float32, brains.data(),
+                   synapse::DType::BFloat16, n);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(halves[i].bits, synapse::Half(values[i]).bits) << values[i];
+    ASSERT_EQ(brains[i].bits, synapse::BFloat16(values[i]).bits) << values[i];
+  }
+
+  std::vector<float> from_halves(n);
+  std::vector<float> from_brains(n);
+  synapse::convert(halves.data(), synapse::DType::Float16, from_halves.data(),
+                   synapse::DType::Float32, n);
+  synapse::convert(brains.data(), synapse::DType::BFloat16,
+                   from_brains.data(), synapse::DType::Float32, n);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_EQ(std::bit_cast<uint32_t>(from_halves[i]),
+              std::bit_cast<uint32_t>(static_cast<float>(halves[i])));
+    ASSERT_EQ(std::bit_cast<uint32_t>(from_brains[i]),
+              std::bit_cast<uint32_t>(static_cast<float>(brains[i])));
+  }
+}
+
+TEST(DTypeTests, IntegerConversionsSaturate) {
+  const std::vector<double> values{-1e10, -128.5, -3.7, 0.0, 3.7, 126.9, 1e10,
+                                   std::numeric_limits<double>::quiet_NaN()};
+  std::vector<int8_t> out(values.size());
+  synapse::convert(values.data(), synapse::DType::Float64, out.data(),
+                   synapse::DType::Int8, values.size());
+  EXPECT_EQ(out, (std::vector<int8_t>{-128, -128, -3, 0, 3, 126, 127, 0}));
+  EXPECT_EQ(synapse::scalar_cast<int32_t>(3e9F),
+            std::numeric_limits<int32_t>::max());
+  EXPECT_EQ(synapse::scalar_cast<int8_t>(int32_t{-300}), -128);
+}
+
+TEST(DTypeTests, PromoteTypes) {
+  using synapse::DType;
+  EXPECT_EQ(synapse::promote_types(DType::Int8, DType::Int32), DType::Int32);
+  EXPECT_EQ(synapse::promote_types(DType::Int32, DType::Float16),
+            DType::Float16);
+  EXPECT_EQ(synapse::promote_types(DType::Float16, DType::BFloat16),
+            DType::Float32);
+  EXPECT_EQ(synapse::promote_types(DType::BFloat16, DType::Float32),
+            DType::Float32);
+  EXPECT_EQ(synapse::promote_types(DType::Float64, DType::Float32),
+            DType::Float64);
+  EXPECT_EQ(synapse::promote_types(DType::Int8, DType::Int8), DType::Int8);
+  EXPECT_EQ(synapse::dtype_size(DType::BFloat16), 2);
+  EXPECT_EQ(synapse::dtype_size(DType::Float64), 8);
+}
+
+TEST(DTypeTests, TypedArrays) {
+  synapse::NDArray array({1.5F, -2.25F, 3.0F, 4.75F}, {2, 2},
+                         synapse::DType::Int32);
+  EXPECT_EQ(array.dtype(), synapse::DType::Int32);
+  EXPECT_EQ(array.element_size(), 4);
+  EXPECT_EQ(array.at<int32_t>(1, 0), 3);
+  array.at<int32_t>(0, 0) = 7;
+  EXPECT_EQ(array.to_string(), "[[7, -2],\n [3, 4]]");
+  EXPECT_THROW(static_cast<void>(array.data()), std::invalid_argument);
+  EXPECT_THROW(static_cast<void>(array.data_ptr<int8_t>()),
+               std::invalid_argument);
+
+  // Conversions go through views and copies keep the dtype
+  const synapse::NDArray column = array.transpose(0, 1).slice(0, 1, 2);
+  const synapse::NDArray halves = column.to(synapse::DType::Float16);
+  EXPECT_EQ(halves.dtype(), synapse::DType::Float16);
+  EXPECT_EQ(halves.to_vector(), (std::vector<float>{-2.0F, 4.0F}));
+  const synapse::NDArray copy = array; // NOLINT
+  EXPECT_EQ(copy.dtype(), synapse::DType::Int32);
+  EXPECT_EQ(array.to(synapse::DType::Int32).storage(), array.storage());
+
+  synapse::NDArray target = synapse::NDArray::zeros({2, 2});
+  target.copy_(array);
+  EXPECT_EQ(target.to_vector(), (std::vector<float>{7, -2, 3, 4}));
+}
+
+TEST(DTypeTests, ElementwiseOpsPromote) {
+  const synapse::Tensor floats{{0.5F, 1.5F, -2.0F}, {3}};
+  const synapse::Tensor ints{{1, 2, 3}, {3}, synapse::DType::Int32};
+  const synapse::Tensor bytes{{100, -100, 5}, {3}, synapse::DType::Int8};
+
+  const synapse::Tensor mixed = synapse::add(floats, ints);
+  EXPECT_EQ(mixed.dtype(), synapse::DType::Float32);
+  EXPECT_EQ(mixed.to_vector(), (std::vector<float>{1.5F, 3.5F, 1.0F}));
+
+  const synapse::Tensor widened = synapse::mul(bytes, ints);
+  EXPECT_EQ(widened.dtype(), synapse::DType::Int32);
+  EXPECT_EQ(widened.to_vector(), (std::vector<float>{100, -200, 15}));
+
+  // Integer results saturate instead of wrapping
+  const synapse::Tensor saturated = synapse::add(bytes, bytes);
+  EXPECT_EQ(saturated.dtype(), synapse::DType::Int8);
+  EXPECT_EQ(saturated.to_vector(), (std::vector<float>{127, -128, 10}));
+  EXPECT_EQ(synapse::neg(bytes).to_vector(),
+            (std::vector<float>{-100, 100, -5}));
+
+  // Division and transcendental ops promote integers to float32
+  const synapse::Tensor quotient = synapse::div(ints, ints.slice(0, 1, 2));
+  EXPECT_EQ(quotient.dtype(), synapse::DType::Float32);
+  EXPECT_EQ(quotient.to_vector(), (std::vector<float>{0.5F, 1.0F, 1.5F}));
+  EXPECT_EQ(synapse::sqrt(ints).dtype(), synapse::DType::Float32);
+
+  // Half precision computes in float32 and rounds the result
+  const synapse::Tensor halves = floats.to(synapse::DType::Float16);
+  const synapse::Tensor exp_half = synapse::exp(halves);
+  EXPECT_EQ(exp_half.dtype(), synapse::DType::Float16);
+  EXPECT_TRUE(synapse::is_close(exp_half, synapse::exp(floats), 5e-3F));
+  EXPECT_EQ(synapse::add(halves, floats.to(synapse::DType::BFloat16)).dtype(),
+            synapse::DType::Float32);
+}
+
+TEST(DTypeTests, MatmulAcrossDtypes) {
+  std::vector<float> values_1(5 * 7);
+  std::vector<float> values_2(7 * 3);
+  for (size_t i = 0; i < values_1.size(); ++i) {
+    values_1[i] = static_cast<float>(static_cast<int>(i % 9) - 4);
+  }
+  for (size_t i = 0; i < values_2.size(); ++i) {
+    values_2[i] = static_cast<float>(static_cast<int>(i % 5) - 2);
+  }
+  const synapse::Tensor mat_1{values_1, {5, 7}};
+  const synapse::Tensor mat_2{values_2, {7, 3}};
+  const synapse::Tensor expected = synapse::matmul(mat_1, mat_2);
+
+  for (const synapse::DType dtype :
+       {synapse::DType::Float64, synapse::DType::Float16,
+        synapse::DType::BFloat16, synapse::DType::Int32,
+        synapse::DType::Int8}) {
+    const synapse::Tensor product =
+        synapse::matmul(mat_1.to(dtype), mat_2.to(dtype));
+    EXPECT_EQ(product.dtype(), dtype);
+    // Small integers are exact in every dtype
+    EXPECT_EQ(product.to_vector(), expected.to_vector())
+        << synapse::dtype_name(dtype);
+  }
+  // Strided operands of the generic path
+  const synapse::Tensor doubles = mat_1.to(synapse::DType::Float64);
+  EXPECT_TRUE(synapse::is_close(
+      synapse::matmul(doubles.transpose(0, 1), doubles),
+      synapse::matmul(mat_1.transpose(0, 1), mat_1)));
+}
+
+TEST(DTypeTests, GradientsFlowThroughConversions) {
+  synapse::Tensor halves{{1, 2}, {2}, synapse::DType::Float16};
+  EXPECT_THROW(halves.set_requires_grad(), std::invalid_argument);
+
+  synapse::Tensor x{{1.0F, -2.0F}, {2}};
+  x.set_requires_grad();
+  const synapse::Tensor y = synapse::mul(x.to(synapse::DType::BFloat16), x);
+  EXPECT_EQ(y.dtype(), synapse::DType::Float32);
+  y.backward(synapse::Tensor{{1.0F, 1.0F}, {2}});
+  EXPECT_EQ(x.grad().dtype(), synapse::DType::Float32);
+  EXPECT_EQ(x.grad().to_vector(), (std::vector<float>{2.0F, -4.0F}));
+}
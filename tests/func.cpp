@@ -1,8 +1,11 @@
+#include "autograd.h"
+#include "dtype.h"
 #include "func.h"
 #include "ndarray.h"
 #include "tensor.h"
 #include <gtest/gtest.h>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 // Test fixture for the Calculator class
@@ -37,3 +40,277 @@ TEST_F(FunctionalTests, MulTensorsMismatchShape) {
   synapse::Tensor tensor_3{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2}};
   EXPECT_THROW(synapse::mul(tensor_1, tensor_3), std::invalid_argument);
 }
+
+TEST_F(FunctionalTests, MatmulTensors) {
+  synapse::Tensor lhs{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F},
+                      synapse::Shape{2, 3}};
+  synapse::Tensor rhs{std::vector<float>{7.0F, 8.0F, 9.0F, 10.0F, 11.0F, 12.0F},
+                      synapse::Shape{3, 2}};
+  synapse::Tensor result = synapse::matmul(lhs, rhs);
+  synapse::Tensor expected_tensor{
+      std::vector<float>{58.0F, 64.0F, 139.0F, 154.0F}, synapse::Shape{2, 2}};
+  EXPECT_TRUE(synapse::is_close(result, expected_tensor));
+}
+
+TEST_F(FunctionalTests, MatmulVectors) {
+  synapse::Tensor matrix{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F},
+                         synapse::Shape{2, 2}};
+  synapse::Tensor vector{std::vector<float>{1.0F, -1.0F}, synapse::Shape{2}};
+
+  synapse::Tensor dot = synapse::matmul(vector, vector);
+  EXPECT_TRUE(synapse::is_close(
+      dot, synapse::Tensor{std::vector<float>{2.0F}, synapse::Shape{}}));
+
+  synapse::Tensor mat_vec = synapse::matmul(matrix, vector);
+  EXPECT_TRUE(synapse::is_close(
+      mat_vec,
+      synapse::Tensor{std::vector<float>{-1.0F, -1.0F}, synapse::Shape{2}}));
+
+  synapse::Tensor vec_mat = synapse::matmul(vector, matrix);
+  EXPECT_TRUE(synapse::is_close(
+      vec_mat,
+      synapse::Tensor{std::vector<float>{-2.0F, -2.0F}, synapse::Shape{2}}));
+}
+
+TEST_F(FunctionalTests, MatmulBroadcastsBatchDimensions) {
+  // Two 2x2 matrices in the batch, multiplied by a single shared 2x1 matrix
+  synapse::Tensor lhs{
+      std::vector<float>{1.0F, 0.0F, 0.0F, 1.0F, 2.0F, 0.0F, 0.0F, 2.0F},
+      synapse::Shape{2, 2, 2}};
+  synapse::Tensor rhs{std::vector<float>{3.0F, 4.0F}, synapse::Shape{1, 2, 1}};
+  synapse::Tensor result = synapse::matmul(lhs, rhs);
+  synapse::Tensor expected_tensor{std::vector<float>{3.0F, 4.0F, 6.0F, 8.0F},
+                                  synapse::Shape{2, 2, 1}};
+  EXPECT_TRUE(synapse::is_close(result, expected_tensor));
+}
+
+TEST_F(FunctionalTests, MatmulMismatchShape) {
+  synapse::Tensor lhs{std::vector<float>(6), synapse::Shape{2, 3}};
+  synapse::Tensor rhs{std::vector<float>(6), synapse::Shape{2, 3}};
+  EXPECT_THROW(synapse::matmul(lhs, rhs), std::invalid_argument);
+
+  synapse::Tensor batch_1{std::vector<float>(12), synapse::Shape{2, 2, 3}};
+  synapse::Tensor batch_2{std::vector<float>(18), synapse::Shape{3, 3, 2}};
+  EXPECT_THROW(synapse::matmul(batch_1, batch_2), std::invalid_argument);
+}
+
+TEST_F(FunctionalTests, MatmulTransposedView) {
+  synapse::Tensor lhs{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F},
+                      synapse::Shape{2, 3}};
+  // lhs x lhs^T without materializing the transpose
+  synapse::Tensor result = synapse::matmul(lhs, lhs.transpose(0, 1));
+  synapse::Tensor expected_tensor{
+      std::vector<float>{14.0F, 32.0F, 32.0F, 77.0F}, synapse::Shape{2, 2}};
+  EXPECT_TRUE(synapse::is_close(result, expected_tensor));
+}
+
+TEST_F(FunctionalTests, AddNonContiguousViews) {
+  synapse::Tensor matrix{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F},
+                         synapse::Shape{2, 2}};
+  synapse::Tensor result = synapse::add(matrix, matrix.transpose(0, 1));
+  synapse::Tensor expected_tensor{std::vector<float>{2.0F, 5.0F, 5.0F, 8.0F},
+                                  synapse::Shape{2, 2}};
+  EXPECT_TRUE(synapse::is_close(result, expected_tensor));
+}
+
+TEST_F(FunctionalTests, AddBroadcastsBias) {
+  synapse::Tensor batch{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F},
+                        synapse::Shape{2, 3}};
+  synapse::Tensor bias{std::vector<float>{10.0F, 20.0F, 30.0F},
+                       synapse::Shape{3}};
+  synapse::Tensor expected_tensor{
+      std::vector<float>{11.0F, 22.0F, 33.0F, 14.0F, 25.0F, 36.0F},
+      synapse::Shape{2, 3}};
+  EXPECT_TRUE(synapse::is_close(synapse::add(batch, bias), expected_tensor));
+  EXPECT_TRUE(synapse::is_close(synapse::add(bias, batch), expected_tensor));
+}
+
+TEST_F(FunctionalTests, MulBroadcastsBothOperands) {
+  synapse::Tensor column{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2, 1}};
+  synapse::Tensor row{std::vector<float>{1.0F, 10.0F, 100.0F},
+                      synapse::Shape{1, 3}};
+  synapse::Tensor expected_tensor{
+      std::vector<float>{1.0F, 10.0F, 100.0F, 2.0F, 20.0F, 200.0F},
+      synapse::Shape{2, 3}};
+  EXPECT_TRUE(synapse::is_close(synapse::mul(column, row), expected_tensor));
+}
+
+TEST_F(FunctionalTests, BinaryOps) {
+  synapse::Tensor lhs{std::vector<float>{1.0F, -2.0F, 3.0F, 8.0F},
+                      synapse::Shape{4}};
+  synapse::Tensor rhs{std::vector<float>{2.0F, 2.0F, -1.0F, 4.0F},
+                      synapse::Shape{4}};
+  EXPECT_TRUE(synapse::is_close(
+      synapse::sub(lhs, rhs),
+      synapse::Tensor{std::vector<float>{-1.0F, -4.0F, 4.0F, 4.0F},
+                      synapse::Shape{4}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::div(lhs, rhs),
+      synapse::Tensor{std::vector<float>{0.5F, -1.0F, -3.0F, 2.0F},
+                      synapse::Shape{4}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::maximum(lhs, rhs),
+      synapse::Tensor{std::vector<float>{2.0F, 2.0F, 3.0F, 8.0F},
+                      synapse::Shape{4}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::minimum(lhs, rhs),
+      synapse::Tensor{std::vector<float>{1.0F, -2.0F, -1.0F, 4.0F},
+                      synapse::Shape{4}}));
+}
+
+TEST_F(FunctionalTests, UnaryOps) {
+  synapse::Tensor input{std::vector<float>{-1.0F, 0.0F, 1.0F, 4.0F},
+                        synapse::Shape{2, 2}};
+  EXPECT_TRUE(synapse::is_close(
+      synapse::neg(input),
+      synapse::Tensor{std::vector<float>{1.0F, 0.0F, -1.0F, -4.0F},
+                      synapse::Shape{2, 2}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::abs(input),
+      synapse::Tensor{std::vector<float>{1.0F, 0.0F, 1.0F, 4.0F},
+                      synapse::Shape{2, 2}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::relu(input),
+      synapse::Tensor{std::vector<float>{0.0F, 0.0F, 1.0F, 4.0F},
+                      synapse::Shape{2, 2}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::exp(input),
+      synapse::Tensor{std::vector<float>{0.367879F, 1.0F, 2.718282F, 54.59815F},
+                      synapse::Shape{2, 2}},
+      1e-4F));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::sigmoid(input),
+      synapse::Tensor{std::vector<float>{0.268941F, 0.5F, 0.731059F, 0.982014F},
+                      synapse::Shape{2, 2}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::tanh(input),
+      synapse::Tensor{
+          std::vector<float>{-0.761594F, 0.0F, 0.761594F, 0.999329F},
+                      synapse::Shape{2, 2}}));
+
+  EXPECT_TRUE(synapse::is_close(
+      synapse::gelu(input),
+      synapse::Tensor{
+          std::vector<float>{-0.158655F, 0.0F, 0.841345F, 3.999873F},
+          synapse::Shape{2, 2}}));
+
+  synapse::Tensor positive{std::vector<float>{1.0F, 4.0F}, synapse::Shape{2}};
+  EXPECT_TRUE(synapse::is_close(
+      synapse::sqrt(positive),
+      synapse::Tensor{std::vector<float>{1.0F, 2.0F}, synapse::Shape{2}}));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::log(positive),
+      synapse::Tensor{std::vector<float>{0.0F, 1.386294F}, synapse::Shape{2}}));
+
+  // Views are read through their strides
+  EXPECT_TRUE(synapse::is_close(
+      synapse::neg(input.transpose(0, 1)),
+      synapse::Tensor{std::vector<float>{1.0F, -1.0F, 0.0F, -4.0F},
+                      synapse::Shape{2, 2}}));
+}
+
+TEST_F(FunctionalTests, OutVariantsWriteIntoTheirBuffer) {
+  synapse::Tensor out = synapse::Tensor::empty({4});
+  const void *buffer = std::as_const(out).raw_data();
+  synapse::Tensor &result = synapse::add(tensor_1, tensor_2, out);
+  EXPECT_EQ(&result, &out);
+  EXPECT_EQ(std::as_const(out).raw_data(), buffer);
+  EXPECT_TRUE(synapse::is_close(out, synapse::add(tensor_1, tensor_2)));
+  synapse::exp(tensor_1, out);
+  EXPECT_TRUE(synapse::is_close(out, synapse::exp(tensor_1)));
+
+  synapse::Tensor wrong_shape = synapse::Tensor::empty({2, 2});
+  EXPECT_THROW(synapse::add(tensor_1, tensor_2, wrong_shape),
+               std::invalid_argument);
+  synapse::Tensor wrong_dtype =
+      synapse::Tensor::empty({4}, synapse::DType::Int32);
+  EXPECT_THROW(synapse::add(tensor_1, tensor_2, wrong_dtype),
+               std::invalid_argument);
+  synapse::Tensor expanded{synapse::Tensor::zeros({1}).NDArray::expand({4})};
+  EXPECT_THROW(synapse::add(tensor_1, tensor_2, expanded),
+               std::invalid_argument);
+}
+
+TEST_F(FunctionalTests, InPlaceVariants) {
+  synapse::Tensor acc = synapse::Tensor::zeros({2, 2});
+  const synapse::Tensor row{std::vector<float>{1.0F, -2.0F}, synapse::Shape{2}};
+  const synapse::Tensor kept = acc;
+  synapse::add_(acc, row);
+  synapse::add_(acc, row);
+  EXPECT_EQ(acc.to_vector(), (std::vector<float>{2.0F, -4.0F, 2.0F, -4.0F}));
+  // Copies taken before keep their values
+  EXPECT_EQ(kept.to_vector(), std::vector<float>(4, 0.0F));
+  synapse::relu_(acc);
+  EXPECT_EQ(acc.to_vector(), (std::vector<float>{2.0F, 0.0F, 2.0F, 0.0F}));
+  synapse::mul_(acc,
+                synapse::Tensor{std::vector<float>{0.5F}, synapse::Shape{}});
+  EXPECT_EQ(acc.to_vector(), (std::vector<float>{1.0F, 0.0F, 1.0F, 0.0F}));
+
+  // Writing through a view updates the tensor it was taken from
+  synapse::Tensor first_row = acc.slice(0, 0, 1);
+  synapse::neg_(first_row);
+  EXPECT_EQ(acc.to_vector(), (std::vector<float>{-1.0F, 0.0F, 1.0F, 0.0F}));
+
+  // The result must fit the first operand
+  synapse::Tensor small = synapse::Tensor::zeros({2});
+  EXPECT_THROW(synapse::add_(small, acc), std::invalid_argument);
+  synapse::Tensor ints{std::vector<float>{1.0F}, synapse::Shape{1},
+                       synapse::DType::Int32};
+  EXPECT_THROW(synapse::exp_(ints), std::invalid_argument);
+
+  synapse::Tensor weight = synapse::Tensor::zeros({2});
+  weight.set_requires_grad();
+  EXPECT_THROW(synapse::add_(weight, row), std::logic_error);
+  {
+    const synapse::NoGradGuard no_grad;
+    synapse::add_(weight, row);
+  }
+  EXPECT_EQ(weight.to_vector(), row.to_vector());
+}
+
+TEST_F(FunctionalTests, OutMayOverlapOperands) {
+  const std::vector<float> values{1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F};
+  synapse::Tensor base{values, synapse::Shape{6}};
+  // out[i] = base[i] + base[i + 1], written one element ahead of the lhs
+  synapse::Tensor out = base.slice(0, 1, 6);
+  synapse::add(base.slice(0, 0, 5), base.slice(0, 1, 6), out);
+  EXPECT_EQ(base.to_vector(),
+            (std::vector<float>{1.0F, 3.0F, 5.0F, 7.0F, 9.0F, 11.0F}));
+
+  // A transposed view of the operand itself
+  synapse::Tensor square{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F},
+                         synapse::Shape{2, 2}};
+  synapse::Tensor transposed = square.transpose(0, 1);
+  synapse::sub(square, transposed, square);
+  EXPECT_EQ(square.to_vector(), (std::vector<float>{0.0F, -1.0F, 1.0F, 0.0F}));
+}
+
+TEST_F(FunctionalTests, MatmulOut) {
+  const synapse::Tensor lhs{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F, 5.0F,
+                                               6.0F},
+                            synapse::Shape{2, 3}};
+  const synapse::Tensor rhs{std::vector<float>{1.0F, 0.0F, 0.0F, 1.0F, 1.0F,
+                                               1.0F},
+                            synapse::Shape{3, 2}};
+  const synapse::Tensor expected = synapse::matmul(lhs, rhs);
+
+  synapse::Tensor out = synapse::Tensor::empty({2, 2});
+  const void *buffer = std::as_const(out).raw_data();
+  synapse::matmul(lhs, rhs, out);
+  EXPECT_EQ(std::as_const(out).raw_data(), buffer);
+  EXPECT_TRUE(synapse::is_close(out, expected));
+
+  // Strided outputs and outputs overlapping an operand go through a copy
+  synapse::Tensor dense = synapse::Tensor::empty({2, 2});
+  synapse::Tensor strided = dense.transpose(0, 1);
+  synapse::matmul(lhs, rhs, strided);
+  EXPECT_TRUE(synapse::is_close(dense.transpose(0, 1), expected));
+  synapse::Tensor square{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F},
+                         synapse::Shape{2, 2}};
+  const synapse::Tensor squared = synapse::matmul(square, square);
+  synapse::matmul(square, square, square);
+  EXPECT_TRUE(synapse::is_close(square, squared));
+
+  synapse::Tensor wrong = synapse::Tensor::empty({3, 3});
+  EXPECT_THROW(synapse::matmul(lhs, rhs, wrong), std::invalid_argument);
+}
@@ -0,0 +1,216 @@
+#include "gemm.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Deterministic, well conditioned inputs
+auto make_matrix(size_t rows, size_t cols, float seed) -> std::vector<float> {
+  std::vector<float> out(rows * cols);
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = std::sin(seed + static_cast<float>(i) * 0.37F);
+  }
+  return out;
+}
+
+// Reference triple loop over strided operands
+auto naive_gemm(size_t m, size_t n, size_t k, const std::vector<float> &a,
+                size_t rs_a, size_t cs_a, const std::vector<float> &b,
+                size_t rs_b, size_t cs_b) -> std::vector<float> {
+  std::vector<float> c(m * n, 0.0F);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      double acc = 0.0;
+      for (size_t p = 0; p < k; ++p) {
+        acc += static_cast<double>(a[(i * rs_a) + (p * cs_a)]) *
+               static_cast<double>(b[(p * rs_b) + (j * cs_b)]);
+      }
+      c[(i * n) + j] = static_cast<float>(acc);
+    }
+  }
+  return c;
+}
+
+auto supported_backends() -> std::vector<synapse::GemmBackend> {
+  std::vector<synapse::GemmBackend> out;
+  for (const auto backend :
+       {synapse::GemmBackend::Scalar, synapse::GemmBackend::Avx2,
+        synapse::GemmBackend::Avx512}) {
+    if (synapse::gemm_backend_supported(backend)) {
+      out.push_back(backend);
+    }
+  }
+  return out;
+}
+
+auto expect_near_all(const std::vector<float> &actual,
+                     const std::vector<float> &expected) -> void {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_NEAR(actual[i], expected[i], 1e-3F) << "at position " << i;
+  }
+}
+} // namespace
+
+class GemmTests : public ::testing::Test {
+protected:
+  synapse::GemmBackend initial = synapse::gemm_backend();
+  void TearDown() override { synapse::set_gemm_backend(initial); }
+};
+
+TEST_F(GemmTests, MatchesReferenceOnAllBackends) {
+  // Sizes that hit full tiles, edge tiles and multiple cache blocks
+  const std::vector<std::vector<size_t>> sizes{
+      {2, 2, 2}, {7, 5, 3}, {13, 33, 17}, {64, 64, 64}, {150, 70, 300}};
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    for (const auto &size : sizes) {
+      const size_t m = size[0];
+      const size_t n = size[1];
+      const size_t k = size[2];
+      const auto a = make_matrix(m, k, 0.1F);
+      const auto b = make_matrix(k, n, 0.7F);
+      std::vector<float> c(m * n, -1.0F);
+      synapse::sgemm(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n);
+      expect_near_all(c, naive_gemm(m, n, k, a, k, 1, b, n, 1));
+    }
+  }
+}
+
+TEST_F(GemmTests, TransposedOperands) {
+  const size_t m = 19;
+  const size_t n = 23;
+  const size_t k = 29;
+  // A is stored as k x m and B as n x k, both read transposed
+  const auto a = make_matrix(k, m, 0.3F);
+  const auto b = make_matrix(n, k, 0.5F);
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    std::vector<float> c(m * n);
+    synapse::sgemm(m, n, k, a.data(), 1, m, b.data(), 1, k, c.data(), n);
+    expect_near_all(c, naive_gemm(m, n, k, a, 1, m, b, 1, k));
+  }
+}
+
+TEST_F(GemmTests, Accumulate) {
+  const size_t m = 9;
+  const size_t n = 17;
+  const size_t k = 5;
+  const auto a = make_matrix(m, k, 0.2F);
+  const auto b = make_matrix(k, n, 0.4F);
+  auto expected = naive_gemm(m, n, k, a, k, 1, b, n, 1);
+  for (auto &value : expected) {
+    value += 1.0F;
+  }
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    std::vector<float> c(m * n, 1.0F);
+    synapse::sgemm(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n, true);
+    expect_near_all(c, expected);
+  }
+}
+
+TEST_F(GemmTests, SkinnyShapes) {
+  // Matrix-vector products and products with few rows or columns, with
+  // depths that leave tails after the vector loops
+  const std::vector<std::vector<size_t>> sizes{
+      {1, 41, 37},   {41, 1, 37},    {300, 1, 130}, {1, 300, 130},
+      {200, 3, 100}, {5, 150, 100},  {8, 8, 67},    {1, 1, 1}};
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    for (const auto &size : sizes) {
+      const size_t m = size[0];
+      const size_t n = size[1];
+      const size_t k = size[2];
+      const auto a = make_matrix(m, k, 0.6F);
+      const auto b = make_matrix(k, n, 0.9F);
+      // Stored transposed, as k x m and n x k
+      const auto a_t = make_matrix(k, m, 0.6F);
+      const auto b_t = make_matrix(n, k, 0.9F);
+      for (const bool transpose_a : {false, true}) {
+        for (const bool transpose_b : {false, true}) {
+          const auto &a_data = transpose_a ? a_t : a;
+          const auto &b_data = transpose_b ? b_t : b;
+          const size_t rs_a = transpose_a ? 1 : k;
+          const size_t cs_a = transpose_a ? m : 1;
+          const size_t rs_b = transpose_b ? 1 : n;
+          const size_t cs_b = transpose_b ? k : 1;
+          auto expected =
+              naive_gemm(m, n, k, a_data, rs_a, cs_a, b_data, rs_b, cs_b);
+          for (auto &value : expected) {
+            value += 1.0F;
+          }
+          std::vector<float> c(m * n, 1.0F);
+          synapse::sgemm(m, n, k, a_data.data(), rs_a, cs_a, b_data.data(),
+                         rs_b, cs_b, c.data(), n, true);
+          expect_near_all(c, expected);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(GemmTests, EmptyDepthZeroesOutput) {
+  std::vector<float> c(6, 3.0F);
+  synapse::sgemm(2, 3, 0, nullptr, 0, 1, nullptr, 3, 1, c.data(), 3);
+  expect_near_all(c, std::vector<float>(6, 0.0F));
+}
+
+TEST_F(GemmTests, EpilogueAddsBiasAndActivates) {
+  // Sizes that hit the blocked path over several depth blocks, the skinny
+  // paths and the empty depth
+  const std::vector<std::vector<size_t>> sizes{
+      {150, 70, 300}, {13, 33, 17}, {1, 41, 37}, {41, 1, 37},
+      {200, 3, 50},   {3, 200, 50}, {3, 5, 0}};
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    for (const auto &size : sizes) {
+      const size_t m = size[0];
+      const size_t n = size[1];
+      const size_t k = size[2];
+      const auto a = make_matrix(m, k, 0.1F);
+      const auto b = make_matrix(k, n, 0.7F);
+      const auto col_bias = make_matrix(1, n, 0.2F);
+      const auto row_bias = make_matrix(m, 1, 0.4F);
+      const auto product = naive_gemm(m, n, k, a, k, 1, b, n, 1);
+
+      std::vector<float> expected(product);
+      for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+          expected[(i * n) + j] =
+              std::max(product[(i * n) + j] + col_bias[j], 0.0F);
+        }
+      }
+      std::vector<float> c(m * n);
+      synapse::sgemm(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n,
+                     false,
+                     {.bias = col_bias.data(),
+                      .activation = synapse::Activation::Relu});
+      expect_near_all(c, expected);
+
+      for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+          const float x = product[(i * n) + j] + row_bias[i];
+          expected[(i * n) + j] =
+              0.5F * x * (1.0F + std::erf(x / std::sqrt(2.0F)));
+        }
+      }
+      synapse::sgemm(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n,
+                     false,
+                     {.bias = row_bias.data(),
+                      .rs_bias = 1,
+                      .cs_bias = 0,
+                      .activation = synapse::Activation::Gelu});
+      expect_near_all(c, expected);
+    }
+  }
+}
+
+TEST_F(GemmTests, ScalarBackendIsAlwaysSupported) {
+  EXPECT_TRUE(synapse::gemm_backend_supported(synapse::GemmBackend::Scalar));
+  EXPECT_NO_THROW(synapse::set_gemm_backend(synapse::GemmBackend::Scalar));
+  EXPECT_EQ(synapse::gemm_backend(), synapse::GemmBackend::Scalar);
+}
@@ -0,0 +1,72 @@
+#include "iterator.h"
+#include "ndarray.h"
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+TEST(TensorIteratorTests, CoalescesDenseOperands) {
+  synapse::NDArray out(std::vector<float>(24), {2, 3, 4});
+  synapse::NDArray lhs(std::vector<float>(24), {2, 3, 4});
+  synapse::NDArray rhs(std::vector<float>(24), {2, 3, 4});
+  synapse::TensorIterator iter(out, {&lhs, &rhs});
+  EXPECT_EQ(iter.shape(), (synapse::Shape{24}));
+  EXPECT_EQ(iter.strides(1), (synapse::Strides{1}));
+}
+
+TEST(TensorIteratorTests, BroadcastedOperandsGetZeroStrides) {
+  synapse::NDArray out(std::vector<float>(12), {3, 4});
+  synapse::NDArray bias(std::vector<float>(4), {4});
+  synapse::NDArray column(std::vector<float>(3), {3, 1});
+  synapse::TensorIterator iter(out, {&bias, &column});
+  EXPECT_EQ(iter.shape(), (synapse::Shape{3, 4}));
+  EXPECT_EQ(iter.strides(0), (synapse::Strides{4, 1}));
+  EXPECT_EQ(iter.strides(1), (synapse::Strides{0, 1}));
+  EXPECT_EQ(iter.strides(2), (synapse::Strides{1, 0}));
+}
+
+TEST(TensorIteratorTests, DropsUnitDimensionsAndHandlesScalars) {
+  synapse::NDArray out(std::vector<float>(4), {1, 4, 1});
+  synapse::NDArray scalar(std::vector<float>{2}, {});
+  synapse::TensorIterator iter(out, {&scalar});
+  EXPECT_EQ(iter.shape(), (synapse::Shape{4}));
+  EXPECT_EQ(iter.strides(1), (synapse::Strides{0}));
+
+  synapse::NDArray single(std::vector<float>(1), {});
+  synapse::TensorIterator scalar_iter(single, {&scalar});
+  EXPECT_EQ(scalar_iter.shape(), (synapse::Shape{1}));
+  EXPECT_EQ(scalar_iter.numel(), 1);
+}
+
+TEST(TensorIteratorTests, VisitsEveryElementInRanges) {
+  synapse::NDArray out(std::vector<float>(6), {2, 3});
+  synapse::NDArray src({1, 2, 3, 4, 5, 6}, {2, 3});
+  // The transposed view cannot be merged with the dense output
+  synapse::NDArray transposed =
+      src.transpose(0, 1).contiguous().transpose(0, 1);
+  synapse::TensorIterator iter(out, {&transposed});
+  EXPECT_EQ(iter.shape(), (synapse::Shape{2, 3}));
+
+  std::vector<size_t> runs;
+  const auto copy = [&runs](float *dst, const float *const *in,
+                            const size_t *strides, size_t n) {
+    runs.push_back(n);
+    for (size_t i = 0; i < n; ++i) {
+      dst[i * strides[0]] = in[0][i * strides[1]];
+    }
+  };
+  // Splitting in the middle of a row produces partial runs
+  iter.for_each(copy, 0, 2);
+  iter.for_each(copy, 2, 6);
+  EXPECT_EQ(runs, (std::vector<size_t>{2, 1, 3}));
+  EXPECT_EQ(out.to_vector(), src.to_vector());
+}
+
+TEST(TensorIteratorTests, IncompatibleShapesThrow) {
+  synapse::NDArray out(std::vector<float>(6), {2, 3});
+  synapse::NDArray bad(std::vector<float>(2), {2});
+  synapse::NDArray too_big(std::vector<float>(12), {2, 2, 3});
+  EXPECT_THROW(synapse::TensorIterator(out, {&bad}), std::invalid_argument);
+  EXPECT_THROW(synapse::TensorIterator(out, {&too_big}),
+               std::invalid_argument);
+}
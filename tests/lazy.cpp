@@ -0,0 +1,109 @@
+#include "allocator.h"
+#include "func.h"
+#include "lazy.h"
+#include "ndarray.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+namespace {
+auto ramp(size_t numel, float scale) -> std::vector<float> {
+  std::vector<float> values(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    values[i] = std::sin(static_cast<float>(i) * scale);
+  }
+  return values;
+}
+} // namespace
+
+TEST(LazyTests, GuardTogglesLazyMode) {
+  EXPECT_FALSE(synapse::LazyMode::is_enabled());
+  {
+    const synapse::LazyGuard lazy;
+    EXPECT_TRUE(synapse::LazyMode::is_enabled());
+    {
+      const synapse::LazyGuard eager(false);
+      EXPECT_FALSE(synapse::LazyMode::is_enabled());
+    }
+    EXPECT_TRUE(synapse::LazyMode::is_enabled());
+  }
+  EXPECT_FALSE(synapse::LazyMode::is_enabled());
+}
+
+TEST(LazyTests, FusedChainMatchesEager) {
+  const synapse::Tensor a{ramp(24, 0.3F), {2, 3, 4}};
+  const synapse::Tensor b{ramp(4, 0.7F), {4}};
+  const synapse::Tensor c{ramp(6, 1.1F), {2, 3, 1}};
+  const auto chain = [&] {
+    const synapse::Tensor x = synapse::add(synapse::mul(a, b), c);
+    const synapse::Tensor y = synapse::sigmoid(synapse::maximum(x, b));
+    return synapse::div(synapse::tanh(y), synapse::exp(synapse::neg(x)));
+  };
+  const synapse::Tensor eager = chain();
+
+  synapse::Tensor lazy = [&] {
+    const synapse::LazyGuard guard;
+    return chain();
+  }();
+  EXPECT_TRUE(lazy.is_lazy());
+  EXPECT_EQ(lazy.shape(), eager.shape());
+  lazy.eval();
+  EXPECT_FALSE(lazy.is_lazy());
+  EXPECT_TRUE(synapse::is_close(lazy, eager));
+}
+
+TEST(LazyTests, IntermediatesAreNeverAllocated) {
+  const synapse::Tensor a{ramp(1000, 0.1F), {1000}};
+  const synapse::Tensor b{ramp(1000, 0.2F), {1000}};
+  const auto arena = std::make_shared<synapse::Arena>();
+  synapse::Tensor out = [&] {
+    const synapse::AllocatorGuard allocator(arena);
+    const synapse::LazyGuard lazy;
+    return synapse::relu(synapse::sub(synapse::mul(a, b), synapse::abs(a)));
+  }();
+  EXPECT_EQ(arena->stats().allocations, 0);
+  // Accessing the data evaluates the whole chain into a single buffer
+  EXPECT_FLOAT_EQ(out.data()[10], std::max(0.0F, a.data()[10] * b.data()[10] -
+                                                     std::fabs(a.data()[10])));
+  EXPECT_EQ(arena->stats().allocations, 1);
+}
+
+TEST(LazyTests, SharedSubexpressionsAndViews) {
+  const synapse::Tensor a{ramp(12, 0.5F), {3, 4}};
+  synapse::Tensor lazy = [&] {
+    const synapse::LazyGuard guard;
+    const synapse::Tensor shared = synapse::exp(a);
+    // A transposed view of a deferred result is read as a leaf
+    const synapse::Tensor view = shared.transpose(0, 1).contiguous();
+    return synapse::add(synapse::mul(shared, shared),
+                        view.transpose(0, 1));
+  }();
+  const synapse::Tensor shared = synapse::exp(a);
+  const synapse::Tensor eager =
+      synapse::add(synapse::mul(shared, shared), shared);
+  EXPECT_EQ(lazy.to_string(), eager.to_string());
+}
+
+TEST(LazyTests, EagerOpsAndAutogradMaterializeInputs) {
+  synapse::Tensor x{ramp(6, 0.4F), {2, 3}};
+  x.set_requires_grad();
+  const synapse::Tensor w{ramp(6, 0.9F), {3, 2}};
+  synapse::Tensor loss = [&] {
+    const synapse::LazyGuard guard;
+    const synapse::Tensor hidden = synapse::tanh(synapse::mul(x, x));
+    EXPECT_TRUE(hidden.is_lazy());
+    return synapse::matmul(hidden, w);
+  }();
+  EXPECT_FALSE(loss.is_lazy());
+  loss.backward(synapse::Tensor{std::vector<float>(4, 1.0F), {2, 2}});
+
+  synapse::Tensor x_eager{ramp(6, 0.4F), {2, 3}};
+  x_eager.set_requires_grad();
+  synapse::matmul(synapse::tanh(synapse::mul(x_eager, x_eager)), w)
+      .backward(synapse::Tensor{std::vector<float>(4, 1.0F), {2, 2}});
+  EXPECT_TRUE(synapse::is_close(x.grad(), x_eager.grad()));
+}
@@ -1,6 +1,17 @@
 #include "ndarray.h"
+#include "accessor.h"
+#include "dtype.h"
+#include "storage.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <gtest/gtest.h>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 class NDArrayTests : public ::testing::Test {};
@@ -15,7 +26,7 @@ TEST(NDArrayTest, Build1DArray) {
   EXPECT_EQ(arr.ndim(), 1);
   EXPECT_EQ(arr.size(), 6);
   EXPECT_EQ(arr.shape(), shape);
-  EXPECT_EQ(arr.data(), data);
+  EXPECT_EQ(arr.to_vector(), data);
   EXPECT_EQ(arr.strides(), strides);
 }
 
@@ -28,7 +39,7 @@ TEST(NDArrayTest, Build2DArray) {
   EXPECT_EQ(arr.ndim(), 2);
   EXPECT_EQ(arr.size(), 6);
   EXPECT_EQ(arr.shape(), shape);
-  EXPECT_EQ(arr.data(), data);
+  EXPECT_EQ(arr.to_vector(), data);
   EXPECT_EQ(arr.strides(), strides);
 }
 
@@ -42,7 +53,7 @@ TEST(NDArrayTest, Build3DArray) {
   EXPECT_EQ(arr.ndim(), 3);
   EXPECT_EQ(arr.size(), 12);
   EXPECT_EQ(arr.shape(), shape);
-  EXPECT_EQ(arr.data(), data);
+  EXPECT_EQ(arr.to_vector(), data);
   EXPECT_EQ(arr.strides(), strides);
 }
 
@@ -93,6 +104,67 @@ TEST(NDArrayTest, ToString) {
                                        " [[6.540, 7.770],\n  [8.880, 9.990]]]");
 }
 
+TEST(NDArrayTest, StreamSummarizesLargeArrays) {
+  std::vector<float> data(2000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>(i);
+  }
+  const synapse::NDArray array(data, {200, 10});
+  std::ostringstream oss;
+  oss << array;
+  EXPECT_EQ(oss.str(), array.to_string());
+  EXPECT_EQ(oss.str().substr(0, 50),
+            "[[0.000, 1.000, 2.000, ..., 7.000, 8.000, 9.000],\n");
+  EXPECT_NE(oss.str().find("],\n ...,\n [1970.000"), std::string::npos);
+  EXPECT_EQ(std::ranges::count(oss.str(), '\n'), 6);
+
+  // Below the threshold everything is written
+  EXPECT_EQ(std::ranges::count(array.slice(0, 0, 50).to_string(), '\n'), 49);
+}
+
+TEST(NDArrayTest, PrintOptions) {
+  const synapse::PrintOptions defaults = synapse::print_options();
+  const synapse::NDArray array({1.0F / 3.0F, -2.5F, 1e30F, 4.0F}, {4});
+
+  synapse::set_print_options({.precision = 1, .threshold = 3, .edge_items = 1});
+  EXPECT_EQ(array.to_string(), "[0.3, ..., 4.0]");
+  synapse::set_print_options({.precision = 5});
+  EXPECT_EQ(array.slice(0, 0, 2).to_string(), "[0.33333, -2.50000]");
+  synapse::set_print_options(defaults);
+
+  // Without edge items a summarized view never reads past its elements
+  std::vector<float> data(4000);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<float>(i);
+  }
+  const synapse::NDArray view =
+      synapse::NDArray(data, {4000}).slice(0, 0, 2000);
+  synapse::set_print_options({.edge_items = 0});
+  EXPECT_EQ(view.to_string(), "[...]");
+  EXPECT_EQ(synapse::NDArray(data, {2, 2000}).to_string(), "[...]");
+  synapse::set_print_options(defaults);
+
+  // Explicit options do not touch the global ones
+  std::string out;
+  synapse::write_array(array, {.precision = 0},
+                       [&out](std::string_view chunk) { out += chunk; });
+  EXPECT_EQ(out, "[0, -2, 1000000015047466219876688855040, 4]");
+  EXPECT_EQ(synapse::print_options().precision, defaults.precision);
+}
+
+TEST(NDArrayTest, StreamFollowsStrides) {
+  const synapse::NDArray array({1, 2, 3, 4, 5, 6}, {2, 3});
+  std::ostringstream oss;
+  oss << array.transpose(0, 1).slice(0, 1, 3);
+  EXPECT_EQ(oss.str(), "[[2.000, 5.000],\n [3.000, 6.000]]");
+
+  const synapse::NDArray ints({-7, 8}, {2}, synapse::DType::Int32);
+  const synapse::NDArray scalar({0.5F}, {});
+  oss.str("");
+  oss << ints << ' ' << scalar << ' ' << synapse::NDArray::zeros({0, 2});
+  EXPECT_EQ(oss.str(), "[-7, 8] 0.500 []");
+}
+
 TEST(NDArrayTest, OutOfBoundsAccessThrows) {
   std::vector<float> data = {1, 2, 3, 4, 5, 6};
   synapse::Shape shape = {2, 3};
@@ -102,6 +174,184 @@ TEST(NDArrayTest, OutOfBoundsAccessThrows) {
   EXPECT_THROW(arr(0, 3), std::out_of_range);
 }
 
+TEST(NDArrayTest, AccessorReadsThroughStrides) {
+  synapse::NDArray arr({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, {3, 4});
+  const synapse::NDArray view = arr.transpose(0, 1).slice(1, 0, 3, 2);
+  const auto acc = view.accessor<2>();
+  ASSERT_EQ(acc.size(0), 4);
+  ASSERT_EQ(acc.size(1), 2);
+  for (size_t i = 0; i < acc.size(0); ++i) {
+    for (size_t j = 0; j < acc.size(1); ++j) {
+      EXPECT_EQ(acc(i, j), view(i, j));
+    }
+  }
+  EXPECT_EQ(acc[3][1], 11);
+
+  // Writes go to the shared storage
+  auto writer = arr.accessor<2>();
+  writer(1, 2) = -1;
+  writer[2][0] = -2;
+  EXPECT_EQ(arr(1, 2), -1);
+  EXPECT_EQ(arr(2, 0), -2);
+
+  EXPECT_THROW(static_cast<void>(acc.at(4, 0)), std::out_of_range);
+  EXPECT_THROW(static_cast<void>(arr.accessor<3>()), std::invalid_argument);
+  EXPECT_THROW(static_cast<void>((arr.accessor<2, int32_t>())),
+               std::invalid_argument);
+  if constexpr (synapse::BOUNDS_CHECK) {
+    EXPECT_THROW(static_cast<void>(acc(0, 2)), std::out_of_range);
+  }
+}
+
+TEST(NDArrayTest, TypedAccessor) {
+  synapse::NDArray arr({1, 2, 3, 4, 5, 6}, {2, 3}, synapse::DType::Int8);
+  auto acc = arr.accessor<2, int8_t>();
+  acc(1, 1) = 42;
+  EXPECT_EQ(arr.at<int8_t>(1, 1), 42);
+  EXPECT_EQ(acc.stride(0), 3);
+}
+
+TEST(NDArrayTest, DataSizeMustMatchShape) {
+  EXPECT_THROW(synapse::NDArray({1, 2, 3}, {2, 2}), std::invalid_argument);
+}
+
+TEST(NDArrayTest, CopiesAreIndependent) {
+  synapse::NDArray arr({1, 2, 3, 4, 5, 6}, {2, 3});
+  synapse::NDArray copy = arr.transpose(0, 1);
+  copy = arr;
+  copy(0, 0) = -1;
+  EXPECT_EQ(arr(0, 0), 1);
+
+  // Copying a view produces a dense array
+  const synapse::NDArray view = arr.transpose(0, 1);
+  synapse::NDArray dense(view);
+  EXPECT_NE(dense.storage(), arr.storage());
+  EXPECT_TRUE(dense.is_contigous());
+  EXPECT_EQ(dense.to_vector(), (std::vector<float>{1, 4, 2, 5, 3, 6}));
+}
+
+TEST(NDArrayTest, CopiesShareUntilWritten) {
+  synapse::NDArray arr({1, 2, 3, 4, 5, 6}, {2, 3});
+  const synapse::NDArray row = arr.slice(0, 1, 2);
+  const synapse::NDArray copy = arr;
+  EXPECT_NE(copy.storage(), arr.storage());
+  EXPECT_EQ(copy.raw_data(), std::as_const(arr).raw_data());
+  EXPECT_TRUE(arr.storage()->is_shared());
+
+  // The write detaches `arr`, and its views follow it
+  arr(1, 0) = -1;
+  EXPECT_FALSE(arr.storage()->is_shared());
+  EXPECT_NE(copy.raw_data(), std::as_const(arr).raw_data());
+  EXPECT_EQ(row(0, 0), -1);
+  EXPECT_EQ(copy(1, 0), 4);
+
+  // Copies written from several threads each get a buffer of their own
+  std::vector<synapse::NDArray> copies(4, arr);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < copies.size(); ++i) {
+    threads.emplace_back([&copies, i] {
+      copies[i](0, 0) = static_cast<float>(i);
+      synapse::NDArray again = copies[i];
+      again(0, 1) = 0;
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < copies.size(); ++i) {
+    EXPECT_EQ(copies[i](0, 0), static_cast<float>(i));
+    EXPECT_EQ(copies[i](0, 1), 2);
+  }
+  EXPECT_EQ(arr(0, 0), 1);
+}
+
+TEST(NDArrayTest, SliceSharesStorage) {
+  synapse::NDArray arr({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, {3, 4});
+  synapse::NDArray rows = arr.slice(0, 1, 3);
+  EXPECT_EQ(rows.shape(), (synapse::Shape{2, 4}));
+  EXPECT_EQ(rows.storage(), arr.storage());
+  EXPECT_EQ(rows.offset(), 4);
+  EXPECT_TRUE(rows.is_contigous());
+  EXPECT_EQ(rows(1, 2), 10);
+
+  synapse::NDArray cols = arr.slice(1, 0, 4, 2);
+  EXPECT_EQ(cols.shape(), (synapse::Shape{3, 2}));
+  EXPECT_EQ(cols.strides(), (synapse::Strides{4, 2}));
+  EXPECT_FALSE(cols.is_contigous());
+  EXPECT_EQ(cols.to_vector(), (std::vector<float>{0, 2, 4, 6, 8, 10}));
+
+  // Writes through a view are visible in the original array
+  cols(2, 1) = -1;
+  EXPECT_EQ(arr(2, 2), -1);
+
+  EXPECT_THROW(arr.slice(2, 0, 1), std::out_of_range);
+  EXPECT_THROW(arr.slice(0, 2, 1), std::out_of_range);
+}
+
+TEST(NDArrayTest, TransposeAndPermute) {
+  synapse::NDArray arr({1, 2, 3, 4, 5, 6}, {2, 3});
+  synapse::NDArray t = arr.transpose(0, 1);
+  EXPECT_EQ(t.shape(), (synapse::Shape{3, 2}));
+  EXPECT_EQ(t.strides(), (synapse::Strides{1, 3}));
+  EXPECT_EQ(t.storage(), arr.storage());
+  EXPECT_FALSE(t.is_contigous());
+  EXPECT_EQ(t.to_vector(), (std::vector<float>{1, 4, 2, 5, 3, 6}));
+  EXPECT_EQ(t.to_string(),
+            "[[1.000, 4.000],\n [2.000, 5.000],\n [3.000, 6.000]]");
+
+  synapse::NDArray cube({0, 1, 2, 3, 4, 5, 6, 7}, {2, 2, 2});
+  synapse::NDArray p = cube.permute({2, 0, 1});
+  EXPECT_EQ(p.strides(), (synapse::Strides{1, 4, 2}));
+  EXPECT_EQ(p(1, 0, 1), 3);
+  EXPECT_THROW(cube.permute({0, 0, 1}), std::invalid_argument);
+  EXPECT_THROW(arr.transpose(0, 2), std::out_of_range);
+}
+
+TEST(NDArrayTest, ReshapeIsCopyFreeWhenPossible) {
+  synapse::NDArray arr({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}, {3, 4});
+  synapse::NDArray flat = arr.reshape({2, 6});
+  EXPECT_EQ(flat.storage(), arr.storage());
+  EXPECT_EQ(flat(1, 0), 6);
+
+  // Splitting a dimension of a sliced view keeps sharing the storage
+  synapse::NDArray split = arr.slice(0, 1, 3).reshape({2, 2, 2});
+  EXPECT_EQ(split.storage(), arr.storage());
+  EXPECT_EQ(split(1, 1, 0), 10);
+
+  // Merging transposed dimensions needs a copy
+  synapse::NDArray merged = arr.transpose(0, 1).reshape({12});
+  EXPECT_NE(merged.storage(), arr.storage());
+  EXPECT_EQ(merged.to_vector(), (std::vector<float>{0, 4, 8, 1, 5, 9, 2, 6,
+                                                    10, 3, 7, 11}));
+
+  EXPECT_THROW(arr.reshape({5}), std::invalid_argument);
+}
+
+TEST(NDArrayTest, BroadcastToUsesZeroStrides) {
+  synapse::NDArray row({1, 2, 3}, {3});
+  synapse::NDArray grid = row.broadcast_to({2, 3});
+  EXPECT_EQ(grid.strides(), (synapse::Strides{0, 1}));
+  EXPECT_EQ(grid.storage(), row.storage());
+  EXPECT_EQ(grid.to_vector(), (std::vector<float>{1, 2, 3, 1, 2, 3}));
+
+  synapse::NDArray col({1, 2}, {2, 1});
+  EXPECT_EQ(col.expand({2, 3}).to_vector(),
+            (std::vector<float>{1, 1, 1, 2, 2, 2}));
+  EXPECT_THROW(row.broadcast_to({2, 4}), std::invalid_argument);
+  EXPECT_THROW(row.broadcast_to({}), std::invalid_argument);
+}
+
+TEST(NDArrayTest, Contiguous) {
+  synapse::NDArray arr({1, 2, 3, 4, 5, 6}, {2, 3});
+  EXPECT_EQ(arr.contiguous().storage(), arr.storage());
+
+  synapse::NDArray dense = arr.transpose(0, 1).contiguous();
+  EXPECT_NE(dense.storage(), arr.storage());
+  EXPECT_TRUE(dense.is_contigous());
+  EXPECT_EQ(dense.strides(), (synapse::Strides{2, 1}));
+  EXPECT_EQ(dense.to_vector(), (std::vector<float>{1, 4, 2, 5, 3, 6}));
+}
+
 TEST(ShapeBroadcastTests, NdIndexToPos) {
   // 1D Array
   synapse::Shape indices_1d = {3};
@@ -0,0 +1,276 @@
+#include "autograd.h"
+#include "func.h"
+#include "gemm.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "tensor.h"
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace {
+// Deterministic, well conditioned values
+auto make_tensor(const synapse::Shape &shape, float seed) -> synapse::Tensor {
+  std::vector<float> values(synapse::shape_numel(shape));
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = std::sin(seed + (static_cast<float>(i) * 0.37F));
+  }
+  return synapse::Tensor{values, shape};
+}
+
+// Direct convolution with a bias, the reference of conv2d
+auto naive_conv2d(const synapse::Tensor &input, const synapse::Tensor &weight,
+                  const synapse::Tensor &bias, size_t stride, size_t padding)
+    -> synapse::Tensor {
+  const size_t batch = input.shape()[0];
+  const size_t channels = input.shape()[1];
+  const size_t height = input.shape()[2];
+  const size_t width = input.shape()[3];
+  const size_t out_channels = weight.shape()[0];
+  const size_t kernel_h = weight.shape()[2];
+  const size_t kernel_w = weight.shape()[3];
+  const size_t out_h = ((height + (2 * padding) - kernel_h) / stride) + 1;
+  const size_t out_w = ((width + (2 * padding) - kernel_w) / stride) + 1;
+  synapse::Tensor out =
+      synapse::Tensor::zeros({batch, out_channels, out_h, out_w});
+  for (size_t n = 0; n < batch; ++n) {
+    for (size_t o = 0; o < out_channels; ++o) {
+      for (size_t oh = 0; oh < out_h; ++oh) {
+        for (size_t ow = 0; ow < out_w; ++ow) {
+          float acc = bias(o);
+          for (size_t c = 0; c < channels; ++c) {
+            for (size_t kh = 0; kh < kernel_h; ++kh) {
+              for (size_t kw = 0; kw < kernel_w; ++kw) {
+                const size_t ih = (oh * stride) + kh;
+                const size_t iw = (ow * stride) + kw;
+                if (ih < padding || iw < padding || ih - padding >= height ||
+                    iw - padding >= width) {
+                  continue;
+                }
+                acc += input(n, c, ih - padding, iw - padding) *
+                       weight(o, c, kh, kw);
+              }
+            }
+          }
+          out(n, o, oh, ow) = acc;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+// Sum of the outputs, to differentiate a whole tensor at once
+auto total(const synapse::Tensor &tensor) -> float {
+  float out = 0.0F;
+  for (const float value : tensor.to_vector()) {
+    out += value;
+  }
+  return out;
+}
+} // namespace
+
+TEST(NNTests, LinearMatchesUnfusedOps) {
+  const synapse::Tensor input = make_tensor({2, 3, 20}, 0.1F);
+  const synapse::Tensor weight = make_tensor({7, 20}, 0.5F);
+  const synapse::Tensor bias = make_tensor({7}, 0.9F);
+  const synapse::Tensor product =
+      synapse::add(synapse::matmul(input, weight.transpose(0, 1)), bias);
+
+  EXPECT_TRUE(synapse::is_close(synapse::nn::linear(input, weight, &bias),
+                                product, 1e-4F));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::nn::linear(input, weight, &bias, synapse::Activation::Relu),
+      synapse::relu(product), 1e-4F));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::nn::linear(input, weight, &bias, synapse::Activation::Gelu),
+      synapse::gelu(product), 1e-4F));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::nn::linear(input, weight),
+      synapse::matmul(input, weight.transpose(0, 1)), 1e-4F));
+
+  // Views are read through their strides
+  const synapse::Tensor transposed = make_tensor({20, 7}, 0.5F);
+  EXPECT_TRUE(synapse::is_close(
+      synapse::nn::linear(input, transposed.transpose(0, 1)),
+      synapse::matmul(input, transposed), 1e-4F));
+
+  EXPECT_THROW(synapse::nn::linear(input, make_tensor({7, 3}, 0.0F)),
+               std::invalid_argument);
+  EXPECT_THROW(synapse::nn::linear(input, weight, &input),
+               std::invalid_argument);
+}
+
+TEST(NNTests, LinearGradients) {
+  synapse::Tensor input = make_tensor({4, 5}, 0.1F);
+  synapse::nn::Linear layer(make_tensor({3, 5}, 0.5F), make_tensor({3}, 0.9F),
+                            synapse::Activation::Gelu);
+  input.set_requires_grad();
+  for (synapse::Tensor *parameter : layer.parameters()) {
+    parameter->set_requires_grad();
+  }
+  synapse::sum(layer(input)).backward();
+
+  // Same graph built from func.h ops
+  synapse::Tensor ref_input = make_tensor({4, 5}, 0.1F);
+  synapse::Tensor ref_weight = make_tensor({3, 5}, 0.5F);
+  synapse::Tensor ref_bias = make_tensor({3}, 0.9F);
+  ref_input.set_requires_grad();
+  ref_weight.set_requires_grad();
+  ref_bias.set_requires_grad();
+  synapse::sum(synapse::gelu(synapse::add(
+                   synapse::matmul(ref_input, ref_weight.transpose(0, 1)),
+                   ref_bias)))
+      .backward();
+
+  EXPECT_TRUE(synapse::is_close(input.grad(), ref_input.grad(), 1e-4F));
+  EXPECT_TRUE(synapse::is_close(layer.weight().grad(), ref_weight.grad(),
+                                1e-4F));
+  EXPECT_TRUE(synapse::is_close(layer.bias().grad(), ref_bias.grad(), 1e-4F));
+}
+
+TEST(NNTests, Conv2dMatchesDirectConvolution) {
+  const synapse::Tensor input = make_tensor({2, 3, 9, 8}, 0.1F);
+  const synapse::Tensor bias = make_tensor({4}, 0.9F);
+  for (const auto &[kernel, stride, padding] :
+       std::vector<std::tuple<size_t, size_t, size_t>>{
+           {3, 1, 0}, {3, 2, 1}, {1, 1, 0}, {5, 3, 2}}) {
+    const synapse::Tensor weight = make_tensor({4, 3, kernel, kernel}, 0.5F);
+    const synapse::Tensor expected =
+        naive_conv2d(input, weight, bias, stride, padding);
+    EXPECT_TRUE(synapse::is_close(
+        synapse::nn::conv2d(input, weight, &bias, stride, padding), expected,
+        1e-4F))
+        << "kernel " << kernel << ", stride " << stride << ", padding "
+        << padding;
+    EXPECT_TRUE(synapse::is_close(
+        synapse::nn::conv2d(input, weight, &bias, stride, padding,
+                            synapse::Activation::Relu),
+        synapse::relu(expected), 1e-4F));
+  }
+
+  EXPECT_THROW(synapse::nn::conv2d(input, make_tensor({4, 2, 3, 3}, 0.0F)),
+               std::invalid_argument);
+  EXPECT_THROW(synapse::nn::conv2d(input, make_tensor({4, 3, 11, 3}, 0.0F)),
+               std::invalid_argument);
+}
+
+TEST(NNTests, Conv2dGradientsMatchFiniteDifferences) {
+  const synapse::Shape input_shape{2, 2, 5, 4};
+  const synapse::Shape weight_shape{3, 2, 3, 3};
+  synapse::Tensor input = make_tensor(input_shape, 0.1F);
+  synapse::Tensor weight = make_tensor(weight_shape, 0.5F);
+  synapse::Tensor bias = make_tensor({3}, 0.9F);
+  input.set_requires_grad();
+  weight.set_requires_grad();
+  bias.set_requires_grad();
+  synapse::sum(synapse::nn::conv2d(input, weight, &bias, 2, 1)).backward();
+
+  const float eps = 1e-2F;
+  const auto check = [&](const synapse::Tensor &param,
+                         const synapse::Tensor &grad, auto forward) {
+    std::vector<float> values = param.to_vector();
+    const std::vector<float> actual = grad.to_vector();
+    for (size_t i = 0; i < values.size(); ++i) {
+      const float original = values[i];
+      values[i] = original + eps;
+      const float plus = total(forward(synapse::Tensor{values, param.shape()}));
+      values[i] = original - eps;
+      const float minus =
+          total(forward(synapse::Tensor{values, param.shape()}));
+      values[i] = original;
+      EXPECT_NEAR(actual[i], (plus - minus) / (2.0F * eps), 2e-2F)
+          << "at position " << i;
+    }
+  };
+  const synapse::NoGradGuard no_grad;
+  check(input, input.grad(), [&](const synapse::Tensor &x) {
+    return synapse::nn::conv2d(x, weight, &bias, 2, 1);
+  });
+  check(weight, weight.grad(), [&](const synapse::Tensor &w) {
+    return synapse::nn::conv2d(input, w, &bias, 2, 1);
+  });
+  check(bias, bias.grad(), [&](const synapse::Tensor &b) {
+    return synapse::nn::conv2d(input, weight, &b, 2, 1);
+  });
+}
+
+TEST(NNTests, LayerNorm) {
+  const synapse::Tensor input = make_tensor({3, 4, 6}, 0.3F);
+  const synapse::Tensor weight = make_tensor({6}, 0.5F);
+  const synapse::Tensor bias = make_tensor({6}, 0.9F);
+  const synapse::Tensor fused = synapse::nn::layer_norm(input, weight, bias);
+
+  // Reference from the differentiable path
+  synapse::Tensor leaf = make_tensor({3, 4, 6}, 0.3F);
+  leaf.set_requires_grad();
+  const synapse::Tensor unfused = synapse::nn::layer_norm(leaf, weight, bias);
+  EXPECT_TRUE(synapse::is_close(fused, unfused, 1e-4F));
+  EXPECT_TRUE(unfused.requires_grad());
+
+  // Without affine parameters every row has zero mean and unit variance
+  synapse::nn::LayerNorm layer({4, 6});
+  const synapse::Tensor normalized = layer(input);
+  EXPECT_TRUE(synapse::is_close(synapse::mean(normalized, {1, 2}),
+                                synapse::Tensor::zeros({3}), 1e-5F));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::var(normalized, {1, 2}, false, 0),
+      synapse::Tensor{std::vector<float>(3, 1.0F), synapse::Shape{3}}, 1e-3F));
+  EXPECT_EQ(layer.parameters().size(), 2);
+
+  EXPECT_THROW(synapse::nn::layer_norm(input, make_tensor({4}, 0.0F),
+                                       make_tensor({4}, 0.0F)),
+               std::invalid_argument);
+}
+
+TEST(NNTests, Softmax) {
+  const synapse::Tensor input = make_tensor({3, 5, 4}, 0.2F);
+  for (size_t dim = 0; dim < input.ndim(); ++dim) {
+    const synapse::Tensor shifted = synapse::exp(
+        synapse::sub(input, synapse::max(input, {dim}, true)));
+    const synapse::Tensor expected =
+        synapse::div(shifted, synapse::sum(shifted, {dim}, true));
+    EXPECT_TRUE(
+        synapse::is_close(synapse::nn::softmax(input, dim), expected, 1e-5F))
+        << "along dimension " << dim;
+  }
+
+  // Large logits do not overflow
+  const synapse::Tensor large{std::vector<float>{1000.0F, 1001.0F, 999.0F},
+                              synapse::Shape{3}};
+  EXPECT_TRUE(synapse::is_close(
+      synapse::nn::Softmax(0)(large),
+      synapse::Tensor{std::vector<float>{0.244728F, 0.665241F, 0.090031F},
+                      synapse::Shape{3}}));
+  EXPECT_THROW(synapse::nn::softmax(large, 1), std::out_of_range);
+}
+
+TEST(NNTests, Modules) {
+  synapse::nn::Linear linear(8, 4);
+  EXPECT_EQ(linear.weight().shape(), (synapse::Shape{4, 8}));
+  EXPECT_EQ(linear.bias().shape(), (synapse::Shape{4}));
+  EXPECT_EQ(linear.parameters().size(), 2);
+  EXPECT_EQ(linear(make_tensor({5, 8}, 0.0F)).shape(), (synapse::Shape{5, 4}));
+  for (const float value : linear.weight().to_vector()) {
+    EXPECT_LE(std::fabs(value), 1.0F / std::sqrt(8.0F));
+  }
+
+  synapse::nn::Linear no_bias(8, 4, false);
+  EXPECT_EQ(no_bias.parameters().size(), 1);
+  EXPECT_THROW(no_bias.bias(), std::logic_error);
+
+  synapse::nn::Conv2d conv(3, 6, 3, 1, 1);
+  EXPECT_EQ(conv.weight().shape(), (synapse::Shape{6, 3, 3, 3}));
+  EXPECT_EQ(conv(make_tensor({1, 3, 7, 7}, 0.0F)).shape(),
+            (synapse::Shape{1, 6, 7, 7}));
+
+  const synapse::Tensor input = make_tensor({2, 3}, 0.0F);
+  EXPECT_TRUE(
+      synapse::is_close(synapse::nn::ReLU()(input), synapse::relu(input)));
+  EXPECT_TRUE(
+      synapse::is_close(synapse::nn::GELU()(input), synapse::gelu(input)));
+  EXPECT_TRUE(synapse::nn::ReLU().parameters().empty());
+}
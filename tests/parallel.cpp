@@ -0,0 +1,134 @@
+#include "func.h"
+#include "gemm.h"
+#include "ndarray.h"
+#include "parallel.h"
+#include "tensor.h"
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+auto sine_values(size_t numel, float phase) -> std::vector<float> {
+  std::vector<float> values(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    values[i] = std::sin(static_cast<float>(i) + phase);
+  }
+  return values;
+}
+
+// Restores the thread count changed by a test
+class ParallelTests : public ::testing::Test {
+protected:
+  void SetUp() override { this->_threads = synapse::get_num_threads(); }
+  void TearDown() override { synapse::set_num_threads(this->_threads); }
+
+private:
+  size_t _threads = 1;
+};
+} // namespace
+
+TEST_F(ParallelTests, ParallelForVisitsEveryIndexOnce) {
+  synapse::set_num_threads(4);
+  std::vector<std::atomic<int>> visits(100000);
+  synapse::parallel_for(0, visits.size(), 1000, [&](size_t begin, size_t end) {
+    EXPECT_TRUE(synapse::in_parallel_region());
+    for (size_t i = begin; i < end; ++i) {
+      ++visits[i];
+    }
+  });
+  for (const auto &count : visits) {
+    ASSERT_EQ(count.load(), 1);
+  }
+  EXPECT_FALSE(synapse::in_parallel_region());
+}
+
+TEST_F(ParallelTests, SmallRangesStayOnTheCallingThread) {
+  synapse::set_num_threads(4);
+  size_t calls = 0;
+  synapse::parallel_for(0, 100, synapse::GRAIN_SIZE,
+                        [&](size_t begin, size_t end) {
+                          EXPECT_EQ(begin, 0);
+                          EXPECT_EQ(end, 100);
+                          ++calls;
+                        });
+  EXPECT_EQ(calls, 1);
+}
+
+TEST_F(ParallelTests, ParallelReduce) {
+  synapse::set_num_threads(4);
+  const size_t n = 1000000;
+  const size_t sum = synapse::parallel_reduce(
+      0, n, 1000, size_t{0},
+      [](size_t begin, size_t end, size_t acc) {
+        for (size_t i = begin; i < end; ++i) {
+          acc += i;
+        }
+        return acc;
+      },
+      [](size_t lhs, size_t rhs) { return lhs + rhs; });
+  EXPECT_EQ(sum, n * (n - 1) / 2);
+}
+
+TEST_F(ParallelTests, NestedRegionsRunInline) {
+  synapse::set_num_threads(4);
+  std::atomic<size_t> total{0};
+  synapse::parallel_for(0, 8, 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      synapse::parallel_for(0, 1000, 1, [&](size_t inner_begin,
+                                            size_t inner_end) {
+        // The whole inner range arrives in one call
+        EXPECT_EQ(inner_end - inner_begin, 1000);
+        total += inner_end - inner_begin;
+      });
+    }
+  });
+  EXPECT_EQ(total.load(), 8000);
+}
+
+TEST_F(ParallelTests, ExceptionsReachTheCaller) {
+  synapse::set_num_threads(4);
+  const auto failing = [](size_t begin, size_t end) {
+    if (begin <= 37 && 37 < end) {
+      throw std::runtime_error("boom");
+    }
+  };
+  EXPECT_THROW(synapse::parallel_for(0, 64, 1, failing), std::runtime_error);
+  // The pool is still usable afterwards
+  std::atomic<size_t> count{0};
+  synapse::parallel_for(0, 64, 1, [&](size_t begin, size_t end) {
+    count += end - begin;
+  });
+  EXPECT_EQ(count.load(), 64);
+  EXPECT_THROW(synapse::set_num_threads(0), std::invalid_argument);
+}
+
+TEST_F(ParallelTests, KernelsMatchSerialResults) {
+  // Large enough for every kernel to be split across the threads
+  const size_t numel = 7 * (synapse::GRAIN_SIZE + 1);
+  const synapse::Tensor lhs{sine_values(numel, 0.0F), {numel}};
+  const synapse::Tensor rhs = lhs.reshape({numel / 7, 7}).transpose(0, 1);
+  const synapse::Tensor mat_1{sine_values(300 * 200, 0.5F), {300, 200}};
+  const synapse::Tensor mat_2{sine_values(200 * 500, 1.0F), {200, 500}};
+  const synapse::Tensor mat_3{sine_values(1500 * 300, 1.5F), {1500, 300}};
+  const synapse::Tensor vec{sine_values(300, 2.0F), {300}};
+
+  synapse::set_num_threads(1);
+  const synapse::Tensor exp_serial = synapse::exp(lhs);
+  const synapse::Tensor add_serial = synapse::add(rhs, rhs);
+  const synapse::Tensor mm_serial = synapse::matmul(mat_1, mat_2);
+  const synapse::Tensor mv_serial = synapse::matmul(mat_3, vec);
+  const synapse::Tensor vm_serial = synapse::matmul(vec, mat_3.transpose(0, 1));
+
+  synapse::set_num_threads(4);
+  EXPECT_TRUE(synapse::is_close(synapse::exp(lhs), exp_serial, 0.0F));
+  EXPECT_TRUE(synapse::is_close(synapse::add(rhs, rhs), add_serial, 0.0F));
+  EXPECT_TRUE(synapse::is_close(synapse::matmul(mat_1, mat_2), mm_serial,
+                                1e-4F));
+  EXPECT_TRUE(synapse::is_close(synapse::matmul(mat_3, vec), mv_serial, 1e-4F));
+  EXPECT_TRUE(synapse::is_close(synapse::matmul(vec, mat_3.transpose(0, 1)),
+                                vm_serial, 1e-4F));
+  EXPECT_FALSE(synapse::is_close(synapse::exp(lhs), lhs, 1e-3F));
+}
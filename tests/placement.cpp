@@ -0,0 +1,141 @@
+#include "allocator.h"
+#include "func.h"
+#include "parallel.h"
+#include "placement.h"
+#include "tensor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+// Restores the pool settings changed by a test
+class PlacementTests : public ::testing::Test {
+protected:
+  void SetUp() override {
+    this->_threads = synapse::get_num_threads();
+    this->_affinity = synapse::get_thread_affinity();
+  }
+  void TearDown() override {
+    synapse::set_num_threads(this->_threads);
+    synapse::set_thread_affinity(this->_affinity);
+  }
+
+private:
+  size_t _threads = 1;
+  synapse::ThreadAffinity _affinity = synapse::ThreadAffinity::None;
+};
+} // namespace
+
+TEST_F(PlacementTests, Topology) {
+  const size_t nodes = synapse::numa_num_nodes();
+  ASSERT_GE(nodes, 1);
+  size_t cpus = 0;
+  for (size_t node = 0; node < nodes; ++node) {
+    cpus += synapse::numa_node_cpus(node).size();
+  }
+  // Every CPU the process may use belongs to exactly one node
+  EXPECT_EQ(cpus, synapse::current_thread_cpus().size());
+  EXPECT_LT(synapse::numa_current_node(), nodes);
+  EXPECT_THROW(static_cast<void>(synapse::numa_node_cpus(nodes)),
+               std::invalid_argument);
+
+  const std::vector<size_t> cpu_nodes = synapse::numa_cpu_nodes();
+  ASSERT_FALSE(cpu_nodes.empty());
+  for (size_t node = 0; node < nodes; ++node) {
+    EXPECT_EQ(std::ranges::find(cpu_nodes, node) != cpu_nodes.end(),
+              !synapse::numa_node_cpus(node).empty());
+  }
+}
+
+TEST_F(PlacementTests, NumaAllocatorPolicies) {
+  for (const synapse::NumaPolicy policy :
+       {synapse::NumaPolicy::FirstTouch, synapse::NumaPolicy::Interleave,
+        synapse::NumaPolicy::Bind}) {
+    const auto allocator = std::make_shared<synapse::NumaAllocator>(policy);
+    EXPECT_EQ(allocator->allocate(0), nullptr);
+    void *ptr = allocator->allocate(10000);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) %
+                  synapse::Allocator::alignment,
+              0);
+    const size_t block = synapse::NumaAllocator::block_size(10000);
+    EXPECT_GE(block, 10000);
+    EXPECT_EQ(allocator->stats().live_bytes, block);
+    allocator->deallocate(ptr, 10000);
+    EXPECT_EQ(allocator->stats().live_bytes, 0);
+    EXPECT_EQ(allocator->stats().peak_bytes, block);
+
+    // Storages created under a guard come from the allocator
+    {
+      const synapse::AllocatorGuard guard(allocator);
+      const synapse::Tensor zeros = synapse::Tensor::zeros({1000, 100});
+      EXPECT_EQ(zeros.storage()->allocator(), allocator);
+      EXPECT_EQ(synapse::sum(zeros).to_vector(), std::vector<float>{0.0F});
+    }
+    EXPECT_EQ(allocator->stats().live_bytes, 0);
+  }
+  EXPECT_THROW(synapse::NumaAllocator(synapse::NumaPolicy::Bind,
+                                      synapse::numa_num_nodes()),
+               std::invalid_argument);
+}
+
+TEST_F(PlacementTests, ReplicatedTensor) {
+  synapse::Tensor weight{std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F},
+                         synapse::Shape{2, 2}};
+  const synapse::ReplicatedTensor replicated(weight);
+  // Only nodes with CPUs get a replica
+  const std::vector<size_t> cpu_nodes = synapse::numa_cpu_nodes();
+  ASSERT_EQ(replicated.num_replicas(), cpu_nodes.size());
+  for (const size_t node : cpu_nodes) {
+    EXPECT_EQ(replicated.replica(node).to_vector(), weight.to_vector());
+    EXPECT_EQ(replicated.replica(node).shape(), weight.shape());
+  }
+  EXPECT_EQ(replicated.local().to_vector(), weight.to_vector());
+  EXPECT_THROW(
+      static_cast<void>(replicated.replica(synapse::numa_num_nodes())),
+      std::out_of_range);
+
+  // Replicas are taken once
+  synapse::add_(weight, weight);
+  EXPECT_EQ(replicated.local().to_vector(),
+            (std::vector<float>{1.0F, 2.0F, 3.0F, 4.0F}));
+}
+
+TEST_F(PlacementTests, PinnedWorkers) {
+  const std::vector<size_t> caller_cpus = synapse::current_thread_cpus();
+  synapse::set_num_threads(2);
+  for (const synapse::ThreadAffinity affinity :
+       {synapse::ThreadAffinity::None, synapse::ThreadAffinity::Node,
+        synapse::ThreadAffinity::Core}) {
+    synapse::set_thread_affinity(affinity);
+    EXPECT_EQ(synapse::get_thread_affinity(), affinity);
+    std::mutex mutex;
+    std::vector<size_t> worker_cpus;
+    const std::thread::id caller = std::this_thread::get_id();
+    // Slow chunks, so the worker gets some of them
+    synapse::parallel_run(8, [&](size_t /*chunk*/) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      if (std::this_thread::get_id() != caller) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        worker_cpus = synapse::current_thread_cpus();
+      }
+    });
+    ASSERT_FALSE(worker_cpus.empty());
+    if (affinity == synapse::ThreadAffinity::Core) {
+      EXPECT_EQ(worker_cpus.size(), 1);
+    } else if (affinity == synapse::ThreadAffinity::Node) {
+      // Second of two threads, placed halfway through the nodes with CPUs
+      const std::vector<size_t> nodes = synapse::numa_cpu_nodes();
+      EXPECT_EQ(worker_cpus, synapse::numa_node_cpus(nodes[nodes.size() / 2]));
+    }
+  }
+  // The calling thread is left alone
+  EXPECT_EQ(synapse::current_thread_cpus(), caller_cpus);
+}
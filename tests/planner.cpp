@@ -0,0 +1,124 @@
+#include "allocator.h"
+#include "func.h"
+#include "ndarray.h"
+#include "planner.h"
+#include "tensor.h"
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+auto values(size_t numel, float scale) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = scale * std::sin(static_cast<float>(i));
+  }
+  return out;
+}
+} // namespace
+
+TEST(PlannerTests, DeadIntermediatesShareTheWorkspace) {
+  const synapse::Tensor input{values(64, 1.0F), synapse::Shape{8, 8}};
+  const synapse::Tensor weight{values(64, 0.5F), synapse::Shape{8, 8}};
+  const auto forward = [&] {
+    synapse::Tensor hidden = synapse::matmul(input, weight);
+    hidden = synapse::matmul(hidden, weight);
+    hidden = synapse::matmul(hidden, weight);
+    return hidden;
+  };
+  const synapse::Tensor expected = forward();
+
+  synapse::MemoryPlan plan(forward);
+  const auto &buffers = plan.buffers();
+  ASSERT_EQ(buffers.size(), 3);
+  // The first product is gone by the time the third one is computed
+  EXPECT_EQ(buffers[0].offset, buffers[2].offset);
+  EXPECT_NE(buffers[0].offset, buffers[1].offset);
+  EXPECT_FALSE(buffers[1].inplace);
+  EXPECT_EQ(plan.workspace_bytes(), 2 * 256);
+  EXPECT_EQ(plan.unplanned_bytes(), 2 * 256);
+
+  const synapse::Tensor out = plan.run(forward);
+  EXPECT_TRUE(synapse::is_close(out, expected));
+  EXPECT_EQ(out.storage()->allocator(), plan.allocator());
+}
+
+TEST(PlannerTests, ElementwiseOpsRunInPlace) {
+  const synapse::Tensor lhs{values(100, 1.0F), synapse::Shape{10, 10}};
+  const synapse::Tensor rhs{values(10, 2.0F), synapse::Shape{10}};
+  const auto forward = [&] {
+    synapse::Tensor hidden = synapse::add(lhs, rhs);
+    hidden = synapse::relu(hidden);
+    hidden = synapse::exp(hidden);
+    return hidden;
+  };
+  const synapse::Tensor expected = forward();
+
+  synapse::MemoryPlan plan(forward);
+  const auto &buffers = plan.buffers();
+  ASSERT_EQ(buffers.size(), 3);
+  EXPECT_FALSE(buffers[0].inplace);
+  EXPECT_TRUE(buffers[1].inplace);
+  EXPECT_TRUE(buffers[2].inplace);
+  EXPECT_EQ(buffers[1].offset, buffers[0].offset);
+  EXPECT_EQ(buffers[2].offset, buffers[0].offset);
+  EXPECT_EQ(plan.workspace_bytes(), 448);
+  EXPECT_EQ(plan.unplanned_bytes(), 2 * 448);
+
+  for (int i = 0; i < 3; ++i) {
+    const synapse::Tensor out = plan.run(forward);
+    EXPECT_TRUE(synapse::is_close(out, expected));
+  }
+  const synapse::AllocatorStats stats = plan.allocator()->stats();
+  EXPECT_EQ(stats.allocations, 9);
+  EXPECT_EQ(stats.hits, 9);
+  EXPECT_EQ(stats.misses, 0);
+}
+
+TEST(PlannerTests, OperandsReadLaterAreNotOverwritten) {
+  const synapse::Tensor input{values(16, 1.0F), synapse::Shape{16}};
+  const auto forward = [&] {
+    const synapse::Tensor shifted = synapse::sub(input, input);
+    const synapse::Tensor rectified = synapse::relu(input);
+    const synapse::Tensor product =
+        synapse::mul(rectified, synapse::add(rectified, shifted));
+    return synapse::add(product, rectified);
+  };
+  const synapse::Tensor expected = forward();
+
+  synapse::MemoryPlan plan(forward);
+  const auto &buffers = plan.buffers();
+  ASSERT_EQ(buffers.size(), 5);
+  EXPECT_FALSE(buffers[1].inplace);
+  EXPECT_FALSE(buffers[2].inplace);
+  // Only the temporary sum dies right after the product reads it
+  EXPECT_TRUE(buffers[3].inplace);
+  EXPECT_EQ(buffers[3].offset, buffers[2].offset);
+  EXPECT_TRUE(synapse::is_close(plan.run(forward), expected));
+}
+
+TEST(PlannerTests, DivergingPassFallsBack) {
+  synapse::Shape shape{4};
+  const auto forward = [&] {
+    const synapse::Tensor input = synapse::Tensor::zeros(shape);
+    return synapse::add(input, input);
+  };
+  synapse::MemoryPlan plan(forward);
+  EXPECT_EQ(plan.buffers().size(), 2);
+
+  shape = {1000};
+  const synapse::Tensor out = plan.run(forward);
+  EXPECT_EQ(out.to_vector(), std::vector<float>(1000, 0.0F));
+  const synapse::AllocatorStats stats = plan.allocator()->stats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_NE(out.storage()->allocator(), synapse::default_allocator());
+}
+
+TEST(PlannerTests, EmptyPlan) {
+  const synapse::MemoryPlan plan([] {});
+  EXPECT_TRUE(plan.buffers().empty());
+  EXPECT_EQ(plan.workspace_bytes(), 0);
+  EXPECT_EQ(plan.unplanned_bytes(), 0);
+}
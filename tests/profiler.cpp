@@ -0,0 +1,97 @@
+#include "func.h"
+#include "profiler.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(ProfilerTests, SummaryAggregatesByName) {
+  synapse::Profiler::clear();
+  const std::vector<synapse::Shape> shapes{{4, 4}, {4, 4}};
+  synapse::Profiler::record({"matmul", shapes, 0, 3000, 384, 128, 0});
+  synapse::Profiler::record({"add", shapes, 3000, 1000, 192, 16, 0});
+  synapse::Profiler::record({"matmul", shapes, 4000, 1000, 384, 128, 0});
+  const std::string summary = synapse::Profiler::summary();
+  synapse::Profiler::clear();
+
+  // Most time consuming first
+  const size_t matmul = summary.find("matmul");
+  const size_t add = summary.find("add");
+  ASSERT_NE(matmul, std::string::npos);
+  ASSERT_NE(add, std::string::npos);
+  EXPECT_LT(matmul, add);
+  std::istringstream fields(
+      summary.substr(matmul, summary.find('\n', matmul) - matmul));
+  std::string name;
+  size_t calls = 0;
+  double total_ms = 0.0;
+  double mean_us = 0.0;
+  double share = 0.0;
+  double bandwidth = 0.0;
+  double throughput = 0.0;
+  fields >> name >> calls >> total_ms >> mean_us >> share >> bandwidth >>
+      throughput;
+  EXPECT_EQ(calls, 2);
+  EXPECT_DOUBLE_EQ(total_ms, 0.004);
+  EXPECT_DOUBLE_EQ(mean_us, 2.0);
+  EXPECT_DOUBLE_EQ(share, 80.0);
+  EXPECT_DOUBLE_EQ(bandwidth, 0.19);
+  EXPECT_DOUBLE_EQ(throughput, 0.06);
+}
+
+TEST(ProfilerTests, ChromeTrace) {
+  synapse::Profiler::clear();
+  synapse::Profiler::record({"add", {{2, 3}, {3}}, 1500, 2000, 60, 6, 0});
+  std::ostringstream out;
+  synapse::Profiler::write_chrome_trace(out);
+  synapse::Profiler::clear();
+  EXPECT_EQ(out.str(),
+            "{\"traceEvents\":[\n"
+            "{\"name\":\"add\",\"cat\":\"synapse\",\"ph\":\"X\",\"ts\":1.500,"
+            "\"dur\":2.000,\"pid\":0,\"tid\":0,\"args\":{\"shapes\":[[2, 3],"
+            "[3]],\"bytes\":60,\"flops\":6}}\n"
+            "],\"displayTimeUnit\":\"ns\"}\n");
+}
+
+TEST(ProfilerTests, InstrumentsOpsAndAllocations) {
+  const synapse::Tensor lhs = synapse::Tensor::zeros({8, 4});
+  const synapse::Tensor rhs = synapse::Tensor::zeros({4});
+  synapse::Profiler::clear();
+  synapse::Profiler::start();
+  const synapse::Tensor sum = synapse::add(lhs, rhs);
+  const synapse::Tensor product = synapse::matmul(lhs, lhs.transpose(0, 1));
+  synapse::Profiler::stop();
+  // Stopped, so not recorded
+  const synapse::Tensor ignored = synapse::add(lhs, rhs);
+  const std::vector<synapse::ProfileEvent> events =
+      synapse::Profiler::events();
+  synapse::Profiler::clear();
+  if constexpr (!synapse::PROFILE) {
+    EXPECT_FALSE(synapse::Profiler::is_enabled());
+    EXPECT_TRUE(events.empty());
+    return;
+  }
+
+  const auto find = [&events](const char *name) {
+    return std::ranges::find_if(events, [name](const auto &event) {
+      return std::string(event.name) == name;
+    });
+  };
+  ASSERT_NE(find("add"), events.end());
+  EXPECT_EQ(find("add")->input_shapes,
+            (std::vector<synapse::Shape>{{8, 4}, {4}}));
+  EXPECT_EQ(find("add")->bytes, (32 + 4 + 32) * sizeof(float));
+  EXPECT_EQ(find("add")->flops, 32);
+  ASSERT_NE(find("matmul"), events.end());
+  EXPECT_EQ(find("matmul")->flops, 2 * 8 * 8 * 4);
+  ASSERT_NE(find("allocate"), events.end());
+  EXPECT_EQ(find("allocate")->bytes, 32 * sizeof(float));
+  EXPECT_EQ(std::ranges::count_if(events,
+                                  [](const auto &event) {
+                                    return std::string(event.name) == "add";
+                                  }),
+            1);
+}
@@ -0,0 +1,267 @@
+#include "dtype.h"
+#include "func.h"
+#include "gemm.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "quantize.h"
+#include "tensor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Covers the whole int8 range, extremes included
+auto make_int8(size_t numel, size_t seed) -> std::vector<int8_t> {
+  std::vector<int8_t> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = static_cast<int8_t>(static_cast<int>(((i + seed) * 97) % 256) -
+                                 128);
+  }
+  return out;
+}
+
+auto make_values(size_t numel, float seed) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::sin(seed + (static_cast<float>(i) * 0.37F));
+  }
+  return out;
+}
+
+auto naive_igemm(size_t m, size_t n, size_t k, const std::vector<int8_t> &a,
+                 size_t rs_a, size_t cs_a, const std::vector<int8_t> &b,
+                 size_t rs_b, size_t cs_b) -> std::vector<int32_t> {
+  std::vector<int32_t> c(m * n, 0);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t p = 0; p < k; ++p) {
+        c[(i * n) + j] +=
+            a[(i * rs_a) + (p * cs_a)] * b[(p * rs_b) + (j * cs_b)];
+      }
+    }
+  }
+  return c;
+}
+
+auto supported_backends() -> std::vector<synapse::GemmBackend> {
+  std::vector<synapse::GemmBackend> out;
+  for (const auto backend :
+       {synapse::GemmBackend::Scalar, synapse::GemmBackend::Avx2,
+        synapse::GemmBackend::Avx512}) {
+    if (synapse::gemm_backend_supported(backend)) {
+      out.push_back(backend);
+    }
+  }
+  return out;
+}
+
+auto max_abs_diff(const synapse::Tensor &lhs, const synapse::Tensor &rhs)
+    -> float {
+  const std::vector<float> a = lhs.to_vector();
+  const std::vector<float> b = rhs.to_vector();
+  float out = 0.0F;
+  for (size_t i = 0; i < a.size(); ++i) {
+    out = std::max(out, std::fabs(a[i] - b[i]));
+  }
+  return out;
+}
+} // namespace
+
+class QuantizeTests : public ::testing::Test {
+protected:
+  synapse::GemmBackend initial = synapse::gemm_backend();
+  void TearDown() override { synapse::set_gemm_backend(initial); }
+};
+
+TEST_F(QuantizeTests, IgemmIsExactOnAllBackends) {
+  // Full tiles, edge tiles, depths that are not a multiple of 4, and enough
+  // rows for several blocks
+  const std::vector<std::vector<size_t>> sizes{
+      {1, 1, 1}, {7, 5, 3}, {13, 33, 17}, {64, 64, 64}, {200, 70, 301}};
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    for (const auto &size : sizes) {
+      const size_t m = size[0];
+      const size_t n = size[1];
+      const size_t k = size[2];
+      const auto a = make_int8(m * k, 3);
+      const auto b = make_int8(k * n, 11);
+      std::vector<int32_t> c(m * n, -1);
+      synapse::igemm(m, n, k, a.data(), k, 1, b.data(), n, 1, c.data(), n);
+      EXPECT_EQ(c, naive_igemm(m, n, k, a, k, 1, b, n, 1));
+
+      // Transposed operands are read through their strides
+      std::vector<int32_t> t(m * n);
+      synapse::igemm(m, n, k, a.data(), 1, m, b.data(), 1, k, t.data(), n);
+      EXPECT_EQ(t, naive_igemm(m, n, k, a, 1, m, b, 1, k));
+
+      // Packed once, reused across products
+      const synapse::PackedInt8Matrix packed(k, n, b.data(), n, 1);
+      std::vector<int32_t> p(m * n);
+      synapse::igemm(m, a.data(), k, 1, packed, p.data(), n);
+      EXPECT_EQ(p, c);
+    }
+  }
+  std::vector<int32_t> c(1);
+  const std::vector<int8_t> long_row(synapse::IGEMM_MAX_DEPTH + 1);
+  EXPECT_THROW(synapse::igemm(1, 1, long_row.size(), long_row.data(), 0, 1,
+                              long_row.data(), 1, 0, c.data(), 1),
+               std::invalid_argument);
+}
+
+TEST_F(QuantizeTests, IgemmRequantizes) {
+  const size_t m = 9;
+  const size_t n = 20;
+  const size_t k = 31;
+  const auto a = make_int8(m * k, 5);
+  const auto b = make_int8(k * n, 7);
+  std::vector<int32_t> b_zero_points(n);
+  std::vector<float> scales(n);
+  std::vector<float> bias(n);
+  for (size_t j = 0; j < n; ++j) {
+    b_zero_points[j] = static_cast<int32_t>(j % 5) - 2;
+    scales[j] = 1e-4F * static_cast<float>(j + 1);
+    bias[j] = 0.1F * static_cast<float>(j % 3) - 0.1F;
+  }
+  const synapse::Requantization requantization{
+      .a_zero_point = 3,
+      .b_zero_points = b_zero_points.data(),
+      .cs_b_zero_points = 1,
+      .scales = scales.data(),
+      .cs_scales = 1,
+      .bias = bias.data(),
+      .cs_bias = 1,
+      .activation = synapse::Activation::Relu,
+      .out_scale = 0.01F,
+      .out_zero_point = -20};
+
+  std::vector<float> expected(m * n);
+  for (size_t i = 0; i < m; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      int32_t acc = 0;
+      for (size_t p = 0; p < k; ++p) {
+        acc += (a[(i * k) + p] - 3) * (b[(p * n) + j] - b_zero_points[j]);
+      }
+      expected[(i * n) + j] =
+          std::max(scales[j] * static_cast<float>(acc) + bias[j], 0.0F);
+    }
+  }
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    std::vector<float> real(m * n);
+    synapse::igemm(m, n, k, a.data(), k, 1, b.data(), n, 1, real.data(), n,
+                   requantization);
+    std::vector<int8_t> quantized(m * n);
+    synapse::igemm(m, n, k, a.data(), k, 1, b.data(), n, 1, quantized.data(),
+                   n, requantization);
+    for (size_t i = 0; i < m * n; ++i) {
+      EXPECT_NEAR(real[i], expected[i], 1e-4F);
+      const float rounded =
+          std::clamp(std::nearbyint(expected[i] / 0.01F) - 20.0F, -128.0F,
+                     127.0F);
+      EXPECT_NEAR(quantized[i], rounded, 1.0F);
+    }
+  }
+}
+
+TEST_F(QuantizeTests, QuantizeRoundTrips) {
+  const synapse::Tensor tensor{make_values(60, 0.5F), synapse::Shape{4, 15}};
+  const synapse::QuantParams params =
+      synapse::QuantParams::from_range(-1.0F, 1.0F);
+  const synapse::QuantizedTensor quantized = synapse::quantize(tensor, params);
+  EXPECT_EQ(quantized.values().dtype(), synapse::DType::Int8);
+  EXPECT_LE(max_abs_diff(quantized.dequantize(), tensor),
+            params.scales[0] / 2.0F + 1e-6F);
+
+  // One symmetric scale per row
+  synapse::Observer observer(size_t{0}, true);
+  observer.observe(tensor);
+  const synapse::QuantParams rows = observer.params();
+  ASSERT_EQ(rows.scales.size(), 4);
+  EXPECT_EQ(rows.zero_points, (std::vector<int32_t>{0, 0, 0, 0}));
+  const synapse::QuantizedTensor per_row = synapse::quantize(tensor, rows);
+  EXPECT_LE(max_abs_diff(per_row.dequantize(), tensor),
+            *std::ranges::max_element(rows.scales) / 2.0F + 1e-6F);
+
+  EXPECT_THROW(synapse::quantize(tensor, {{1.0F, 1.0F}, {0, 0}, 1}),
+               std::invalid_argument);
+  EXPECT_THROW(synapse::quantize(tensor, {{0.0F}, {0}, std::nullopt}),
+               std::invalid_argument);
+}
+
+TEST_F(QuantizeTests, ObserverCalibratesRange) {
+  synapse::Observer observer;
+  EXPECT_THROW(static_cast<void>(observer.params()), std::logic_error);
+  const synapse::Tensor first{{0.5F, 2.0F}, synapse::Shape{2}};
+  const synapse::Tensor second{{-0.55F, 1.0F}, synapse::Shape{2}};
+  EXPECT_EQ(&observer(first), &first);
+  observer(second);
+  const synapse::QuantParams params = observer.params();
+  EXPECT_FLOAT_EQ(params.scales[0], 2.55F / 255.0F);
+  EXPECT_EQ(params.zero_points[0], -73);
+  EXPECT_FALSE(params.per_channel());
+}
+
+TEST_F(QuantizeTests, QuantizedLinearMatchesFloatLayer) {
+  synapse::nn::Linear layer(64, 32, true, synapse::Activation::Relu);
+  const synapse::Tensor input{make_values(5 * 64, 0.2F), synapse::Shape{5, 64}};
+  const synapse::Tensor expected = layer(input);
+
+  synapse::Observer observer;
+  observer(input);
+  const synapse::nn::QuantizedLinear calibrated(layer, observer.params());
+  const synapse::nn::QuantizedLinear dynamic(layer);
+  EXPECT_EQ(calibrated.weight().params().scales.size(), 32);
+  for (const auto backend : supported_backends()) {
+    synapse::set_gemm_backend(backend);
+    const synapse::Tensor out = calibrated(input);
+    EXPECT_EQ(out.shape(), expected.shape());
+    EXPECT_LT(max_abs_diff(out, expected), 0.02F);
+    EXPECT_LT(max_abs_diff(dynamic(input), expected), 0.02F);
+
+    // Int8 end to end, requantized inside the kernel
+    const synapse::QuantParams output =
+        synapse::QuantParams::from_range(0.0F, 2.0F);
+    const synapse::QuantizedTensor chained = calibrated.forward(
+        synapse::quantize(input, observer.params()), output);
+    EXPECT_LT(max_abs_diff(chained.dequantize(), expected),
+              0.02F + output.scales[0]);
+  }
+}
+
+TEST_F(QuantizeTests, QuantizedMatmulPerColumn) {
+  const synapse::Tensor lhs{make_values(6 * 10, 0.1F), synapse::Shape{6, 10}};
+  const synapse::Tensor rhs{make_values(10 * 4, 0.9F), synapse::Shape{10, 4}};
+  synapse::Observer columns(size_t{1});
+  columns.observe(rhs);
+  const synapse::QuantizedTensor q_lhs = synapse::quantize(
+      lhs, synapse::QuantParams::from_range(-1.0F, 1.0F));
+  const synapse::QuantizedTensor q_rhs =
+      synapse::quantize(rhs, columns.params());
+  const synapse::Tensor expected = synapse::matmul(lhs, rhs);
+  EXPECT_LT(max_abs_diff(synapse::quantized_matmul(q_lhs, q_rhs), expected),
+            0.05F);
+  EXPECT_THROW(static_cast<void>(synapse::quantized_matmul(q_rhs, q_lhs)),
+               std::invalid_argument);
+}
+
+TEST_F(QuantizeTests, Int8MatmulSaturatesExactProducts) {
+  const synapse::Tensor lhs{
+      synapse::NDArray({100, -100, 3, 4}, {2, 2}, synapse::DType::Int8)};
+  const synapse::Tensor rhs{
+      synapse::NDArray({1, 2, 1, 2}, {2, 2}, synapse::DType::Int8)};
+  const synapse::Tensor out = synapse::matmul(lhs, rhs);
+  EXPECT_EQ(out.dtype(), synapse::DType::Int8);
+  EXPECT_EQ(out.to_vector(), (std::vector<float>{0.0F, 0.0F, 7.0F, 14.0F}));
+
+  const synapse::Tensor large{
+      synapse::NDArray({100, 100}, {1, 2}, synapse::DType::Int8)};
+  const synapse::Tensor column{
+      synapse::NDArray({100, 100}, {2, 1}, synapse::DType::Int8)};
+  EXPECT_EQ(synapse::matmul(large, column).to_vector(),
+            (std::vector<float>{127.0F}));
+}
@@ -0,0 +1,192 @@
+#include "autograd.h"
+#include "dtype.h"
+#include "func.h"
+#include "ndarray.h"
+#include "parallel.h"
+#include "reduce.h"
+#include "tensor.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Values 0.1 * (i % 7) - 0.3 of the positions i of `shape`
+auto iota(const synapse::Shape &shape) -> synapse::Tensor {
+  std::vector<float> data(synapse::shape_numel(shape));
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (0.1F * static_cast<float>(i % 7)) - 0.3F;
+  }
+  return {data, shape};
+}
+
+// Sums a 3D array over its middle dimension, element by element
+auto naive_sum_middle(const synapse::NDArray &array) -> std::vector<float> {
+  std::vector<float> out;
+  for (size_t i = 0; i < array.shape()[0]; ++i) {
+    for (size_t k = 0; k < array.shape()[2]; ++k) {
+      double sum = 0.0;
+      for (size_t j = 0; j < array.shape()[1]; ++j) {
+        sum += static_cast<double>(array(i, j, k));
+      }
+      out.push_back(static_cast<float>(sum));
+    }
+  }
+  return out;
+}
+} // namespace
+
+TEST(ReduceTests, SumOverDimensions) {
+  const synapse::Tensor tensor{{1.0F, 2.0F, 3.0F, 4.0F, 5.0F, 6.0F}, {2, 3}};
+  EXPECT_TRUE(synapse::is_close(synapse::sum(tensor), {{21.0F}, {}}));
+  EXPECT_TRUE(synapse::is_close(synapse::sum(tensor, {0}),
+                                {{5.0F, 7.0F, 9.0F}, {3}}));
+  EXPECT_TRUE(synapse::is_close(synapse::sum(tensor, {1}, true),
+                                {{6.0F, 15.0F}, {2, 1}}));
+  EXPECT_EQ(synapse::sum(tensor, {0, 1}, true).shape(), (synapse::Shape{1, 1}));
+  EXPECT_THROW(synapse::sum(tensor, {2}), std::out_of_range);
+  EXPECT_THROW(synapse::sum(tensor, {1, 1}), std::invalid_argument);
+}
+
+TEST(ReduceTests, EveryLayoutMatchesNaiveSum) {
+  const synapse::Tensor tensor = iota({6, 50, 40});
+  // Dense runs, rows of outputs, and gathered blocks
+  const synapse::NDArray layouts[] = {
+      tensor.NDArray::permute({0, 2, 1}),
+      tensor,
+      tensor.NDArray::permute({1, 0, 2}).slice(2, 0, 40, 3),
+      tensor.NDArray::expand({6, 50, 40}),
+  };
+  for (const synapse::NDArray &array : layouts) {
+    const synapse::NDArray sum =
+        synapse::reduce(array, synapse::ReduceOp::Sum, {1});
+    const std::vector<float> expected = naive_sum_middle(array);
+    const std::vector<float> actual = sum.to_vector();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(actual[i], expected[i], 1e-4F);
+    }
+  }
+}
+
+TEST(ReduceTests, ParallelMatchesSerial) {
+  const synapse::Tensor tensor = iota({300, 1000});
+  const size_t threads = synapse::get_num_threads();
+  synapse::set_num_threads(1);
+  const synapse::Tensor serial_all = synapse::sum(tensor);
+  const synapse::Tensor serial_rows = synapse::max(tensor, {1});
+  const synapse::Tensor serial_cols = synapse::var(tensor, {0});
+  synapse::set_num_threads(4);
+  EXPECT_TRUE(synapse::is_close(synapse::sum(tensor), serial_all, 1e-2F));
+  EXPECT_TRUE(synapse::is_close(synapse::max(tensor, {1}), serial_rows));
+  EXPECT_TRUE(synapse::is_close(synapse::var(tensor, {0}), serial_cols));
+  synapse::set_num_threads(threads);
+}
+
+TEST(ReduceTests, SummationStaysAccurate) {
+  // A serial float accumulator drifts by several percent on this sum
+  const size_t n = size_t{1} << 24;
+  const synapse::Tensor tensor{std::vector<float>(n, 0.1F), {n}};
+  const float expected = 0.1F * static_cast<float>(n);
+  EXPECT_NEAR(synapse::sum(tensor).data()[0], expected, expected * 1e-6F);
+
+  // Same along the rows of a matrix
+  const synapse::Tensor rows{std::vector<float>(n, 0.1F), {n / 4, 4}};
+  const std::vector<float> sums = synapse::sum(rows, {0}).to_vector();
+  for (const float sum : sums) {
+    EXPECT_NEAR(sum, expected / 4.0F, expected * 1e-6F);
+  }
+}
+
+TEST(ReduceTests, Statistics) {
+  const synapse::Tensor tensor{{1.0F, 2.0F, 3.0F, 4.0F, 3.0F, -4.0F}, {2, 3}};
+  EXPECT_TRUE(
+      synapse::is_close(synapse::mean(tensor, {1}), {{2.0F, 1.0F}, {2}}));
+  EXPECT_TRUE(synapse::is_close(synapse::var(tensor, {1}),
+                                {{1.0F, 19.0F}, {2}}, 1e-4F));
+  EXPECT_TRUE(synapse::is_close(synapse::var(tensor, {1}, false, 0),
+                                {{2.0F / 3.0F, 38.0F / 3.0F}, {2}}, 1e-4F));
+  EXPECT_TRUE(
+      synapse::is_close(synapse::norm(tensor, {0}),
+                        {{std::sqrt(17.0F), std::sqrt(13.0F), 5.0F}, {3}}));
+  EXPECT_TRUE(
+      synapse::is_close(synapse::max(tensor, {0}), {{4.0F, 3.0F, 3.0F}, {3}}));
+  EXPECT_TRUE(synapse::is_close(synapse::min(tensor), {{-4.0F}, {}}));
+
+  const synapse::Tensor argmax = synapse::argmax(tensor, 1);
+  EXPECT_EQ(argmax.dtype(), synapse::DType::Int32);
+  EXPECT_EQ(argmax.at<int32_t>(0), 2);
+  EXPECT_EQ(argmax.at<int32_t>(1), 0);
+  EXPECT_EQ(synapse::argmin(tensor).data_ptr<int32_t>()[0], 5);
+  EXPECT_EQ(synapse::argmax(tensor, 0, true).shape(), (synapse::Shape{1, 3}));
+  EXPECT_EQ(synapse::argmax(tensor, 0).at<int32_t>(2), 0);
+}
+
+TEST(ReduceTests, NaNPropagates) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<float> data(100, 1.0F);
+  data[37] = nan;
+  data[64] = nan;
+  const synapse::Tensor tensor{data, {100}};
+  EXPECT_TRUE(std::isnan(synapse::max(tensor).data()[0]));
+  EXPECT_TRUE(std::isnan(synapse::min(tensor).data()[0]));
+  EXPECT_EQ(synapse::argmax(tensor).data_ptr<int32_t>()[0], 37);
+  EXPECT_EQ(synapse::argmin(tensor.reshape({10, 10}), 0).at<int32_t>(7), 3);
+}
+
+TEST(ReduceTests, EmptyAndTypedReductions) {
+  const synapse::Tensor empty = synapse::Tensor::zeros({0, 3});
+  EXPECT_TRUE(synapse::is_close(synapse::sum(empty, {0}),
+                                synapse::Tensor::zeros({3})));
+  EXPECT_TRUE(std::isnan(synapse::mean(empty).data()[0]));
+  EXPECT_THROW(synapse::max(empty, {0}), std::invalid_argument);
+  EXPECT_EQ(synapse::sum(empty, {1}).shape(), (synapse::Shape{0}));
+
+  const synapse::Tensor ints{{1.0F, 2.0F, 3.0F, 4.0F}, {4},
+                             synapse::DType::Int32};
+  EXPECT_EQ(synapse::sum(ints).dtype(), synapse::DType::Int32);
+  EXPECT_EQ(synapse::sum(ints).data_ptr<int32_t>()[0], 10);
+  EXPECT_EQ(synapse::max(ints).data_ptr<int32_t>()[0], 4);
+  EXPECT_EQ(synapse::mean(ints).dtype(), synapse::DType::Float32);
+  EXPECT_FLOAT_EQ(synapse::mean(ints).data_ptr<float>()[0], 2.5F);
+
+  const synapse::Tensor halves = iota({8, 16}).to(synapse::DType::Float16);
+  const synapse::Tensor sum = synapse::sum(halves, {1});
+  EXPECT_EQ(sum.dtype(), synapse::DType::Float16);
+  EXPECT_TRUE(synapse::is_close(sum.to(synapse::DType::Float32),
+                                synapse::sum(iota({8, 16}), {1}), 1e-2F));
+}
+
+TEST(ReduceTests, Backward) {
+  synapse::Tensor tensor{{1.0F, 5.0F, 5.0F, 2.0F, -3.0F, 0.5F}, {2, 3}};
+  tensor.set_requires_grad(true);
+
+  synapse::sum(synapse::mean(tensor, {1})).backward();
+  EXPECT_TRUE(synapse::is_close(tensor.grad(),
+                                {std::vector<float>(6, 1.0F / 3.0F), {2, 3}}));
+
+  tensor.zero_grad();
+  synapse::sum(synapse::max(tensor, {1})).backward();
+  EXPECT_TRUE(synapse::is_close(
+      tensor.grad(), {{0.0F, 0.5F, 0.5F, 1.0F, 0.0F, 0.0F}, {2, 3}}));
+
+  tensor.zero_grad();
+  synapse::sum(synapse::var(tensor, {1})).backward();
+  // 2 (x - mean) / (n - 1) with means 11/3 and -1/6
+  EXPECT_TRUE(synapse::is_close(tensor.grad(),
+                                {{-8.0F / 3.0F, 4.0F / 3.0F, 4.0F / 3.0F,
+                                  13.0F / 6.0F, -17.0F / 6.0F, 4.0F / 6.0F},
+                                 {2, 3}},
+                                1e-4F));
+
+  tensor.zero_grad();
+  synapse::norm(tensor).backward();
+  const float norm = std::sqrt(64.25F);
+  EXPECT_TRUE(synapse::is_close(
+      tensor.grad(), {{1.0F / norm, 5.0F / norm, 5.0F / norm, 2.0F / norm,
+                        -3.0F / norm, 0.5F / norm},
+                       {2, 3}}));
+}
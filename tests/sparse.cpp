@@ -0,0 +1,176 @@
+#include "func.h"
+#include "ndarray.h"
+#include "nn.h"
+#include "sparse.h"
+#include "tensor.h"
+#include <cmath>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+// Mostly zeros, with a few values per row
+auto make_sparse_values(size_t rows, size_t cols) -> std::vector<float> {
+  std::vector<float> out(rows * cols, 0.0F);
+  for (size_t i = 0; i < out.size(); ++i) {
+    if ((i * 7) % 5 == 0) {
+      out[i] = std::sin(static_cast<float>(i) + 0.5F);
+    }
+  }
+  return out;
+}
+
+auto make_values(size_t numel) -> std::vector<float> {
+  std::vector<float> out(numel);
+  for (size_t i = 0; i < numel; ++i) {
+    out[i] = std::cos(static_cast<float>(i) * 0.3F);
+  }
+  return out;
+}
+} // namespace
+
+TEST(SparseTests, CooCoalescesTriplets) {
+  const synapse::SparseTensor coo = synapse::SparseTensor::coo(
+      {2, 3}, {1, 0, 1, 0}, {2, 1, 2, 0}, {1.0F, 2.0F, 3.0F, 4.0F});
+  EXPECT_EQ(coo.nnz(), 3);
+  EXPECT_EQ(coo.row_indices(), (std::vector<size_t>{0, 0, 1}));
+  EXPECT_EQ(coo.col_indices(), (std::vector<size_t>{0, 1, 2}));
+  EXPECT_EQ(coo.values(), (std::vector<float>{4.0F, 2.0F, 4.0F}));
+  EXPECT_EQ(coo.to_dense().to_vector(),
+            (std::vector<float>{4.0F, 2.0F, 0.0F, 0.0F, 0.0F, 4.0F}));
+  EXPECT_THROW(static_cast<void>(coo.row_offsets()), std::logic_error);
+
+  const synapse::SparseTensor csr = coo.to(synapse::SparseLayout::Csr);
+  EXPECT_EQ(csr.row_offsets(), (std::vector<size_t>{0, 2, 3}));
+  EXPECT_EQ(csr.to(synapse::SparseLayout::Coo).row_indices(),
+            coo.row_indices());
+
+  EXPECT_THROW(synapse::SparseTensor::coo({2, 3}, {2}, {0}, {1.0F}),
+               std::invalid_argument);
+  EXPECT_THROW(synapse::SparseTensor::coo({6}, {}, {}, {}),
+               std::invalid_argument);
+  EXPECT_THROW(synapse::SparseTensor::csr({2, 3}, {0, 2, 1}, {0}, {1.0F}),
+               std::invalid_argument);
+}
+
+TEST(SparseTests, DenseRoundTrips) {
+  const synapse::Tensor dense{make_sparse_values(7, 9), synapse::Shape{7, 9}};
+  for (const auto layout :
+       {synapse::SparseLayout::Coo, synapse::SparseLayout::Csr}) {
+    const synapse::SparseTensor sparse =
+        synapse::SparseTensor::from_dense(dense, layout);
+    EXPECT_EQ(sparse.layout(), layout);
+    EXPECT_LT(sparse.nnz(), dense.size() / 2);
+    EXPECT_EQ(sparse.to_dense().to_vector(), dense.to_vector());
+    EXPECT_EQ(sparse.transpose().to_dense().to_vector(),
+              dense.transpose(0, 1).contiguous().to_vector());
+  }
+}
+
+TEST(SparseTests, SpmmMatchesDenseMatmul) {
+  const synapse::Tensor dense{make_sparse_values(13, 11),
+                              synapse::Shape{13, 11}};
+  const synapse::Tensor rhs{make_values(11 * 5), synapse::Shape{11, 5}};
+  const synapse::Tensor vector{make_values(11), synapse::Shape{11}};
+  for (const auto layout :
+       {synapse::SparseLayout::Coo, synapse::SparseLayout::Csr}) {
+    const synapse::SparseTensor sparse =
+        synapse::SparseTensor::from_dense(dense, layout);
+    EXPECT_TRUE(synapse::is_close(synapse::spmm(sparse, rhs),
+                                  synapse::matmul(dense, rhs)));
+    EXPECT_TRUE(synapse::is_close(
+        synapse::spmv(sparse, vector),
+        synapse::matmul(dense, vector.reshape({11, 1})).reshape({13})));
+  }
+  EXPECT_THROW(static_cast<void>(synapse::spmm(
+                   synapse::SparseTensor::from_dense(dense), dense)),
+               std::invalid_argument);
+}
+
+TEST(SparseTests, SpmmGradientFlowsToDense) {
+  const synapse::Tensor dense{make_sparse_values(4, 6), synapse::Shape{4, 6}};
+  const synapse::SparseTensor sparse = synapse::SparseTensor::from_dense(dense);
+  synapse::Tensor rhs{make_values(6 * 3), synapse::Shape{6, 3}};
+  rhs.set_requires_grad();
+  synapse::sum(synapse::spmm(sparse, rhs)).backward();
+  // d sum(A B) / d B = A^T 1
+  const synapse::Tensor ones{std::vector<float>(4 * 3, 1.0F),
+                             synapse::Shape{4, 3}};
+  EXPECT_TRUE(synapse::is_close(
+      rhs.grad(), synapse::matmul(dense.transpose(0, 1), ones)));
+}
+
+TEST(SparseTests, ElementwiseOpsBroadcastDense) {
+  const synapse::SparseTensor sparse = synapse::SparseTensor::coo(
+      {2, 3}, {0, 1}, {1, 2}, {2.0F, -1.0F});
+  synapse::Tensor row{{1.0F, 2.0F, 3.0F}, synapse::Shape{3}};
+  row.set_requires_grad();
+
+  const synapse::Tensor sum = synapse::add(sparse, row);
+  EXPECT_EQ(sum.to_vector(),
+            (std::vector<float>{1.0F, 4.0F, 3.0F, 1.0F, 2.0F, 2.0F}));
+  synapse::sum(sum).backward();
+  EXPECT_EQ(row.grad().to_vector(), (std::vector<float>{2.0F, 2.0F, 2.0F}));
+
+  // A sparse product has no gradient to give back to `row`
+  EXPECT_THROW(static_cast<void>(synapse::mul(row, sparse)), std::logic_error);
+  const synapse::SparseTensor product = synapse::mul(row.detach(), sparse);
+  EXPECT_EQ(product.col_indices(), sparse.col_indices());
+  EXPECT_EQ(product.values(), (std::vector<float>{4.0F, -3.0F}));
+
+  const synapse::Tensor wide{
+      synapse::NDArray({1.0, 1.0, 1.0}, {3}, synapse::DType::Float64)};
+  EXPECT_EQ(synapse::add(wide, sparse).dtype(), synapse::DType::Float64);
+  EXPECT_THROW(static_cast<void>(synapse::add(
+                   sparse, synapse::Tensor{{1.0F, 2.0F}, synapse::Shape{2}})),
+               std::invalid_argument);
+
+  const synapse::SparseTensor twice = synapse::add(sparse, sparse);
+  EXPECT_EQ(twice.values(), (std::vector<float>{4.0F, -2.0F}));
+  const synapse::SparseTensor merged = synapse::add(
+      sparse, synapse::SparseTensor::coo({2, 3}, {0}, {0}, {5.0F}));
+  EXPECT_EQ(merged.to_dense().to_vector(),
+            (std::vector<float>{5.0F, 2.0F, 0.0F, 0.0F, 0.0F, -1.0F}));
+}
+
+TEST(SparseTests, EmbeddingSparseGradient) {
+  const synapse::Tensor ids{
+      synapse::NDArray({3.0F, 1.0F, 3.0F}, {3}, synapse::DType::Int32)};
+  synapse::nn::Embedding dense_table(synapse::Tensor{make_values(5 * 4),
+                                                     synapse::Shape{5, 4}});
+  synapse::nn::Embedding sparse_table(
+      synapse::Tensor{make_values(5 * 4), synapse::Shape{5, 4}}, true);
+  dense_table.weight().set_requires_grad();
+  sparse_table.weight().set_requires_grad();
+
+  const synapse::Tensor looked_up = sparse_table(ids);
+  EXPECT_EQ(looked_up.shape(), (synapse::Shape{3, 4}));
+  EXPECT_TRUE(synapse::is_close(looked_up, dense_table(ids)));
+
+  synapse::sum(synapse::mul(dense_table(ids), dense_table(ids))).backward();
+  synapse::sum(synapse::mul(looked_up, looked_up)).backward();
+  EXPECT_FALSE(sparse_table.weight().has_grad());
+  ASSERT_TRUE(sparse_table.has_sparse_grad());
+  // Only rows 1 and 3 are stored
+  EXPECT_EQ(sparse_table.sparse_grad().nnz(), 2 * 4);
+  EXPECT_TRUE(synapse::is_close(sparse_table.sparse_grad().to_dense(),
+                                dense_table.weight().grad()));
+
+  // Accumulates over backward passes, and steps the touched rows only
+  synapse::sum(sparse_table(ids)).backward();
+  EXPECT_EQ(sparse_table.sparse_grad().nnz(), 2 * 4);
+  const std::vector<float> before = sparse_table.weight().to_vector();
+  sparse_table.sparse_grad().add_to(sparse_table.weight(), -0.5F);
+  const std::vector<float> after = sparse_table.weight().to_vector();
+  EXPECT_EQ(after[0], before[0]);
+  EXPECT_NE(after[4], before[4]);
+  sparse_table.zero_sparse_grad();
+  EXPECT_THROW(static_cast<void>(sparse_table.sparse_grad()),
+               std::logic_error);
+
+  EXPECT_THROW(static_cast<void>(synapse::nn::embedding(
+                   synapse::Tensor{{5.0F}, synapse::Shape{1}},
+                   sparse_table.weight())),
+               std::out_of_range);
+}
@@ -0,0 +1,106 @@
+#include "func.h"
+#include "ndarray.h"
+#include "static_tensor.h"
+#include "tensor.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+using Mat23 = synapse::StaticTensor<float, 2, 3>;
+using Mat32 = synapse::StaticTensor<float, 3, 2>;
+
+static_assert(Mat23::rank == 2);
+static_assert(Mat23::numel == 6);
+static_assert(Mat23::strides == std::array<size_t, 2>{3, 1});
+static_assert(synapse::StaticTensor<float, 2, 3, 4>::strides ==
+              std::array<size_t, 3>{12, 4, 1});
+// Nothing but the elements
+static_assert(sizeof(Mat23) == 6 * sizeof(float));
+static_assert(Mat23({1, 2, 3, 4, 5, 6})(1, 2) == 6.0F);
+
+TEST(StaticTensorTests, Indexing) {
+  Mat23 mat({1, 2, 3, 4, 5, 6});
+  EXPECT_EQ(mat(0, 1), 2.0F);
+  mat(1, 0) = 7.0F;
+  EXPECT_EQ(mat.at(1, 0), 7.0F);
+  EXPECT_THROW(static_cast<void>(mat.at(2, 0)), std::out_of_range);
+  EXPECT_EQ(Mat23{}.values(), (std::array<float, 6>{}));
+  EXPECT_EQ(Mat23::full(2.0F), Mat23({2, 2, 2, 2, 2, 2}));
+}
+
+TEST(StaticTensorTests, ElementwiseMatchesTensorOps) {
+  const Mat23 lhs({1, -2, 3, -4, 5, -6});
+  const Mat23 rhs({0.5F, 1, 2, 4, -1, 3});
+  const synapse::Tensor lhs_tensor = lhs.to_tensor();
+  const synapse::Tensor rhs_tensor = rhs.to_tensor();
+
+  EXPECT_EQ((lhs + rhs).to_tensor().to_vector(),
+            synapse::add(lhs_tensor, rhs_tensor).to_vector());
+  EXPECT_EQ((lhs - rhs).to_tensor().to_vector(),
+            synapse::sub(lhs_tensor, rhs_tensor).to_vector());
+  EXPECT_EQ((lhs * rhs).to_tensor().to_vector(),
+            synapse::mul(lhs_tensor, rhs_tensor).to_vector());
+  EXPECT_EQ((lhs / rhs).to_tensor().to_vector(),
+            synapse::div(lhs_tensor, rhs_tensor).to_vector());
+  EXPECT_EQ((-lhs).to_tensor().to_vector(),
+            synapse::neg(lhs_tensor).to_vector());
+  EXPECT_EQ(synapse::apply<synapse::ElementwiseOp::Relu>(lhs)
+                .to_tensor()
+                .to_vector(),
+            synapse::relu(lhs_tensor).to_vector());
+  EXPECT_EQ(synapse::apply<synapse::ElementwiseOp::Exp>(lhs)
+                .to_tensor()
+                .to_vector(),
+            synapse::exp(lhs_tensor).to_vector());
+  EXPECT_EQ(lhs * 2.0F, lhs + lhs);
+
+  const synapse::StaticTensor<int32_t, 3> ints({1, -2, 3});
+  EXPECT_EQ(synapse::apply<synapse::ElementwiseOp::Abs>(ints),
+            (synapse::StaticTensor<int32_t, 3>({1, 2, 3})));
+}
+
+TEST(StaticTensorTests, MatmulMatchesTensorMatmul) {
+  const Mat23 lhs({1, 2, 3, 4, 5, 6});
+  const Mat32 rhs({7, 8, 9, 10, 11, 12});
+  EXPECT_EQ(synapse::matmul(lhs, rhs), (synapse::StaticTensor<float, 2, 2>(
+                                           {58, 64, 139, 154})));
+  EXPECT_TRUE(synapse::is_close(
+      synapse::matmul(lhs, rhs).to_tensor(),
+      synapse::matmul(lhs.to_tensor(), rhs.to_tensor())));
+
+  const synapse::StaticTensor<float, 3> vec({1, 0, -1});
+  EXPECT_EQ(synapse::matmul(lhs, vec),
+            (synapse::StaticTensor<float, 2>({-2, -2})));
+  EXPECT_EQ(synapse::transpose(lhs), Mat32({1, 4, 2, 5, 3, 6}));
+
+  // Past the unroll limit the same product runs as loops
+  using Big = synapse::StaticTensor<double, 8, 8>;
+  Big identity;
+  Big values;
+  for (size_t i = 0; i < 8; ++i) {
+    identity(i, i) = 1.0;
+    for (size_t j = 0; j < 8; ++j) {
+      values(i, j) = static_cast<double>((i * 8) + j);
+    }
+  }
+  EXPECT_EQ(synapse::matmul(values, identity), values);
+}
+
+TEST(StaticTensorTests, ConvertsFromAndToTensor) {
+  const synapse::Tensor tensor{std::vector<float>{1, 2, 3, 4, 5, 6},
+                               synapse::Shape{3, 2}};
+  // Strided views and other dtypes are copied into the inline elements
+  const Mat23 transposed(synapse::Tensor{tensor.transpose(0, 1)});
+  EXPECT_EQ(transposed, Mat23({1, 3, 5, 2, 4, 6}));
+  const synapse::StaticTensor<int32_t, 3, 2> ints(tensor);
+  EXPECT_EQ(ints(2, 1), 6);
+
+  const synapse::Tensor back = ints.to_tensor();
+  EXPECT_EQ(back.dtype(), synapse::DType::Int32);
+  EXPECT_EQ(back.shape(), (synapse::Shape{3, 2}));
+  EXPECT_EQ(back.to_vector(), tensor.to_vector());
+  EXPECT_THROW(Mat23{tensor}, std::invalid_argument);
+}
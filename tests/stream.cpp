@@ -0,0 +1,151 @@
+#include "autograd.h"
+#include "func.h"
+#include "ndarray.h"
+#include "stream.h"
+#include "tensor.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+// GCC 12 warns about the switch it generates over the suspension points
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wswitch-default"
+auto scale_on(synapse::Stream &stream, synapse::Future<synapse::Tensor> input,
+              float factor) -> synapse::Future<synapse::Tensor> {
+  const synapse::Tensor &value = co_await input;
+  synapse::Tensor copy = value;
+  co_await stream.schedule();
+  EXPECT_TRUE(stream.is_current());
+  co_return synapse::mul(copy, synapse::Tensor{{factor}, synapse::Shape{1}});
+}
+#pragma GCC diagnostic pop
+} // namespace
+
+TEST(StreamTests, SubmitRunsOnTheStream) {
+  synapse::Stream stream;
+  const synapse::Tensor lhs{{1.0F, 2.0F, 3.0F}, synapse::Shape{3}};
+  const synapse::Tensor rhs{{4.0F, 5.0F, 6.0F}, synapse::Shape{3}};
+  const synapse::Future<synapse::Tensor> sum = stream.submit(
+      [&stream](const synapse::Tensor &a, const synapse::Tensor &b) {
+        EXPECT_TRUE(stream.is_current());
+        return synapse::add(a, b);
+      },
+      lhs, rhs);
+  EXPECT_FALSE(stream.is_current());
+  EXPECT_EQ(sum.get().to_vector(), (std::vector<float>{5.0F, 7.0F, 9.0F}));
+  EXPECT_TRUE(sum.is_ready());
+}
+
+TEST(StreamTests, TasksRunInSubmissionOrder) {
+  synapse::Stream stream;
+  std::vector<int> order;
+  for (int i = 0; i < 100; ++i) {
+    stream.submit([&order, i] { order.push_back(i); });
+  }
+  stream.synchronize();
+  ASSERT_EQ(order.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(order[static_cast<size_t>(i)], i);
+  }
+}
+
+TEST(StreamTests, FutureArgumentsAreDependencies) {
+  synapse::Stream loader;
+  synapse::Stream compute;
+  std::atomic<bool> loaded{false};
+  const synapse::Future<synapse::Tensor> batch = loader.submit([&loaded] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    loaded = true;
+    return synapse::Tensor{{-1.0F, 2.0F}, synapse::Shape{2}};
+  });
+  const synapse::Future<synapse::Tensor> out = compute.submit(
+      [&loaded](const synapse::Tensor &input) {
+        EXPECT_TRUE(loaded);
+        return synapse::relu(input);
+      },
+      batch);
+  const synapse::Future<float> total = compute.submit(
+      [](const synapse::Tensor &a, const synapse::Tensor &b) {
+        return synapse::sum(synapse::add(a, b)).to_vector()[0];
+      },
+      batch, out);
+  EXPECT_EQ(out.get().to_vector(), (std::vector<float>{0.0F, 2.0F}));
+  EXPECT_FLOAT_EQ(total.get(), 3.0F);
+
+  // Futures without a result are waited for as well
+  std::atomic<bool> written{false};
+  const synapse::Future<void> write = loader.submit([&written] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    written = true;
+  });
+  const synapse::Future<bool> after = compute.submit(
+      [&written](const synapse::Future<void> &done) {
+        return written && done.is_ready();
+      },
+      write);
+  EXPECT_TRUE(after.get());
+}
+
+TEST(StreamTests, ExceptionsPropagateToDependents) {
+  synapse::Stream stream;
+  const synapse::Future<synapse::Tensor> failed =
+      stream.submit([]() -> synapse::Tensor {
+        throw std::runtime_error("Could not read the batch.");
+      });
+  bool ran = false;
+  const synapse::Future<void> dependent = stream.submit(
+      [&ran](const synapse::Tensor & /*input*/) { ran = true; }, failed);
+  EXPECT_THROW(failed.get(), std::runtime_error);
+  EXPECT_THROW(dependent.get(), std::runtime_error);
+  EXPECT_FALSE(ran);
+
+  const synapse::Future<void> failed_void = stream.submit(
+      [] { throw std::runtime_error("Could not write the batch."); });
+  const synapse::Future<void> after_void = stream.submit(
+      [&ran](const synapse::Future<void> & /*done*/) { ran = true; },
+      failed_void);
+  EXPECT_THROW(after_void.get(), std::runtime_error);
+  EXPECT_FALSE(ran);
+}
+
+TEST(StreamTests, WaitOrdersAcrossStreams) {
+  synapse::Stream first;
+  synapse::Stream second;
+  synapse::Promise<void> release;
+  std::atomic<int> step{0};
+  second.wait(release.get_future());
+  const synapse::Future<int> observed =
+      second.submit([&step] { return step.load(); });
+  first.submit([&step, release]() mutable {
+    step = 1;
+    release.set_value();
+  });
+  EXPECT_EQ(observed.get(), 1);
+}
+
+TEST(StreamTests, CoroutinesHopBetweenStreams) {
+  synapse::Stream loader;
+  synapse::Stream compute;
+  const synapse::Future<synapse::Tensor> batch = loader.submit([] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return synapse::Tensor{{1.0F, 2.0F}, synapse::Shape{2}};
+  });
+  const synapse::Future<synapse::Tensor> out = scale_on(compute, batch, 3.0F);
+  EXPECT_EQ(out.get().to_vector(), (std::vector<float>{3.0F, 6.0F}));
+}
+
+TEST(StreamTests, TasksInheritGradMode) {
+  synapse::Stream stream;
+  const synapse::Future<bool> enabled =
+      stream.submit([] { return synapse::GradMode::is_enabled(); });
+  EXPECT_TRUE(enabled.get());
+  const synapse::NoGradGuard guard;
+  const synapse::Future<bool> disabled =
+      stream.submit([] { return synapse::GradMode::is_enabled(); });
+  EXPECT_FALSE(disabled.get());
+}